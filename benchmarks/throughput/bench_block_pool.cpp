@@ -0,0 +1,252 @@
+// File: benchmarks/throughput/bench_block_pool.cpp
+// Voxel block pool: (1) slab churn against the system allocator, with a fixed live set and
+// one release plus one take per step (a region evicted, another allocated), using either
+// one heap allocation per region slab or one per block; (2) pool reuse and
+// fragmentation while the map patrols under a --budget MiB cap; (3) the same map with
+// 4 KiB pages and with 2 MiB transparent huge pages: warm ray integration and random block
+// reads, the chunks the kernel accepted the advice for and AnonHugePages from
+// /proc/self/smaps_rollup.
+//
+//   wm_bench_block_pool [--live SLABS] [--steps N] [--rays N] [--distance M] [--budget MiB]
+//                       [--reps R]
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/block_pool.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+namespace {
+
+constexpr double kMiB = 1024.0 * 1024.0;
+
+// AnonHugePages of this process in kB (0 when the kernel does not report it).
+std::size_t anon_huge_kb() {
+  std::ifstream in("/proc/self/smaps_rollup");
+  std::string key;
+  std::size_t kb = 0;
+  while (in >> key) {
+    if (key == "AnonHugePages:") {
+      in >> kb;
+      return kb;
+    }
+    in.ignore(1 << 12, '\n');
+  }
+  return 0;
+}
+
+// Churn: `live` slabs held, then `steps` times a random one is released and a slab taken
+// in its place; every taken block gets one byte written, as a map claiming it would.
+struct ChurnOrder {
+  std::vector<std::uint32_t> victims;
+};
+
+ChurnOrder churn_order(std::size_t live, std::size_t steps) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<std::size_t> pick(0, live - 1);
+  ChurnOrder o;
+  o.victims.resize(steps);
+  for (auto& v : o.victims) v = static_cast<std::uint32_t>(pick(rng));
+  return o;
+}
+
+template <typename Take, typename Release>
+std::uint64_t churn(std::size_t live, const ChurnOrder& order, Take&& take, Release&& release) {
+  std::vector<typename std::invoke_result_t<Take>> held(live);
+  for (auto& h : held) h = take();
+  for (const std::uint32_t v : order.victims) {
+    release(held[v]);
+    held[v] = take();
+  }
+  for (auto& h : held) release(h);
+  return order.victims.size() + live;
+}
+
+struct PatrolRow {
+  double seconds{0.0};
+  wm::VoxelBlockMapStats map;
+};
+
+// Out-and-back patrol as in bench_map_budget.
+PatrolRow patrol(wm::VoxelBlockMap& map, const wm::RayIntegratorConfig& rcfg, const wm::PointBuffer& scan,
+                 int distance) {
+  PatrolRow row;
+  wm::RayIntegrator integrator(map, rcfg);
+  wm::PointBuffer moved;
+  for (int f = 0; f <= 2 * distance; ++f) {
+    const float x = static_cast<float>(f <= distance ? f : 2 * distance - f);
+    moved.clear();
+    for (std::size_t i = 0; i < scan.size(); ++i) {
+      const wm::PointXYZI p = scan.view().at(i);
+      moved.push_back(p.x + x, p.y, p.z, p.intensity);
+    }
+    row.seconds += wm::bench::best_of(1, [&] { integrator.integrate(wm::Vec3f{x, 0.0f, 1.0f}, moved.view()); });
+  }
+  row.map = map.stats();
+  return row;
+}
+
+void print_pool(const wm::VoxelBlockMapStats& s) {
+  wm::bench::print_row("  pool", static_cast<double>(s.pool_bytes) / kMiB, "MiB");
+  wm::bench::print_row("  pool chunks", static_cast<double>(s.pool_chunks), "");
+  wm::bench::print_row("  pool occupancy", 100.0 * s.pool_occupancy(), "%");
+  wm::bench::print_row("  fragmentation (stranded slots)", 100.0 * s.fragmentation(), "%");
+  wm::bench::print_row("  free regions", static_cast<double>(s.free_regions), "");
+  wm::bench::print_row("  regions allocated", static_cast<double>(s.regions_allocated), "");
+  wm::bench::print_row("  of those, reused", static_cast<double>(s.regions_reused), "");
+  wm::bench::print_row("  blocks allocated", static_cast<double>(s.blocks_allocated), "");
+  wm::bench::print_row("  blocks released", static_cast<double>(s.blocks_released), "");
+}
+
+struct PagesRow {
+  double integrate_s{0.0};
+  double reads_s{0.0};
+  std::uint64_t checksum{0};
+  std::size_t huge_page_chunks{0};
+  std::size_t anon_huge_kb{0};
+  std::size_t pool_bytes{0};
+};
+
+PagesRow pages_run(const wm::MappingConfig& mcfg, bool huge, const wm::PointBuffer& scan, int reps) {
+  wm::VoxelBlockMapParams params = wm::VoxelBlockMapParams::from_config(mcfg);
+  params.huge_pages = huge;
+  const std::size_t anon_before = anon_huge_kb();
+  wm::VoxelBlockMap map(params);
+  wm::RayIntegrator integrator(map, wm::RayIntegratorConfig::from_config(mcfg));
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+  integrator.integrate(origin, scan.view());
+
+  PagesRow row;
+  row.integrate_s = wm::bench::best_of(reps, [&] { integrator.integrate(origin, scan.view()); });
+
+  // Random block reads: one cell per block, blocks in shuffled order (TLB bound).
+  std::vector<wm::BlockIndex> blocks;
+  map.for_each_block([&](const wm::BlockKey&, wm::BlockIndex b) { blocks.push_back(b); });
+  std::mt19937 rng(3);
+  std::shuffle(blocks.begin(), blocks.end(), rng);
+  std::vector<std::uint32_t> voxel(blocks.size());
+  std::uniform_int_distribution<std::uint32_t> pick(0, static_cast<std::uint32_t>(map.voxels_per_block() - 1));
+  for (auto& v : voxel) v = pick(rng);
+  row.reads_s = wm::bench::best_of(reps, [&] {
+    std::uint64_t sum = 0;
+    for (int pass = 0; pass < 8; ++pass) {
+      for (std::size_t i = 0; i < blocks.size(); ++i) sum += static_cast<std::uint16_t>(map.cell(blocks[i], voxel[i]));
+    }
+    row.checksum = sum;
+  }) / (8.0 * static_cast<double>(blocks.size()));
+
+  const wm::VoxelBlockMapStats s = map.stats();
+  row.huge_page_chunks = s.huge_page_chunks;
+  row.pool_bytes = s.pool_bytes;
+  const std::size_t anon_after = anon_huge_kb();
+  row.anon_huge_kb = anon_after > anon_before ? anon_after - anon_before : 0;
+  return row;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto live = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--live", 4096));
+  const auto steps = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--steps", 2'000'000));
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 200'000));
+  const int distance = static_cast<int>(wm::bench::arg_i64(argc, argv, "--distance", 40));
+  const int budget_mb = static_cast<int>(wm::bench::arg_i64(argc, argv, "--budget", 512));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 3));
+
+  const wm::MappingConfig mcfg;
+  const wm::VoxelBlockMapParams params = wm::VoxelBlockMapParams::from_config(mcfg);
+  const std::size_t r = static_cast<std::size_t>(params.region_size_blocks);
+  const std::size_t per_slab = r * r * r;
+  const std::size_t bytes_per_voxel = params.log_odds_bits == 8 ? 1 : 2;
+  const std::size_t block_bytes = static_cast<std::size_t>(params.block_size_vox) * params.block_size_vox *
+                                  params.block_size_vox * bytes_per_voxel;
+
+  // (1) Slab churn.
+  std::cout << "block pool: " << block_bytes << " B blocks, " << per_slab << " per region slab, " << live
+            << " live slabs, " << steps << " release/take steps, best of " << reps << "\n";
+  const ChurnOrder order = churn_order(live, steps);
+  std::uint64_t ops = 0;
+  const double t_pool = wm::bench::best_of(reps, [&] {
+    wm::BlockPool pool({block_bytes, per_slab, params.blocks_per_chunk, false});
+    ops = churn(
+        live, order,
+        [&] {
+          const std::uint32_t s = pool.take_slab();
+          for (std::size_t i = 0; i < per_slab; ++i) *pool.block_ptr(s * per_slab + i) = 1;
+          return s;
+        },
+        [&](std::uint32_t s) { pool.release_slab(s); });
+  });
+  const double t_slab_heap = wm::bench::best_of(reps, [&] {
+    churn(
+        live, order,
+        [&] {
+          auto* p = static_cast<std::uint8_t*>(::operator new(per_slab * block_bytes, std::align_val_t{64}));
+          for (std::size_t i = 0; i < per_slab; ++i) p[i * block_bytes] = 1;
+          return p;
+        },
+        [&](std::uint8_t* p) { ::operator delete(p, std::align_val_t{64}); });
+  });
+  const double t_block_heap = wm::bench::best_of(reps, [&] {
+    churn(
+        live, order,
+        [&] {
+          std::vector<std::uint8_t*> blocks(per_slab);
+          for (auto& p : blocks) {
+            p = static_cast<std::uint8_t*>(::operator new(block_bytes, std::align_val_t{64}));
+            *p = 1;
+          }
+          return blocks;
+        },
+        [&](std::vector<std::uint8_t*>& blocks) {
+          for (auto* p : blocks) ::operator delete(p, std::align_val_t{64});
+        });
+  });
+  const double slab_ops = static_cast<double>(ops);
+  wm::bench::print_row("pool take+release", t_pool / slab_ops * 1e9, "ns/slab");
+  wm::bench::print_row("heap, one allocation per slab", t_slab_heap / slab_ops * 1e9, "ns/slab");
+  wm::bench::print_row("heap, one allocation per block", t_block_heap / slab_ops * 1e9, "ns/slab");
+  wm::bench::print_row("pool speedup vs per-block heap", t_block_heap / t_pool, "x");
+
+  // (2) Reuse under a memory budget.
+  {
+    wm::MappingConfig capped = mcfg;
+    capped.roi.min = wm::Vec3f{-20.0f, -20.0f, -2.0f};
+    capped.roi.max = wm::Vec3f{static_cast<float>(distance) + 20.0f, 20.0f, 5.0f};
+    capped.map_memory_budget_mb = budget_mb;
+    const wm::PointBuffer scan = wm::bench::make_scan(10'000, 9.5f);
+    wm::VoxelBlockMap map(capped);
+    const PatrolRow row = patrol(map, wm::RayIntegratorConfig::from_config(capped), scan, distance);
+    std::cout << "patrol: " << 2 * distance + 1 << " frames of 10000 rays, budget " << budget_mb << " MiB\n";
+    print_pool(row.map);
+    wm::bench::print_row("  block allocations", static_cast<double>(row.map.blocks_allocated) / row.seconds,
+                         "blocks/s");
+    wm::bench::print_row("  evicted regions", static_cast<double>(row.map.evicted_regions), "");
+  }
+
+  // (3) Page size.
+  const wm::PointBuffer scan = wm::bench::make_scan(rays, 9.5f);
+  std::cout << "page size: " << rays << " rays, best of " << reps << "\n";
+  const PagesRow small = pages_run(mcfg, false, scan, reps);
+  const PagesRow huge = pages_run(mcfg, true, scan, reps);
+  for (const auto* row : {&small, &huge}) {
+    std::cout << (row == &small ? "  4 KiB pages\n" : "  2 MiB transparent huge pages\n");
+    wm::bench::print_row("  pool", static_cast<double>(row->pool_bytes) / kMiB, "MiB");
+    wm::bench::print_row("  chunks advised as huge pages", static_cast<double>(row->huge_page_chunks), "");
+    wm::bench::print_row("  AnonHugePages gained", static_cast<double>(row->anon_huge_kb) / 1024.0, "MiB");
+    wm::bench::print_row("  warm scan", static_cast<double>(rays) / row->integrate_s * 1e-6, "Mrays/s");
+    wm::bench::print_row("  random block read", row->reads_s * 1e9, "ns");
+  }
+  wm::bench::print_row("huge pages: scan speedup", small.integrate_s / huge.integrate_s, "x");
+  wm::bench::print_row("huge pages: read speedup", small.reads_s / huge.reads_s, "x");
+  wm::bench::print_row("checksums equal", small.checksum == huge.checksum ? 1.0 : 0.0, "");
+  return 0;
+}
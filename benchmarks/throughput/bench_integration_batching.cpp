@@ -0,0 +1,122 @@
+// File: benchmarks/throughput/bench_integration_batching.cpp
+// Frame-accumulating integration: a fixed sensor 2.5 m above a factory floor streams
+// --sensor-hz frames of --rays returns each for --seconds: the same beams every frame with
+// range noise, --fresh percent of them replaced by new returns. Integrating every frame on
+// arrival is compared with IntegrationScheduler batches at 10 and 5 Hz: block visits, rays
+// cast, voxel updates and integration time per second of sensor time, and how many voxels
+// classify the same at the end.
+//
+//   wm_bench_integration_batching [--rays N] [--sensor-hz H] [--seconds S] [--fresh P] [--threads T]
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/integration_scheduler.hpp"
+
+namespace {
+
+struct Row {
+  double seconds{0.0};
+  wm::RayIntegratorStats stats;
+  wm::IntegrationSchedulerStats sched;
+};
+
+Row run(wm::MultiResMap& map, const wm::RayIntegratorConfig& rcfg, double map_hz, double sensor_hz,
+        const std::vector<wm::PointBuffer>& frames) {
+  wm::IntegrationSchedulerConfig scfg;
+  scfg.integrate_hz = map_hz;
+  wm::IntegrationScheduler scheduler(map, rcfg, scfg);
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};  // as the frames below
+  Row row;
+  row.seconds = wm::bench::best_of(1, [&] {
+    for (std::size_t f = 0; f < frames.size(); ++f) {
+      const wm::TimestampNs t{static_cast<std::int64_t>(static_cast<double>(f) * 1e9 / sensor_hz)};
+      scheduler.push(t, origin, frames[f].view());
+    }
+    scheduler.flush();
+  });
+  row.stats = scheduler.integrator_stats();
+  row.sched = scheduler.stats();
+  return row;
+}
+
+double agreement(const wm::VoxelBlockMap& a, const wm::VoxelBlockMap& b) {
+  std::size_t voxels = 0;
+  std::size_t same = 0;
+  const wm::LogOddsModel& m = a.log_odds_model();
+  a.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex ba) {
+    const wm::BlockIndex bb = b.find(k);
+    for (std::uint32_t v = 0; v < a.voxels_per_block(); ++v) {
+      const wm::VoxelState sb = bb == wm::kInvalidBlock ? wm::VoxelState::kUnknown : m.classify(b.cell(bb, v));
+      same += m.classify(a.cell(ba, v)) == sb ? 1 : 0;
+      ++voxels;
+    }
+  });
+  return voxels == 0 ? 100.0 : 100.0 * static_cast<double>(same) / static_cast<double>(voxels);
+}
+
+void print(const std::string& name, const Row& row, double sensor_seconds) {
+  std::cout << "  " << name << "\n";
+  wm::bench::print_row("  map updates / s", static_cast<double>(row.sched.batches) / sensor_seconds, "");
+  wm::bench::print_row("  block visits / s", static_cast<double>(row.stats.blocks_touched) / sensor_seconds * 1e-3, "k");
+  wm::bench::print_row("  rays cast / s",
+                       static_cast<double>(row.sched.points) / sensor_seconds * 1e-3, "k");
+  wm::bench::print_row("  voxel updates / s",
+                       static_cast<double>(row.stats.hits + row.stats.misses) / sensor_seconds * 1e-6, "M");
+  wm::bench::print_row("  integration / sensor second", row.seconds / sensor_seconds * 1e3, "ms");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 8'000));
+  const double sensor_hz = static_cast<double>(wm::bench::arg_i64(argc, argv, "--sensor-hz", 20));
+  const double seconds = static_cast<double>(wm::bench::arg_i64(argc, argv, "--seconds", 4));
+  const int threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--threads", 0));
+  const double fresh_pct = static_cast<double>(wm::bench::arg_i64(argc, argv, "--fresh", 10));
+
+  const wm::MappingConfig mcfg;
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = threads;
+  // A fixed sensor fires the same beams every frame; returns differ by range noise
+  // (1 cm sigma along the beam) and a --fresh percentage of beams hitting something new.
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+  const wm::PointBuffer beams = wm::bench::make_scan(rays, 9.5f, 1);
+  std::vector<wm::PointBuffer> frames;
+  std::mt19937 rng(7);
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  std::uniform_real_distribution<double> u01(0.0, 1.0);
+  for (int f = 0; f < static_cast<int>(sensor_hz * seconds); ++f) {
+    const wm::PointBuffer fresh = wm::bench::make_scan(rays, 9.5f, static_cast<std::uint32_t>(f + 2));
+    wm::PointBuffer frame;
+    for (std::size_t i = 0; i < rays; ++i) {
+      wm::PointXYZI p = u01(rng) * 100.0 < fresh_pct ? fresh.at(i) : beams.at(i);
+      const wm::Vec3f d{p.x - origin.x, p.y - origin.y, p.z - origin.z};
+      const float r = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+      const float s = r > 0.0f ? 1.0f + noise(rng) / r : 1.0f;
+      frame.push_back(origin.x + d.x * s, origin.y + d.y * s, origin.z + d.z * s, p.intensity);
+    }
+    frames.push_back(std::move(frame));
+  }
+
+  std::cout << "batched integration: " << frames.size() << " frames of " << rays << " rays at " << sensor_hz
+            << " Hz, " << rcfg.rays_per_batch << " rays per pass\n";
+  wm::MultiResMap every(mcfg);
+  const Row r_every = run(every, rcfg, 0.0, sensor_hz, frames);
+  print("every frame", r_every, seconds);
+  for (const double map_hz : {10.0, 5.0}) {
+    wm::MultiResMap batched(mcfg);
+    const Row r = run(batched, rcfg, map_hz, sensor_hz, frames);
+    print("batched at " + std::to_string(static_cast<int>(map_hz)) + " Hz", r, seconds);
+    wm::bench::print_row("  block visits vs every frame",
+                         static_cast<double>(r_every.stats.blocks_touched) / static_cast<double>(r.stats.blocks_touched),
+                         "x fewer");
+    wm::bench::print_row("  time vs every frame", r_every.seconds / r.seconds, "x faster");
+    wm::bench::print_row("  state agreement", agreement(every.level(0), batched.level(0)), "%");
+  }
+  return 0;
+}
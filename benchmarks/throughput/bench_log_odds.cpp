@@ -0,0 +1,151 @@
+// File: benchmarks/throughput/bench_log_odds.cpp
+// Fixed-point log-odds occupancy: the whole-block saturating update kernel per SIMD tier
+// and cell width, against scattered per-voxel updates (what the apply phase did before),
+// at several fractions of a block's voxels updated per pass. Then map memory and state
+// agreement of int8 vs int16 cells on the default ray-cast workload.
+//
+//   wm_bench_log_odds [--blocks N] [--rays N] [--reps R]
+//   WM_DISABLE_AVX2=1 caps the tiers at SSE2.
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/log_odds.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+namespace {
+
+constexpr std::size_t kVoxels = 512;  // 8^3 block
+
+struct Workload {
+  std::vector<std::uint8_t> counts;                 // per block: hit counts, then miss counts
+  std::vector<std::vector<std::uint16_t>> updated;  // per block: counted voxels, for the scatter path
+};
+
+Workload make_counts(std::size_t blocks, double fraction, std::uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  Workload w;
+  w.counts.assign(blocks * 2 * kVoxels, 0);
+  w.updated.resize(blocks);
+  for (std::size_t b = 0; b < blocks; ++b) {
+    for (std::size_t v = 0; v < kVoxels; ++v) {
+      if (u(rng) >= fraction) continue;
+      // Mostly misses (rays passing through), a few voxels seen by several rays.
+      std::uint8_t* c = w.counts.data() + b * 2 * kVoxels;
+      c[v] = u(rng) < 0.2 ? 1 : 0;
+      c[kVoxels + v] = static_cast<std::uint8_t>(1 + (u(rng) < 0.3 ? 2 : 0));
+      w.updated[b].push_back(static_cast<std::uint16_t>(v));
+    }
+  }
+  return w;
+}
+
+template <typename Cell>
+void scatter(const wm::LogOddsModel& m, Cell* cells, const std::uint8_t* counts,
+             const std::vector<std::uint16_t>& list) {
+  for (const std::uint16_t v : list) {
+    const std::int32_t d = counts[v] * m.hit + counts[kVoxels + v] * m.miss;
+    cells[v] = static_cast<Cell>(std::clamp(cells[v] + d, m.min, m.max));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto blocks = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--blocks", 4096));
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 50'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+  const wm::MappingConfig mcfg;
+
+  std::cout << "log-odds block updates: " << blocks << " blocks of " << kVoxels << " voxels, best of " << reps
+            << "\n";
+  bool exact = true;
+  for (const int bits : {16, 8}) {
+    const wm::LogOddsModel model = wm::LogOddsModel::make(bits, mcfg.log_odds_hit, mcfg.log_odds_miss,
+                                                          mcfg.log_odds_min, mcfg.log_odds_max,
+                                                          mcfg.log_odds_occupied, mcfg.log_odds_free);
+    const std::size_t bytes = blocks * kVoxels * model.cell_bytes();
+    std::cout << "  int" << bits << " cells (hit " << model.hit << ", miss " << model.miss << ", clamp [" << model.min
+              << ", " << model.max << "])\n";
+    for (const double fraction : {0.02, 0.1, 0.5}) {
+      const Workload w = make_counts(blocks, fraction, 3);
+      std::vector<std::uint8_t> cells(bytes, 0);
+      std::vector<std::uint8_t> counts;
+      const double t_scatter = wm::bench::best_of(reps, [&] {
+        for (std::size_t b = 0; b < blocks; ++b) {
+          const std::uint8_t* mk = w.counts.data() + b * 2 * kVoxels;
+          if (bits == 8) {
+            scatter(model, reinterpret_cast<std::int8_t*>(cells.data()) + b * kVoxels, mk, w.updated[b]);
+          } else {
+            scatter(model, reinterpret_cast<std::int16_t*>(cells.data()) + b * kVoxels, mk, w.updated[b]);
+          }
+        }
+      });
+      const std::vector<std::uint8_t> reference = cells;
+      std::cout << "    " << fraction * 100.0 << "% of voxels updated\n";
+      wm::bench::print_row("    scattered (scalar)", static_cast<double>(blocks) / t_scatter * 1e-6, "Mblocks/s");
+      for (const wm::SimdLevel level : {wm::SimdLevel::kScalar, wm::SimdLevel::kSse2, wm::SimdLevel::kAvx2}) {
+        if (wm::clamp_simd_level(level) != level) continue;
+        std::fill(cells.begin(), cells.end(), 0);
+        // Counts are consumed by the kernel, so each rep restores them first (memcpy
+        // included in the timing; it is the same traffic the apply phase pays to count).
+        const double t = wm::bench::best_of(reps, [&] {
+          counts = w.counts;
+          for (std::size_t b = 0; b < blocks; ++b) {
+            std::uint8_t* c = counts.data() + b * 2 * kVoxels;
+            wm::apply_block_updates(model, cells.data() + b * kVoxels * model.cell_bytes(), c, c + kVoxels, kVoxels,
+                                    level);
+          }
+        });
+        // Same number of passes as the scatter loop, so the cells must match exactly.
+        exact = exact && cells == reference;
+        const std::string name = std::string("    block kernel (") + wm::simd_level_name(level) + ")";
+        wm::bench::print_row(name, static_cast<double>(blocks) / t * 1e-6, "Mblocks/s");
+      }
+    }
+  }
+
+  // Map memory and state agreement on the default workload (sensor 2.5 m above the floor).
+  const wm::PointBuffer scan = wm::bench::make_scan(rays, 9.5f);
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+  wm::MappingConfig c16 = mcfg;
+  c16.log_odds_bits = 16;
+  wm::MappingConfig c8 = mcfg;
+  c8.log_odds_bits = 8;
+  wm::VoxelBlockMap m16(c16);
+  wm::VoxelBlockMap m8(c8);
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = 1;
+  for (int f = 0; f < 3; ++f) {
+    wm::RayIntegrator(m16, rcfg).integrate(origin, scan.view());
+    wm::RayIntegrator(m8, rcfg).integrate(origin, scan.view());
+  }
+  std::size_t voxels = 0;
+  std::size_t same = 0;
+  m16.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex b) {
+    const wm::BlockIndex b8 = m8.find(k);
+    for (std::uint32_t v = 0; v < m16.voxels_per_block(); ++v) {
+      const wm::VoxelState s16 = m16.log_odds_model().classify(m16.cell(b, v));
+      const wm::VoxelState s8 = b8 == wm::kInvalidBlock ? wm::VoxelState::kUnknown : m8.log_odds_model().classify(m8.cell(b8, v));
+      same += s16 == s8 ? 1 : 0;
+      ++voxels;
+    }
+  });
+  // Float cells would double the int16 pool.
+  const wm::VoxelBlockMapStats s16 = m16.stats();
+  const double float_mib =
+      static_cast<double>(s16.memory_bytes + s16.pool_chunks * m16.params().blocks_per_chunk * m16.block_bytes()) /
+      (1024.0 * 1024.0);
+  std::cout << "  map after 3 x " << rays << " rays (" << m16.num_blocks() << " blocks)\n";
+  wm::bench::print_row("  memory, float cells (before)", float_mib, "MiB");
+  wm::bench::print_row("  memory, int16 cells", static_cast<double>(s16.memory_bytes) / (1024.0 * 1024.0), "MiB");
+  wm::bench::print_row("  memory, int8 cells", static_cast<double>(m8.stats().memory_bytes) / (1024.0 * 1024.0), "MiB");
+  wm::bench::print_row("  int8 vs int16 state agreement", 100.0 * static_cast<double>(same) / static_cast<double>(voxels), "%");
+  if (!exact) std::cout << "  WARNING: block kernel differs from scattered updates\n";
+  return 0;
+}
@@ -0,0 +1,125 @@
+// File: benchmarks/throughput/bench_map_budget.cpp
+// Memory-capped voxel map on a long run: the sensor patrols --distance metres down a
+// corridor and back (ROI opened up to hold all of it), integrating a factory-hall scan per
+// metre. Compares the unbounded map with a --budget MiB cap that drops evicted regions
+// and one that spills them to disk: peak and final memory, evictions, spill traffic and
+// time per frame. The core box around the start must stay identical to the unbounded map;
+// with spilling so must every resident block (eviction and restore are lossless).
+//
+//   wm_bench_map_budget [--rays N] [--distance M] [--budget MiB] [--threads T]
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+namespace {
+
+struct Row {
+  double seconds{0.0};
+  std::size_t peak_memory{0};
+  wm::VoxelBlockMapStats map;
+};
+
+Row run(wm::VoxelBlockMap& map, const wm::RayIntegratorConfig& rcfg, const wm::PointBuffer& scan, int distance) {
+  Row row;
+  wm::RayIntegrator integrator(map, rcfg);
+  wm::PointBuffer moved;
+  // Out and back: regions evicted on the way out are observed again on the way back.
+  for (int f = 0; f <= 2 * distance; ++f) {
+    const float x = static_cast<float>(f <= distance ? f : 2 * distance - f);
+    moved.clear();
+    for (std::size_t i = 0; i < scan.size(); ++i) {
+      const wm::PointXYZI p = scan.view().at(i);
+      moved.push_back(p.x + x, p.y, p.z, p.intensity);
+    }
+    row.seconds += wm::bench::best_of(1, [&] { integrator.integrate(wm::Vec3f{x, 0.0f, 1.0f}, moved.view()); });
+    row.peak_memory = std::max(row.peak_memory, map.stats().memory_bytes);
+  }
+  row.seconds /= static_cast<double>(2 * distance + 1);
+  row.map = map.stats();
+  return row;
+}
+
+// Fraction of `ref`'s voxels (restricted to blocks centred in `box` if given) with the
+// same cell value in `other`; blocks missing from `other` read as 0.
+double agreement(const wm::VoxelBlockMap& ref, const wm::VoxelBlockMap& other, const wm::AABB* box) {
+  std::size_t voxels = 0;
+  std::size_t same = 0;
+  const float half = 0.5f * ref.block_extent_m();
+  ref.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex b) {
+    const wm::Vec3f o = ref.block_origin(k);
+    const wm::Vec3f c{o.x + half, o.y + half, o.z + half};
+    if (box != nullptr && !(c.x >= box->min.x && c.x < box->max.x && c.y >= box->min.y && c.y < box->max.y &&
+                            c.z >= box->min.z && c.z < box->max.z)) {
+      return;
+    }
+    const wm::BlockIndex ob = other.find(k);
+    for (std::uint32_t v = 0; v < ref.voxels_per_block(); ++v) {
+      same += ref.cell(b, v) == (ob == wm::kInvalidBlock ? 0 : other.cell(ob, v)) ? 1 : 0;
+      ++voxels;
+    }
+  });
+  return voxels == 0 ? 100.0 : 100.0 * static_cast<double>(same) / static_cast<double>(voxels);
+}
+
+void print(const char* name, const Row& row) {
+  constexpr double kMiB = 1024.0 * 1024.0;
+  std::cout << "  " << name << "\n";
+  wm::bench::print_row("  peak map memory", static_cast<double>(row.peak_memory) / kMiB, "MiB");
+  wm::bench::print_row("  live memory at end", static_cast<double>(row.map.live_bytes) / kMiB, "MiB");
+  wm::bench::print_row("  resident blocks at end", static_cast<double>(row.map.blocks), "");
+  wm::bench::print_row("  evicted regions", static_cast<double>(row.map.evicted_regions), "");
+  wm::bench::print_row("  spilled regions", static_cast<double>(row.map.spilled_regions), "");
+  wm::bench::print_row("  restored regions", static_cast<double>(row.map.restored_regions), "");
+  wm::bench::print_row("  spill written", static_cast<double>(row.map.spill_bytes_written) / kMiB, "MiB");
+  wm::bench::print_row("  spill read", static_cast<double>(row.map.spill_bytes_read) / kMiB, "MiB");
+  wm::bench::print_row("  spill errors", static_cast<double>(row.map.spill_errors), "");
+  wm::bench::print_row("  frame", row.seconds * 1e3, "ms");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 10'000));
+  const int distance = static_cast<int>(wm::bench::arg_i64(argc, argv, "--distance", 40));
+  const int budget_mb = static_cast<int>(wm::bench::arg_i64(argc, argv, "--budget", 512));
+  const int threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--threads", 0));
+
+  wm::MappingConfig mcfg;
+  mcfg.roi.min = wm::Vec3f{-20.0f, -20.0f, -2.0f};
+  mcfg.roi.max = wm::Vec3f{static_cast<float>(distance) + 20.0f, 20.0f, 5.0f};
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = threads;
+  const wm::PointBuffer scan = wm::bench::make_scan(rays, 9.5f);
+
+  std::cout << "memory-capped map: " << rays << " rays per frame, " << 2 * distance + 1 << " frames ("
+            << distance << " m out and back), budget " << budget_mb << " MiB, core [" << mcfg.map_core.min.x << ", "
+            << mcfg.map_core.max.x << "] m\n";
+
+  wm::VoxelBlockMap unbounded(mcfg);
+  const Row r_unbounded = run(unbounded, rcfg, scan, distance);
+  print("unbounded", r_unbounded);
+
+  wm::MappingConfig capped = mcfg;
+  capped.map_memory_budget_mb = budget_mb;
+  wm::VoxelBlockMap dropping(capped);
+  const Row r_drop = run(dropping, rcfg, scan, distance);
+  print("budget, evicted regions dropped", r_drop);
+
+  capped.map_spill_path = (std::filesystem::temp_directory_path() / "wm_bench_map_budget.spill").string();
+  wm::VoxelBlockMap spilling(capped);
+  const Row r_spill = run(spilling, rcfg, scan, distance);
+  print("budget, evicted regions spilled", r_spill);
+
+  const wm::AABB core{mcfg.map_core.min, mcfg.map_core.max};
+  std::cout << "  agreement with the unbounded map\n";
+  wm::bench::print_row("  core, dropped", agreement(unbounded, dropping, &core), "%");
+  wm::bench::print_row("  core, spilled", agreement(unbounded, spilling, &core), "%");
+  wm::bench::print_row("  whole map, dropped", agreement(unbounded, dropping, nullptr), "%");
+  wm::bench::print_row("  whole map, spilled (resident only)", agreement(spilling, unbounded, nullptr), "%");
+  return 0;
+}
@@ -0,0 +1,70 @@
+// File: benchmarks/throughput/bench_map_scaling.cpp
+// Scaling of one frame of ray integration into the sharded voxel block map with the
+// thread count (default mapping config, factory scan from a sensor 1 m above the origin).
+// Each row uses a fresh map: "cold" integrates the frame into the empty map (every block
+// is new and goes through the shard-parallel insert), "warm" integrates it again.
+//
+//   wm_bench_map_scaling [--rays N] [--max-threads T] [--reps R]
+//   Thread counts above the machine's cores are run but flagged: they cannot speed up.
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 50'000));
+  const int max_threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--max-threads", 8));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 3));
+  const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+  const wm::MappingConfig mcfg;
+  const wm::PointBuffer scan = wm::bench::make_scan(n, 9.5f);
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+
+  std::cout << "map scaling: " << n << " rays/frame, " << mcfg.map_shards << " map shards, " << cores
+            << " core(s), best of " << reps << "\n";
+  double cold_1 = 0.0;
+  double warm_1 = 0.0;
+  for (int t = 1; t <= max_threads; t *= 2) {
+    wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+    rcfg.threads = t;
+
+    double t_cold = 1e30;
+    wm::RayIntegratorStats cold_stats;
+    for (int r = 0; r < reps; ++r) {
+      wm::VoxelBlockMap map(mcfg);
+      wm::RayIntegrator integrator(map, rcfg);
+      t_cold = std::min(t_cold, wm::bench::best_of(1, [&] { integrator.integrate(origin, scan.view()); }));
+      cold_stats = integrator.stats();
+    }
+
+    wm::VoxelBlockMap map(mcfg);
+    wm::RayIntegrator integrator(map, rcfg);
+    integrator.integrate(origin, scan.view());
+    const wm::RayIntegratorStats before = integrator.stats();
+    const double t_warm = wm::bench::best_of(reps, [&] { integrator.integrate(origin, scan.view()); });
+    const wm::RayIntegratorStats& after = integrator.stats();
+
+    if (t == 1) {
+      cold_1 = t_cold;
+      warm_1 = t_warm;
+    }
+    // Warm phases: averaged over the timed frames.
+    const auto phase_ms = [&](std::int64_t a, std::int64_t b) { return static_cast<double>(b - a) * 1e-6 / reps; };
+    std::cout << "  threads " << t << (t > cores ? " (oversubscribed)" : "") << "\n";
+    wm::bench::print_row("  cold frame", t_cold * 1e3, "ms");
+    wm::bench::print_row("    speedup", cold_1 / t_cold, "x");
+    wm::bench::print_row("    efficiency", cold_1 / t_cold / t * 100.0, "%");
+    wm::bench::print_row("    allocate phase", static_cast<double>(cold_stats.allocate_ns) * 1e-6, "ms");
+    wm::bench::print_row("  warm frame", t_warm * 1e3, "ms");
+    wm::bench::print_row("    speedup", warm_1 / t_warm, "x");
+    wm::bench::print_row("    efficiency", warm_1 / t_warm / t * 100.0, "%");
+    wm::bench::print_row("    traverse phase", phase_ms(before.traverse_ns, after.traverse_ns), "ms");
+    wm::bench::print_row("    apply phase", phase_ms(before.apply_ns, after.apply_ns), "ms");
+    wm::bench::print_row("    rays/s", static_cast<double>(n) / t_warm * 1e-6, "Mrays/s");
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+// File: benchmarks/throughput/bench_map_snapshot.cpp
+// Checkpoint / restore of the voxel block map through a memory-mapped snapshot, against
+// relearning it (baseline.capture_duration_ns of live input). The map is built by ray
+// casting a factory scan at the default mapping config.
+//
+//   wm_bench_map_snapshot [--rays N] [--reps R]
+//   The snapshot is written to the system temp directory and removed afterwards. Restore
+//   times are with the file in the page cache (a warm restart of the node).
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/map_snapshot.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+#include "wm/core/util/repro_hash.hpp"
+
+namespace {
+
+// Blocks of `a` missing from `b` or with different voxels or occupancy masks.
+std::size_t count_mismatches(const wm::VoxelBlockMap& a, const wm::VoxelBlockMap& b) {
+  std::size_t bad = a.num_blocks() == b.num_blocks() ? 0 : 1;
+  bad += a.count_occupied() == b.count_occupied() && a.count_known() == b.count_known() ? 0 : 1;
+  const std::size_t mask_bytes = 2 * a.mask_words() * sizeof(std::uint64_t);
+  a.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex i) {
+    const wm::BlockIndex j = b.find(k);
+    if (j == wm::kInvalidBlock || std::memcmp(a.voxels(i), b.voxels(j), a.block_bytes()) != 0 ||
+        std::memcmp(a.occupied_mask(i), b.occupied_mask(j), mask_bytes) != 0) {
+      ++bad;
+    }
+  });
+  return bad;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 20'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+
+  const wm::Config cfg;
+  const wm::MappingConfig& mcfg = cfg.mapping;
+  const wm::VoxelBlockMapParams params = wm::VoxelBlockMapParams::from_config(mcfg);
+  const wm::MapSnapshotKey key = wm::MapSnapshotKey::from_config(cfg);
+  const std::string path = (std::filesystem::temp_directory_path() / "wm_bench_map_snapshot.wmmap").string();
+
+  wm::VoxelBlockMap map(params);
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = 1;
+  {
+    wm::RayIntegrator integrator(map, rcfg);
+    integrator.integrate(wm::Vec3f{0.0f, 0.0f, 1.0f}, wm::bench::make_scan(n, 9.5f, 1).view());
+  }
+
+  wm::Status st;
+  const double t_save = wm::bench::best_of(reps, [&] { st = wm::save_map_snapshot(map, key, path); });
+  if (!st.ok()) {
+    std::cerr << "save failed: " << st.message() << "\n";
+    return 1;
+  }
+  const double file_mib = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+  double t_load = 1e30;
+  double t_touch = 1e30;
+  volatile float sink = 0.0f;
+  for (int r = 0; r < reps; ++r) {
+    std::optional<wm::VoxelBlockMap> restored;
+    t_load = std::min(t_load, wm::bench::best_of(1, [&] {
+      auto res = wm::load_map_snapshot(path, key, params);
+      if (res.ok()) restored.emplace(res.take_value());
+      st = res.status();
+    }));
+    if (!restored) {
+      std::cerr << "load failed: " << st.message() << "\n";
+      return 1;
+    }
+    // First read of every block: page faults on the mapping.
+    t_touch = std::min(t_touch, wm::bench::best_of(1, [&] {
+      float s = 0.0f;
+      restored->for_each_block([&](const wm::BlockKey&, wm::BlockIndex b) { s += static_cast<float>(restored->cell(b, 0)); });
+      sink = s;
+    }));
+  }
+
+  // Restored map equals the original, and keeps integrating identically (copy-on-write).
+  auto restored = wm::load_map_snapshot(path, key, params);
+  std::size_t bad = restored.ok() ? count_mismatches(map, *restored) : 1;
+  if (restored.ok()) {
+    const wm::PointBuffer next = wm::bench::make_scan(n / 4, 9.5f, 2);
+    wm::RayIntegrator(map, rcfg).integrate(wm::Vec3f{0.5f, 0.0f, 1.0f}, next.view());
+    wm::RayIntegrator(*restored, rcfg).integrate(wm::Vec3f{0.5f, 0.0f, 1.0f}, next.view());
+    bad += count_mismatches(map, *restored);
+  }
+
+  // A snapshot from another calibration must be refused.
+  wm::MapSnapshotKey stale = key;
+  stale.calibration_hash = "0000000000000000";
+  const bool stale_rejected = !wm::load_map_snapshot(path, stale, params).ok();
+  std::filesystem::remove(path);
+
+  const double capture_ms = static_cast<double>(cfg.baseline.capture_duration_ns) * 1e-6;
+  std::cout << "map snapshot: " << map.num_blocks() << " blocks (" << n << " rays), file " << file_mib
+            << " MiB, best of " << reps << "\n";
+  wm::bench::print_row("save", t_save * 1e3, "ms");
+  wm::bench::print_row("  write rate", file_mib / t_save, "MiB/s");
+  wm::bench::print_row("restore (map + rebuild tables)", t_load * 1e3, "ms");
+  wm::bench::print_row("first touch of every block", t_touch * 1e3, "ms");
+  wm::bench::print_row("relearn (baseline capture)", capture_ms, "ms");
+  wm::bench::print_row("  restore speedup", capture_ms / (t_load * 1e3), "x");
+  if (bad != 0) std::cout << "  WARNING: restored map differs from the original (" << bad << " blocks)\n";
+  if (!stale_rejected) std::cout << "  WARNING: stale snapshot was accepted\n";
+  return 0;
+}
@@ -0,0 +1,107 @@
+// File: benchmarks/throughput/bench_multires_map.cpp
+// Single-resolution vs range-banded multi-resolution ray integration on a large hall:
+// a factory scan out to --range metres from a sensor 2.5 m above the floor, with the ROI
+// opened up to hold the whole hall. Reports map memory, DDA steps and time per frame, and
+// near-field fidelity: how many probes within lod_near_m classify the same in both maps
+// (returns plus random points in the level-0 band).
+//
+//   wm_bench_multires_map [--rays N] [--range M] [--levels L] [--near M] [--reps R]
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <random>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/multires_map.hpp"
+
+namespace {
+
+struct Row {
+  double seconds{0.0};
+  wm::RayIntegratorStats stats;
+  wm::VoxelBlockMapStats map;
+};
+
+Row run(const wm::MultiResMapParams& params, const wm::RayIntegratorConfig& rcfg, const wm::Vec3f& origin,
+        const wm::PointBuffer& scan, int reps, std::optional<wm::MultiResMap>& out) {
+  Row row;
+  row.seconds = 1e30;
+  for (int r = 0; r < reps; ++r) {
+    out.emplace(params);
+    wm::MultiResIntegrator integrator(*out, rcfg);
+    row.seconds = std::min(row.seconds, wm::bench::best_of(1, [&] { integrator.integrate(origin, scan.view()); }));
+    row.stats = integrator.stats();
+  }
+  row.map = out->stats();
+  return row;
+}
+
+void print(const char* name, const Row& row, std::size_t rays) {
+  std::cout << "  " << name << "\n";
+  wm::bench::print_row("  map memory", static_cast<double>(row.map.memory_bytes) / (1024.0 * 1024.0), "MiB");
+  wm::bench::print_row("  blocks", static_cast<double>(row.map.blocks), "");
+  wm::bench::print_row("  voxel steps / ray", static_cast<double>(row.stats.voxel_steps) / static_cast<double>(rays), "");
+  wm::bench::print_row("  frame", row.seconds * 1e3, "ms");
+  wm::bench::print_row("  rays/s", static_cast<double>(rays) / row.seconds * 1e-3, "krays/s");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 4'000));
+  const float range = static_cast<float>(wm::bench::arg_i64(argc, argv, "--range", 30));
+  const int levels = static_cast<int>(wm::bench::arg_i64(argc, argv, "--levels", 3));
+  const float near_m = static_cast<float>(wm::bench::arg_i64(argc, argv, "--near", 10));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 3));
+
+  wm::MappingConfig mcfg;
+  mcfg.roi.min = wm::Vec3f{-range - 2.0f, -range - 2.0f, -2.0f};
+  mcfg.roi.max = wm::Vec3f{range + 2.0f, range + 2.0f, 5.0f};
+  mcfg.max_range_m = 2.0f * range;
+  mcfg.lod_near_m = near_m;
+  const wm::PointBuffer scan = wm::bench::make_scan(n, range);
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = 1;
+
+  mcfg.lod_levels = 1;
+  std::optional<wm::MultiResMap> single;
+  const Row a = run(wm::MultiResMapParams::from_config(mcfg), rcfg, origin, scan, reps, single);
+  mcfg.lod_levels = levels;
+  std::optional<wm::MultiResMap> multi;
+  const Row b = run(wm::MultiResMapParams::from_config(mcfg), rcfg, origin, scan, reps, multi);
+
+  // Near-field fidelity. Bands are centred on the map origin, as the node uses them.
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> u(-near_m, near_m);
+  std::size_t probes = 0;
+  std::size_t same = 0;
+  const auto probe = [&](const wm::Vec3f& p) {
+    if (multi->level_of(p) != 0) return;
+    ++probes;
+    same += single->state(p) == multi->state(p) ? 1 : 0;
+  };
+  for (std::size_t i = 0; i < scan.size(); ++i) {
+    const wm::PointXYZI p = scan.view().at(i);
+    probe(wm::Vec3f{p.x, p.y, p.z});
+  }
+  for (int i = 0; i < 200'000; ++i) probe(wm::Vec3f{u(rng), u(rng), 0.35f * u(rng)});
+
+  std::cout << "multires map: " << n << " rays to " << range << " m, " << levels << " levels (near " << near_m
+            << " m, voxel " << mcfg.voxel_size_m * 100.0f << " cm doubling), best of " << reps << "\n";
+  print("single resolution", a, n);
+  print("multi resolution", b, n);
+  for (int l = 0; l < multi->num_levels(); ++l) {
+    const wm::VoxelBlockMapStats s = multi->level(l).stats();
+    std::cout << "    level " << l << " [" << multi->band_min_m(l) << ", " << multi->band_max_m(l) << ") m, "
+              << multi->level(l).voxel_size() * 100.0f << " cm: " << s.blocks << " blocks, "
+              << static_cast<double>(s.memory_bytes) / (1024.0 * 1024.0) << " MiB\n";
+  }
+  std::cout << "  gain\n";
+  wm::bench::print_row("  memory", static_cast<double>(a.map.memory_bytes) / static_cast<double>(b.map.memory_bytes), "x");
+  wm::bench::print_row("  voxel steps", static_cast<double>(a.stats.voxel_steps) / static_cast<double>(b.stats.voxel_steps), "x");
+  wm::bench::print_row("  frame time", a.seconds / b.seconds, "x");
+  wm::bench::print_row("  near-field agreement", 100.0 * static_cast<double>(same) / static_cast<double>(probes), "%");
+  return 0;
+}
@@ -0,0 +1,119 @@
+// File: benchmarks/throughput/bench_occupancy_scan.cpp
+// Occupancy scans over a factory-hall map: the sensor integrates a hall scan per metre
+// along --distance metres (ROI opened up to hold all of it), then the map is scanned the
+// way change detection and clustering would: count occupied and known voxels, and visit
+// every occupied voxel. Per-voxel iteration (classify every cell of every block) is
+// compared with the occupancy bitmasks (region summary word, block mask words, popcount).
+// Both must find the same voxels.
+//
+//   wm_bench_occupancy_scan [--rays N] [--distance M] [--reps R] [--threads T]
+#include <cmath>
+#include <iostream>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+namespace {
+
+struct Counts {
+  std::size_t occupied{0};
+  std::size_t known{0};
+  double centre_sum{0.0};  // over occupied voxel centres, so the visit is not optimised out
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 10'000));
+  const int distance = static_cast<int>(wm::bench::arg_i64(argc, argv, "--distance", 20));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+  const int threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--threads", 0));
+
+  wm::MappingConfig mcfg;
+  mcfg.roi.min = wm::Vec3f{-20.0f, -20.0f, -2.0f};
+  mcfg.roi.max = wm::Vec3f{static_cast<float>(distance) + 20.0f, 20.0f, 5.0f};
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = threads;
+  const wm::PointBuffer scan = wm::bench::make_scan(rays, 9.5f);
+
+  wm::VoxelBlockMap map(mcfg);
+  wm::RayIntegrator integrator(map, rcfg);
+  wm::PointBuffer moved;
+  for (int f = 0; f <= distance; ++f) {
+    const auto x = static_cast<float>(f);
+    moved.clear();
+    for (std::size_t i = 0; i < scan.size(); ++i) {
+      const wm::PointXYZI p = scan.view().at(i);
+      moved.push_back(p.x + x, p.y, p.z, p.intensity);
+    }
+    integrator.integrate(wm::Vec3f{x, 0.0f, 1.0f}, moved.view());
+  }
+
+  const wm::LogOddsModel& model = map.log_odds_model();
+  const std::size_t vpb = map.voxels_per_block();
+
+  Counts per_voxel_count;
+  const double t_voxel_count = wm::bench::best_of(reps, [&] {
+    per_voxel_count = Counts{};
+    map.for_each_block([&](const wm::BlockKey&, wm::BlockIndex b) {
+      for (std::uint32_t v = 0; v < vpb; ++v) {
+        const wm::VoxelState s = model.classify(map.cell(b, v));
+        per_voxel_count.occupied += s == wm::VoxelState::kOccupied ? 1 : 0;
+        per_voxel_count.known += s != wm::VoxelState::kUnknown ? 1 : 0;
+      }
+    });
+  });
+  Counts mask_count;
+  const double t_mask_count = wm::bench::best_of(reps, [&] {
+    mask_count.occupied = map.count_occupied();
+    mask_count.known = map.count_known();
+  });
+
+  Counts per_voxel_visit;
+  const double t_voxel_visit = wm::bench::best_of(reps, [&] {
+    per_voxel_visit = Counts{};
+    map.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex b) {
+      for (std::uint32_t v = 0; v < vpb; ++v) {
+        if (model.classify(map.cell(b, v)) != wm::VoxelState::kOccupied) continue;
+        const wm::Vec3f c = map.voxel_center(k, v);
+        per_voxel_visit.centre_sum += static_cast<double>(c.x + c.y + c.z);
+        ++per_voxel_visit.occupied;
+      }
+    });
+  });
+  Counts mask_visit;
+  const double t_mask_visit = wm::bench::best_of(reps, [&] {
+    mask_visit = Counts{};
+    map.for_each_occupied_voxel([&](const wm::BlockKey& k, wm::BlockIndex, std::uint32_t v) {
+      const wm::Vec3f c = map.voxel_center(k, v);
+      mask_visit.centre_sum += static_cast<double>(c.x + c.y + c.z);
+      ++mask_visit.occupied;
+    });
+  });
+
+  const wm::VoxelBlockMapStats st = map.stats();
+  std::cout << "occupancy scans: " << distance + 1 << " hall scans of " << rays << " rays, " << st.blocks
+            << " blocks (" << st.blocks * vpb / 1000000 << " M voxels, " << map.log_odds_model().bits
+            << "-bit cells)\n";
+  wm::bench::print_row("occupied voxels", static_cast<double>(mask_count.occupied), "");
+  wm::bench::print_row("known voxels", static_cast<double>(mask_count.known), "");
+  std::size_t occupied_blocks = 0;
+  map.for_each_occupied_block([&](const wm::BlockKey&, wm::BlockIndex) { ++occupied_blocks; });
+  wm::bench::print_row("blocks with an occupied voxel", 100.0 * static_cast<double>(occupied_blocks) /
+                                                            static_cast<double>(st.blocks), "%");
+  std::cout << "  count occupied + known\n";
+  wm::bench::print_row("  per voxel", t_voxel_count * 1e3, "ms");
+  wm::bench::print_row("  bitmasks", t_mask_count * 1e3, "ms");
+  wm::bench::print_row("  speed-up", t_voxel_count / t_mask_count, "x");
+  std::cout << "  visit occupied voxels\n";
+  wm::bench::print_row("  per voxel", t_voxel_visit * 1e3, "ms");
+  wm::bench::print_row("  bitmasks", t_mask_visit * 1e3, "ms");
+  wm::bench::print_row("  speed-up", t_voxel_visit / t_mask_visit, "x");
+  const bool same = per_voxel_count.occupied == mask_count.occupied && per_voxel_count.known == mask_count.known &&
+                    per_voxel_visit.occupied == mask_visit.occupied &&
+                    std::fabs(per_voxel_visit.centre_sum - mask_visit.centre_sum) <=
+                        1e-9 * std::fabs(per_voxel_visit.centre_sum);  // summed in another order
+  std::cout << "  results " << (same ? "identical" : "DIFFER") << "\n";
+  return same ? 0 : 1;
+}
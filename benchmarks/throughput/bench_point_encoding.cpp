@@ -0,0 +1,79 @@
+// File: benchmarks/throughput/bench_point_encoding.cpp
+// Float32 vs quantized (int16 xyz + uint8 intensity) point transport:
+// bytes/point and decode throughput into SoA lanes.
+//
+//   wm_bench_point_encoding [--points N] [--reps R]
+//   WM_DISABLE_AVX2=1 wm_bench_point_encoding   # scalar decode path
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/io/quantized_points.hpp"
+#include "wm/core/util/simd.hpp"
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points", 2'000'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 10));
+
+  const wm::PointBuffer src = wm::bench::make_scan(n, 50.0f);
+  const wm::ConstPointView sv = src.view();
+
+  // Interleaved AoS copy, as stored in .bin frame files.
+  std::vector<float> aos(4 * n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const wm::PointXYZI p = sv.at(i);
+    aos[4 * i + 0] = p.x;
+    aos[4 * i + 1] = p.y;
+    aos[4 * i + 2] = p.z;
+    aos[4 * i + 3] = p.intensity;
+  }
+
+  // Quantized lanes, as stored in .qbin / kQuant16 records.
+  const wm::QuantizationParams qp = wm::choose_quantization(sv);
+  std::vector<std::int16_t> qx(n), qy(n), qz(n);
+  std::vector<std::uint8_t> qi(n);
+  wm::quantize_points(sv, qp, qx.data(), qy.data(), qz.data(), qi.data());
+  const wm::QuantizedPointsView qv{qx.data(), qy.data(), qz.data(), qi.data(), n, qp};
+
+  wm::PointBuffer out;
+  out.reserve(n);
+
+  const double t_aos = wm::bench::best_of(reps, [&] {
+    out.clear();
+    out.append(wm::ConstPointView{aos.data(), aos.data() + 1, aos.data() + 2, aos.data() + 3, n, 4});
+  });
+  const double t_soa = wm::bench::best_of(reps, [&] {
+    out.clear();
+    out.append(sv);
+  });
+  const double t_q16 = wm::bench::best_of(reps, [&] { wm::dequantize_points(qv, out); });
+
+  double max_err = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const wm::PointXYZI a = sv.at(i);
+    const wm::PointXYZI b = out.at(i);
+    max_err = std::max({max_err, static_cast<double>(std::abs(a.x - b.x)),
+                        static_cast<double>(std::abs(a.y - b.y)),
+                        static_cast<double>(std::abs(a.z - b.z))});
+  }
+
+  const double mpts = static_cast<double>(n) * 1e-6;
+  const auto gbps = [&](double bytes_per_point, double t) {
+    return static_cast<double>(n) * bytes_per_point / t * 1e-9;
+  };
+
+  std::cout << "point encoding: " << n << " points, best of " << reps
+            << " (decode path: " << (wm::cpu_has_avx2() ? "avx2" : "scalar") << ")\n";
+  wm::bench::print_row("float32 bytes/point", 16.0, "B");
+  wm::bench::print_row("q16 bytes/point", static_cast<double>(wm::kQuantizedBytesPerPoint), "B");
+  wm::bench::print_row("float32 AoS -> SoA de-interleave", mpts / t_aos, "Mpts/s");
+  wm::bench::print_row("  input bandwidth", gbps(16.0, t_aos), "GB/s");
+  wm::bench::print_row("float32 SoA -> SoA copy", mpts / t_soa, "Mpts/s");
+  wm::bench::print_row("  input bandwidth", gbps(16.0, t_soa), "GB/s");
+  wm::bench::print_row("q16 -> float32 SoA decode", mpts / t_q16, "Mpts/s");
+  wm::bench::print_row("  input bandwidth", gbps(static_cast<double>(wm::kQuantizedBytesPerPoint), t_q16), "GB/s");
+  wm::bench::print_row("q16 max abs xyz error", max_err * 1000.0, "mm");
+  return 0;
+}
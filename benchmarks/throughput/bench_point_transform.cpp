@@ -0,0 +1,79 @@
+// File: benchmarks/throughput/bench_point_transform.cpp
+// Batch lidar -> site transform (one fused T_site_lidar per point) per SIMD tier, single
+// thread, so the Mpts/s figures are per core.
+//
+//   wm_bench_point_transform [--points N] [--reps R]
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "bench_util.hpp"
+#include "wm/core/geom/point_transform.hpp"
+#include "wm/core/util/simd.hpp"
+
+namespace {
+
+wm::TransformSE3 make_extrinsics(float yaw, float pitch, float tx, float ty, float tz) {
+  const float cy = std::cos(yaw), sy = std::sin(yaw);
+  const float cp = std::cos(pitch), sp = std::sin(pitch);
+  wm::TransformSE3 T;
+  T.m = {cy * cp, -sy, cy * sp, tx,  //
+         sy * cp, cy,  sy * sp, ty,  //
+         -sp,     0,   cp,      tz,  //
+         0,       0,   0,       1};
+  return T;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points", 2'000'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 10));
+
+  const wm::PointBuffer src = wm::bench::make_scan(n, 50.0f);
+  const wm::TransformSE3 T_node_lidar = make_extrinsics(0.3f, -0.2f, 0.1f, 0.0f, 2.5f);
+  const wm::TransformSE3 T_site_node = make_extrinsics(1.2f, 0.0f, 40.0f, -12.0f, 0.0f);
+  const wm::TransformSE3 T_site_lidar = wm::compose(T_site_node, T_node_lidar);
+
+  std::cout << "point transform: " << n << " points, best of " << reps
+            << " (best tier: " << wm::simd_level_name(wm::best_simd_level()) << ")\n";
+
+  wm::PointBuffer reference;
+  wm::transform_points(T_site_lidar, src.view(), reference, wm::SimdLevel::kScalar);
+
+  wm::PointBuffer out;
+  out.reserve(n);
+  const double mpts = static_cast<double>(n) * 1e-6;
+  for (const wm::SimdLevel level : {wm::SimdLevel::kScalar, wm::SimdLevel::kSse2, wm::SimdLevel::kAvx2}) {
+    if (wm::clamp_simd_level(level) != level) continue;
+    const std::string name = wm::simd_level_name(level);
+
+    const double t_copy = wm::bench::best_of(reps, [&] {
+      wm::transform_points(T_site_lidar, src.view(), out, level);
+    });
+    const bool same = std::memcmp(out.view().x, reference.view().x, n * sizeof(float)) == 0 &&
+                      std::memcmp(out.view().y, reference.view().y, n * sizeof(float)) == 0 &&
+                      std::memcmp(out.view().z, reference.view().z, n * sizeof(float)) == 0;
+
+    // In place on a warm buffer (the stage-local case): re-applying T each rep is fine for timing.
+    wm::PointBuffer work = src;
+    const double t_inplace = wm::bench::best_of(reps, [&] {
+      wm::transform_points(T_site_lidar, work.mutable_view(), level);
+    });
+
+    wm::bench::print_row(name + " out-of-place", mpts / t_copy, "Mpts/s");
+    wm::bench::print_row(name + " in place", mpts / t_inplace, "Mpts/s");
+    wm::bench::print_row(name + " 2M pts/s core load", 2.0 / (mpts / t_inplace) * 100.0, "%");
+    if (!same) std::cout << "  WARNING: " << name << " differs from the scalar reference\n";
+  }
+
+  // The two-matrix path the fused transform replaces.
+  wm::PointBuffer work = src;
+  const double t_two = wm::bench::best_of(reps, [&] {
+    wm::transform_points(T_node_lidar, work.mutable_view());
+    wm::transform_points(T_site_node, work.mutable_view());
+  });
+  wm::bench::print_row("unfused (two passes, best tier)", mpts / t_two, "Mpts/s");
+  return 0;
+}
@@ -0,0 +1,88 @@
+// File: benchmarks/throughput/bench_range_gate.cpp
+// Range / ROI input gating per SIMD tier, single thread, against a plain copy of the same
+// lanes (the memory-bandwidth ceiling for a stage that reads and writes every point).
+//
+//   wm_bench_range_gate [--points N] [--reps R]
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "bench_util.hpp"
+#include "wm/core/preprocess/range_gate.hpp"
+#include "wm/core/util/simd.hpp"
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points", 4'000'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 10));
+
+  // Returns out to 15 m around a sensor 1 m above the node origin; the default ROI
+  // (20 x 20 x 7 m) cuts a good share of them, so the compaction path is exercised.
+  const wm::PointBuffer src = wm::bench::make_scan(n, 15.0f);
+  const wm::MappingConfig mcfg;
+  const wm::RangeGateParams params = wm::RangeGateParams::from_config(mcfg);
+  wm::TransformSE3 T_node_lidar;
+  T_node_lidar.m[11] = 1.0f;
+
+  std::cout << "range gate: " << n << " points, best of " << reps
+            << " (best tier: " << wm::simd_level_name(wm::best_simd_level()) << ")\n";
+
+  wm::PointBuffer reference;
+  const wm::RangeGateStats ref =
+      wm::range_gate(params, T_node_lidar, src.view(), reference, wm::SimdLevel::kScalar);
+  const double in_n = static_cast<double>(ref.input);
+  wm::bench::print_row("kept", 100.0 * static_cast<double>(ref.kept) / in_n, "%");
+  wm::bench::print_row("rejected min_range", 100.0 * static_cast<double>(ref.rejected_min_range) / in_n, "%");
+  wm::bench::print_row("rejected max_range", 100.0 * static_cast<double>(ref.rejected_max_range) / in_n, "%");
+  wm::bench::print_row("rejected roi", 100.0 * static_cast<double>(ref.rejected_roi) / in_n, "%");
+
+  const double mpts = static_cast<double>(n) * 1e-6;
+  // Bytes moved: four lanes read, four lanes written for the survivors.
+  const double gbytes = (16.0 * static_cast<double>(n) + 16.0 * static_cast<double>(ref.kept)) * 1e-9;
+
+  wm::PointBuffer out;
+  out.reserve(n);
+  const wm::ConstPointView sv = src.view();
+  const double t_copy = wm::bench::best_of(reps, [&] {
+    out.resize(n);
+    const wm::PointView ov = out.mutable_view();
+    std::memcpy(ov.x, sv.x, n * sizeof(float));
+    std::memcpy(ov.y, sv.y, n * sizeof(float));
+    std::memcpy(ov.z, sv.z, n * sizeof(float));
+    std::memcpy(ov.intensity, sv.intensity, n * sizeof(float));
+  });
+  wm::bench::print_row("copy 4 lanes (reference)", 32.0 * static_cast<double>(n) * 1e-9 / t_copy, "GB/s");
+
+  for (const wm::SimdLevel level : {wm::SimdLevel::kScalar, wm::SimdLevel::kSse2, wm::SimdLevel::kAvx2}) {
+    if (wm::clamp_simd_level(level) != level) continue;
+    const std::string name = wm::simd_level_name(level);
+
+    wm::RangeGateStats s;
+    const double t = wm::bench::best_of(reps, [&] { s = wm::range_gate(params, T_node_lidar, sv, out, level); });
+    const bool same = s.kept == ref.kept && s.rejected_min_range == ref.rejected_min_range &&
+                      s.rejected_max_range == ref.rejected_max_range && s.rejected_roi == ref.rejected_roi &&
+                      std::memcmp(out.view().x, reference.view().x, s.kept * sizeof(float)) == 0 &&
+                      std::memcmp(out.view().y, reference.view().y, s.kept * sizeof(float)) == 0 &&
+                      std::memcmp(out.view().z, reference.view().z, s.kept * sizeof(float)) == 0 &&
+                      std::memcmp(out.view().intensity, reference.view().intensity, s.kept * sizeof(float)) == 0;
+
+    // In place, as wm_node runs it; the copy back into the work buffer is timed separately.
+    wm::PointBuffer work;
+    work.reserve(n);
+    const double t_inplace_total = wm::bench::best_of(reps, [&] {
+      work.resize(n);
+      const wm::PointView wv = work.mutable_view();
+      std::memcpy(wv.x, sv.x, n * sizeof(float));
+      std::memcpy(wv.y, sv.y, n * sizeof(float));
+      std::memcpy(wv.z, sv.z, n * sizeof(float));
+      std::memcpy(wv.intensity, sv.intensity, n * sizeof(float));
+      (void)wm::range_gate(params, T_node_lidar, work, level);
+    });
+    const double t_inplace = std::max(t_inplace_total - t_copy, 1e-9);
+
+    wm::bench::print_row(name + " out-of-place", mpts / t, "Mpts/s");
+    wm::bench::print_row(name + " out-of-place", gbytes / t, "GB/s");
+    wm::bench::print_row(name + " in place (minus refill)", mpts / t_inplace, "Mpts/s");
+    if (!same) std::cout << "  WARNING: " << name << " differs from the scalar reference\n";
+  }
+  return 0;
+}
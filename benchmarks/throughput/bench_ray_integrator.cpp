@@ -0,0 +1,49 @@
+// File: benchmarks/throughput/bench_ray_integrator.cpp
+// Free-space ray casting (3D-DDA) into the voxel block map at the default mapping config
+// (2 cm voxels, 20x20x7 m ROI) from a sensor 2.5 m above the floor.
+//
+//   wm_bench_ray_integrator [--rays N] [--threads T] [--reps R]
+//   --threads 0 uses all cores; the rays/s per core figure divides by the thread count.
+#include <iostream>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 200'000));
+  const int threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--threads", 1));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+
+  const wm::MappingConfig mcfg;
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = threads;
+
+  const wm::PointBuffer scan = wm::bench::make_scan(n, 9.5f);
+  const wm::Vec3f origin{0.0f, 0.0f, 1.0f};
+
+  wm::VoxelBlockMap map(mcfg);
+  wm::RayIntegrator integrator(map, rcfg);
+
+  // First scan allocates the blocks; later ones measure steady-state integration.
+  const double t_cold = wm::bench::best_of(1, [&] { integrator.integrate(origin, scan.view()); });
+  const double t_warm = wm::bench::best_of(reps, [&] { integrator.integrate(origin, scan.view()); });
+
+  const wm::RayIntegratorStats& s = integrator.stats();
+  const double passes = 1.0 + reps;
+  const double steps_per_ray = static_cast<double>(s.voxel_steps) / static_cast<double>(s.rays - s.rays_skipped);
+  const double rays_per_s = static_cast<double>(n) / t_warm;
+
+  std::cout << "ray integrator: " << n << " rays/scan, " << integrator.threads() << " thread(s), voxel "
+            << mcfg.voxel_size_m * 100.0f << " cm, best of " << reps << "\n";
+  wm::bench::print_row("voxel steps per ray (avg)", steps_per_ray, "");
+  wm::bench::print_row("cold scan (allocating blocks)", static_cast<double>(n) / t_cold * 1e-6, "Mrays/s");
+  wm::bench::print_row("warm scan", rays_per_s * 1e-6, "Mrays/s");
+  wm::bench::print_row("  per core", rays_per_s / integrator.threads() * 1e-6, "Mrays/s");
+  wm::bench::print_row("  voxel steps", rays_per_s * steps_per_ray * 1e-6, "Msteps/s");
+  wm::bench::print_row("voxel updates per scan",
+                       static_cast<double>(s.hits + s.misses) / passes, "");
+  wm::bench::print_row("blocks", static_cast<double>(map.num_blocks()), "");
+  wm::bench::print_row("map memory", static_cast<double>(map.stats().memory_bytes) / (1024.0 * 1024.0), "MiB");
+  return 0;
+}
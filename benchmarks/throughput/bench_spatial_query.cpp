@@ -0,0 +1,181 @@
+// File: benchmarks/throughput/bench_spatial_query.cpp
+// Batch spatial queries on an occupancy snapshot against per-voxel map lookups, over a map
+// built from --scans factory-hall scans at the default mapping config:
+// - point states: VoxelBlockMap::state per point (hash probe), OccupancySnapshot::state
+//   per point (binary search) and SpatialQuery::states per batch (sorted merge);
+// - boxes (robot-footprint sized, 0.2-0.6 m): state of every voxel via the map against
+//   SpatialQuery::boxes (mask popcounts), plus collecting their occupied voxels;
+// - concurrency: an integrating thread publishes a snapshot after every scan while a
+//   query thread answers box batches against the latest one.
+// Counts must match the per-voxel answers exactly.
+//
+//   wm_bench_spatial_query [--rays N] [--scans S] [--points N] [--boxes N] [--reps R]
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+#include "wm/core/mapping/spatial_query.hpp"
+
+namespace {
+
+constexpr double kMiB = 1024.0 * 1024.0;
+
+// Voxel counts of `box` from one map lookup per voxel (same coverage rule as
+// SpatialQuery::boxes: voxels the box intersects, max exclusive).
+wm::BoxQueryResult box_by_voxels(const wm::VoxelBlockMap& map, const wm::AABB& box) {
+  const float v = map.voxel_size();
+  wm::BoxQueryResult r;
+  const auto lo = [&](float x) { return static_cast<std::int32_t>(std::floor(x / v)); };
+  const auto hi = [&](float x) { return static_cast<std::int32_t>(std::ceil(x / v)) - 1; };
+  for (std::int32_t z = lo(box.min.z); z <= hi(box.max.z); ++z) {
+    for (std::int32_t y = lo(box.min.y); y <= hi(box.max.y); ++y) {
+      for (std::int32_t x = lo(box.min.x); x <= hi(box.max.x); ++x) {
+        const wm::VoxelState s = map.state(wm::Vec3f{(static_cast<float>(x) + 0.5f) * v,
+                                                     (static_cast<float>(y) + 0.5f) * v,
+                                                     (static_cast<float>(z) + 0.5f) * v});
+        ++r.voxels;
+        r.known += s != wm::VoxelState::kUnknown ? 1 : 0;
+        r.occupied += s == wm::VoxelState::kOccupied ? 1 : 0;
+      }
+    }
+  }
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto rays = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--rays", 20'000));
+  const int scans = static_cast<int>(wm::bench::arg_i64(argc, argv, "--scans", 5));
+  const auto num_points = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points", 1'000'000));
+  const auto num_boxes = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--boxes", 2'000));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 3));
+
+  const wm::MappingConfig mcfg;
+  wm::RayIntegratorConfig rcfg = wm::RayIntegratorConfig::from_config(mcfg);
+  rcfg.threads = 1;
+  wm::VoxelBlockMap map(mcfg);
+  wm::RayIntegrator integrator(map, rcfg);
+  std::vector<wm::PointBuffer> frames;
+  for (int s = 0; s < scans; ++s) {
+    frames.push_back(wm::bench::make_scan(rays, 9.5f, static_cast<std::uint32_t>(s + 1)));
+  }
+  const auto origin = [](int s) { return wm::Vec3f{0.5f * static_cast<float>(s % 5) - 1.0f, 0.0f, 1.0f}; };
+  for (int s = 0; s < scans; ++s) integrator.integrate(origin(s), frames[static_cast<std::size_t>(s)].view());
+
+  std::shared_ptr<const wm::OccupancySnapshot> snap;
+  const double t_capture = wm::bench::best_of(reps, [&] { snap = wm::OccupancySnapshot::capture(map); });
+  std::cout << "spatial queries: map of " << map.num_blocks() << " blocks (" << scans << " scans of " << rays
+            << " rays), best of " << reps << "\n";
+  wm::bench::print_row("map memory", static_cast<double>(map.stats().memory_bytes) / kMiB, "MiB");
+  wm::bench::print_row("snapshot memory", static_cast<double>(snap->memory_bytes()) / kMiB, "MiB");
+  wm::bench::print_row("snapshot capture", t_capture * 1e3, "ms");
+
+  // Points: uniform over the ROI (mostly free and unknown space, like planner probes).
+  std::mt19937 rng(11);
+  const wm::RoiConfig& roi = mcfg.roi;
+  std::uniform_real_distribution<float> ux(roi.min.x, roi.max.x);
+  std::uniform_real_distribution<float> uy(roi.min.y, roi.max.y);
+  std::uniform_real_distribution<float> uz(roi.min.z, roi.max.z);
+  std::vector<wm::Vec3f> points(num_points);
+  for (auto& p : points) p = wm::Vec3f{ux(rng), uy(rng), uz(rng)};
+  std::vector<wm::VoxelState> by_map(num_points);
+  std::vector<wm::VoxelState> by_snapshot(num_points);
+  std::vector<wm::VoxelState> by_batch(num_points);
+  wm::SpatialQuery query;
+  const double t_map = wm::bench::best_of(reps, [&] {
+    for (std::size_t i = 0; i < num_points; ++i) by_map[i] = map.state(points[i]);
+  });
+  const double t_single = wm::bench::best_of(reps, [&] {
+    for (std::size_t i = 0; i < num_points; ++i) by_snapshot[i] = snap->state(points[i]);
+  });
+  const double t_batch = wm::bench::best_of(reps, [&] { query.states(*snap, points, by_batch); });
+  std::size_t point_mismatches = 0;
+  for (std::size_t i = 0; i < num_points; ++i) {
+    point_mismatches += (by_map[i] != by_batch[i] ? 1 : 0) + (by_snapshot[i] != by_batch[i] ? 1 : 0);
+  }
+  const double n = static_cast<double>(num_points);
+  std::cout << "  " << num_points << " point queries\n";
+  wm::bench::print_row("  map state per point (hash)", t_map / n * 1e9, "ns/point");
+  wm::bench::print_row("  snapshot state per point", t_single / n * 1e9, "ns/point");
+  wm::bench::print_row("  snapshot batch (sorted merge)", t_batch / n * 1e9, "ns/point");
+  wm::bench::print_row("  batch speedup vs map", t_map / t_batch, "x");
+  wm::bench::print_row("  mismatches", static_cast<double>(point_mismatches), "");
+
+  // Boxes: footprint-sized, anywhere in the ROI.
+  std::uniform_real_distribution<float> side(0.2f, 0.6f);
+  std::vector<wm::AABB> boxes(num_boxes);
+  for (auto& b : boxes) {
+    b.min = wm::Vec3f{ux(rng), uy(rng), uz(rng)};
+    b.max = wm::Vec3f{b.min.x + side(rng), b.min.y + side(rng), b.min.z + side(rng)};
+  }
+  std::vector<wm::BoxQueryResult> ref(num_boxes);
+  std::vector<wm::BoxQueryResult> got(num_boxes);
+  std::vector<wm::OccupiedVoxel> occupied;
+  const double t_voxels = wm::bench::best_of(1, [&] {
+    for (std::size_t i = 0; i < num_boxes; ++i) ref[i] = box_by_voxels(map, boxes[i]);
+  });
+  const double t_boxes = wm::bench::best_of(reps, [&] { query.boxes(*snap, boxes, got); });
+  const double t_collect = wm::bench::best_of(reps, [&] {
+    occupied.clear();
+    query.boxes(*snap, boxes, got, &occupied);
+  });
+  std::size_t box_mismatches = 0;
+  std::uint64_t voxels = 0;
+  std::uint64_t occupied_total = 0;
+  std::size_t free_boxes = 0;
+  for (std::size_t i = 0; i < num_boxes; ++i) {
+    box_mismatches += ref[i].voxels != got[i].voxels || ref[i].known != got[i].known ||
+                              ref[i].occupied != got[i].occupied
+                          ? 1
+                          : 0;
+    voxels += got[i].voxels;
+    occupied_total += got[i].occupied;
+    free_boxes += got[i].all_free() ? 1 : 0;
+  }
+  box_mismatches += occupied.size() != occupied_total ? 1 : 0;
+  const double nb = static_cast<double>(num_boxes);
+  std::cout << "  " << num_boxes << " box queries (" << static_cast<double>(voxels) / nb << " voxels per box, "
+            << free_boxes << " all free)\n";
+  wm::bench::print_row("  map state per voxel", t_voxels / nb * 1e6, "us/box");
+  wm::bench::print_row("  snapshot batch, counts", t_boxes / nb * 1e6, "us/box");
+  wm::bench::print_row("  snapshot batch, + occupied voxels", t_collect / nb * 1e6, "us/box");
+  wm::bench::print_row("  batch speedup vs per voxel", t_voxels / t_boxes, "x");
+  wm::bench::print_row("  mismatches", static_cast<double>(box_mismatches), "");
+
+  // Integration and queries on separate threads, handing snapshots over.
+  wm::OccupancyPublisher publisher;
+  publisher.publish(snap);
+  std::atomic<bool> done{false};
+  std::size_t batches = 0;
+  std::uint64_t sequence_lag = 0;
+  std::thread reader([&] {
+    wm::SpatialQuery q;
+    std::vector<wm::BoxQueryResult> out(num_boxes);
+    while (!done.load(std::memory_order_acquire)) {
+      const std::shared_ptr<const wm::OccupancySnapshot> s = publisher.latest();
+      q.boxes(*s, boxes, out);
+      ++batches;
+    }
+  });
+  const double t_concurrent = wm::bench::best_of(1, [&] {
+    for (int s = 0; s < scans; ++s) {
+      integrator.integrate(origin(s), frames[static_cast<std::size_t>(s)].view());
+      publisher.publish(wm::OccupancySnapshot::capture(map, static_cast<std::uint64_t>(s + 1)));
+    }
+  });
+  done.store(true, std::memory_order_release);
+  reader.join();
+  sequence_lag = static_cast<std::uint64_t>(scans) - publisher.latest()->sequence();
+  std::cout << "  integrating thread publishing a snapshot per scan, query thread answering box batches\n";
+  wm::bench::print_row("  scans integrated + published", static_cast<double>(scans) / t_concurrent, "scans/s");
+  wm::bench::print_row("  box batches answered meanwhile", static_cast<double>(batches), "");
+  wm::bench::print_row("  final snapshot lag", static_cast<double>(sequence_lag), "scans");
+  return 0;
+}
@@ -0,0 +1,72 @@
+// File: benchmarks/throughput/bench_util.hpp
+// Shared helpers for the throughput micro-benchmarks (header-only, no framework).
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "wm/core/io/point_buffer.hpp"
+
+namespace wm::bench {
+
+// Runs fn() `reps` times and returns the best wall time in seconds.
+template <typename Fn>
+double best_of(int reps, Fn&& fn) {
+  double best = 1e30;
+  for (int r = 0; r < reps; ++r) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+// Reads "--name value" style integer options with a default.
+inline std::int64_t arg_i64(int argc, char** argv, const std::string& name, std::int64_t def) {
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (argv[i] == name) return std::strtoll(argv[i + 1], nullptr, 10);
+  }
+  return def;
+}
+
+// Factory-hall-like scan: a floor, walls at the ROI edge, and scattered clutter, all
+// within `range_m` of the origin. Deterministic for a given seed.
+inline PointBuffer make_scan(std::size_t n, float range_m, std::uint32_t seed = 1) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+  PointBuffer pts;
+  pts.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const float kind = u01(rng);
+    float x = range_m * u(rng);
+    float y = range_m * u(rng);
+    float z = 0.0f;
+    if (kind < 0.5f) {
+      z = -1.5f + 0.01f * u(rng);  // floor
+    } else if (kind < 0.8f) {
+      x = (u(rng) > 0.0f ? 1.0f : -1.0f) * range_m * 0.7f;  // wall
+      z = -1.5f + 6.0f * u01(rng);
+    } else {
+      x *= 0.3f;
+      y *= 0.3f;
+      z = -1.5f + 2.0f * u01(rng);  // clutter
+    }
+    pts.push_back(x, y, z, u01(rng));
+  }
+  return pts;
+}
+
+inline void print_row(const std::string& name, double value, const std::string& unit) {
+  std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(14)
+            << std::fixed << std::setprecision(2) << value << " " << unit << "\n";
+}
+
+}  // namespace wm::bench
@@ -0,0 +1,83 @@
+// File: benchmarks/throughput/bench_voxel_block_map.cpp
+// Sparse voxel block map at the default mapping config (2 cm voxels, 8^3 blocks, 20x20x7 m
+// ROI) fed with one second of 2M points/s input (10 frames of 200k points), single thread.
+//
+//   wm_bench_voxel_block_map [--points-per-sec N] [--fps F] [--reps R]
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+
+int main(int argc, char** argv) {
+  const auto pps = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points-per-sec", 2'000'000));
+  const auto fps = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--fps", 10));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+
+  const wm::MappingConfig mcfg;  // defaults: the edge profile we size for
+  const std::size_t per_frame = pps / fps;
+
+  std::vector<wm::PointBuffer> frames;
+  for (std::size_t f = 0; f < fps; ++f) {
+    frames.push_back(wm::bench::make_scan(per_frame, 9.5f, static_cast<std::uint32_t>(f + 1)));
+  }
+  // make_scan emits points in random order, the worst case for the map's last-block cache
+  // (a spinning sensor's ring order is far more coherent), so these are lower bounds.
+  const auto integrate_second = [&](wm::VoxelBlockMap& map, const std::vector<wm::PointBuffer>& in) {
+    std::size_t n = 0;
+    for (const auto& fr : in) n += map.integrate_hits(fr.view());
+    return n;
+  };
+
+  // Cold: empty map, every new block allocated and hashed.
+  double t_cold = 1e30;
+  std::size_t integrated = 0;
+  for (int r = 0; r < reps; ++r) {
+    wm::VoxelBlockMap map(mcfg);
+    t_cold = std::min(t_cold, wm::bench::best_of(1, [&] { integrated = integrate_second(map, frames); }));
+  }
+
+  // Warm: same scene again, all blocks present (steady state of a fixed sensor).
+  wm::VoxelBlockMap map(mcfg);
+  integrate_second(map, frames);
+  const double t_warm = wm::bench::best_of(reps, [&] { integrate_second(map, frames); });
+
+  // Raw hash lookups in shuffled order (no spatial coherence, no last-block cache).
+  std::vector<wm::BlockKey> keys;
+  keys.reserve(map.num_blocks());
+  map.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex) { keys.push_back(k); });
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  std::size_t found = 0;
+  const double t_find = wm::bench::best_of(reps, [&] {
+    found = 0;
+    for (const auto& k : keys) found += map.find(k) != wm::kInvalidBlock;
+  });
+  std::size_t missing = 0;
+  const double t_miss = wm::bench::best_of(reps, [&] {
+    missing = 0;
+    for (const auto& k : keys) missing += map.find(wm::BlockKey{k.x, k.y, k.z + 100000}) == wm::kInvalidBlock;
+  });
+
+  const wm::VoxelBlockMapStats s = map.stats();
+  const double mpts = static_cast<double>(pps) * 1e-6;
+  const double mkeys = static_cast<double>(keys.size()) * 1e-6;
+
+  std::cout << "voxel block map: " << pps << " points/s as " << fps << " frames, voxel "
+            << mcfg.voxel_size_m * 100.0f << " cm, block " << mcfg.block_size_vox << "^3, best of " << reps
+            << "\n";
+  wm::bench::print_row("points inside ROI", static_cast<double>(integrated), "pts");
+  wm::bench::print_row("cold integrate (new map)", mpts / t_cold, "Mpts/s");
+  wm::bench::print_row("  core load at input rate", t_cold * 100.0, "%");
+  wm::bench::print_row("warm integrate (blocks present)", mpts / t_warm, "Mpts/s");
+  wm::bench::print_row("  core load at input rate", t_warm * 100.0, "%");
+  wm::bench::print_row("find, present (shuffled)", mkeys / t_find, "Mlookups/s");
+  wm::bench::print_row("find, absent (shuffled)", mkeys / t_miss, "Mlookups/s");
+  wm::bench::print_row("blocks", static_cast<double>(s.blocks), "");
+  wm::bench::print_row("hash slots", static_cast<double>(s.hash_slots), "");
+  wm::bench::print_row("memory", static_cast<double>(s.memory_bytes) / (1024.0 * 1024.0), "MiB");
+  if (found != keys.size() || missing != keys.size()) std::cout << "  WARNING: lookup mismatch\n";
+  return 0;
+}
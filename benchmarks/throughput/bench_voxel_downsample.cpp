@@ -0,0 +1,87 @@
+// File: benchmarks/throughput/bench_voxel_downsample.cpp
+// Voxel-grid downsampling at budgets.downsample_voxel_m: the radix-sort path against the
+// hash path over a range of frame sizes, to place VoxelDownsampleParams::hash_max_points,
+// plus a check that every thread count produces the same points (and the hash path the
+// same centroids, in first-seen rather than Morton order).
+//
+//   wm_bench_voxel_downsample [--threads T] [--reps R]
+//   --threads 0 uses all cores (sort path only; the hash path is serial).
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/preprocess/voxel_downsample.hpp"
+
+namespace {
+
+bool same_points(const wm::PointBuffer& a, const wm::PointBuffer& b) {
+  if (a.size() != b.size()) return false;
+  const std::size_t bytes = a.size() * sizeof(float);
+  return std::memcmp(a.view().x, b.view().x, bytes) == 0 && std::memcmp(a.view().y, b.view().y, bytes) == 0 &&
+         std::memcmp(a.view().z, b.view().z, bytes) == 0 &&
+         std::memcmp(a.view().intensity, b.view().intensity, bytes) == 0;
+}
+
+// Same points in any order.
+bool same_point_set(const wm::PointBuffer& a, const wm::PointBuffer& b) {
+  const auto sorted = [](const wm::PointBuffer& p) {
+    std::vector<std::array<float, 4>> v(p.size());
+    for (std::size_t i = 0; i < p.size(); ++i) {
+      const wm::PointXYZI q = p.at(i);
+      v[i] = {q.x, q.y, q.z, q.intensity};
+    }
+    std::sort(v.begin(), v.end());
+    return v;
+  };
+  return sorted(a) == sorted(b);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int threads = static_cast<int>(wm::bench::arg_i64(argc, argv, "--threads", 1));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 10));
+
+  wm::VoxelDownsampleParams params = wm::VoxelDownsampleParams::from_config(wm::BudgetsConfig{});
+  params.threads = threads;
+  wm::VoxelDownsampleParams sort_params = params;
+  sort_params.hash_max_points = 0;
+  wm::VoxelDownsampleParams hash_params = params;
+  hash_params.hash_max_points = std::numeric_limits<std::size_t>::max();
+  wm::VoxelDownsampleParams serial_params = sort_params;
+  serial_params.threads = 1;
+
+  wm::VoxelDownsampler sorter(sort_params);
+  wm::VoxelDownsampler hasher(hash_params);
+  wm::VoxelDownsampler serial(serial_params);
+
+  std::cout << "voxel downsample: voxel " << params.voxel_m * 100.0f << " cm, sort path on " << sorter.threads()
+            << " thread(s), best of " << reps << "\n";
+
+  wm::PointBuffer out_sort;
+  wm::PointBuffer out_hash;
+  wm::PointBuffer out_serial;
+  for (const std::size_t n : {1'000u, 4'000u, 16'000u, 64'000u, 256'000u, 1'000'000u}) {
+    const wm::PointBuffer scan = wm::bench::make_scan(n, 8.0f);
+    const double mpts = static_cast<double>(n) * 1e-6;
+
+    wm::VoxelDownsampleStats s;
+    const double t_sort = wm::bench::best_of(reps, [&] { s = sorter.downsample(scan.view(), out_sort); });
+    const double t_hash = wm::bench::best_of(reps, [&] { (void)hasher.downsample(scan.view(), out_hash); });
+    (void)serial.downsample(scan.view(), out_serial);
+
+    const std::string label = std::to_string(n) + " pts";
+    wm::bench::print_row(label + " -> voxels", static_cast<double>(s.output), "");
+    wm::bench::print_row("  sort path", mpts / t_sort, "Mpts/s");
+    wm::bench::print_row("  hash path", mpts / t_hash, "Mpts/s");
+    if (!same_point_set(out_sort, out_hash) || !same_points(out_sort, out_serial)) {
+      std::cout << "  WARNING: outputs differ between paths or thread counts\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+// File: benchmarks/throughput/bench_voxel_neighbourhood.cpp
+// 26-neighbourhood scans over a factory-hall map (default mapping config: 2 cm voxels, 8^3
+// blocks) under each block layout, single thread:
+//   linear voxels, 1-block regions  (flat hash of blocks: the old layout)
+//   morton voxels, 1-block regions
+//   linear voxels, R^3-block regions
+//   morton voxels, R^3-block regions (the default)
+//
+// "block scan": every occupied voxel, block by block, counts its occupied neighbours via
+// the 27 neighbouring blocks resolved once per block (dilation / clustering inner loop).
+// "point probes": the same count for occupied voxels in shuffled order, every neighbour
+// looked up by position (region search + hash per probe, no per-block caching).
+//
+//   wm_bench_voxel_neighbourhood [--points N] [--region R] [--block B] [--reps R]
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+
+namespace {
+
+struct LayoutResult {
+  double block_scan_s{0.0};
+  double probe_s{0.0};
+  std::size_t occupied{0};
+  std::size_t neighbours{0};
+  std::size_t probe_neighbours{0};
+  std::size_t memory_bytes{0};
+};
+
+// Occupied-neighbour count of every occupied voxel, one block at a time.
+std::size_t block_scan(const wm::VoxelBlockMap& map, const std::vector<std::array<std::uint8_t, 3>>& local_of,
+                       std::size_t& occupied) {
+  const auto B = static_cast<std::int32_t>(map.block_size());
+  const std::size_t n = map.voxels_per_block();
+  std::size_t count = 0;
+  occupied = 0;
+  std::array<const std::int16_t*, 27> nb{};
+  map.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex b) {
+    const std::int16_t* centre = map.cells<std::int16_t>(b);
+    for (int dz = -1, i = 0; dz <= 1; ++dz) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx, ++i) {
+          const wm::BlockIndex nbi = map.find(wm::BlockKey{k.x + dx, k.y + dy, k.z + dz});
+          nb[i] = nbi == wm::kInvalidBlock ? nullptr : map.cells<std::int16_t>(nbi);
+        }
+      }
+    }
+    // Storage order, so the centre block is read sequentially under either voxel order.
+    for (std::size_t v = 0; v < n; ++v) {
+      if (centre[v] <= 0) continue;
+      ++occupied;
+      const std::int32_t lx = local_of[v][0];
+      const std::int32_t ly = local_of[v][1];
+      const std::int32_t lz = local_of[v][2];
+      for (std::int32_t oz = -1; oz <= 1; ++oz) {
+        const std::int32_t z = lz + oz;
+        const int bz = z < 0 ? 0 : (z >= B ? 2 : 1);
+        const auto wz = static_cast<std::uint32_t>(z - (bz - 1) * B);
+        for (std::int32_t oy = -1; oy <= 1; ++oy) {
+          const std::int32_t y = ly + oy;
+          const int by = y < 0 ? 0 : (y >= B ? 2 : 1);
+          const auto wy = static_cast<std::uint32_t>(y - (by - 1) * B);
+          for (std::int32_t ox = -1; ox <= 1; ++ox) {
+            if ((ox | oy | oz) == 0) continue;
+            const std::int32_t x = lx + ox;
+            const int bx = x < 0 ? 0 : (x >= B ? 2 : 1);
+            const std::int16_t* p = nb[static_cast<std::size_t>(bz * 9 + by * 3 + bx)];
+            if (p == nullptr) continue;
+            const auto wx = static_cast<std::uint32_t>(x - (bx - 1) * B);
+            count += p[map.voxel_index(wx, wy, wz)] > 0;
+          }
+        }
+      }
+    }
+  });
+  return count;
+}
+
+LayoutResult run_layout(const wm::MappingConfig& mcfg, const std::vector<wm::PointBuffer>& frames,
+                        const std::vector<wm::Vec3f>& probes, int reps) {
+  wm::VoxelBlockMap map(mcfg);
+  for (const auto& fr : frames) map.integrate_hits(fr.view());
+
+  // Storage index -> block-local coordinates, whatever the voxel order.
+  const auto B = static_cast<std::uint32_t>(map.block_size());
+  std::vector<std::array<std::uint8_t, 3>> local_of(map.voxels_per_block());
+  for (std::uint32_t z = 0; z < B; ++z) {
+    for (std::uint32_t y = 0; y < B; ++y) {
+      for (std::uint32_t x = 0; x < B; ++x) {
+        local_of[map.voxel_index(x, y, z)] = {static_cast<std::uint8_t>(x), static_cast<std::uint8_t>(y),
+                                              static_cast<std::uint8_t>(z)};
+      }
+    }
+  }
+
+  LayoutResult r;
+  r.memory_bytes = map.stats().memory_bytes;
+  r.block_scan_s = wm::bench::best_of(reps, [&] { r.neighbours = block_scan(map, local_of, r.occupied); });
+
+  const float v = map.voxel_size();
+  r.probe_s = wm::bench::best_of(reps, [&] {
+    std::size_t count = 0;
+    for (const wm::Vec3f& p : probes) {
+      for (int oz = -1; oz <= 1; ++oz) {
+        for (int oy = -1; oy <= 1; ++oy) {
+          for (int ox = -1; ox <= 1; ++ox) {
+            if ((ox | oy | oz) == 0) continue;
+            count += map.log_odds(wm::Vec3f{p.x + ox * v, p.y + oy * v, p.z + oz * v}) > 0.0f;
+          }
+        }
+      }
+    }
+    r.probe_neighbours = count;
+  });
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto n = static_cast<std::size_t>(wm::bench::arg_i64(argc, argv, "--points", 2'000'000));
+  const int region = static_cast<int>(wm::bench::arg_i64(argc, argv, "--region", 2));
+  const int block = static_cast<int>(wm::bench::arg_i64(argc, argv, "--block", 8));
+  const int reps = static_cast<int>(wm::bench::arg_i64(argc, argv, "--reps", 5));
+
+  // One second of 2M points/s input as 10 frames.
+  std::vector<wm::PointBuffer> frames;
+  for (std::uint32_t f = 0; f < 10; ++f) frames.push_back(wm::bench::make_scan(n / 10, 9.5f, f + 1));
+
+  wm::MappingConfig base;
+  base.block_size_vox = block;
+  base.log_odds_bits = 16;  // the scans read int16 cells
+
+  // Probe at voxel centres of occupied voxels, shuffled (as a region-growing frontier
+  // jumps around the map).
+  std::vector<wm::Vec3f> probes;
+  {
+    wm::VoxelBlockMap map(base);
+    for (const auto& fr : frames) map.integrate_hits(fr.view());
+    const float v = map.voxel_size();
+    const auto B = map.block_size();
+    map.for_each_block([&](const wm::BlockKey& k, wm::BlockIndex b) {
+      const std::int16_t* vox = map.cells<std::int16_t>(b);
+      const wm::Vec3f o = map.block_origin(k);
+      for (int z = 0; z < B; ++z) {
+        for (int y = 0; y < B; ++y) {
+          for (int x = 0; x < B; ++x) {
+            if (vox[map.voxel_index(x, y, z)] > 0) {
+              probes.push_back(wm::Vec3f{o.x + (x + 0.5f) * v, o.y + (y + 0.5f) * v, o.z + (z + 0.5f) * v});
+            }
+          }
+        }
+      }
+    });
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(11));
+    probes.resize(std::min<std::size_t>(probes.size(), 200'000));
+  }
+
+  struct Layout {
+    const char* name;
+    bool morton;
+    int region;
+  };
+  const std::string r_name = "R=" + std::to_string(region);
+  const Layout layouts[] = {
+      {"linear, R=1 (flat)", false, 1},
+      {"morton, R=1", true, 1},
+      {"linear, ", false, region},
+      {"morton, ", true, region},
+  };
+
+  std::cout << "voxel neighbourhood: " << n << " points in 10 frames, voxel " << base.voxel_size_m * 100.0f
+            << " cm, block " << base.block_size_vox << "^3, " << probes.size() << " probes, best of " << reps
+            << "\n";
+  double flat_scan = 0.0;
+  double flat_probe = 0.0;
+  std::size_t ref_neighbours = 0;
+  std::size_t ref_probe = 0;
+  for (const Layout& l : layouts) {
+    wm::MappingConfig mcfg = base;
+    mcfg.morton_voxels = l.morton;
+    mcfg.region_size_blocks = l.region;
+    const LayoutResult r = run_layout(mcfg, frames, probes, reps);
+    const std::string name = l.region == 1 ? std::string(l.name) : std::string(l.name) + r_name;
+    const double mvox = static_cast<double>(r.occupied) * 1e-6;
+    const double mprobe = static_cast<double>(probes.size()) * 1e-6;
+    if (flat_scan == 0.0) {
+      flat_scan = r.block_scan_s;
+      flat_probe = r.probe_s;
+      ref_neighbours = r.neighbours;
+      ref_probe = r.probe_neighbours;
+    }
+    std::cout << "  " << name << "\n";
+    wm::bench::print_row("  block scan", mvox / r.block_scan_s, "Mvoxels/s");
+    wm::bench::print_row("    speedup vs flat", flat_scan / r.block_scan_s, "x");
+    wm::bench::print_row("  point probes", mprobe / r.probe_s, "Mvoxels/s");
+    wm::bench::print_row("    speedup vs flat", flat_probe / r.probe_s, "x");
+    wm::bench::print_row("  memory", static_cast<double>(r.memory_bytes) / (1024.0 * 1024.0), "MiB");
+    if (r.neighbours != ref_neighbours || r.probe_neighbours != ref_probe) {
+      std::cout << "  WARNING: neighbour counts differ between layouts\n";
+    }
+  }
+  return 0;
+}
@@ -3,21 +3,52 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "wm/core/io/frame_prefetcher.hpp"
 #include "wm/core/io/frame_source.hpp"
+#include "wm/core/io/mapped_file.hpp"
+#include "wm/core/io/quantized_points.hpp"
 
 namespace wm {
 
+// Quantized frame file (".qbin"): this header, then int16 x[n], y[n], z[n], uint8 intensity[n].
+// See QuantizationParams for the decode rule. 7 bytes/point instead of 16.
+inline constexpr char kQuantizedFrameMagic[4] = {'W', 'M', 'Q', '1'};
+
+struct QuantizedFrameFileHeader {
+  char magic[4];
+  std::uint32_t num_points;
+  QuantizationParams params;
+  std::uint8_t reserved[24];
+};
+static_assert(sizeof(QuantizedFrameFileHeader) == 64);
+
+// Writes `pts` as a .qbin frame file with per-frame quantization parameters.
+Status write_quantized_frame_file(const std::string& path, ConstPointView pts);
+
+enum class FrameDirReadMode {
+  kCopy,  // read each file into owned SoA lanes
+  kMmap,  // map each file and view its records in place (zero-copy, strided view)
+};
+
 struct FrameDirSourceConfig {
   // Directory containing frame files.
-  // Format: one ".bin" file per frame, each file packed as float32 x,y,z,intensity per point.
+  // Format: one file per frame, either ".bin" (float32 x,y,z,intensity per point) or ".qbin"
+  // (quantized, see QuantizedFrameFileHeader; always mapped and SIMD-decoded).
   // Files are consumed in lexicographic filename order for deterministic playback.
   std::string path;
   bool loop{false};
   // If <= 0, caller pacing is used but timestamps are still synthesized at 10 Hz.
   double fps{0.0};
+  // kMmap: Frame::points borrows the mapping, which stays alive while any Frame refers to it.
+  FrameDirReadMode read_mode{FrameDirReadMode::kCopy};
+  // Read-ahead: load and decode up to prefetch_depth frames on io_threads background threads.
+  // 0 disables read-ahead (files are read on the calling thread).
+  int prefetch_depth{0};
+  int io_threads{1};
 };
 
 class FrameDirSource final : public FrameSource {
@@ -27,11 +58,33 @@ class FrameDirSource final : public FrameSource {
 
   Status open() override;
   Result<Frame> next() override;
+  Status next_into(Frame& out) override;
+  // With read-ahead, drains the ready slots under one lock. Without it, opens every file
+  // of the batch (with its read-ahead hint, see open_frame) before decoding the first one,
+  // so the kernel reads them in parallel with decoding.
+  Result<std::size_t> next_batch(std::span<Frame> out) override;
   void close() override;
 
+  // Read-ahead statistics (all zero when prefetch is disabled).
+  [[nodiscard]] FramePrefetchStats prefetch_stats() const;
+
  private:
+  // A frame file opened for decoding: mapped (.qbin, kMmap) or a descriptor (kCopy).
+  struct OpenFrame {
+    std::shared_ptr<const MappedFile> map;
+    int fd{-1};
+  };
+
   Status load_file_list();
-  Result<Frame> read_frame(const std::string& path, const std::string& frame_id);
+  // Opens frame `index` and hints that all of it will be read: the sequential mapping
+  // issues MADV_WILLNEED, a kCopy descriptor gets POSIX_FADV_WILLNEED.
+  Status open_frame(std::size_t index, OpenFrame& f) const;
+  // Decodes an opened frame into `out` and closes it.
+  Status decode_frame(std::size_t index, OpenFrame& f, Frame& out) const;
+  static Status read_frame(int fd, const std::string& frame_id, Frame& out);
+  static Status map_frame(std::shared_ptr<const MappedFile> map, const std::string& frame_id, Frame& out);
+  static Status decode_quantized_frame(const MappedFile& map, const std::string& frame_id, Frame& out);
+  Status load_frame(std::size_t index, Frame& out);
 
   FrameDirSourceConfig cfg_;
   bool opened_{false};
@@ -42,6 +95,9 @@ class FrameDirSource final : public FrameSource {
   std::int64_t emitted_{0};
 
   std::int64_t frame_period_ns_{100000000};
+
+  std::unique_ptr<FramePrefetcher> prefetcher_;
+  std::vector<OpenFrame> batch_;  // next_batch scratch (without read-ahead)
 };
 
 }  // namespace wm
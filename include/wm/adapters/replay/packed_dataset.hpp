@@ -0,0 +1,207 @@
+// File: include/wm/adapters/replay/packed_dataset.hpp
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wm/core/io/frame_source.hpp"
+#include "wm/core/io/mapped_file.hpp"
+#include "wm/core/io/quantized_points.hpp"
+
+namespace wm {
+
+// -----------------------------
+// Packed dataset format (.wmpack), version 1
+// -----------------------------
+// A single file holding a whole replay dataset:
+//
+//   PackedFileHeader                      (64 B, offset 0)
+//   frame record 0 .. N-1                 (each starts on a 64 B boundary)
+//     PackedFrameHeader                   (128 B)
+//     payload, by encoding (every lane padded to 64 B):
+//       kFloat32Soa: x[n] | y[n] | z[n] | intensity[n]               float32
+//       kQuant16:    QuantizationParams | x[n] | y[n] | z[n]         int16
+//                    | intensity[n]                                  uint8
+//   PackedIndexEntry[N]                   (32 B each, sorted by record order)
+//   PackedFooter                          (64 B, last bytes of the file)
+//
+// Opening reads the footer and maps the file; the index is used in place, so open is O(1)
+// in the number of frames. Lanes are 64-byte aligned within a page-aligned mapping, so
+// readers hand them out as zero-copy contiguous views.
+// All integers are little-endian; timestamps are dataset-time nanoseconds.
+
+static_assert(std::endian::native == std::endian::little, "packed dataset assumes little-endian");
+
+inline constexpr char kPackedFileMagic[8] = {'W', 'M', 'P', 'A', 'C', 'K', '0', '1'};
+inline constexpr char kPackedFooterMagic[8] = {'W', 'M', 'P', 'I', 'D', 'X', '0', '1'};
+inline constexpr std::uint32_t kPackedFrameMagic = 0x52464d57u;  // "WMFR"
+inline constexpr std::uint32_t kPackedVersion = 1;
+inline constexpr std::size_t kPackedAlignment = 64;
+
+enum class PackedEncoding : std::uint32_t {
+  kFloat32Soa = 0,  // four float32 lanes (16 B/point)
+  kQuant16 = 1,     // int16 xyz + uint8 intensity, per-frame scale/offset (7 B/point)
+};
+
+struct PackedFileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t header_bytes;  // sizeof(PackedFileHeader)
+  char node_id[32];            // NUL-padded
+  std::uint8_t reserved[16];
+};
+static_assert(sizeof(PackedFileHeader) == 64);
+
+struct PackedFrameHeader {
+  std::uint32_t magic;         // kPackedFrameMagic
+  std::uint32_t encoding;      // PackedEncoding
+  std::uint64_t num_points;
+  std::int64_t t_ns;
+  std::uint64_t seq;
+  char node_id[32];            // NUL-padded
+  char frame_id[48];           // NUL-padded (truncated if longer)
+  std::uint64_t payload_bytes; // bytes following this header, including lane padding
+  std::uint8_t reserved[8];
+};
+static_assert(sizeof(PackedFrameHeader) == 128);
+
+struct PackedIndexEntry {
+  std::uint64_t offset;  // file offset of the PackedFrameHeader
+  std::int64_t t_ns;
+  std::uint64_t seq;
+  std::uint64_t num_points;
+};
+static_assert(sizeof(PackedIndexEntry) == 32);
+
+struct PackedFooter {
+  char magic[8];
+  std::uint64_t index_offset;
+  std::uint64_t num_frames;
+  std::int64_t t_first_ns;
+  std::int64_t t_last_ns;
+  std::uint64_t index_checksum;  // FNV-1a 64 over the index bytes
+  std::uint8_t reserved[16];
+};
+static_assert(sizeof(PackedFooter) == 64);
+
+// -----------------------------
+// Writer
+// -----------------------------
+// Appends frames in order, then writes the index and footer in finish().
+// Timestamps must be non-decreasing (the index is searched by time). Destroying the writer
+// before finish() removes the partial file.
+class PackedDatasetWriter {
+ public:
+  PackedDatasetWriter() = default;
+  ~PackedDatasetWriter();
+
+  PackedDatasetWriter(const PackedDatasetWriter&) = delete;
+  PackedDatasetWriter& operator=(const PackedDatasetWriter&) = delete;
+
+  Status open(const std::string& path, const std::string& node_id,
+              PackedEncoding encoding = PackedEncoding::kFloat32Soa);
+  Status append(const Frame& frame, std::uint64_t seq);
+  Status finish();
+
+  [[nodiscard]] std::uint64_t num_frames() const noexcept { return index_.size(); }
+
+ private:
+  Status write_bytes(const void* data, std::size_t n);
+  Status pad_to_alignment();
+  Status write_float_lanes(ConstPointView pts);
+  Status write_quantized_lanes(ConstPointView pts);
+
+  std::ofstream f_;
+  std::string path_;
+  std::string node_id_;
+  PackedEncoding encoding_{PackedEncoding::kFloat32Soa};
+  std::uint64_t offset_{0};
+  std::vector<PackedIndexEntry> index_;
+
+  // Quantization scratch, reused across frames.
+  std::vector<std::int16_t> qx_, qy_, qz_;
+  std::vector<std::uint8_t> qi_;
+};
+
+// -----------------------------
+// Reader
+// -----------------------------
+class PackedDatasetReader {
+ public:
+  // Maps the file and validates header, footer and index bounds.
+  Status open(const std::string& path);
+  void close();
+
+  [[nodiscard]] bool is_open() const noexcept { return map_ != nullptr; }
+  [[nodiscard]] std::size_t num_frames() const noexcept { return num_frames_; }
+  [[nodiscard]] const PackedIndexEntry& entry(std::size_t i) const noexcept { return index_[i]; }
+  [[nodiscard]] std::int64_t t_first_ns() const noexcept { return footer_.t_first_ns; }
+  [[nodiscard]] std::int64_t t_last_ns() const noexcept { return footer_.t_last_ns; }
+  [[nodiscard]] const std::string& node_id() const noexcept { return node_id_; }
+
+  // First frame with t_ns >= t (num_frames() if none). O(log N) over the mapped index.
+  [[nodiscard]] std::size_t lower_bound_time(std::int64_t t_ns) const noexcept;
+
+  // Fills `out` with frame i. Float32 points borrow the mapping (zero-copy) unless
+  // copy_points; quantized frames are always decoded (SIMD) into owned lanes.
+  Status read_into(std::size_t i, Frame& out, bool copy_points = false) const;
+
+  // Asks the kernel to read records [first, last) ahead in one go (batched reads).
+  void prefetch_records(std::size_t first, std::size_t last) const noexcept;
+
+  // Encoding of frame i, and a zero-copy view for stages that consume kQuant16 directly.
+  Result<PackedEncoding> encoding(std::size_t i) const;
+  Status quantized_view(std::size_t i, QuantizedPointsView& out) const;
+
+  // Full O(N) integrity check (index checksum, record headers, bounds). open() does not
+  // run it so that opening stays O(1); tools call it after writing or before archiving.
+  Status verify() const;
+
+ private:
+  Result<const PackedFrameHeader*> frame_header(std::size_t i) const;
+
+  std::shared_ptr<const MappedFile> map_;
+  PackedFooter footer_{};
+  const PackedIndexEntry* index_{nullptr};
+  std::size_t num_frames_{0};
+  std::string node_id_;
+};
+
+// -----------------------------
+// FrameSource over a packed dataset
+// -----------------------------
+struct PackedDatasetSourceConfig {
+  std::string path;
+  bool loop{false};
+  // Copy points into owned lanes instead of borrowing the mapping.
+  bool copy_points{false};
+};
+
+class PackedDatasetSource final : public FrameSource {
+ public:
+  explicit PackedDatasetSource(PackedDatasetSourceConfig cfg);
+  ~PackedDatasetSource() override { close(); }
+
+  Status open() override;
+  Result<Frame> next() override;
+  Status next_into(Frame& out) override;
+  void close() override;
+
+  // Positions the next read at frame `index` / the first frame with t_ns >= t.
+  Status seek(std::size_t index);
+  Status seek_time(TimestampNs t);
+
+  [[nodiscard]] const PackedDatasetReader& reader() const noexcept { return reader_; }
+
+ private:
+  PackedDatasetSourceConfig cfg_;
+  PackedDatasetReader reader_;
+  std::size_t idx_{0};
+};
+
+}  // namespace wm
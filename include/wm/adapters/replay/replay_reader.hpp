@@ -0,0 +1,71 @@
+// File: include/wm/adapters/replay/replay_reader.hpp
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "wm/adapters/replay/packed_dataset.hpp"
+#include "wm/core/io/frame_source.hpp"
+
+namespace wm {
+
+struct ReplayReaderConfig {
+  // A .wmpack file, or a dataset directory containing kReplayDatasetFileName.
+  std::string dataset_path;
+  // 1.0 = real time from recorded timestamps, 2.0 = twice as fast, 0 = as fast as possible.
+  double time_scale{0.0};
+  // Trim window in dataset time, relative to the first frame. 0 disables each bound.
+  // End is exclusive.
+  std::int64_t start_offset_ns{0};
+  std::int64_t end_offset_ns{0};
+  bool loop{false};
+  // Copy points into owned lanes instead of borrowing the dataset mapping.
+  bool copy_points{false};
+};
+
+inline constexpr const char* kReplayDatasetFileName = "dataset.wmpack";
+
+// Streaming replay of a packed dataset.
+// - The trim window is resolved to an index range with two binary searches at open();
+//   frames outside it are never read.
+// - With time_scale > 0, next() sleeps until the frame's recorded time (scaled) has elapsed
+//   since playback started, so the source paces itself; callers should not add their own tick.
+// - Emitted t_ns is dataset time relative to the window start. On loop, later passes are
+//   shifted by the window span plus one mean frame period so t_ns stays monotonic.
+// - seq counts emitted frames; frame_id keeps the recorded id.
+class ReplayReader final : public FrameSource {
+ public:
+  explicit ReplayReader(ReplayReaderConfig cfg);
+  ~ReplayReader() override { close(); }
+
+  Status open() override;
+  Result<Frame> next() override;
+  Status next_into(Frame& out) override;
+  // Hints the batch's contiguous record range to the kernel in one madvise, then reads the
+  // frames in order. With time_scale > 0 each frame is still paced, so the call returns
+  // when the last frame of the batch is due.
+  Result<std::size_t> next_batch(std::span<Frame> out) override;
+  void close() override;
+
+  [[nodiscard]] std::size_t window_begin() const noexcept { return begin_; }
+  [[nodiscard]] std::size_t window_end() const noexcept { return end_; }
+
+ private:
+  ReplayReaderConfig cfg_;
+  PackedDatasetReader reader_;
+
+  std::size_t begin_{0};
+  std::size_t end_{0};
+  std::size_t idx_{0};
+
+  std::int64_t t_window_start_ns_{0};
+  std::int64_t loop_span_ns_{0};
+  std::int64_t loop_offset_ns_{0};
+  std::uint64_t emitted_{0};
+
+  std::chrono::steady_clock::time_point wall_anchor_{};
+};
+
+}  // namespace wm
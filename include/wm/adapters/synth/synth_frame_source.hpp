@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <vector>
 
 #include "wm/core/io/frame_source.hpp"
 
@@ -26,10 +25,14 @@ class SynthFrameSource final : public FrameSource {
 
   Status open() override;
   Result<Frame> next() override;
+  Status next_into(Frame& out) override;
+  // Generates out.size() consecutive ticks; never stops early.
+  Result<std::size_t> next_batch(std::span<Frame> out) override;
   void close() override;
 
  private:
-  void append_obstacle_points(std::vector<PointXYZI>& points, double t_s) const;
+  void fill_frame(Frame& out);
+  void append_obstacle_points(PointBuffer& points, double t_s) const;
   void build_static_scene();
 
   SynthSourceConfig cfg_;
@@ -38,7 +41,7 @@ class SynthFrameSource final : public FrameSource {
   std::int64_t tick_period_ns_{100000000};
   std::int64_t tick_{0};
 
-  std::vector<PointXYZI> static_points_;
+  PointBuffer static_points_;
 };
 
 }  // namespace wm
@@ -1,8 +1,10 @@
 // include/wm/core/config.hpp
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "wm/core/status.hpp"
 #include "wm/core/types.hpp"
@@ -50,6 +52,9 @@ struct CalibrationConfig {
   // Leave identity if unknown.
   TransformSE3 T_site_node = TransformSE3::identity();
 
+  // Derived at load (T_site_node * T_node_lidar); not read from YAML.
+  TransformSE3 T_site_lidar = TransformSE3::identity();
+
   // A version string you control (also ends up hashed).
   std::string calibration_version = "dev";
 };
@@ -63,6 +68,10 @@ struct BaselineConfig {
 
   // Optional: ignore the first few seconds while the sensor settles.
   DurationNs warmup_duration_ns = seconds_to_ns(0.0);
+
+  // Map snapshot (.wmmap) restored at startup when its config / calibration hashes match,
+  // and written once the baseline is frozen. Empty disables snapshots.
+  std::string snapshot_path;
 };
 
 // -----------------------------
@@ -82,8 +91,49 @@ struct MappingConfig {
   // Sparse hashed block size (e.g. 8 means 8x8x8 voxels per block).
   int block_size_vox = 8;
 
+  // Memory layout for neighbourhood scans: blocks are stored in Z-order within cubic
+  // regions of region_size_blocks^3 (power of two, 1..16), voxels in Z-order within blocks.
+  // Larger regions scan faster but reserve more unused block slots on sparse maps.
+  int region_size_blocks = 2;
+  bool morton_voxels = true;  // needs a power-of-two block_size_vox
+
+  // Independent region-table shards (power of two, 1..1024); parallel integration inserts
+  // new blocks one shard per task, so this should comfortably exceed integrate_threads.
+  int map_shards = 64;
+  // Back the voxel block pool with 2 MiB transparent huge pages (Linux THP in "madvise" or
+  // "always" mode): fewer TLB misses when ray casting walks many blocks, at the cost of
+  // growing the pool 2 MiB at a time.
+  bool map_huge_pages = false;
+
+  // Distance-adaptive levels of detail (1..4; 1 = single resolution). Level i has voxels
+  // of voxel_size_m * 2^i; level 0 covers [0, lod_near_m) from the node origin and each
+  // further level a band twice as far out (the last one extends to max_range_m).
+  int lod_levels = 1;
+  float lod_near_m = 10.0f;
+
+  // Occupancy: per-voxel clamped log-odds stored as int8 or int16 fixed point (8 or 16;
+  // int8 quarters voxel memory against float at ~0.03 log-odds resolution). Each
+  // observation adds log_odds_hit or log_odds_miss, clamped to [log_odds_min, log_odds_max].
+  int log_odds_bits = 16;
+  float log_odds_hit = 0.85f;
+  float log_odds_miss = -0.4f;
+  float log_odds_min = -2.0f;
+  float log_odds_max = 3.5f;
+  // Queries report occupied above log_odds_occupied, free below log_odds_free and unknown
+  // in between (widen the gap to keep noisy voxels unknown).
+  float log_odds_occupied = 0.0f;
+  float log_odds_free = 0.0f;
+
   RoiConfig roi;
 
+  // Map memory cap in MiB (0 = unbounded). Past it, the regions observed least recently are
+  // evicted, except those touching map_core (node frame), which always stay resident. With
+  // map_spill_path set, evicted regions are written there (run-length coded, scratch file
+  // for the run) and read back when observed again; otherwise they revert to unknown.
+  int map_memory_budget_mb = 0;
+  RoiConfig map_core{Vec3f{-5.0f, -5.0f, -2.0f}, Vec3f{5.0f, 5.0f, 5.0f}};
+  std::string map_spill_path;
+
   // Input gating (very cheap nuisance filtering).
   float min_range_m = 0.2f;
   float max_range_m = 50.0f;
@@ -91,8 +141,24 @@ struct MappingConfig {
   // Keep intensity for later nuisance handling; doesn't affect core mapping yet.
   bool use_intensity = true;
 
-  // Integration rate target (replay can exceed; live will aim for this).
+  // Map update rate in frame time: frames are buffered and integrated together once per
+  // 1/integrate_hz, so a block seen by several frames of a batch is visited once per pass
+  // of integrate_pass_rays rays (0 = integrate every frame on arrival). Every frame's
+  // observations still count, so batching sets the map's latency, not how fast it learns.
   int integrate_hz = 10;
+
+  // Ray-casting worker threads, including the calling thread (0 = all cores).
+  int integrate_threads = 0;
+
+  // Rays per integration pass; a voxel's observations within a pass are counted and
+  // applied at once. Bounds the update buffers (~4 B per voxel step: ~35 MB per 16k rays
+  // of 10 m at 2 cm).
+  int integrate_pass_rays = 16384;
+
+  // After each integrated batch, capture an occupancy snapshot of every level and publish
+  // it to query threads (MultiResOccupancySnapshot); costs a copy of the occupancy masks
+  // (~1/8 of int16 cells) on the integrating thread per batch.
+  bool publish_snapshots = false;
 };
 
 // -----------------------------
@@ -107,6 +173,15 @@ struct BudgetsConfig {
 
   // When over budget, voxel-grid downsample input points at this size (metres).
   float downsample_voxel_m = 0.03f;
+
+  // Downsampler worker threads, including the calling thread (0 = all cores).
+  int downsample_threads = 0;
+
+  // Closed-loop governor: picks a decimation level (stride / voxel / ROI shrink) per frame
+  // to keep within max_points_per_sec and target_fps.
+  bool governor_enabled = true;
+  int governor_window_frames = 8;   // frames averaged per decision
+  float governor_headroom = 0.8f;   // step down only below this fraction of both budgets
 };
 
 // -----------------------------
@@ -135,7 +210,8 @@ struct ChangeDetectionConfig {
 // Replay input (deterministic)
 // -----------------------------
 struct ReplayConfig {
-  // Dataset root directory (contains a manifest + frame files).
+  // Packed dataset: a .wmpack file, or a directory containing dataset.wmpack.
+  // Used when input.type == "replay".
   std::string dataset_path;
 
   // Playback speed: 1.0 = real-time according to timestamps, 0 = as fast as possible.
@@ -168,17 +244,44 @@ struct InputFrameDirConfig {
   bool loop = false;
   // If <= 0, wm_node uses input.tick_hz for generated frame timestamps.
   double fps = 0.0;
+  // "copy": read into owned point lanes. "mmap": view frame files in place (zero-copy).
+  std::string read_mode = "copy";  // copy | mmap
+  // Background read-ahead depth in frames (0 = read on the tick thread) and I/O thread count.
+  int prefetch_depth = 0;
+  int io_threads = 1;
+};
+
+// One LiDAR of a multi-sensor node (input.type == "merge").
+struct InputSensorConfig {
+  std::string sensor_id;
+  std::string type = "frame_dir";  // synth | frame_dir | replay
+  // frame_dir: frame directory. replay: .wmpack file or dataset directory.
+  std::string path;
+  // frame_dir only (read_mode / prefetch settings come from input.frame_dir).
+  bool loop = false;
+  double fps = 0.0;  // <= 0 => input.tick_hz
+  // synth only (other synth settings come from input.synth).
+  std::uint32_t seed = 1;
+  // Extrinsics of this sensor; defaults to calibration.T_node_lidar when omitted.
+  TransformSE3 T_node_lidar = TransformSE3::identity();
+  // Derived at load (calibration.T_site_node * T_node_lidar); not read from YAML.
+  TransformSE3 T_site_lidar = TransformSE3::identity();
 };
 
 struct InputConfig {
-  std::string type = "synth";  // synth | frame_dir
+  // synth | frame_dir | replay (uses the top-level replay section) | merge (uses sensors)
+  std::string type = "synth";
   double tick_hz = 10.0;
   int heartbeat_every_s = 5;   // 0 disables
   std::int64_t max_ticks = 0;  // 0 disables
   double max_run_s = 0.0;      // 0 disables
+  // Frames pulled per loop iteration for self-paced (replay) input. Paced sources use 1.
+  int batch_size = 1;
 
   InputSynthConfig synth;
   InputFrameDirConfig frame_dir;
+  // Sensors merged by timestamp when type == "merge".
+  std::vector<InputSensorConfig> sensors;
 };
 
 // -----------------------------
@@ -220,8 +323,67 @@ inline Status validate_config(const Config& cfg) {
   if (cfg.mapping.voxel_size_m <= 0.0f) {
     return Status::invalid_argument("mapping.voxel_size_m must be > 0");
   }
-  if (cfg.mapping.block_size_vox <= 0) {
-    return Status::invalid_argument("mapping.block_size_vox must be > 0");
+  // Bounded so saturated voxel coordinates (kVoxelCoordLimit) fall outside the block key range.
+  if (cfg.mapping.block_size_vox <= 0 || cfg.mapping.block_size_vox > 256) {
+    return Status::invalid_argument("mapping.block_size_vox must be in [1, 256]");
+  }
+  {
+    const int r = cfg.mapping.region_size_blocks;
+    if (r < 1 || r > 16 || (r & (r - 1)) != 0) {
+      return Status::invalid_argument("mapping.region_size_blocks must be a power of two in [1, 16]");
+    }
+  }
+  if (cfg.mapping.morton_voxels && (cfg.mapping.block_size_vox & (cfg.mapping.block_size_vox - 1)) != 0) {
+    return Status::invalid_argument("mapping.morton_voxels requires a power-of-two mapping.block_size_vox");
+  }
+  {
+    const int s = cfg.mapping.map_shards;
+    if (s < 1 || s > 1024 || (s & (s - 1)) != 0) {
+      return Status::invalid_argument("mapping.map_shards must be a power of two in [1, 1024]");
+    }
+  }
+  if (cfg.mapping.lod_levels < 1 || cfg.mapping.lod_levels > 4) {
+    return Status::invalid_argument("mapping.lod_levels must be in [1, 4]");
+  }
+  if (!(cfg.mapping.lod_near_m > 0.0f)) {
+    return Status::invalid_argument("mapping.lod_near_m must be > 0");
+  }
+  if (cfg.mapping.log_odds_bits != 8 && cfg.mapping.log_odds_bits != 16) {
+    return Status::invalid_argument("mapping.log_odds_bits must be 8 or 16");
+  }
+  if (!(cfg.mapping.log_odds_min < 0.0f) || !(cfg.mapping.log_odds_max > 0.0f)) {
+    return Status::invalid_argument("mapping.log_odds_min must be < 0 and mapping.log_odds_max > 0");
+  }
+  if (!(cfg.mapping.log_odds_hit > 0.0f) || !(cfg.mapping.log_odds_miss < 0.0f)) {
+    return Status::invalid_argument("mapping.log_odds_hit must be > 0 and mapping.log_odds_miss < 0");
+  }
+  {
+    // Both increments must survive quantisation (see LogOddsModel).
+    const float unit = std::max(-cfg.mapping.log_odds_min, cfg.mapping.log_odds_max) /
+                       (cfg.mapping.log_odds_bits == 8 ? 127.0f : 32767.0f);
+    if (cfg.mapping.log_odds_hit < unit || -cfg.mapping.log_odds_miss < unit) {
+      return Status::invalid_argument("mapping.log_odds_hit/miss are below the fixed-point resolution");
+    }
+  }
+  if (!(cfg.mapping.log_odds_free <= cfg.mapping.log_odds_occupied) ||
+      cfg.mapping.log_odds_free < cfg.mapping.log_odds_min || cfg.mapping.log_odds_occupied > cfg.mapping.log_odds_max) {
+    return Status::invalid_argument(
+        "mapping.log_odds_free <= mapping.log_odds_occupied must lie within [log_odds_min, log_odds_max]");
+  }
+  if (cfg.mapping.map_memory_budget_mb < 0) {
+    return Status::invalid_argument("mapping.map_memory_budget_mb must be >= 0");
+  }
+  if (!AABB{cfg.mapping.map_core.min, cfg.mapping.map_core.max}.is_valid()) {
+    return Status::invalid_argument("mapping.map_core must be a valid AABB (min <= max)");
+  }
+  if (cfg.mapping.integrate_hz < 0) {
+    return Status::invalid_argument("mapping.integrate_hz must be >= 0");
+  }
+  if (cfg.mapping.integrate_pass_rays <= 0) {
+    return Status::invalid_argument("mapping.integrate_pass_rays must be > 0");
+  }
+  if (cfg.mapping.integrate_threads < 0) {
+    return Status::invalid_argument("mapping.integrate_threads must be >= 0");
   }
   if (!AABB{cfg.mapping.roi.min, cfg.mapping.roi.max}.is_valid()) {
     return Status::invalid_argument("mapping.roi must be a valid AABB (min <= max)");
@@ -235,6 +397,18 @@ inline Status validate_config(const Config& cfg) {
   if (cfg.budgets.target_fps <= 0) {
     return Status::invalid_argument("budgets.target_fps must be > 0");
   }
+  if (!(cfg.budgets.downsample_voxel_m > 0.0f)) {
+    return Status::invalid_argument("budgets.downsample_voxel_m must be > 0");
+  }
+  if (cfg.budgets.downsample_threads < 0) {
+    return Status::invalid_argument("budgets.downsample_threads must be >= 0");
+  }
+  if (cfg.budgets.governor_window_frames < 2) {
+    return Status::invalid_argument("budgets.governor_window_frames must be >= 2");
+  }
+  if (!(cfg.budgets.governor_headroom > 0.0f && cfg.budgets.governor_headroom < 1.0f)) {
+    return Status::invalid_argument("budgets.governor_headroom must be in (0, 1)");
+  }
   if (cfg.output.out_dir.empty()) {
     return Status::invalid_argument("output.out_dir must not be empty");
   }
@@ -250,15 +424,61 @@ inline Status validate_config(const Config& cfg) {
   if (cfg.input.max_run_s < 0.0) {
     return Status::invalid_argument("input.max_run_s must be >= 0");
   }
+  if (cfg.input.batch_size <= 0) {
+    return Status::invalid_argument("input.batch_size must be > 0");
+  }
   if (cfg.input.synth.num_points <= 0) {
     return Status::invalid_argument("input.synth.num_points must be > 0");
   }
-  if (cfg.input.type != "synth" && cfg.input.type != "frame_dir") {
-    return Status::invalid_argument("input.type must be 'synth' or 'frame_dir'");
+  if (cfg.input.type != "synth" && cfg.input.type != "frame_dir" && cfg.input.type != "replay" &&
+      cfg.input.type != "merge") {
+    return Status::invalid_argument("input.type must be 'synth', 'frame_dir', 'replay' or 'merge'");
+  }
+  if (cfg.input.type == "merge" && cfg.input.sensors.empty()) {
+    return Status::invalid_argument("input.sensors must not be empty for merge input");
+  }
+  for (std::size_t i = 0; i < cfg.input.sensors.size(); ++i) {
+    const InputSensorConfig& s = cfg.input.sensors[i];
+    if (s.sensor_id.empty()) {
+      return Status::invalid_argument("input.sensors[].sensor_id must not be empty");
+    }
+    for (std::size_t j = 0; j < i; ++j) {
+      if (cfg.input.sensors[j].sensor_id == s.sensor_id) {
+        return Status::invalid_argument("input.sensors: duplicate sensor_id '" + s.sensor_id + "'");
+      }
+    }
+    if (s.type != "synth" && s.type != "frame_dir" && s.type != "replay") {
+      return Status::invalid_argument("input.sensors[" + s.sensor_id +
+                                      "].type must be 'synth', 'frame_dir' or 'replay'");
+    }
+    if (s.type != "synth" && s.path.empty()) {
+      return Status::invalid_argument("input.sensors[" + s.sensor_id + "].path must not be empty");
+    }
+  }
+  if (cfg.input.type == "replay" && cfg.replay.dataset_path.empty()) {
+    return Status::invalid_argument("replay.dataset_path must not be empty for replay input");
+  }
+  if (cfg.replay.time_scale < 0.0) {
+    return Status::invalid_argument("replay.time_scale must be >= 0");
+  }
+  if (cfg.replay.start_offset_ns < 0 || cfg.replay.end_offset_ns < 0) {
+    return Status::invalid_argument("replay.start_offset_s and replay.end_offset_s must be >= 0");
+  }
+  if (cfg.replay.end_offset_ns > 0 && cfg.replay.end_offset_ns <= cfg.replay.start_offset_ns) {
+    return Status::invalid_argument("replay.end_offset_s must be > replay.start_offset_s when set");
   }
   if (cfg.input.type == "frame_dir" && cfg.input.frame_dir.path.empty()) {
     return Status::invalid_argument("input.frame_dir.path must not be empty for frame_dir input");
   }
+  if (cfg.input.frame_dir.read_mode != "copy" && cfg.input.frame_dir.read_mode != "mmap") {
+    return Status::invalid_argument("input.frame_dir.read_mode must be 'copy' or 'mmap'");
+  }
+  if (cfg.input.frame_dir.prefetch_depth < 0) {
+    return Status::invalid_argument("input.frame_dir.prefetch_depth must be >= 0");
+  }
+  if (cfg.input.frame_dir.io_threads <= 0) {
+    return Status::invalid_argument("input.frame_dir.io_threads must be > 0");
+  }
   return Status::ok_status();
 }
 
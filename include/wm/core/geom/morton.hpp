@@ -0,0 +1,50 @@
+// File: include/wm/core/geom/morton.hpp
+#pragma once
+
+#include <cstdint>
+
+namespace wm {
+
+// 3D Morton (Z-order) codes: bit i of x, y, z lands at bits 3i, 3i+1, 3i+2, so sorting by
+// code visits space in nested octants. Up to 21 bits per axis (63-bit codes).
+inline constexpr int kMortonBitsPerAxis = 21;
+
+// Spreads the low 21 bits of v to every third bit.
+constexpr std::uint64_t morton_spread3(std::uint32_t v) noexcept {
+  std::uint64_t x = v & 0x1fffffu;
+  x = (x | (x << 32)) & 0x1f00000000ffffull;
+  x = (x | (x << 16)) & 0x1f0000ff0000ffull;
+  x = (x | (x << 8)) & 0x100f00f00f00f00full;
+  x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+  x = (x | (x << 2)) & 0x1249249249249249ull;
+  return x;
+}
+
+// Inverse of morton_spread3: gathers every third bit (starting at bit 0).
+constexpr std::uint32_t morton_compact3(std::uint64_t x) noexcept {
+  x &= 0x1249249249249249ull;
+  x = (x | (x >> 2)) & 0x10c30c30c30c30c3ull;
+  x = (x | (x >> 4)) & 0x100f00f00f00f00full;
+  x = (x | (x >> 8)) & 0x1f0000ff0000ffull;
+  x = (x | (x >> 16)) & 0x1f00000000ffffull;
+  x = (x | (x >> 32)) & 0x1fffffull;
+  return static_cast<std::uint32_t>(x);
+}
+
+// Unsigned coordinates only; callers offset signed grids first.
+constexpr std::uint64_t morton_encode3(std::uint32_t x, std::uint32_t y, std::uint32_t z) noexcept {
+  return morton_spread3(x) | (morton_spread3(y) << 1) | (morton_spread3(z) << 2);
+}
+
+constexpr void morton_decode3(std::uint64_t code, std::uint32_t& x, std::uint32_t& y,
+                              std::uint32_t& z) noexcept {
+  x = morton_compact3(code);
+  y = morton_compact3(code >> 1);
+  z = morton_compact3(code >> 2);
+}
+
+static_assert(morton_encode3(1, 0, 0) == 1 && morton_encode3(0, 1, 0) == 2 && morton_encode3(0, 0, 1) == 4);
+static_assert(morton_encode3(0x1fffff, 0x1fffff, 0x1fffff) == 0x7fffffffffffffffull);
+static_assert(morton_compact3(morton_spread3(0x15a5a5)) == 0x15a5a5);
+
+}  // namespace wm
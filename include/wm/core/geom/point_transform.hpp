@@ -0,0 +1,38 @@
+// File: include/wm/core/geom/point_transform.hpp
+#pragma once
+
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/types.hpp"
+#include "wm/core/util/simd.hpp"
+
+namespace wm {
+
+// a * b: the transform that applies b first, then a (e.g. T_site_node * T_node_lidar).
+TransformSE3 compose(const TransformSE3& a, const TransformSE3& b) noexcept;
+
+// Translation column of T (e.g. the sensor origin for T_site_lidar).
+inline Vec3f translation(const TransformSE3& T) noexcept { return Vec3f{T.m[3], T.m[7], T.m[11]}; }
+
+// Applies T to a single point (rigid part: rows 0..2).
+inline Vec3f transform_point(const TransformSE3& T, const Vec3f& p) noexcept {
+  const auto& m = T.m;
+  return Vec3f{m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3],
+               m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7],
+               m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]};
+}
+
+// Batch transforms over SoA lanes. The bottom row of T is ignored (SE(3) / affine).
+// All SIMD tiers evaluate ((m0*x + m1*y) + m2*z) + m3 with separate multiplies and adds, so
+// results are bit-identical across tiers. `level` is capped at what the CPU supports.
+//
+// out = T * in; intensity is copied. Contiguous inputs take a single pass; strided
+// (interleaved) inputs are de-interleaved into `out` first. `in` may be out.view() (handled
+// in place) but must not otherwise point into `out`.
+void transform_points(const TransformSE3& T, ConstPointView in, PointBuffer& out,
+                      SimdLevel level = best_simd_level());
+
+// In place on owned lanes. A borrowed buffer is materialised first (copy-on-write).
+void transform_points(const TransformSE3& T, PointBuffer& pts, SimdLevel level = best_simd_level());
+void transform_points(const TransformSE3& T, PointView pts, SimdLevel level = best_simd_level()) noexcept;
+
+}  // namespace wm
@@ -1,10 +1,11 @@
 // File: include/wm/core/io/frame.hpp
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <vector>
 
-#include "wm/core/types.hpp"  // TimestampNs, PointXYZI
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/types.hpp"  // TimestampNs, NodeId, FrameName
 
 namespace wm {
 
@@ -12,7 +13,31 @@ struct Frame {
   // Logical time for the frame. For synth: ticks since start. For replay: dataset time or ticks.
   TimestampNs t_ns{0};
   std::string frame_id;
-  std::vector<PointXYZI> points;
+  // Monotonic frame index within the source (deterministic replay + debugging).
+  std::uint64_t seq{0};
+  // Originating sensor on multi-LiDAR nodes (see MergeFrameSource): index into the node's
+  // sensor list and its configured id. Single-sensor sources leave 0 / empty, meaning the
+  // node-level calibration.T_node_lidar applies.
+  std::uint32_t sensor_index{0};
+  std::string sensor_id;
+  // SoA lanes (x / y / z / intensity). May borrow storage owned by the source (see PointBuffer).
+  PointBuffer points;
+};
+
+struct PointCloudFrame {
+  TimestampNs timestamp;
+  NodeId node_id;
+
+  // Frame these points are expressed in (typically "lidar" for raw sensor output).
+  FrameName frame = "lidar";
+
+  // Monotonic frame index within the dataset (deterministic replay + debugging).
+  std::uint64_t seq = 0;
+
+  PointBuffer points;
+
+  [[nodiscard]] std::size_t size() const noexcept { return points.size(); }
+  [[nodiscard]] bool empty() const noexcept { return points.empty(); }
 };
 
 }  // namespace wm
\ No newline at end of file
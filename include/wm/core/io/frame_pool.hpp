@@ -0,0 +1,84 @@
+// File: include/wm/core/io/frame_pool.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "wm/core/io/frame.hpp"
+
+namespace wm {
+
+struct FramePoolStats {
+  std::int64_t frames_allocated{0};  // Frames ever created by the pool
+  std::int64_t acquires{0};
+  std::int64_t reuses{0};            // acquires served from the idle list
+  std::size_t idle{0};
+};
+
+// Small pool of reusable Frames.
+// A Lease hands out a Frame whose point lanes and frame_id keep the capacity they grew to on
+// earlier ticks; when the lease is dropped (by the tick loop or by whichever stage held on
+// to the frame) the Frame goes back to the idle list instead of being freed.
+// Thread-safe. The pool must outlive every Lease it handed out.
+class FramePool {
+ public:
+  class Lease {
+   public:
+    Lease() = default;
+    Lease(Lease&& other) noexcept = default;
+    Lease& operator=(Lease&& other) noexcept {
+      if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        frame_ = std::move(other.frame_);
+      }
+      return *this;
+    }
+    ~Lease() { reset(); }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    [[nodiscard]] Frame& operator*() const noexcept { return *frame_; }
+    [[nodiscard]] Frame* operator->() const noexcept { return frame_.get(); }
+    [[nodiscard]] Frame* get() const noexcept { return frame_.get(); }
+    explicit operator bool() const noexcept { return frame_ != nullptr; }
+
+    // Returns the frame to the pool early.
+    void reset() {
+      if (frame_ && pool_ != nullptr) pool_->give_back(std::move(frame_));
+      frame_.reset();
+    }
+
+   private:
+    friend class FramePool;
+    Lease(FramePool* pool, std::unique_ptr<Frame> frame) : pool_(pool), frame_(std::move(frame)) {}
+
+    FramePool* pool_{nullptr};
+    std::unique_ptr<Frame> frame_;
+  };
+
+  // `max_idle`: frames kept for reuse; extra returns are freed.
+  // `reserve_points`: initial per-frame point capacity (0 = grow on first use).
+  explicit FramePool(std::size_t max_idle = 4, std::size_t reserve_points = 0);
+
+  // Reused frames come back cleared (no points, empty frame_id) with capacity intact.
+  [[nodiscard]] Lease acquire();
+
+  [[nodiscard]] FramePoolStats stats() const;
+
+ private:
+  void give_back(std::unique_ptr<Frame> frame);
+
+  std::size_t max_idle_;
+  std::size_t reserve_points_;
+
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Frame>> idle_;
+  FramePoolStats stats_;
+};
+
+}  // namespace wm
@@ -0,0 +1,98 @@
+// File: include/wm/core/io/frame_prefetcher.hpp
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "wm/core/io/frame.hpp"
+#include "wm/core/status.hpp"
+
+namespace wm {
+
+struct FramePrefetcherConfig {
+  // Maximum number of frames loaded ahead of the consumer (>= 1).
+  std::size_t depth{4};
+  // Background threads running the load function (>= 1).
+  int io_threads{1};
+  // Wrap around to item 0 after the last item instead of reporting eof.
+  bool loop{false};
+};
+
+struct FramePrefetchStats {
+  std::size_t queue_depth{0};      // frames ready right now
+  std::size_t max_queue_depth{0};  // high-water mark
+  std::int64_t frames_loaded{0};
+  std::int64_t load_ns{0};         // total time spent in the load function (all threads)
+  std::int64_t io_wait_ns{0};      // total time the consumer blocked waiting for a frame
+  std::int64_t io_waits{0};        // number of next() calls that had to block
+};
+
+// Bounded read-ahead over an indexed sequence of frames.
+// Items are loaded on background threads but always handed out in index order, so playback
+// stays deterministic regardless of io_threads. Load errors are delivered in order too.
+// The load function must be safe to call concurrently for different indices.
+//
+// Slots own their Frames. next_into() swaps the ready slot with the caller's frame, so the
+// caller's previous buffers go back into the ring and are refilled in place: once capacities
+// have warmed up, steady-state read-ahead does not allocate.
+class FramePrefetcher {
+ public:
+  using LoadFn = std::function<Status(std::size_t index, Frame& out)>;
+
+  FramePrefetcher(FramePrefetcherConfig cfg, std::size_t num_items, LoadFn load);
+  ~FramePrefetcher() { stop(); }
+
+  FramePrefetcher(const FramePrefetcher&) = delete;
+  FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+  void start();
+  void stop();
+
+  // Next frame in order. Status kOutOfRange ("eof") once all items are consumed (non-loop).
+  // `index_out` receives the item index (0..num_items-1) of the returned frame.
+  Status next_into(Frame& out, std::size_t* index_out = nullptr);
+  Result<Frame> next(std::size_t* index_out = nullptr);
+
+  // Up to out.size() frames in order under one lock acquisition. Blocks only for the first
+  // frame; after that it takes whatever is already loaded and stops at the first slot that
+  // is not ready or holds an error. Returns the number of frames filled (>= 1) or the
+  // error/eof of the first frame.
+  Result<std::size_t> next_batch(std::span<Frame> out);
+
+  [[nodiscard]] FramePrefetchStats stats() const;
+
+ private:
+  struct Slot {
+    Frame frame;
+    Status status;
+    bool ready{false};
+  };
+
+  void worker_loop();
+
+  FramePrefetcherConfig cfg_;
+  std::size_t num_items_{0};
+  LoadFn load_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_ready_;  // consumer waits on this
+  std::condition_variable cv_space_;  // workers wait on this
+
+  // Slot for sequence number s is slots_[s % depth]. Sequence numbers grow without bound
+  // (looping maps them back onto item indices with s % num_items).
+  std::vector<Slot> slots_;
+  std::uint64_t next_to_load_{0};
+  std::uint64_t next_to_consume_{0};
+  bool stopping_{false};
+
+  FramePrefetchStats stats_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace wm
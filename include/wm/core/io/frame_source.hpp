@@ -1,6 +1,10 @@
 // File: include/wm/core/io/frame_source.hpp
 #pragma once
 
+#include <cstddef>
+#include <span>
+#include <utility>
+
 #include "wm/core/io/frame.hpp"
 #include "wm/core/status.hpp"
 
@@ -12,6 +16,34 @@ class FrameSource {
   virtual Status open() = 0;
   virtual Result<Frame> next() = 0;
   virtual void close() = 0;
+
+  // Fills a caller-owned frame in place (same contract and errors as next()).
+  // Sources override this to reuse the frame's point capacity and frame_id storage, so a
+  // caller that keeps passing the same (or a pooled) Frame does no steady-state allocation.
+  // The default falls back to next() and moves the result in.
+  virtual Status next_into(Frame& out) {
+    auto r = next();
+    if (!r.ok()) return r.status();
+    out = r.take_value();
+    return Status::ok_status();
+  }
+
+  // Fills up to out.size() frames in source order and returns how many were filled.
+  // Stops early at eof or on an error after at least one frame; the condition is then
+  // reported by the next call. Returns the error itself (kOutOfRange at eof) only when
+  // no frame could be filled. Frames are reused in place, as with next_into().
+  // Sources override this to amortise per-call and I/O overhead across the batch.
+  virtual Result<std::size_t> next_batch(std::span<Frame> out) {
+    std::size_t n = 0;
+    for (; n < out.size(); ++n) {
+      const Status st = next_into(out[n]);
+      if (!st.ok()) {
+        if (n == 0) return Result<std::size_t>::err(st);
+        break;
+      }
+    }
+    return Result<std::size_t>::ok(n);
+  }
 };
 
 }  // namespace wm
@@ -0,0 +1,54 @@
+// File: include/wm/core/io/mapped_file.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "wm/core/status.hpp"
+
+namespace wm {
+
+// Memory mapping of a whole file (POSIX mmap), read-only or private copy-on-write.
+// Shared ownership is the lifetime contract: anything viewing the bytes (e.g. a PointBuffer
+// that borrowed its lanes) holds a shared_ptr, and the mapping is released with the last one.
+class MappedFile {
+ public:
+  enum class Access {
+    kSequential,  // one pass front to back (frame files)
+    kRandom,      // seeks (indexed datasets)
+  };
+
+  static Result<std::shared_ptr<const MappedFile>> open(const std::string& path,
+                                                        Access access = Access::kSequential);
+
+  // Writable private mapping: pages are read from the file on first touch and copied on
+  // first write; writes never reach the file.
+  static Result<std::shared_ptr<MappedFile>> open_copy_on_write(const std::string& path,
+                                                                Access access = Access::kRandom);
+
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] const std::byte* data() const noexcept { return data_; }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] const std::string& path() const noexcept { return path_; }
+  // Null unless opened with open_copy_on_write.
+  [[nodiscard]] std::byte* mutable_data() const noexcept { return writable_ ? const_cast<std::byte*>(data_) : nullptr; }
+
+  // Hint that [offset, offset + len) will be read soon (MADV_WILLNEED), so the kernel can
+  // start reading it in one request. Advisory only; out-of-range parts are ignored.
+  void advise_willneed(std::size_t offset, std::size_t len) const noexcept;
+
+ private:
+  MappedFile() = default;
+  static Result<std::shared_ptr<MappedFile>> map(const std::string& path, Access access, bool writable);
+
+  const std::byte* data_{nullptr};
+  bool writable_{false};
+  std::size_t size_{0};
+  std::string path_;
+};
+
+}  // namespace wm
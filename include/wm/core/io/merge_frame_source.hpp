@@ -0,0 +1,92 @@
+// File: include/wm/core/io/merge_frame_source.hpp
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wm/core/io/frame_source.hpp"
+#include "wm/core/types.hpp"
+
+namespace wm {
+
+// One sensor feeding a MergeFrameSource.
+struct MergeSensor {
+  std::string sensor_id;
+  TransformSE3 T_node_lidar = TransformSE3::identity();
+  std::unique_ptr<FrameSource> source;
+};
+
+struct MergeFrameSourceConfig {
+  // Frames fetched ahead per sensor (>= 1).
+  std::size_t queue_depth{2};
+};
+
+// Timestamp-ordered merge of several sensors on one node.
+// - Each child is pulled on its own thread into a small bounded queue, so a slow sensor
+//   only delays output when its next frame is genuinely the earliest one.
+// - Output is a k-way merge on t_ns over a min-heap of the children's head frames. Ties go
+//   to the lower sensor index, so the merged order is deterministic for a given input.
+// - Merged frames carry sensor_index / sensor_id of their child; seq is renumbered to count
+//   merged frames. sensor(i) exposes the child's T_node_lidar for downstream transforms.
+// - Sources that restart t_ns at 0 per child are assumed to share a time base.
+// - The first child error is returned as-is; the merge ends (eof) when every child has.
+class MergeFrameSource final : public FrameSource {
+ public:
+  MergeFrameSource(std::vector<MergeSensor> sensors, MergeFrameSourceConfig cfg = {});
+  ~MergeFrameSource() override { close(); }
+
+  MergeFrameSource(const MergeFrameSource&) = delete;
+  MergeFrameSource& operator=(const MergeFrameSource&) = delete;
+
+  Status open() override;
+  Result<Frame> next() override;
+  Status next_into(Frame& out) override;
+  void close() override;
+
+  [[nodiscard]] std::size_t num_sensors() const noexcept { return lanes_.size(); }
+  [[nodiscard]] const MergeSensor& sensor(std::size_t i) const noexcept { return lanes_[i]->sensor; }
+
+ private:
+  struct Lane {
+    MergeSensor sensor;
+    std::thread worker;
+    // Guarded by mu_.
+    std::deque<Frame> ready;
+    std::vector<Frame> spare;  // recycled frames handed back by the consumer
+    Status end_status;         // set once the child stops producing
+    bool finished{false};
+    // Consumer-only state.
+    Frame head;
+    bool in_heap{false};
+    bool exhausted{false};
+  };
+
+  struct HeapItem {
+    std::int64_t t_ns;
+    std::uint32_t lane;
+  };
+
+  void worker_loop(Lane& lane);
+  void stop_workers();
+
+  MergeFrameSourceConfig cfg_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+
+  std::mutex mu_;
+  std::condition_variable cv_ready_;  // consumer waits on this
+  std::condition_variable cv_space_;  // workers wait on this
+  bool stopping_{false};
+
+  std::vector<HeapItem> heap_;
+  std::uint64_t emitted_{0};
+  bool opened_{false};
+};
+
+}  // namespace wm
@@ -0,0 +1,171 @@
+// File: include/wm/core/io/point_buffer.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "wm/core/types.hpp"  // PointXYZI
+
+namespace wm {
+
+// Owned lanes (AlignedFloatLane) start on a cache line and their capacity is rounded up to whole
+// cache lines, so SIMD kernels working on owned storage can use aligned loads and may read (not
+// write) past size() up to the next 64-byte boundary. Borrowed and mmap'd views carry no such
+// guarantee: kernels taking a ConstPointView must handle the tail without reading past size.
+inline constexpr std::size_t kPointLaneAlignment = 64;
+inline constexpr std::size_t kPointLaneFloatsPerLine = kPointLaneAlignment / sizeof(float);
+
+// Owning 64-byte-aligned float array. Growing preserves contents; shrinking keeps capacity.
+class AlignedFloatLane {
+ public:
+  AlignedFloatLane() = default;
+  AlignedFloatLane(AlignedFloatLane&& other) noexcept = default;
+  AlignedFloatLane& operator=(AlignedFloatLane&& other) noexcept = default;
+
+  [[nodiscard]] float* data() noexcept { return data_.get(); }
+  [[nodiscard]] const float* data() const noexcept { return data_.get(); }
+  [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+
+  // Ensures capacity >= n, copying the first `keep` values into the new storage.
+  void reserve(std::size_t n, std::size_t keep);
+  // Copies the first n values of `other` (capacity grows as needed).
+  void assign(const AlignedFloatLane& other, std::size_t n);
+
+ private:
+  struct Deleter {
+    void operator()(float* p) const noexcept;
+  };
+
+  std::unique_ptr<float[], Deleter> data_;
+  std::size_t capacity_{0};
+};
+
+// Read-only view over point lanes.
+// `stride` is in floats: 1 for SoA lanes, 4 for interleaved x,y,z,intensity records
+// (e.g. a .bin frame viewed in place). Kernels should take the fast path when contiguous().
+struct ConstPointView {
+  const float* x = nullptr;
+  const float* y = nullptr;
+  const float* z = nullptr;
+  const float* intensity = nullptr;
+  std::size_t size = 0;
+  std::size_t stride = 1;
+
+  [[nodiscard]] bool contiguous() const noexcept { return stride == 1; }
+  [[nodiscard]] bool empty() const noexcept { return size == 0; }
+
+  [[nodiscard]] PointXYZI at(std::size_t i) const noexcept {
+    const std::size_t k = i * stride;
+    return PointXYZI{x[k], y[k], z[k], intensity[k]};
+  }
+
+  // Span accessors are only meaningful for contiguous views.
+  [[nodiscard]] std::span<const float> xs() const noexcept { return {x, size}; }
+  [[nodiscard]] std::span<const float> ys() const noexcept { return {y, size}; }
+  [[nodiscard]] std::span<const float> zs() const noexcept { return {z, size}; }
+  [[nodiscard]] std::span<const float> intensities() const noexcept { return {intensity, size}; }
+};
+
+// Mutable view over owned SoA lanes (always contiguous).
+struct PointView {
+  float* x = nullptr;
+  float* y = nullptr;
+  float* z = nullptr;
+  float* intensity = nullptr;
+  std::size_t size = 0;
+
+  [[nodiscard]] std::span<float> xs() const noexcept { return {x, size}; }
+  [[nodiscard]] std::span<float> ys() const noexcept { return {y, size}; }
+  [[nodiscard]] std::span<float> zs() const noexcept { return {z, size}; }
+  [[nodiscard]] std::span<float> intensities() const noexcept { return {intensity, size}; }
+
+  operator ConstPointView() const noexcept { return ConstPointView{x, y, z, intensity, size, 1}; }
+};
+
+// Structure-of-arrays point container: separate x / y / z / intensity lanes plus optional
+// named extra float fields (e.g. "ring", "t_offset"), all sized together.
+//
+// A buffer either owns its lanes or borrows them from external storage kept alive by a
+// shared handle (see borrow()). Mutable accessors on a borrowed buffer first copy the
+// points into owned lanes (copy-on-write), so the external storage is never written.
+class PointBuffer {
+ public:
+  PointBuffer() = default;
+  // Copies are deep for owned lanes; a borrowed buffer's copy shares the same external storage.
+  PointBuffer(const PointBuffer& other);
+  PointBuffer& operator=(const PointBuffer& other);
+  PointBuffer(PointBuffer&& other) noexcept;
+  PointBuffer& operator=(PointBuffer&& other) noexcept;
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] std::size_t capacity() const noexcept { return x_.capacity(); }
+  [[nodiscard]] bool is_borrowed() const noexcept { return borrowed_.x != nullptr; }
+
+  void reserve(std::size_t n);
+  void resize(std::size_t n);
+  // Keeps capacity (owned lanes) so steady-state reuse does not allocate.
+  void clear() noexcept;
+  // Shrinks to the first n points (n <= size()); used by in-place compaction.
+  void truncate(std::size_t n) noexcept;
+
+  void push_back(float x, float y, float z, float intensity);
+  void push_back(const PointXYZI& p) { push_back(p.x, p.y, p.z, p.intensity); }
+  void append(ConstPointView src);
+
+  [[nodiscard]] PointXYZI at(std::size_t i) const noexcept { return view().at(i); }
+
+  [[nodiscard]] ConstPointView view() const noexcept;
+  [[nodiscard]] PointView mutable_view();
+
+  // Mutable lane access (materialises a borrowed buffer).
+  [[nodiscard]] float* x() { return mutable_view().x; }
+  [[nodiscard]] float* y() { return mutable_view().y; }
+  [[nodiscard]] float* z() { return mutable_view().z; }
+  [[nodiscard]] float* intensity() { return mutable_view().intensity; }
+
+  // Extra fields. add_field() returns the existing lane if `name` is already present.
+  float* add_field(const std::string& name);
+  [[nodiscard]] float* field(const std::string& name) noexcept;
+  [[nodiscard]] const float* field(const std::string& name) const noexcept;
+  [[nodiscard]] std::size_t num_fields() const noexcept { return fields_.size(); }
+  // Lane of the k-th extra field (k < num_fields()), for stages that rewrite every lane.
+  [[nodiscard]] float* field_at(std::size_t k) noexcept { return fields_[k].data.data(); }
+
+  // Points the buffer at external lanes. `keepalive` must own (or share ownership of)
+  // the memory behind `v` for as long as this buffer (or a copy of it) refers to it.
+  // Extra fields are dropped.
+  void borrow(ConstPointView v, std::shared_ptr<const void> keepalive);
+
+  // Copies borrowed points into owned lanes. No-op for owned buffers.
+  void materialize();
+
+ private:
+  struct NamedLane {
+    std::string name;
+    AlignedFloatLane data;
+  };
+
+  void grow_to(std::size_t n);
+
+  AlignedFloatLane x_;
+  AlignedFloatLane y_;
+  AlignedFloatLane z_;
+  AlignedFloatLane i_;
+  std::vector<NamedLane> fields_;
+  std::size_t size_{0};
+
+  ConstPointView borrowed_{};
+  std::shared_ptr<const void> keepalive_;
+};
+
+// True if `v` is exactly buf.view(), i.e. a "buf -> out" kernel was handed its own output.
+[[nodiscard]] inline bool views_whole_buffer(const ConstPointView& v, const PointBuffer& buf) noexcept {
+  const ConstPointView b = buf.view();
+  return v.x == b.x && v.size == b.size && v.stride == b.stride;
+}
+
+}  // namespace wm
@@ -0,0 +1,61 @@
+// File: include/wm/core/io/quantized_points.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "wm/core/io/point_buffer.hpp"
+
+namespace wm {
+
+// Compact fixed-point point encoding (7 bytes/point instead of 16):
+//   x = offset_x + scale_x * qx      (qx: int16, likewise y/z)
+//   intensity = intensity_scale * qi (qi: uint8)
+// Parameters are chosen per frame from its bounding box, so the xyz step is
+// extent / 65534 (about 0.3 mm for a 20 m extent), far below cm-level voxel sizes.
+// A non-finite coordinate is stored as kQuantizedNaN (outside the +-32767 code range) and
+// decodes to NaN; a non-finite intensity is stored as 0.
+inline constexpr std::int16_t kQuantizedNaN = std::numeric_limits<std::int16_t>::min();
+
+struct QuantizationParams {
+  float scale[3] = {1.0f, 1.0f, 1.0f};
+  float offset[3] = {0.0f, 0.0f, 0.0f};
+  float intensity_scale = 1.0f / 255.0f;
+  float reserved[1] = {0.0f};
+};
+static_assert(sizeof(QuantizationParams) == 32);
+
+// Read-only view of quantized SoA lanes (e.g. borrowed from a mapped file).
+// Stages can consume it directly (at(), or arithmetic on the raw lanes) or decode it.
+struct QuantizedPointsView {
+  const std::int16_t* x = nullptr;
+  const std::int16_t* y = nullptr;
+  const std::int16_t* z = nullptr;
+  const std::uint8_t* intensity = nullptr;
+  std::size_t size = 0;
+  QuantizationParams params;
+
+  [[nodiscard]] PointXYZI at(std::size_t i) const noexcept {
+    const auto axis = [&](const std::int16_t* q, int a) {
+      return q[i] == kQuantizedNaN ? std::numeric_limits<float>::quiet_NaN()
+                                   : params.offset[a] + params.scale[a] * static_cast<float>(q[i]);
+    };
+    return PointXYZI{axis(x, 0), axis(y, 1), axis(z, 2), params.intensity_scale * static_cast<float>(intensity[i])};
+  }
+};
+
+inline constexpr std::size_t kQuantizedBytesPerPoint = 3 * sizeof(std::int16_t) + sizeof(std::uint8_t);
+
+// Per-frame parameters covering the bounding box and max intensity of the finite values.
+QuantizationParams choose_quantization(ConstPointView pts) noexcept;
+
+// Encodes `pts` into caller-provided lanes of pts.size elements each (values are clamped).
+void quantize_points(ConstPointView pts, const QuantizationParams& params, std::int16_t* x,
+                     std::int16_t* y, std::int16_t* z, std::uint8_t* intensity) noexcept;
+
+// Decodes into `out` (replacing its contents; capacity is reused).
+// AVX2 kernel when available, scalar otherwise; both produce identical results.
+void dequantize_points(const QuantizedPointsView& in, PointBuffer& out);
+
+}  // namespace wm
@@ -0,0 +1,116 @@
+// File: include/wm/core/mapping/block_pool.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace wm {
+
+// Transparent huge page size on x86-64 and aarch64 (4 KiB base pages).
+inline constexpr std::size_t kHugePageBytes = std::size_t{2} << 20;
+
+struct BlockPoolParams {
+  std::size_t block_bytes{1024};
+  // Blocks handed out and returned together (a map region's R^3 blocks).
+  std::size_t blocks_per_slab{8};
+  // Chunk size in blocks, rounded up to whole slabs (and with huge_pages to at least one
+  // huge page).
+  std::size_t blocks_per_chunk{256};
+  // Map chunks 2 MiB aligned, in whole huge pages, and advise them as transparent huge
+  // pages, so 2 MiB of blocks take one TLB entry instead of 512.
+  bool huge_pages{false};
+};
+
+struct BlockPoolStats {
+  std::size_t chunks{0};
+  std::size_t mapped_chunks{0};     // adopted from a restored snapshot
+  std::size_t huge_page_chunks{0};  // chunks the kernel accepted the huge page advice for
+  std::size_t chunk_bytes{0};
+  std::size_t slabs{0};             // carved so far (the pool's high-water mark)
+  std::size_t free_slabs{0};        // on the free list
+  // Totals since construction.
+  std::uint64_t slabs_taken{0};
+  std::uint64_t slabs_reused{0};    // of those, off the free list
+  std::uint64_t slabs_released{0};
+};
+
+// Slab allocator for equal-size voxel blocks. Memory comes in large chunks of anonymous
+// mapped memory (64 B aligned or better, zero until written), carved into slabs of
+// blocks_per_slab blocks that are handed out whole; a block's index is
+// slab * blocks_per_slab + slot and maps to a chunk by division, so there are no per-block
+// headers and no pointers to fix up. Released slabs go on a LIFO free list (the most
+// recently released, still cache-warm, is reused first) and are always reused before the
+// pool grows; chunks are kept until the pool is destroyed, so block pointers stay valid
+// and steady-state allocation never reaches the system allocator.
+//
+// Not thread-safe; the voxel map serialises take/release.
+class BlockPool {
+ public:
+  explicit BlockPool(BlockPoolParams params = {});
+
+  BlockPool(const BlockPool&) = delete;
+  BlockPool& operator=(const BlockPool&) = delete;
+  BlockPool(BlockPool&&) noexcept = default;
+  BlockPool& operator=(BlockPool&&) noexcept = default;
+
+  // Effective parameters (chunk size rounded as documented).
+  [[nodiscard]] const BlockPoolParams& params() const noexcept { return params_; }
+  [[nodiscard]] std::uint8_t* block_ptr(std::size_t b) const noexcept {
+    return chunks_[b / params_.blocks_per_chunk] + (b % params_.blocks_per_chunk) * params_.block_bytes;
+  }
+
+  // Returns a slab off the free list, else carves a new one (numbered num_slabs() before
+  // the call), mapping a chunk when the last one is full. Throws std::bad_alloc when the
+  // system is out of memory.
+  std::uint32_t take_slab();
+  void release_slab(std::uint32_t slab);
+  // Every slab carved so far becomes free, lowest numbered reused first.
+  void release_all();
+
+  [[nodiscard]] std::size_t num_slabs() const noexcept { return slabs_; }
+  [[nodiscard]] std::size_t free_slabs() const noexcept { return free_.size(); }
+  [[nodiscard]] std::size_t chunk_bytes() const noexcept { return params_.blocks_per_chunk * params_.block_bytes; }
+  [[nodiscard]] std::size_t memory_bytes() const noexcept { return chunks_.size() * chunk_bytes(); }
+
+  // Restores an empty pool over `chunks` existing chunks of blocks_per_chunk blocks each
+  // (a snapshot's voxel section), holding `slabs` slabs that are all in use; `backing`
+  // keeps that memory alive. New chunks continue at the same size.
+  void adopt(const std::vector<std::uint8_t*>& chunks, std::size_t blocks_per_chunk, std::size_t slabs,
+             std::shared_ptr<const void> backing);
+
+  [[nodiscard]] BlockPoolStats stats() const noexcept;
+
+ private:
+  // One anonymous mapping, unmapped on destruction.
+  class OwnedChunk {
+   public:
+    OwnedChunk(void* base, std::size_t bytes) noexcept : base_(base), bytes_(bytes) {}
+    OwnedChunk(OwnedChunk&& o) noexcept : base_(o.base_), bytes_(o.bytes_) { o.base_ = nullptr; }
+    OwnedChunk& operator=(OwnedChunk&& o) noexcept;
+    OwnedChunk(const OwnedChunk&) = delete;
+    OwnedChunk& operator=(const OwnedChunk&) = delete;
+    ~OwnedChunk();
+
+   private:
+    void* base_;
+    std::size_t bytes_;
+  };
+
+  void map_chunk();
+
+  BlockPoolParams params_;
+  std::vector<std::uint8_t*> chunks_;   // chunk base pointers: mapped ones first, then owned
+  std::vector<OwnedChunk> owned_;
+  std::shared_ptr<const void> mapped_;  // restored snapshot backing the first chunks
+  std::size_t mapped_chunks_{0};
+  std::size_t huge_page_chunks_{0};
+  std::size_t slabs_{0};
+  std::vector<std::uint32_t> free_;
+  std::uint64_t slabs_taken_{0};
+  std::uint64_t slabs_reused_{0};
+  std::uint64_t slabs_released_{0};
+};
+
+}  // namespace wm
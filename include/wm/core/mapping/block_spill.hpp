@@ -0,0 +1,80 @@
+// File: include/wm/core/mapping/block_spill.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wm/core/status.hpp"
+
+namespace wm {
+
+// Run-length code for voxel cells (cell_bytes 1 or 2): (u16 run, cell) pairs. Carved free
+// space saturates at the miss clamp and unobserved space stays 0, so blocks are long runs.
+void append_cells_rle(std::vector<std::uint8_t>& out, const void* cells, std::size_t n, std::size_t cell_bytes);
+// Decodes exactly n cells from [in, in + size); returns the bytes consumed, 0 if malformed.
+std::size_t read_cells_rle(const std::uint8_t* in, std::size_t size, void* cells, std::size_t n,
+                           std::size_t cell_bytes) noexcept;
+
+struct BlockSpillStats {
+  std::size_t records{0};          // records on disk
+  std::uint64_t file_bytes{0};     // including dead space awaiting compaction
+  std::uint64_t live_bytes{0};
+  std::uint64_t bytes_written{0};  // totals since open
+  std::uint64_t bytes_read{0};
+  std::size_t compactions{0};
+  std::size_t compaction_errors{0};  // failed compactions (the dead space stays)
+};
+
+// On-disk tier for evicted voxel regions: opaque byte records keyed by packed region key,
+// appended to one file and indexed in memory. Taking a record back frees it; the file is
+// rewritten without dead records once they outweigh live ones (and exceed 64 MiB). The
+// file is scratch space for one run: open() truncates it and it is removed on close.
+class BlockSpillFile {
+ public:
+  BlockSpillFile() = default;
+  ~BlockSpillFile();
+
+  BlockSpillFile(const BlockSpillFile&) = delete;
+  BlockSpillFile& operator=(const BlockSpillFile&) = delete;
+
+  Status open(const std::string& path);
+  [[nodiscard]] bool is_open() const noexcept { return fd_ >= 0; }
+  void close() noexcept;
+
+  // Stores `bytes` under `key`, replacing any older record. A failed compaction after the
+  // record is stored does not fail the put; see stats().compaction_errors and
+  // compaction_status().
+  Status put(std::uint64_t key, const std::vector<std::uint8_t>& bytes);
+  [[nodiscard]] bool contains(std::uint64_t key) const noexcept { return index_.count(key) != 0; }
+  // Reads the record of `key` into `out` and drops it. not_found if there is none.
+  Status take(std::uint64_t key, std::vector<std::uint8_t>& out);
+  // Reads the record of `key` into `out` and keeps it.
+  Status read(std::uint64_t key, std::vector<std::uint8_t>& out) const;
+  // Keys of every record, ascending.
+  [[nodiscard]] std::vector<std::uint64_t> keys() const;
+  // Drops every record.
+  Status clear();
+
+  [[nodiscard]] const BlockSpillStats& stats() const noexcept { return stats_; }
+  // Error of the last failed compaction (ok if none failed).
+  [[nodiscard]] const Status& compaction_status() const noexcept { return compaction_status_; }
+
+ private:
+  struct Record {
+    std::uint64_t offset{0};
+    std::uint64_t size{0};
+  };
+
+  Status compact();
+
+  std::string path_;
+  int fd_{-1};
+  std::unordered_map<std::uint64_t, Record> index_;
+  BlockSpillStats stats_;
+  Status compaction_status_;
+};
+
+}  // namespace wm
@@ -0,0 +1,77 @@
+// File: include/wm/core/mapping/integration_scheduler.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/mapping/multires_map.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+#include "wm/core/types.hpp"
+
+namespace wm {
+
+struct IntegrationSchedulerConfig {
+  // Batches per second of frame time (<= 0: every frame is integrated on arrival).
+  double integrate_hz{10.0};
+  // A batch is integrated early once it holds this many points, bounding the buffer when
+  // frame timestamps stall.
+  std::size_t max_batch_points{std::size_t{1} << 20};
+
+  static IntegrationSchedulerConfig from_config(const MappingConfig& m);
+};
+
+struct IntegrationSchedulerStats {
+  std::int64_t frames{0};           // frames queued
+  std::int64_t batches{0};          // batches integrated
+  std::int64_t points{0};           // points queued
+  std::size_t max_batch_frames{0};
+  std::int64_t integrate_ns{0};     // wall time spent integrating
+};
+
+// Decouples map updates from the input rate. Frames (map-frame points and the sensor
+// origin) are copied into one buffer and integrated together once per 1/integrate_hz as a
+// multi-origin RayIntegrator run, so a block seen by several frames of the batch is
+// allocated and visited once per pass of mapping.integrate_pass_rays rays instead of once
+// per frame. Every frame's rays are cast and every observation is applied (RayIntegrator
+// counts them per voxel), so the map depends on the frames, not on how they were batched.
+//
+// Windows follow frame timestamps, not the wall clock, so replay produces the same map at
+// any speed. A window opens at the first frame queued; the batch is integrated when a
+// frame at or past the window's end (or before its start: a looped replay) arrives, before
+// that frame is queued, or on flush(). The map therefore lags the newest frame by at most
+// one window plus one frame.
+class IntegrationScheduler {
+ public:
+  IntegrationScheduler(MultiResMap& map, RayIntegratorConfig rcfg, IntegrationSchedulerConfig cfg = {});
+
+  // Queues a frame; integrates the queued batch first if t_ns closes its window. Returns
+  // whether a batch was integrated.
+  bool push(TimestampNs t_ns, const Vec3f& origin, ConstPointView points);
+  // Integrates whatever is queued (end of input, before snapshotting the map).
+  bool flush();
+
+  [[nodiscard]] std::size_t queued_frames() const noexcept { return queued_.size(); }
+  [[nodiscard]] const IntegrationSchedulerStats& stats() const noexcept { return stats_; }
+  [[nodiscard]] RayIntegratorStats integrator_stats() const noexcept { return integrator_.stats(); }
+
+ private:
+  struct Queued {
+    Vec3f origin;
+    std::size_t begin;
+    std::size_t count;
+  };
+
+  MultiResIntegrator integrator_;
+  IntegrationSchedulerConfig cfg_;
+  std::int64_t period_ns_{0};
+  PointBuffer points_;
+  std::vector<Queued> queued_;
+  std::vector<RayBundle> bundles_;
+  TimestampNs window_start_{};
+  IntegrationSchedulerStats stats_;
+};
+
+}  // namespace wm
@@ -0,0 +1,69 @@
+// File: include/wm/core/mapping/log_odds.hpp
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "wm/core/util/simd.hpp"
+
+namespace wm {
+
+// Three-state voxel model. Log-odds 0 means "never observed".
+enum class VoxelState : std::uint8_t {
+  kUnknown = 0,
+  kFree = 1,
+  kOccupied = 2,
+};
+
+// -----------------------------
+// Fixed-point log-odds
+// -----------------------------
+// Voxels store clamped log-odds as int8 or int16 (`bits`), scaled so the larger clamp
+// bound maps to the type's maximum: int16 resolves ~1e-4, int8 ~0.03 at the default
+// [-2, 3.5] clamps. Updates are integer adds, so maps are bit-exact across SIMD tiers.
+struct LogOddsModel {
+  int bits{16};
+  float scale{0.0f};        // cell units per unit of log-odds
+  std::int32_t hit{0};      // per-observation increments, in cell units
+  std::int32_t miss{0};
+  std::int32_t min{0};      // clamp bounds
+  std::int32_t max{0};
+  std::int32_t occupied{0};  // cells above this are occupied
+  std::int32_t free{0};      // cells below this are free
+
+  static LogOddsModel make(int bits, float hit, float miss, float min, float max, float occupied, float free) noexcept;
+
+  [[nodiscard]] std::size_t cell_bytes() const noexcept { return bits == 8 ? 1 : 2; }
+  [[nodiscard]] std::int32_t encode(float log_odds) const noexcept {
+    const std::int32_t limit = bits == 8 ? 127 : 32767;
+    return static_cast<std::int32_t>(std::clamp(std::lround(log_odds * scale), -long{limit}, long{limit}));
+  }
+  [[nodiscard]] float decode(std::int32_t cell) const noexcept { return static_cast<float>(cell) / scale; }
+  [[nodiscard]] VoxelState classify(std::int32_t cell) const noexcept {
+    return cell > occupied ? VoxelState::kOccupied : (cell < free ? VoxelState::kFree : VoxelState::kUnknown);
+  }
+};
+
+// Observations applied by apply_block_updates.
+struct BlockUpdateCounts {
+  std::int64_t hits{0};
+  std::int64_t misses{0};
+};
+
+// Applies one pass of updates to a block of n cells (int8 or int16 per model.bits): cell i
+// gets hits[i] * model.hit + misses[i] * model.miss (the pass's observation counts of the
+// voxel), clamped to [model.min, model.max]. Counts are cleared. The whole block is
+// processed branch-free, the sums in int32 (16 cells per AVX2 step).
+BlockUpdateCounts apply_block_updates(const LogOddsModel& model, void* cells, std::uint8_t* hits,
+                                      std::uint8_t* misses, std::size_t n,
+                                      SimdLevel level = best_simd_level()) noexcept;
+
+// Occupancy bitmasks of a block of n cells: bit i % 64 of word i / 64 is set in
+// `occupied` when cell i classifies occupied and in `known` when it is free or occupied.
+// Writes (n + 63) / 64 words to each (32 cells per AVX2 compare and movemask).
+void classify_block(const LogOddsModel& model, const void* cells, std::size_t n, std::uint64_t* occupied,
+                    std::uint64_t* known, SimdLevel level = best_simd_level()) noexcept;
+
+}  // namespace wm
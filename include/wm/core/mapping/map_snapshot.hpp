@@ -0,0 +1,93 @@
+// File: include/wm/core/mapping/map_snapshot.hpp
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "wm/core/config.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+#include "wm/core/status.hpp"
+
+namespace wm {
+
+// -----------------------------
+// Map snapshot format (.wmmap), version 4
+// -----------------------------
+// A VoxelBlockMap written so that restoring it is a mapping, not a parse:
+//
+//   MapSnapshotHeader                     (128 B, offset 0)
+//   region keys   u64[num_regions]        (64 B aligned)
+//   block keys    u64[num_regions * R^3]  (64 B aligned; ~0 = unused slot)
+//   block masks   u64[num_regions * R^3 * 2 * W]  (64 B aligned, right after the keys;
+//                 occupied then known bits per block, W = ceil(B^3 / 64))
+//   voxels        cell[chunks * blocks_per_chunk * B^3]   (page aligned; int8 or int16)
+//
+// Regions are renumbered 0..num_regions-1, so every reference in the file is an offset or
+// an index (position independent). The voxel section is the map's pool verbatim (region
+// r's blocks at r * R^3, chunk padding zeroed), so a restored map points its pool chunks
+// into a private copy-on-write mapping of the file: voxels are paged in on first touch
+// and copied only if written, and nothing is parsed beyond the key arrays (to rebuild the
+// hash tables) and the occupancy masks (copied; region summaries are rebuilt from them).
+// A frozen baseline restored this way shares the page cache.
+//
+// Snapshots are keyed by compute_map_config_hash and compute_calibration_hash; a snapshot
+// written under another map config or calibration is rejected rather than reused.
+// All integers are little-endian.
+
+static_assert(std::endian::native == std::endian::little, "map snapshot assumes little-endian");
+
+inline constexpr char kMapSnapshotMagic[8] = {'W', 'M', 'M', 'A', 'P', 'S', '0', '1'};
+// 2: fixed-point log-odds cells, 3: occupancy masks, 4: checksum covers the masks
+inline constexpr std::uint32_t kMapSnapshotVersion = 4;
+inline constexpr std::size_t kMapSnapshotVoxelAlignment = 4096;
+
+struct MapSnapshotHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t header_bytes;      // sizeof(MapSnapshotHeader)
+  char config_hash[16];            // hex, as compute_map_config_hash
+  char calibration_hash[16];       // hex, as compute_calibration_hash
+  float voxel_size_m;
+  std::int32_t block_size_vox;
+  std::int32_t region_size_blocks;
+  std::uint32_t flags;             // bit 0: Morton voxel order, bit 1: int8 cells (else int16)
+  std::uint64_t num_regions;
+  std::uint64_t num_blocks;
+  std::uint64_t blocks_per_chunk;
+  std::uint64_t region_keys_offset;
+  std::uint64_t block_keys_offset;
+  std::uint64_t voxels_offset;
+  std::uint64_t voxels_bytes;
+  std::uint64_t index_checksum;    // FNV-1a 64 over the key and mask words
+};
+static_assert(sizeof(MapSnapshotHeader) == 128);
+
+inline constexpr std::uint32_t kMapSnapshotMortonVoxels = 1u << 0;
+inline constexpr std::uint32_t kMapSnapshotInt8Cells = 1u << 1;
+
+// What a snapshot must match to be reused.
+struct MapSnapshotKey {
+  std::string config_hash;
+  std::string calibration_hash;
+
+  static MapSnapshotKey from_config(const Config& cfg);
+};
+
+// Writes `map` to `path` (via `path`.tmp and a rename, so a crash never leaves a torn
+// snapshot behind). Regions the memory budget spilled to disk are read back from the spill
+// file and written after the live ones, so the snapshot holds the whole map and a map
+// restored from it has every region resident (it evicts again once it integrates over
+// budget). Regions evicted without a spill file are gone and not in the snapshot.
+Status save_map_snapshot(const VoxelBlockMap& map, const MapSnapshotKey& key, const std::string& path);
+
+// Maps the snapshot at `path` and returns a map over it. Fails with not_found when there
+// is no snapshot, invalid_argument when it is stale (key or map geometry differs from
+// `key` / `params`) and corrupt_data when it is damaged (including a block key that does
+// not belong to its region or slot); callers fall back to relearning.
+// O(regions) work; voxel pages are read lazily (with a readahead hint).
+Result<VoxelBlockMap> load_map_snapshot(const std::string& path, const MapSnapshotKey& key,
+                                        const VoxelBlockMapParams& params);
+
+}  // namespace wm
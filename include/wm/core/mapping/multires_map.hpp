@@ -0,0 +1,99 @@
+// File: include/wm/core/mapping/multires_map.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/mapping/ray_integrator.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+#include "wm/core/types.hpp"
+#include "wm/core/util/thread_pool.hpp"
+
+namespace wm {
+
+struct MultiResMapParams {
+  // Level 0 (finest). Level i uses voxel_size_m * 2^i with the same block size, ROI, layout
+  // and occupancy model.
+  VoxelBlockMapParams base;
+  // Number of levels (1 = a single map at base resolution).
+  int levels{1};
+  // Level 0 covers distances [0, near_m) from center, level i >= 1 covers
+  // [near_m * 2^(i-1), near_m * 2^i); the last level extends to infinity. Each level
+  // keeps roughly the same voxels per unit of angle, matching the beam spacing.
+  float near_m{10.0f};
+  // Band center in the map frame (the node origin: the sensor mount for a fixed site).
+  Vec3f center{0.0f, 0.0f, 0.0f};
+
+  static MultiResMapParams from_config(const MappingConfig& m);
+};
+
+// Range-banded levels of detail: one VoxelBlockMap per level, each owning the points whose
+// distance from params.center falls in its band. Every position belongs to exactly one
+// level, so queries resolve without blending and integration never writes a voxel twice
+// (only voxels straddling a band boundary are present in both neighbours).
+class MultiResMap {
+ public:
+  explicit MultiResMap(MultiResMapParams params = {});
+  explicit MultiResMap(const MappingConfig& cfg) : MultiResMap(MultiResMapParams::from_config(cfg)) {}
+
+  [[nodiscard]] const MultiResMapParams& params() const noexcept { return params_; }
+  [[nodiscard]] int num_levels() const noexcept { return static_cast<int>(levels_.size()); }
+  [[nodiscard]] VoxelBlockMap& level(int i) noexcept { return levels_[static_cast<std::size_t>(i)]; }
+  [[nodiscard]] const VoxelBlockMap& level(int i) const noexcept { return levels_[static_cast<std::size_t>(i)]; }
+
+  // Band of level i, in metres from params.center.
+  [[nodiscard]] float band_min_m(int i) const noexcept;
+  [[nodiscard]] float band_max_m(int i) const noexcept;
+  // Level owning p.
+  [[nodiscard]] int level_of(const Vec3f& p) const noexcept;
+
+  // Queries at p, answered by the level owning p.
+  [[nodiscard]] float log_odds(const Vec3f& p) const noexcept { return level(level_of(p)).log_odds(p); }
+  [[nodiscard]] VoxelState state(const Vec3f& p) const noexcept { return level(level_of(p)).state(p); }
+
+  // VoxelBlockMap::integrate_hits, each point into the level owning it.
+  std::size_t integrate_hits(ConstPointView pts);
+
+  // Occupied / known voxels over all levels (bitmask popcounts, see VoxelBlockMap).
+  [[nodiscard]] std::size_t count_occupied() const noexcept;
+  [[nodiscard]] std::size_t count_known() const noexcept;
+
+  // Summed over levels (shards: per level).
+  [[nodiscard]] VoxelBlockMapStats stats() const noexcept;
+
+ private:
+  MultiResMapParams params_;
+  std::vector<VoxelBlockMap> levels_;
+  std::vector<PointBuffer> split_;  // [level] integrate_hits scratch
+};
+
+// Ray casting into a MultiResMap: one RayIntegrator per level, each clipped to its level's
+// band, sharing one thread pool. A ray costs about (band length / voxel size) steps per
+// level it crosses instead of (range / finest voxel size).
+class MultiResIntegrator {
+ public:
+  MultiResIntegrator(MultiResMap& map, RayIntegratorConfig cfg);
+
+  void integrate(const Vec3f& origin, ConstPointView points);
+  void integrate(std::span<const RayBundle> bundles);
+  void integrate_scan(const TransformSE3& T_map_lidar, ConstPointView lidar_points);
+
+  [[nodiscard]] const RayIntegratorStats& stats(int level) const noexcept {
+    return levels_[static_cast<std::size_t>(level)]->stats();
+  }
+  // Summed over levels, except rays (offered once, to every level). rays_skipped counts a
+  // ray once per level whose band it misses.
+  [[nodiscard]] RayIntegratorStats stats() const noexcept;
+  [[nodiscard]] int threads() const noexcept { return pool_.size(); }
+
+ private:
+  ThreadPool pool_;
+  std::vector<std::unique_ptr<RayIntegrator>> levels_;
+  PointBuffer transformed_;
+};
+
+}  // namespace wm
@@ -0,0 +1,149 @@
+// File: include/wm/core/mapping/ray_integrator.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+#include "wm/core/types.hpp"
+#include "wm/core/util/simd.hpp"
+#include "wm/core/util/thread_pool.hpp"
+
+namespace wm {
+
+struct RayIntegratorConfig {
+  // Worker threads including the caller (<= 0: hardware concurrency).
+  int threads{0};
+  // Returns closer than min_range_m are dropped; beyond max_range_m the ray is truncated
+  // at max_range_m and only carves free space (no hit).
+  float min_range_m{0.2f};
+  float max_range_m{50.0f};
+  // Rays are clipped to the map ROI before stepping; nothing outside it is touched. Without
+  // it rays are still clipped to the block key range (VoxelBlockMap::key_extent).
+  bool clip_to_roi{true};
+  // Range band: only the parts of a ray whose distance from band_center lies in
+  // [band_min_m, band_max_m) are integrated, and the return counts as a hit only if it lies
+  // in the band too. Multi-resolution maps give each level one band (MultiResMap).
+  Vec3f band_center{0.0f, 0.0f, 0.0f};
+  float band_min_m{0.0f};
+  float band_max_m{std::numeric_limits<float>::infinity()};
+  // Rays traversed per pass. Bounds the update buffers (~4 B per voxel step, so ~35 MB
+  // for 10 m rays at 2 cm); larger passes visit a block shared by many rays fewer times.
+  std::size_t rays_per_batch{16384};
+  // Tier of the block update kernel (capped at what the CPU supports).
+  SimdLevel simd{best_simd_level()};
+
+  static RayIntegratorConfig from_config(const MappingConfig& m);
+};
+
+// Points cast from one origin (e.g. one frame), as part of a multi-frame batch.
+struct RayBundle {
+  Vec3f origin;
+  ConstPointView points;
+};
+
+struct RayIntegratorStats {
+  std::int64_t rays{0};           // rays offered
+  std::int64_t rays_skipped{0};   // too short, or entirely outside the ROI / band
+  std::int64_t hits{0};           // occupied observations applied
+  std::int64_t misses{0};         // free observations applied
+  std::int64_t voxel_steps{0};    // DDA steps taken
+  std::int64_t blocks_touched{0}; // sum over passes
+  // Wall time per phase, summed over passes.
+  std::int64_t traverse_ns{0};
+  std::int64_t allocate_ns{0};    // block insertion and memory-budget eviction
+  std::int64_t apply_ns{0};
+};
+
+// Free/occupied/unknown integration by ray casting (Amanatides & Woo 3D-DDA).
+//
+// Each pass over rays_per_batch rays runs in three phases:
+//  1. Traverse (parallel over contiguous ray ranges): every voxel a ray crosses inside the
+//     ROI becomes a miss, its endpoint voxel a hit. Updates are appended to per-thread
+//     buckets, one bucket per map shard.
+//  2. Allocate (parallel over shards, VoxelBlockMap::insert_sharded): blocks first seen in
+//     this pass are inserted into the map.
+//  3. Apply (parallel over shards): each shard owns a disjoint set of blocks, so updates
+//     are written without locks. Each voxel's hits and misses in the pass are counted
+//     (saturating at 255) and applied at once as hits * hit + misses * miss; blocks with
+//     many counted voxels are updated whole by the fixed-point kernel
+//     (apply_block_updates), the rest voxel by voxel. Every observation counts, so how
+//     rays are split into passes or frames into batches changes only where a cell reaches
+//     a clamp bound (or a count saturates) within a pass. Touched blocks are stamped as
+//     observed, and the map then enforces its memory budget.
+// The only serial work per pass is handing out pool slabs for new regions and summing
+// stats, so a frame scales with cores as long as shards outnumber threads.
+// The resulting map does not depend on the thread count or scheduling.
+class RayIntegrator {
+ public:
+  RayIntegrator(VoxelBlockMap& map, RayIntegratorConfig cfg);
+  // Runs on a pool shared with other integrators (cfg.threads is ignored).
+  RayIntegrator(VoxelBlockMap& map, RayIntegratorConfig cfg, ThreadPool& pool);
+
+  // `origin` and `points` are in the map frame (e.g. translation(T_site_lidar) and the
+  // transformed returns).
+  void integrate(const Vec3f& origin, ConstPointView points);
+  // Several origins (frames) in one run of passes: a pass may span bundles, so a block
+  // seen by several frames is allocated and visited once per pass, while each frame's
+  // observations of a voxel still count.
+  void integrate(std::span<const RayBundle> bundles);
+
+  // Convenience: transforms sensor-frame points by T_map_lidar (SIMD kernel) and casts
+  // from the sensor origin, translation(T_map_lidar).
+  void integrate_scan(const TransformSE3& T_map_lidar, ConstPointView lidar_points);
+
+  [[nodiscard]] const RayIntegratorStats& stats() const noexcept { return stats_; }
+  [[nodiscard]] int threads() const noexcept { return pool_->size(); }
+
+ private:
+  static constexpr std::uint32_t kHitBit = 0x80000000u;
+  static constexpr std::size_t kRunHeader = 4;
+  static constexpr std::uint32_t kNoSlot = 0xffffffffu;
+
+  // Per-task traversal output.
+  struct Scratch {
+    // One bucket per map shard (partition). Each holds runs of consecutive voxels of one ray in
+    // one block: [key lo, key hi, block index, count, entry * count], where the block index
+    // is kInvalidBlock for blocks allocated after traversal and entry = voxel offset | kHitBit.
+    std::vector<std::vector<std::uint32_t>> buckets;
+    std::vector<std::vector<std::uint64_t>> new_blocks;  // [shard]: keys not in the map when first seen
+    std::int64_t voxel_steps{0};
+    std::int64_t skipped{0};
+  };
+
+  // Per-partition (map shard) apply state.
+  struct PartitionScratch {
+    std::vector<std::uint8_t> marks;     // per block: hit counts, then miss counts (voxels_per_block each)
+    std::vector<BlockIndex> blocks;      // touched blocks, in first-touch order
+    std::vector<std::uint32_t> updates;  // per block: voxels marked (0 once applied)
+    std::int64_t hits{0};
+    std::int64_t misses{0};
+  };
+
+  void traverse_range(const Vec3f& origin, ConstPointView pts, std::size_t begin, std::size_t end,
+                      Scratch& s) const;
+  // Parts of the segment origin + t * d, t in [t0, t1], inside the band; returns how many.
+  int band_pieces(const Vec3f& origin, const Vec3f& d, float t0, float t1, float (&pieces)[2][2]) const noexcept;
+  void apply_partition(std::size_t p);
+  void init();
+
+  VoxelBlockMap& map_;
+  RayIntegratorConfig cfg_;
+  std::unique_ptr<ThreadPool> owned_pool_;
+  ThreadPool* pool_{nullptr};
+
+  std::vector<Scratch> scratch_;            // [task]
+  std::vector<PartitionScratch> partitions_;
+  std::vector<std::uint32_t> mark_slot_;    // [block index] -> slot in its partition's marks
+  std::vector<std::size_t> bundle_start_;   // integrate(bundles): first ray of each bundle
+  PointBuffer transformed_;
+  RayIntegratorStats stats_;
+};
+
+}  // namespace wm
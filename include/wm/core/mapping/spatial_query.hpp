@@ -0,0 +1,215 @@
+// File: include/wm/core/mapping/spatial_query.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "wm/core/mapping/log_odds.hpp"
+#include "wm/core/mapping/multires_map.hpp"
+#include "wm/core/mapping/voxel_block_map.hpp"
+#include "wm/core/types.hpp"
+
+namespace wm {
+
+// Voxels of one query box by state. A box covers every voxel it intersects, max exclusive:
+// along an axis, voxel i spans [i, i + 1) * voxel size.
+struct BoxQueryResult {
+  std::uint64_t voxels{0};  // saturates at UINT64_MAX (boxes spanning most of the key range)
+  std::uint64_t known{0};  // free or occupied
+  std::uint64_t occupied{0};
+
+  [[nodiscard]] std::uint64_t free() const noexcept { return known - occupied; }
+  [[nodiscard]] std::uint64_t unknown() const noexcept { return voxels - known; }
+  // Every voxel was observed free (unknown space is not free).
+  [[nodiscard]] bool all_free() const noexcept { return occupied == 0 && known == voxels; }
+};
+
+struct OccupiedVoxel {
+  Vec3f center;
+  std::uint32_t query{0};  // index of the box it lies in
+};
+
+// Immutable copy of a VoxelBlockMap's occupancy: each block's occupied and known bitmasks
+// (2 bits per voxel, an eighth of int16 cells), with blocks sorted by a key ordered z, y,
+// x, so a run of x-adjacent blocks is a run of the arrays. Blocks with no known voxel are
+// left out (they read as unknown). Nothing refers back to the map: a snapshot can be
+// queried from any number of threads while the map keeps integrating, and lives as long
+// as its last shared_ptr.
+class OccupancySnapshot {
+ public:
+  // Copies the map's masks. Must not overlap writes to `map` (call it on the integrating
+  // thread between passes). `sequence` is the caller's stamp (e.g. frame time or count).
+  // O(blocks log blocks).
+  static std::shared_ptr<const OccupancySnapshot> capture(const VoxelBlockMap& map, std::uint64_t sequence = 0);
+
+  OccupancySnapshot(const OccupancySnapshot&) = delete;
+  OccupancySnapshot& operator=(const OccupancySnapshot&) = delete;
+
+  [[nodiscard]] float voxel_size() const noexcept { return voxel_size_; }
+  [[nodiscard]] int block_size() const noexcept { return block_size_; }
+  [[nodiscard]] std::size_t num_blocks() const noexcept { return keys_.size(); }
+  [[nodiscard]] std::uint64_t sequence() const noexcept { return sequence_; }
+  [[nodiscard]] std::size_t memory_bytes() const noexcept;
+
+  // State of the voxel at p (one binary search; batch with SpatialQuery).
+  [[nodiscard]] VoxelState state(const Vec3f& p) const noexcept;
+
+  // Sort key of block (x, y, z): biased coordinates packed z, y, x from the top, so keys
+  // order like (z, y, x) tuples and consecutive x in a row are consecutive keys.
+  static constexpr std::uint64_t order_key(std::int64_t x, std::int64_t y, std::int64_t z) noexcept {
+    constexpr std::int64_t bias = std::int64_t{1} << (kBlockKeyBits - 1);
+    return (static_cast<std::uint64_t>(z + bias) << (2 * kBlockKeyBits)) |
+           (static_cast<std::uint64_t>(y + bias) << kBlockKeyBits) | static_cast<std::uint64_t>(x + bias);
+  }
+
+ private:
+  friend class SpatialQuery;
+
+  OccupancySnapshot() = default;
+
+  // Position of block `key` in keys_, or num_blocks().
+  [[nodiscard]] std::size_t find(std::uint64_t key) const noexcept;
+  [[nodiscard]] const std::uint64_t* occupied(std::size_t i) const noexcept { return masks_.data() + i * 2 * words_; }
+  [[nodiscard]] const std::uint64_t* known(std::size_t i) const noexcept { return occupied(i) + words_; }
+  // Offsets with axis coordinate in [lo, hi] (mask words_ words).
+  [[nodiscard]] const std::uint64_t* axis_range(int axis, std::int32_t lo, std::int32_t hi) const noexcept {
+    return ranges_.data() + range_at(axis, lo, hi);
+  }
+  [[nodiscard]] std::size_t range_at(int axis, std::int32_t lo, std::int32_t hi) const noexcept {
+    const auto b = static_cast<std::size_t>(block_size_);
+    return ((static_cast<std::size_t>(axis) * b + static_cast<std::size_t>(lo)) * b + static_cast<std::size_t>(hi)) *
+           words_;
+  }
+  [[nodiscard]] std::uint32_t offset(std::int32_t lx, std::int32_t ly, std::int32_t lz) const noexcept {
+    return axis_index_[static_cast<std::size_t>(lx)] + axis_index_[static_cast<std::size_t>(block_size_ + ly)] +
+           axis_index_[static_cast<std::size_t>(2 * block_size_ + lz)];
+  }
+
+  float voxel_size_{0.02f};
+  float inv_voxel_size_{50.0f};
+  std::int32_t block_size_{8};
+  std::size_t words_{8};  // mask words per block and kind
+  std::uint64_t sequence_{0};
+  std::vector<std::uint64_t> keys_;         // order_key per block, ascending
+  std::vector<std::uint64_t> masks_;        // per block: occupied words, known words
+  std::vector<std::uint32_t> axis_index_;   // [axis * B + l]: offset contribution (as the map)
+  std::vector<std::uint16_t> local_;        // [offset * 3 + axis]: block-local coordinate
+  std::vector<std::uint64_t> ranges_;       // [(axis * B + lo) * B + hi]: axis_range masks
+};
+
+// Snapshots of every MultiResMap level, routed like the map: a point is answered by the
+// level owning it (MultiResMap::level_of), so beyond the near band the coarse levels answer
+// instead of level 0 reading unknown. A box is answered by the finest level it reaches (the
+// one owning its point nearest the band center); where it extends into coarser bands, that
+// part reads as unknown, never as free.
+class MultiResOccupancySnapshot {
+ public:
+  // OccupancySnapshot::capture of each level (same threading rule).
+  static std::shared_ptr<const MultiResOccupancySnapshot> capture(const MultiResMap& map, std::uint64_t sequence = 0);
+
+  MultiResOccupancySnapshot(const MultiResOccupancySnapshot&) = delete;
+  MultiResOccupancySnapshot& operator=(const MultiResOccupancySnapshot&) = delete;
+
+  [[nodiscard]] int num_levels() const noexcept { return static_cast<int>(levels_.size()); }
+  [[nodiscard]] const OccupancySnapshot& level(int i) const noexcept { return *levels_[static_cast<std::size_t>(i)]; }
+  [[nodiscard]] std::uint64_t sequence() const noexcept { return sequence_; }
+  [[nodiscard]] std::size_t num_blocks() const noexcept;  // over levels
+  [[nodiscard]] std::size_t memory_bytes() const noexcept;
+
+  // Level answering queries at p / for box.
+  [[nodiscard]] int level_of(const Vec3f& p) const noexcept;
+  [[nodiscard]] int level_of(const AABB& box) const noexcept;
+
+  [[nodiscard]] VoxelState state(const Vec3f& p) const noexcept { return level(level_of(p)).state(p); }
+
+ private:
+  MultiResOccupancySnapshot() = default;
+
+  Vec3f center_{};
+  std::vector<float> band_max_;  // [level]: MultiResMap::band_max_m
+  std::uint64_t sequence_{0};
+  std::vector<std::shared_ptr<const OccupancySnapshot>> levels_;
+};
+
+// Batch point and box queries against a snapshot. Points are expanded to block keys,
+// sorted, and merged with the snapshot's sorted blocks in one forward pass, so each block
+// is located once per batch however many points share it. Boxes are sorted by first block
+// and each walks the snapshot's blocks inside it, reading whole mask words (popcounts over
+// the box's voxel range) instead of looking voxels up one by one. Holds sort scratch: use
+// one per thread; the snapshot itself is shared.
+class SpatialQuery {
+ public:
+  // out[i] = state of the voxel at points[i]. out.size() must equal points.size().
+  void states(const OccupancySnapshot& snap, std::span<const Vec3f> points, std::span<VoxelState> out);
+
+  // out[i] = voxel counts of boxes[i] (an invalid or empty box has no voxels). With
+  // `occupied`, also appends every occupied voxel of every box (grouped by block, not by
+  // box). out.size() must equal boxes.size(). Cost grows with the observed blocks of
+  // each box and the observed block rows (y, z) between its first and last block, not
+  // with its volume.
+  void boxes(const OccupancySnapshot& snap, std::span<const AABB> boxes, std::span<BoxQueryResult> out,
+             std::vector<OccupiedVoxel>* occupied = nullptr);
+
+  // As above, each query answered by its level (see MultiResOccupancySnapshot).
+  void states(const MultiResOccupancySnapshot& snap, std::span<const Vec3f> points, std::span<VoxelState> out);
+  void boxes(const MultiResOccupancySnapshot& snap, std::span<const AABB> boxes, std::span<BoxQueryResult> out,
+             std::vector<OccupiedVoxel>* occupied = nullptr);
+
+ private:
+  struct PointItem {
+    std::uint64_t key;
+    std::uint32_t offset;
+    std::uint32_t query;
+  };
+  struct BoxRange {
+    std::int32_t v0[3];  // voxel range, inclusive
+    std::int32_t v1[3];
+    std::int32_t b0[3];  // block range, inclusive
+    std::int32_t b1[3];
+  };
+  struct BoxItem {
+    std::uint64_t key;  // order key of the box's first block
+    std::uint32_t query;
+  };
+
+  std::vector<PointItem> points_;
+  std::vector<BoxRange> ranges_;
+  std::vector<BoxItem> order_;
+  // Multi-level scratch: one level's queries and their positions in the caller's batch.
+  std::vector<std::uint32_t> level_index_;
+  std::vector<Vec3f> level_points_;
+  std::vector<VoxelState> level_states_;
+  std::vector<AABB> level_boxes_;
+  std::vector<BoxQueryResult> level_results_;
+};
+
+// Hands the latest snapshot from the integrating thread to query threads: publish() swaps
+// a pointer under a mutex, and a reader keeps the snapshot it got for as long as it uses
+// it, so neither side waits on the other's work.
+template <class Snapshot>
+class SnapshotPublisher {
+ public:
+  void publish(std::shared_ptr<const Snapshot> snap) {
+    std::lock_guard<std::mutex> lock(mu_);
+    latest_.swap(snap);
+    // The previous snapshot (now in `snap`) is released after the lock, by whoever holds it last.
+  }
+  // Null until the first publish().
+  [[nodiscard]] std::shared_ptr<const Snapshot> latest() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return latest_;
+  }
+
+ private:
+  mutable std::mutex mu_;
+  std::shared_ptr<const Snapshot> latest_;
+};
+
+using OccupancyPublisher = SnapshotPublisher<OccupancySnapshot>;
+using MultiResOccupancyPublisher = SnapshotPublisher<MultiResOccupancySnapshot>;
+
+}  // namespace wm
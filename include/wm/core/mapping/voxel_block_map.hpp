@@ -0,0 +1,535 @@
+// File: include/wm/core/mapping/voxel_block_map.hpp
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/mapping/block_pool.hpp"
+#include "wm/core/mapping/block_spill.hpp"
+#include "wm/core/mapping/log_odds.hpp"
+#include "wm/core/types.hpp"
+#include "wm/core/util/thread_pool.hpp"
+
+namespace wm {
+
+// -----------------------------
+// Keys
+// -----------------------------
+// Integer block coordinates: block (x, y, z) covers voxels [x*B, (x+1)*B) per axis.
+struct BlockKey {
+  std::int32_t x = 0;
+  std::int32_t y = 0;
+  std::int32_t z = 0;
+
+  constexpr bool operator==(const BlockKey& o) const noexcept { return x == o.x && y == o.y && z == o.z; }
+  constexpr bool operator!=(const BlockKey& o) const noexcept { return !(*this == o); }
+};
+
+// Block coordinates are packed into 63 bits (21 per axis, two's complement), which covers
+// +/- 1M blocks per axis: hundreds of km even at 2 cm voxels.
+inline constexpr int kBlockKeyBits = 21;
+inline constexpr std::int32_t kBlockKeyMin = -(1 << (kBlockKeyBits - 1));
+inline constexpr std::int32_t kBlockKeyMax = (1 << (kBlockKeyBits - 1)) - 1;
+
+constexpr bool block_key_in_range(const BlockKey& k) noexcept {
+  return k.x >= kBlockKeyMin && k.x <= kBlockKeyMax && k.y >= kBlockKeyMin && k.y <= kBlockKeyMax &&
+         k.z >= kBlockKeyMin && k.z <= kBlockKeyMax;
+}
+
+// Keeps the low 21 bits of each coordinate: a key outside the range would alias a block
+// inside it, so callers reject those first (block_key_in_range).
+constexpr std::uint64_t pack_block_key(const BlockKey& k) noexcept {
+  assert(block_key_in_range(k));
+  constexpr std::uint64_t m = (std::uint64_t{1} << kBlockKeyBits) - 1;
+  return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.x)) & m) |
+         ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.y)) & m) << kBlockKeyBits) |
+         ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.z)) & m) << (2 * kBlockKeyBits));
+}
+
+constexpr BlockKey unpack_block_key(std::uint64_t packed) noexcept {
+  constexpr std::uint64_t m = (std::uint64_t{1} << kBlockKeyBits) - 1;
+  const auto sext = [](std::uint64_t v) {
+    constexpr std::uint64_t sign = std::uint64_t{1} << (kBlockKeyBits - 1);
+    return static_cast<std::int32_t>(static_cast<std::int64_t>(v ^ sign) - static_cast<std::int64_t>(sign));
+  };
+  return BlockKey{sext(packed & m), sext((packed >> kBlockKeyBits) & m), sext((packed >> (2 * kBlockKeyBits)) & m)};
+}
+
+// floor(v) as an integer voxel coordinate, saturated at +-kVoxelCoordLimit (NaN gives
+// -kVoxelCoordLimit), so the conversion is always defined. The limit lies beyond the block
+// key range for every valid block size (< 1024), so saturated input never lands on a
+// representable block.
+inline constexpr std::int32_t kVoxelCoordLimit = 1 << 30;
+
+inline std::int32_t saturate_voxel_coord(float v) noexcept {
+  const float f = std::floor(v);
+  if (!(f > -static_cast<float>(kVoxelCoordLimit))) return -kVoxelCoordLimit;
+  if (f >= static_cast<float>(kVoxelCoordLimit)) return kVoxelCoordLimit;
+  return static_cast<std::int32_t>(f);
+}
+
+// Dense index of a block in the map's pool. Stable until the block is erased.
+using BlockIndex = std::uint32_t;
+inline constexpr BlockIndex kInvalidBlock = ~BlockIndex{0};
+
+// -----------------------------
+// Map
+// -----------------------------
+struct VoxelBlockMapParams {
+  float voxel_size_m{0.02f};
+  int block_size_vox{8};
+  // Blocks are stored in cubic regions of region_size_blocks^3 (a power of two); 1 stores
+  // every block on its own.
+  int region_size_blocks{2};
+  // Voxel order inside a block: Morton (needs a power-of-two block size) or x-fastest linear.
+  bool morton_voxels{true};
+  // Points outside the ROI are ignored by the integration helpers (node/site frame, as fed).
+  AABB roi{Vec3f{-10.0f, -10.0f, -2.0f}, Vec3f{10.0f, 10.0f, 5.0f}};
+
+  // The region table is split into this many independent shards (a power of two) by region
+  // hash, so batches of insertions can run shard-parallel (see insert_sharded).
+  int shards{64};
+  // Hash slots reserved up front over all shards (rounded up to a power of two per shard).
+  std::size_t initial_slots{4096};
+  // Pool growth unit: blocks allocated together in one aligned chunk (rounded up to whole
+  // regions, see BlockPool).
+  std::size_t blocks_per_chunk{256};
+  // Back the pool with 2 MiB transparent huge pages (chunks grow to at least 2 MiB).
+  bool huge_pages{false};
+
+  // Occupancy update (log-odds, per observation) and clamp bounds, stored per voxel as
+  // int8 or int16 fixed point (log_odds_bits, see LogOddsModel).
+  int log_odds_bits{16};
+  float log_odds_hit{0.85f};
+  float log_odds_miss{-0.4f};
+  float log_odds_min{-2.0f};
+  float log_odds_max{3.5f};
+  // State thresholds: occupied above log_odds_occupied, free below log_odds_free.
+  float log_odds_occupied{0.0f};
+  float log_odds_free{0.0f};
+
+  // Memory cap (0 = unbounded) enforced by enforce_memory_budget(): least recently
+  // observed regions are evicted, except those intersecting `core`. Evicted regions are
+  // spilled to spill_path when set, else dropped.
+  std::size_t memory_budget_bytes{0};
+  AABB core{Vec3f{-5.0f, -5.0f, -2.0f}, Vec3f{5.0f, 5.0f, 5.0f}};
+  std::string spill_path;
+
+  static VoxelBlockMapParams from_config(const MappingConfig& m);
+};
+
+struct VoxelBlockMapStats {
+  std::size_t blocks{0};
+  std::size_t free_blocks{0};   // pooled block slots not in use (in live or free regions)
+  std::size_t regions{0};
+  std::size_t shards{0};
+  std::size_t hash_slots{0};    // over all shards
+  std::size_t pool_chunks{0};
+  std::size_t mapped_chunks{0};  // pool chunks backed by a restored snapshot (copy-on-write)
+  std::size_t huge_page_chunks{0};  // pool chunks advised as transparent huge pages
+  std::size_t pool_bytes{0};    // voxel pool chunks (part of memory_bytes)
+  std::size_t free_regions{0};  // pool region slabs on the free list
+  std::size_t stranded_blocks{0};  // unused block slots inside live regions
+  std::size_t memory_bytes{0};  // voxel pool + hash table + per-block / per-region keys
+                                // (mapped chunks count in full, resident or not)
+  std::size_t live_bytes{0};    // the part of memory_bytes held by live regions (what the
+                                // memory budget caps)
+  // Memory budget: totals since construction.
+  std::size_t evicted_regions{0};
+  std::size_t evicted_blocks{0};
+  std::size_t spilled_regions{0};   // evicted regions written to the spill file
+  std::size_t restored_regions{0};  // read back from it when observed again
+  std::size_t spill_errors{0};      // regions dropped for want of a spill (file not open or
+                                    // write failed) plus failed or short restores
+  std::size_t spill_compaction_errors{0};  // failed spill file compactions (nothing lost)
+  std::uint64_t spill_bytes_written{0};
+  std::uint64_t spill_bytes_read{0};
+  std::uint64_t spill_file_bytes{0};  // current size of the spill file
+  // Pool traffic: totals since construction (rates are differences between two calls).
+  std::uint64_t blocks_allocated{0};
+  std::uint64_t blocks_released{0};   // erased, evicted or cleared
+  std::uint64_t regions_allocated{0};
+  std::uint64_t regions_reused{0};    // of those, taken off the free list
+
+  // Share of pooled block slots holding a block.
+  [[nodiscard]] double pool_occupancy() const noexcept {
+    return blocks + free_blocks == 0 ? 0.0 : static_cast<double>(blocks) / static_cast<double>(blocks + free_blocks);
+  }
+  // Share of live regions' block slots left unused: memory held by sparse regions that no
+  // other region can use (free regions are reusable and do not count).
+  [[nodiscard]] double fragmentation() const noexcept {
+    return blocks + stranded_blocks == 0
+               ? 0.0
+               : static_cast<double>(stranded_blocks) / static_cast<double>(blocks + stranded_blocks);
+  }
+};
+
+// Sparse voxel map of hashed fixed-size blocks, laid out for neighbourhood scans.
+// - Blocks are grouped into regions of R^3 blocks (R = region_size_blocks). The hash
+//   table maps packed region keys to region slabs: open addressing with linear probing
+//   over a power-of-two table kept at most half full, backward-shift erase (no tombstones).
+// - The table is sharded: the top bits of a region's hash pick one of `shards` independent
+//   tables. A shard owns its regions and their blocks, so one thread per shard can insert
+//   and update without locks (insert_sharded; the ray integrator's apply phase).
+// - A region owns R^3 consecutive block slots in the pool, in Morton (Z) order of the
+//   block's position in the region, so most of a block's 26 neighbours sit in the same
+//   slab, a few KB away, and are found without hashing. A block's index is
+//   region slot * R^3 + Morton(local block), stable until the block is erased.
+// - A block's B^3 voxels are contiguous fixed-point log-odds cells (int8 or int16, see
+//   LogOddsModel), in Morton order when morton_voxels (a 2x2x2
+//   voxel cube shares a cache line) or x-fastest linear order. voxel_index() hides which.
+// - Blocks live in a BlockPool: one region is one slab of R^3 block slots, carved from
+//   large chunks (optionally 2 MiB huge pages). Unused slots of a live region stay
+//   reserved; empty regions go back on the pool's free list and are reused before the pool
+//   grows, so steady-state insertion does not allocate. Voxel pointers stay valid until
+//   their block is erased.
+// - Occupancy bitmasks: every block keeps an occupied and a known bit per voxel, and
+//   every region one summary bit per block for each ("has an occupied / known voxel"),
+//   so scans skip empty regions and blocks with a word test and count with popcount
+//   instead of reading cells (see "occupancy scans").
+// - Optional memory budget: regions carry the epoch they were last observed in (touch());
+//   enforce_memory_budget() evicts the stalest ones outside the core box, spilling them to
+//   disk if configured. Spilled regions come back transparently when a ray or point
+//   reaches them again.
+// - Not thread-safe beyond insert_sharded and per-shard ownership; concurrent readers are
+//   fine while nothing writes.
+class VoxelBlockMap {
+ public:
+  explicit VoxelBlockMap(VoxelBlockMapParams params = {});
+  explicit VoxelBlockMap(const MappingConfig& cfg) : VoxelBlockMap(VoxelBlockMapParams::from_config(cfg)) {}
+
+  VoxelBlockMap(const VoxelBlockMap&) = delete;
+  VoxelBlockMap& operator=(const VoxelBlockMap&) = delete;
+  VoxelBlockMap(VoxelBlockMap&&) noexcept = default;
+  VoxelBlockMap& operator=(VoxelBlockMap&&) noexcept = default;
+
+  [[nodiscard]] const VoxelBlockMapParams& params() const noexcept { return params_; }
+  [[nodiscard]] float voxel_size() const noexcept { return params_.voxel_size_m; }
+  [[nodiscard]] int block_size() const noexcept { return params_.block_size_vox; }
+  [[nodiscard]] std::size_t voxels_per_block() const noexcept { return voxels_per_block_; }
+  [[nodiscard]] float block_extent_m() const noexcept { return params_.voxel_size_m * static_cast<float>(params_.block_size_vox); }
+
+  // --- geometry
+  // Global integer voxel coordinate along one axis (saturated, see saturate_voxel_coord).
+  [[nodiscard]] std::int32_t voxel_coord(float v) const noexcept {
+    return saturate_voxel_coord(v * inv_voxel_size_);
+  }
+  [[nodiscard]] BlockKey block_of_voxel(std::int32_t vx, std::int32_t vy, std::int32_t vz) const noexcept {
+    return BlockKey{floor_div(vx), floor_div(vy), floor_div(vz)};
+  }
+  [[nodiscard]] BlockKey block_key(const Vec3f& p) const noexcept {
+    return block_of_voxel(voxel_coord(p.x), voxel_coord(p.y), voxel_coord(p.z));
+  }
+  // Index of global voxel (vx, vy, vz) inside its block.
+  [[nodiscard]] std::uint32_t voxel_offset(std::int32_t vx, std::int32_t vy, std::int32_t vz) const noexcept;
+  // Index of block-local voxel (lx, ly, lz), each in [0, B).
+  [[nodiscard]] std::uint32_t voxel_index(std::uint32_t lx, std::uint32_t ly, std::uint32_t lz) const noexcept {
+    // Morton contributions are disjoint bits, linear ones multiples of B and B^2: a sum
+    // covers both (an OR aliases voxels of non-power-of-two linear blocks).
+    return axis_index_[lx] + axis_index_[block_size_ + ly] + axis_index_[2 * block_size_ + lz];
+  }
+  // Minimum corner of a block (metres).
+  [[nodiscard]] Vec3f block_origin(const BlockKey& k) const noexcept;
+  // Space block keys can address (metres, max exclusive); nothing outside it has a block.
+  [[nodiscard]] AABB key_extent() const noexcept;
+
+  // --- blocks
+  // kInvalidBlock if absent (or k is out of key range).
+  [[nodiscard]] BlockIndex find(const BlockKey& k) const noexcept;
+  // Returns the existing block or a new all-unknown one. k must be in key range.
+  BlockIndex find_or_insert(const BlockKey& k);
+
+  // Shard owning block k (all blocks of a region share it), in [0, num_shards()).
+  [[nodiscard]] std::size_t num_shards() const noexcept { return shards_.size(); }
+  [[nodiscard]] std::size_t shard_of(const BlockKey& k) const noexcept { return shard_index(region_key(k)); }
+
+  // Batch insertion of packed block keys, one task per shard: keys_of(shard, add) must call
+  // add(packed key) for every key of that shard (duplicates and existing blocks are fine).
+  // Shards insert into their own tables in parallel; new regions then get pool slabs in
+  // shard order in one short serial step, so block indices depend only on the keys and
+  // the order keys_of presents them, not on the thread count.
+  template <typename KeysOf>
+  void insert_sharded(ThreadPool& pool, KeysOf&& keys_of) {
+    pool.parallel_for(shards_.size(), [&](std::size_t s, int) {
+      keys_of(s, [&](std::uint64_t packed) { insert_pending(s, packed); });
+    });
+    assign_pending_regions();
+    pool.parallel_for(shards_.size(), [&](std::size_t s, int) { commit_pending(s); });
+    for (Shard& sh : shards_) {
+      num_blocks_ += sh.added;
+      sh.added = 0;
+    }
+  }
+  bool erase(const BlockKey& k);
+  void clear();
+
+  // Cells of block b: voxels_per_block() cells of log_odds_model().cell_bytes() each.
+  [[nodiscard]] void* voxels(BlockIndex b) noexcept { return block_ptr(b); }
+  [[nodiscard]] const void* voxels(BlockIndex b) const noexcept { return block_ptr(b); }
+  // Typed view; Cell must be std::int8_t or std::int16_t, matching log_odds_bits.
+  template <typename Cell>
+  [[nodiscard]] Cell* cells(BlockIndex b) noexcept { return reinterpret_cast<Cell*>(block_ptr(b)); }
+  template <typename Cell>
+  [[nodiscard]] const Cell* cells(BlockIndex b) const noexcept { return reinterpret_cast<const Cell*>(block_ptr(b)); }
+  // Cell value of voxel `offset` in block b, in LogOddsModel units.
+  [[nodiscard]] std::int32_t cell(BlockIndex b, std::uint32_t offset) const noexcept {
+    return log_odds_.bits == 8 ? cells<std::int8_t>(b)[offset] : cells<std::int16_t>(b)[offset];
+  }
+  [[nodiscard]] std::size_t block_bytes() const noexcept { return block_bytes_; }
+  [[nodiscard]] const LogOddsModel& log_odds_model() const noexcept { return log_odds_; }
+  [[nodiscard]] BlockKey key_of(BlockIndex b) const noexcept { return unpack_block_key(block_keys_[b]); }
+  [[nodiscard]] std::size_t num_blocks() const noexcept { return num_blocks_; }
+  [[nodiscard]] std::size_t num_regions() const noexcept { return region_blocks_.size() - pool_.free_slabs(); }
+  // Upper bound of block indices handed out so far (for per-block side tables).
+  [[nodiscard]] std::size_t block_capacity() const noexcept { return block_keys_.size(); }
+
+  // Calls fn(BlockKey, BlockIndex) for every block: shard by shard, region by region
+  // (table order), in Morton order inside each region.
+  template <typename Fn>
+  void for_each_block(Fn&& fn) const {
+    for (std::size_t sh = 0; sh < shards_.size(); ++sh) for_each_block_in_shard(sh, fn);
+  }
+  template <typename Fn>
+  void for_each_block_in_shard(std::size_t shard, Fn&& fn) const {
+    for (const Slot& s : shards_[shard].slots) {
+      if (s.key == kEmptyKey) continue;
+      const std::size_t base = static_cast<std::size_t>(s.region) * blocks_per_region_;
+      for (std::size_t b = base; b < base + blocks_per_region_; ++b) {
+        if (block_keys_[b] != kEmptyKey) fn(unpack_block_key(block_keys_[b]), static_cast<BlockIndex>(b));
+      }
+    }
+  }
+
+  // --- voxels
+  // Log-odds at p (0 when the voxel or its block was never observed), decoded.
+  [[nodiscard]] float log_odds(const Vec3f& p) const noexcept { return log_odds_.decode(cell_at(p)); }
+  [[nodiscard]] VoxelState state(const Vec3f& p) const noexcept { return log_odds_.classify(cell_at(p)); }
+
+  // Applies one "hit" to the voxel of every point inside the ROI, allocating blocks as
+  // needed. Returns the number of points integrated.
+  std::size_t integrate_hits(ConstPointView pts);
+
+  // --- occupancy scans
+  // Block b's masks: mask_words() words each, bit i % 64 of word i / 64 for voxel offset i
+  // (storage order, see voxel_index()). Occupied: the cell classifies occupied; known:
+  // free or occupied. The map's own writers (integrate_hits, spill restore, snapshots)
+  // keep them current; code writing through cells() must call note_cell() per voxel or
+  // refresh_masks() per block, then refresh_summary(). Like cells, they belong to the
+  // block's shard: safe to update concurrently for blocks of different shards.
+  [[nodiscard]] std::size_t mask_words() const noexcept { return mask_words_; }
+  [[nodiscard]] const std::uint64_t* occupied_mask(BlockIndex b) const noexcept {
+    return block_masks_.data() + std::size_t{b} * 2 * mask_words_;
+  }
+  [[nodiscard]] const std::uint64_t* known_mask(BlockIndex b) const noexcept { return occupied_mask(b) + mask_words_; }
+  // Voxel `offset` of block b now holds `cell`.
+  void note_cell(BlockIndex b, std::uint32_t offset, std::int32_t cell) noexcept {
+    std::uint64_t* w = block_masks_.data() + std::size_t{b} * 2 * mask_words_ + offset / 64;
+    const std::uint64_t bit = std::uint64_t{1} << (offset % 64);
+    const VoxelState s = log_odds_.classify(cell);
+    w[0] = s == VoxelState::kOccupied ? w[0] | bit : w[0] & ~bit;
+    w[mask_words_] = s != VoxelState::kUnknown ? w[mask_words_] | bit : w[mask_words_] & ~bit;
+  }
+  // Recomputes block b's masks from all its cells (SIMD), and its summary bits.
+  void refresh_masks(BlockIndex b) noexcept;
+  // Recomputes block b's summary bits from its masks.
+  void refresh_summary(BlockIndex b) noexcept;
+
+  // Occupied / known voxels of the whole map: popcounts over the blocks whose summary
+  // bit is set, skipping regions with an all-zero summary.
+  [[nodiscard]] std::size_t count_occupied() const noexcept { return count_bits(0); }
+  [[nodiscard]] std::size_t count_known() const noexcept { return count_bits(1); }
+  // Calls fn(BlockKey, BlockIndex) for every block with an occupied voxel, in pool order.
+  template <typename Fn>
+  void for_each_occupied_block(Fn&& fn) const {
+    for_each_summary_block(0, fn);
+  }
+  // Calls fn(BlockKey, BlockIndex, offset) for every occupied voxel (see voxel_center()).
+  template <typename Fn>
+  void for_each_occupied_voxel(Fn&& fn) const {
+    for_each_summary_block(0, [&](const BlockKey& k, BlockIndex b) {
+      const std::uint64_t* m = occupied_mask(b);
+      for (std::size_t w = 0; w < mask_words_; ++w) {
+        for (std::uint64_t bits = m[w]; bits != 0; bits &= bits - 1) {
+          fn(k, b, static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(bits))));
+        }
+      }
+    });
+  }
+  // Centre (metres) of voxel `offset` of block k.
+  [[nodiscard]] Vec3f voxel_center(const BlockKey& k, std::uint32_t offset) const noexcept;
+
+  // --- memory budget
+  // Marks block b's region as observed in the current epoch. Safe to call concurrently
+  // for blocks of different shards.
+  void touch(BlockIndex b) noexcept { region_seen_[b / blocks_per_region_] = epoch_; }
+  // Starts a new epoch and, when live regions exceed the budget, evicts the least recently
+  // observed regions outside the core (ties by key, so eviction is deterministic) down to
+  // 90% of it. Integrators call this between passes; block indices of evicted regions
+  // become invalid. The pool keeps its high-water mark, so memory_bytes stays within the
+  // budget plus the new regions of one pass. Returns the number of regions evicted.
+  std::size_t enforce_memory_budget();
+  // Last spill failure (opening, writing or reading the spill file; ok if none). An
+  // unopenable spill_path is retried once per eviction pass; regions evicted meanwhile
+  // are dropped and counted in spill_errors.
+  [[nodiscard]] const Status& spill_status() const noexcept { return spill_status_; }
+  // Bytes one live region accounts for (voxels, keys, masks, summaries, counters, ~2
+  // table slots).
+  [[nodiscard]] std::size_t region_bytes() const noexcept {
+    return blocks_per_region_ * (block_bytes_ + sizeof(std::uint64_t) * (1 + 2 * mask_words_)) +
+           2 * summary_words_ * sizeof(std::uint64_t) + sizeof(std::uint32_t) * 2 + 2 * sizeof(Slot);
+  }
+
+  [[nodiscard]] VoxelBlockMapStats stats() const noexcept;
+
+ private:
+  friend struct MapSnapshotAccess;  // map_snapshot.cpp: writes and adopts the pool
+
+  using RegionIndex = std::uint32_t;
+  static constexpr RegionIndex kInvalidRegion = ~RegionIndex{0};
+
+  struct Slot {
+    std::uint64_t key;  // packed region key
+    RegionIndex region;
+  };
+  static constexpr std::uint64_t kEmptyKey = ~std::uint64_t{0};  // packed keys use 63 bits
+  // Region slot of a region inserted by insert_sharded that has no pool slab yet:
+  // kPendingRegion | index into Shard::pending.
+  static constexpr RegionIndex kPendingRegion = RegionIndex{1} << 31;
+
+  struct Shard {
+    std::vector<Slot> slots;
+    std::size_t mask{0};
+    std::size_t regions{0};
+    // insert_sharded state: new region keys, their pool slabs once assigned, blocks of
+    // pending regions, and blocks added to existing regions.
+    std::vector<std::uint64_t> pending;
+    std::vector<RegionIndex> assigned;
+    std::vector<std::uint64_t> pending_blocks;
+    std::size_t added{0};
+  };
+
+  static std::uint64_t hash_key(std::uint64_t k) noexcept {
+    // splitmix64 finaliser: neighbouring regions land far apart.
+    k ^= k >> 30;
+    k *= 0xbf58476d1ce4e5b9ull;
+    k ^= k >> 27;
+    k *= 0x94d049bb133111ebull;
+    k ^= k >> 31;
+    return k;
+  }
+
+  [[nodiscard]] std::int32_t floor_div(std::int32_t v) const noexcept {
+    const std::int32_t b = params_.block_size_vox;
+    const std::int32_t q = v / b;
+    return (v % b != 0 && v < 0) ? q - 1 : q;
+  }
+
+  // Region of a block and the block's slot inside it (arithmetic shifts floor negatives).
+  [[nodiscard]] std::uint64_t region_key(const BlockKey& k) const noexcept {
+    return pack_block_key(BlockKey{k.x >> region_shift_, k.y >> region_shift_, k.z >> region_shift_});
+  }
+  [[nodiscard]] std::size_t slot_in_region(const BlockKey& k) const noexcept;
+
+  [[nodiscard]] std::uint8_t* block_ptr(BlockIndex b) const noexcept {
+    return pool_.block_ptr(b);
+  }
+  [[nodiscard]] std::int32_t cell_at(const Vec3f& p) const noexcept;
+
+  // Region r's summary words for masks kind 0 (occupied) or 1 (known).
+  [[nodiscard]] const std::uint64_t* region_summary(std::size_t r, int kind) const noexcept {
+    return region_summary_.data() + (2 * r + static_cast<std::size_t>(kind)) * summary_words_;
+  }
+  // Clears block b's masks and summary bits (the block leaves the map or is reset).
+  void clear_masks(std::size_t b) noexcept;
+  [[nodiscard]] std::size_t count_bits(int kind) const noexcept;
+  template <typename Fn>
+  void for_each_summary_block(int kind, Fn&& fn) const {
+    // Free pool regions have all-zero summaries, so a linear walk sees only live blocks.
+    const std::size_t regions = region_blocks_.size();
+    for (std::size_t r = 0; r < regions; ++r) {
+      const std::uint64_t* sum = region_summary(r, kind);
+      for (std::size_t w = 0; w < summary_words_; ++w) {
+        for (std::uint64_t bits = sum[w]; bits != 0; bits &= bits - 1) {
+          const std::size_t b = r * blocks_per_region_ + w * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+          fn(unpack_block_key(block_keys_[b]), static_cast<BlockIndex>(b));
+        }
+      }
+    }
+  }
+
+  // Top hash bits pick the shard; the low bits index its table.
+  [[nodiscard]] std::size_t shard_index(std::uint64_t packed_region) const noexcept {
+    return static_cast<std::size_t>((hash_key(packed_region) >> 1) >> shard_shift_);
+  }
+  [[nodiscard]] RegionIndex find_region(std::uint64_t packed_region) const noexcept;
+  RegionIndex allocate_region(std::uint64_t packed_region);
+  RegionIndex take_pool_region();
+  // Inserts the table entry of a region known to be absent.
+  static void insert_slot(Shard& sh, std::uint64_t packed_region, RegionIndex r);
+  // Marks block b of region r used, zeroing its voxels; returns whether it was new.
+  bool claim_block(std::size_t b, RegionIndex r, std::uint64_t packed_block);
+  void erase_region(std::uint64_t packed_region);
+  // Eviction and spill tier (enforce_memory_budget).
+  void evict_region(std::uint64_t packed_region, RegionIndex r);
+  [[nodiscard]] bool region_in_core(std::uint64_t packed_region) const noexcept;
+  // Reads region `packed_region` back into pool slab r if it was spilled.
+  void restore_region(std::uint64_t packed_region, RegionIndex r);
+  // Decodes a spill record of region `packed_region` into R^3 packed block keys (kEmptyKey
+  // for unused slots) and R^3 blocks of cells (unused slots untouched). Returns false if
+  // the record is malformed; what decoded before the damage is kept.
+  bool decode_spill_record(std::uint64_t packed_region, const std::vector<std::uint8_t>& rec, std::uint64_t* keys,
+                           std::uint8_t* cells) const noexcept;
+  static void grow_table(Shard& sh);
+
+  // insert_sharded phases.
+  void insert_pending(std::size_t shard, std::uint64_t packed_block);
+  void assign_pending_regions();
+  void commit_pending(std::size_t shard);
+
+  VoxelBlockMapParams params_;
+  float inv_voxel_size_{50.0f};
+  std::size_t voxels_per_block_{512};
+  std::size_t block_bytes_{1024};
+  LogOddsModel log_odds_;
+  std::uint32_t block_size_{8};
+  std::vector<std::uint32_t> axis_index_;  // [axis * B + l]: voxel_index() contribution
+  int region_shift_{1};
+  std::size_t blocks_per_region_{8};
+
+  std::vector<Shard> shards_;  // region tables
+  int shard_shift_{57};        // 63 - log2(shards)
+  std::size_t num_blocks_{0};
+
+  BlockPool pool_;                             // voxel cells, one slab per region
+  std::vector<std::uint64_t> block_keys_;      // packed key per block slot (kEmptyKey when unused)
+  std::vector<std::uint32_t> region_blocks_;   // blocks in use per region
+  std::size_t mask_words_{8};                  // per block and kind: ceil(B^3 / 64)
+  std::size_t summary_words_{1};               // per region and kind: ceil(R^3 / 64)
+  std::vector<std::uint64_t> block_masks_;     // per block slot: occupied words, known words
+  std::vector<std::uint64_t> region_summary_;  // per region: occupied words, known words
+
+  std::vector<std::uint32_t> region_seen_;  // epoch each region was last observed in
+  std::uint32_t epoch_{1};
+  std::size_t budget_regions_{0};  // 0 = unbounded
+  std::unique_ptr<BlockSpillFile> spill_;  // set once spill_path opens (eviction passes)
+  std::vector<std::uint8_t> spill_buf_;
+  std::vector<std::uint64_t> spill_keys_;   // restore_region scratch: one region's
+  std::vector<std::uint8_t> spill_cells_;   // decoded block keys and cells
+  std::size_t evicted_regions_{0};
+  std::size_t evicted_blocks_{0};
+  std::size_t spilled_regions_{0};
+  std::size_t restored_regions_{0};
+  std::size_t spill_errors_{0};
+  Status spill_status_;
+  std::uint64_t blocks_released_{0};
+};
+
+}  // namespace wm
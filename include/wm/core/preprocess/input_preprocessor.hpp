@@ -0,0 +1,42 @@
+// File: include/wm/core/preprocess/input_preprocessor.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/frame.hpp"
+#include "wm/core/preprocess/range_gate.hpp"
+#include "wm/core/preprocess/throughput_governor.hpp"
+#include "wm/core/preprocess/voxel_downsample.hpp"
+
+namespace wm {
+
+struct PreprocessStats {
+  std::size_t points_in{0};     // as delivered by the source
+  std::size_t points_out{0};    // handed to mapping
+  RangeGateStats gate;          // counts after the stride step
+  int level{0};                 // governor level the frame was processed at
+  std::int64_t preprocess_ns{0};
+};
+
+// Per-frame input path: stride, range/ROI gate, voxel downsample, at the throughput
+// governor's current DecimationLevel. Frames leave in the node frame. The caller times
+// whatever it does with the points and reports both costs through governor().observe().
+class InputPreprocessor {
+ public:
+  explicit InputPreprocessor(const Config& cfg);
+
+  // In place: frame.points is replaced by the decimated node-frame points.
+  PreprocessStats process(Frame& frame, const TransformSE3& T_node_lidar);
+
+  [[nodiscard]] ThroughputGovernor& governor() noexcept { return governor_; }
+
+ private:
+  RangeGateParams gate_params_;
+  VoxelDownsampler downsampler_;
+  ThroughputGovernor governor_;
+  PointBuffer scratch_;
+};
+
+}  // namespace wm
@@ -0,0 +1,66 @@
+// File: include/wm/core/preprocess/range_gate.hpp
+#pragma once
+
+#include <cstddef>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/types.hpp"
+#include "wm/core/util/simd.hpp"
+
+namespace wm {
+
+struct RangeGateParams {
+  // Kept: min_range_m <= |p| <= max_range_m, measured from the sensor origin.
+  float min_range_m{0.2f};
+  float max_range_m{50.0f};
+  // Kept: roi.min <= T * p < roi.max. Disabled -> range only.
+  AABB roi{Vec3f{-10.0f, -10.0f, -2.0f}, Vec3f{10.0f, 10.0f, 5.0f}};
+  bool use_roi{true};
+
+  static RangeGateParams from_config(const MappingConfig& m);
+};
+
+// Per-frame counts. Each rejected point is charged to the first criterion it fails, in
+// the order below, so input == kept + rejected_min_range + rejected_max_range + rejected_roi.
+struct RangeGateStats {
+  std::size_t input{0};
+  std::size_t kept{0};
+  std::size_t rejected_min_range{0};  // closer than min_range_m, or not finite
+  std::size_t rejected_max_range{0};
+  std::size_t rejected_roi{0};
+
+  RangeGateStats& operator+=(const RangeGateStats& o) noexcept {
+    input += o.input;
+    kept += o.kept;
+    rejected_min_range += o.rejected_min_range;
+    rejected_max_range += o.rejected_max_range;
+    rejected_roi += o.rejected_roi;
+    return *this;
+  }
+};
+
+// Input gating, the first stage every frame hits. One pass over sensor-frame points:
+// squared range from the sensor origin, the transform into the ROI frame
+// (T_roi_lidar, e.g. T_node_lidar for MappingConfig::roi), the ROI test, and compaction
+// of the survivors. There are no per-point branches: every tier computes all three tests
+// as masks and advances the write index by the keep bit (AVX2 compacts eight points with
+// one permute per lane). Survivors are written in the ROI frame, in input order, with the
+// same arithmetic as transform_points(), so results are bit-identical across tiers and
+// to transform-then-filter. `level` is capped at what the CPU supports.
+
+// In place (materialises a borrowed buffer); extra fields are compacted alongside.
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar,
+                          PointBuffer& pts, SimdLevel level = best_simd_level());
+
+// In place on a view: survivors end up in [0, kept); the caller shrinks the container.
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar,
+                          PointView pts, SimdLevel level = best_simd_level()) noexcept;
+
+// out = survivors of `in` (e.g. a borrowed mmap frame). Strided inputs are de-interleaved
+// into `out` first. Extra fields of `in` are not carried over. `in` may be out.view() (gated
+// in place) but must not otherwise point into `out`.
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar,
+                          ConstPointView in, PointBuffer& out, SimdLevel level = best_simd_level());
+
+}  // namespace wm
@@ -0,0 +1,86 @@
+// File: include/wm/core/preprocess/throughput_governor.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/types.hpp"
+
+namespace wm {
+
+// How much input the preprocessor throws away before mapping. Applied in this order:
+// keep every stride-th point, range/ROI gate with the ROI's x/y extent scaled by roi_scale
+// about its centre, then voxel-downsample at voxel_m (0 = off).
+struct DecimationLevel {
+  int stride{1};
+  float voxel_m{0.0f};
+  float roi_scale{1.0f};
+};
+
+struct ThroughputGovernorParams {
+  bool enabled{true};
+  std::int64_t max_points_per_sec{2'000'000};
+  int target_fps{10};
+  float downsample_voxel_m{0.03f};
+  // Frames averaged per decision; the level only steps down after a full window of headroom.
+  int window_frames{8};
+  // Step down only when the lighter level is predicted to use at most this budget fraction.
+  float headroom{0.8f};
+
+  static ThroughputGovernorParams from_config(const BudgetsConfig& b);
+};
+
+// Cost of one frame, as processed at the governor's level at the time.
+struct FrameCost {
+  TimestampNs t_ns;             // frame timestamp (sets the input frame rate)
+  std::size_t points_in{0};     // as delivered by the source
+  std::size_t points_out{0};    // after decimation (what mapping consumes)
+  std::int64_t preprocess_ns{0};  // stride + gate + downsample
+  std::int64_t process_ns{0};     // everything downstream of preprocessing
+};
+
+// Closed-loop decimation control against budgets.max_points_per_sec (output points per
+// second at the observed input frame rate) and budgets.target_fps (per-frame processing
+// time <= 1 / target_fps).
+//
+// Levels form a fixed ladder from no decimation to stride 4 + 4x voxel + half ROI. After
+// each frame the governor averages the last window_frames at the current level: if either
+// budget is exceeded it steps up one level; if the next lighter level is predicted (from
+// the keep ratio last measured there, or a prior) to stay under `headroom` of both budgets
+// for a whole window, it steps down one level. The window restarts on every change.
+//
+// The points budget depends only on frame timestamps and counts and is reproducible in
+// replay; the time budget uses wall-clock cost and is not.
+class ThroughputGovernor {
+ public:
+  explicit ThroughputGovernor(ThroughputGovernorParams params);
+
+  // Level for the next frame.
+  [[nodiscard]] const DecimationLevel& level() const noexcept { return levels_[current_]; }
+  [[nodiscard]] int level_index() const noexcept { return static_cast<int>(current_); }
+  [[nodiscard]] std::size_t num_levels() const noexcept { return levels_.size(); }
+
+  // Records the frame just processed at level(). Returns true if the level changed; the
+  // change is then described by last_change().
+  bool observe(const FrameCost& cost);
+
+  // "level=2 from=1 reason=points_per_sec stride=1 voxel_m=0.060 roi_scale=1.00 ..."
+  [[nodiscard]] const std::string& last_change() const noexcept { return last_change_; }
+
+ private:
+  void change_to(std::size_t next, const char* reason, double points_per_sec, double frame_ns, double fps);
+
+  ThroughputGovernorParams params_;
+  std::vector<DecimationLevel> levels_;
+  std::vector<double> keep_ratio_;  // [level] points_out / points_in, measured or prior
+  std::size_t current_{0};
+  std::deque<FrameCost> window_;    // recent frames at the current level
+  int headroom_frames_{0};
+  std::string last_change_;
+};
+
+}  // namespace wm
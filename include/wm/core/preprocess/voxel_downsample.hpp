@@ -0,0 +1,92 @@
+// File: include/wm/core/preprocess/voxel_downsample.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "wm/core/config.hpp"
+#include "wm/core/io/point_buffer.hpp"
+#include "wm/core/util/thread_pool.hpp"
+
+namespace wm {
+
+struct VoxelDownsampleParams {
+  float voxel_m{0.03f};
+  // Worker threads including the caller (<= 0: hardware concurrency).
+  int threads{0};
+  // Frames with fewer points take the serial hash path; sorting only pays off above this.
+  std::size_t hash_max_points{16384};
+
+  static VoxelDownsampleParams from_config(const BudgetsConfig& b);
+};
+
+struct VoxelDownsampleStats {
+  std::size_t input{0};
+  std::size_t output{0};    // occupied voxels
+  std::size_t dropped{0};   // non-finite points, or beyond 2^21 voxels from the frame minimum
+  bool hash_path{false};
+};
+
+// Voxel-grid downsampler: one output point per occupied voxel, at the centroid of its
+// points with their mean intensity.
+//
+// Large frames: 63-bit Morton keys of the voxel coordinates (relative to the frame's
+// minimum voxel) are LSD radix-sorted, 8 bits per pass, skipping passes whose digit is the
+// same for every point. Key computation, histograms, scatters and the run reduction are
+// parallel over contiguous chunks. Small frames: a serial open-addressing hash.
+//
+// Output depends only on the input, never on the thread count: the sort path emits voxels
+// in Morton order, the hash path in order of first occurrence, and both sum each voxel's
+// points in input order (the sort is stable), so the centroids are bit-identical across
+// paths too. Extra fields are not carried over.
+class VoxelDownsampler {
+ public:
+  explicit VoxelDownsampler(VoxelDownsampleParams params);
+
+  VoxelDownsampleStats downsample(ConstPointView in, PointBuffer& out);
+
+  // The governor switches voxel sizes between frames.
+  void set_voxel_m(float voxel_m) noexcept { params_.voxel_m = voxel_m; }
+
+  [[nodiscard]] const VoxelDownsampleParams& params() const noexcept { return params_; }
+  [[nodiscard]] int threads() const noexcept { return pool_.size(); }
+
+ private:
+  // Per-chunk minimum / maximum voxel coordinates of the finite points.
+  struct Bounds {
+    std::int64_t lo[3];
+    std::int64_t hi[3];
+  };
+
+  struct Slot {
+    std::uint64_t key;
+    std::uint32_t accum;  // index into accum_, or empty
+  };
+
+  struct Accum {
+    double x, y, z, i;
+    std::uint32_t count;
+  };
+
+  Bounds frame_bounds(ConstPointView in, std::size_t chunks);
+  void downsample_sorted(ConstPointView in, const Bounds& b, PointBuffer& out, VoxelDownsampleStats& s);
+  void downsample_hash(ConstPointView in, const Bounds& b, PointBuffer& out, VoxelDownsampleStats& s);
+
+  VoxelDownsampleParams params_;
+  ThreadPool pool_;
+
+  // Sort path: ping-pong key / point-index arrays and per-chunk digit histograms.
+  std::vector<std::uint64_t> keys_[2];
+  std::vector<std::uint32_t> index_[2];
+  std::vector<std::size_t> hist_;
+  std::vector<Bounds> chunk_bounds_;
+  std::vector<std::size_t> run_begin_;  // [chunk]: first sorted position of the chunk
+  std::vector<std::size_t> run_count_;  // [chunk]: voxels (runs) starting in the chunk
+
+  // Hash path.
+  std::vector<Slot> table_;
+  std::vector<Accum> accum_;  // first-seen order
+};
+
+}  // namespace wm
@@ -4,7 +4,6 @@
 #include <array>
 #include <cstdint>
 #include <string>
-#include <vector>
 
 namespace wm {
 
@@ -84,20 +83,6 @@ struct PointXYZI {
   float intensity = 0.0f;
 };
 
-struct PointCloudFrame {
-  TimestampNs timestamp;
-  NodeId node_id;
-
-  // Frame these points are expressed in (typically "lidar" for raw sensor output).
-  FrameName frame = "lidar";
-
-  // Monotonic frame index within the dataset (deterministic replay + debugging).
-  std::uint64_t seq = 0;
-
-  std::vector<PointXYZI> points;
-
-  [[nodiscard]] std::size_t size() const noexcept { return points.size(); }
-  [[nodiscard]] bool empty() const noexcept { return points.empty(); }
-};
+// SoA point storage (PointBuffer) and the frames carrying it live in wm/core/io.
 
 }  // namespace wm
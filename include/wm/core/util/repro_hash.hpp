@@ -11,6 +11,12 @@ namespace wm {
 // Goal: if the run changes, this hash should change.
 std::string compute_config_hash(const Config& cfg);
 
+// Hash only the settings that shape the learned map (node, frames, baseline window, mapping
+// geometry and update rules, sensor extrinsics). Run-only knobs (paths, run limits, threads,
+// governor, change detection, output) are left out, so changing them keeps map snapshots
+// valid. Calibration is keyed separately (compute_calibration_hash).
+std::string compute_map_config_hash(const Config& cfg);
+
 // Hash only the calibration payload (extrinsics + versioning).
 // Goal: calibration changes should be obvious in logs.
 std::string compute_calibration_hash(const CalibrationConfig& calib);
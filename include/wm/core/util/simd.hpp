@@ -0,0 +1,40 @@
+// File: include/wm/core/util/simd.hpp
+#pragma once
+
+// Runtime SIMD dispatch helpers.
+// The build targets the baseline ISA (no -march flags), so wider kernels are compiled per
+// function with WM_TARGET_AVX2 and selected at runtime with cpu_has_avx2(). SSE2 is part of
+// the x86-64 baseline and needs no check. Other targets use the scalar kernels, which are
+// written to auto-vectorise (e.g. NEON on Jetson at -O2/-O3).
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WM_SIMD_X86 1
+#define WM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define WM_SIMD_X86 0
+#define WM_TARGET_AVX2
+#endif
+
+namespace wm {
+
+// True if AVX2 + FMA kernels may run on this CPU. Cached after the first call.
+// Setting WM_DISABLE_AVX2=1 in the environment forces the fallback path (benchmarks, CI).
+bool cpu_has_avx2() noexcept;
+
+// Kernel tiers for code that has more than one vector path (e.g. SSE and AVX2).
+enum class SimdLevel : int {
+  kScalar = 0,
+  kSse2 = 1,  // x86-64 baseline
+  kAvx2 = 2,  // AVX2 + FMA, runtime checked
+};
+
+// Widest tier usable here (honours WM_DISABLE_AVX2).
+SimdLevel best_simd_level() noexcept;
+
+// `requested` capped at best_simd_level(), so callers (benchmarks) can pin a slower tier
+// but never select an unsupported one.
+SimdLevel clamp_simd_level(SimdLevel requested) noexcept;
+
+const char* simd_level_name(SimdLevel level) noexcept;
+
+}  // namespace wm
@@ -0,0 +1,57 @@
+// File: include/wm/core/util/thread_pool.hpp
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wm {
+
+// Fixed-size fork/join pool for data-parallel loops.
+// parallel_for() hands task indices 0..n-1 to the workers and the calling thread and
+// returns when all of them are done. Which thread runs which index is not fixed, so
+// callers that need deterministic output write per-task results and combine them in
+// index order afterwards. One parallel_for at a time (calls from several threads serialise).
+class ThreadPool {
+ public:
+  // threads <= 0 selects std::thread::hardware_concurrency(). The caller counts as one
+  // thread, so ThreadPool(1) runs everything inline.
+  explicit ThreadPool(int threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  [[nodiscard]] int size() const noexcept { return static_cast<int>(workers_.size()) + 1; }
+
+  // fn(task_index, thread_slot); thread_slot is in [0, size()) and unique among concurrently
+  // running calls, so it can index per-thread scratch.
+  void parallel_for(std::size_t n, const std::function<void(std::size_t, int)>& fn);
+
+ private:
+  void worker_loop(int slot);
+  void run_tasks(int slot);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex run_mu_;  // serialises parallel_for callers
+
+  std::mutex mu_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  std::uint64_t generation_{0};
+  int busy_{0};
+  bool stopping_{false};
+
+  // Current job (valid while busy_ > 0 or the caller is running tasks).
+  const std::function<void(std::size_t, int)>* fn_{nullptr};
+  std::size_t n_{0};
+  std::atomic<std::size_t> next_{0};
+};
+
+}  // namespace wm
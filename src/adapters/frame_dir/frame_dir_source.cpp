@@ -2,10 +2,19 @@
 #include "wm/adapters/frame_dir/frame_dir_source.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wm/core/io/mapped_file.hpp"
+
 namespace wm {
 namespace {
 
@@ -14,8 +23,36 @@ std::int64_t hz_to_period_ns(double hz) {
   return static_cast<std::int64_t>(1e9 / hz);
 }
 
+bool is_quantized_path(const std::string& path) {
+  return path.size() > 5 && path.compare(path.size() - 5, 5, ".qbin") == 0;
+}
+
 }  // namespace
 
+Status write_quantized_frame_file(const std::string& path, ConstPointView pts) {
+  const std::size_t n = pts.size;
+  if (n > std::numeric_limits<std::uint32_t>::max()) {
+    return Status::invalid_argument("write_quantized_frame_file: too many points for a .qbin frame: " +
+                                    std::to_string(n));
+  }
+  QuantizedFrameFileHeader h{};
+  std::memcpy(h.magic, kQuantizedFrameMagic, sizeof(h.magic));
+  h.num_points = static_cast<std::uint32_t>(n);
+  h.params = choose_quantization(pts);
+
+  std::vector<std::int16_t> q(3 * n);
+  std::vector<std::uint8_t> qi(n);
+  quantize_points(pts, h.params, q.data(), q.data() + n, q.data() + 2 * n, qi.data());
+
+  std::ofstream f(path, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!f.is_open()) return Status::io_error("write_quantized_frame_file: failed opening " + path);
+  f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  f.write(reinterpret_cast<const char*>(q.data()), static_cast<std::streamsize>(q.size() * sizeof(std::int16_t)));
+  f.write(reinterpret_cast<const char*>(qi.data()), static_cast<std::streamsize>(qi.size()));
+  if (!f.good()) return Status::io_error("write_quantized_frame_file: failed writing " + path);
+  return Status::ok_status();
+}
+
 FrameDirSource::FrameDirSource(FrameDirSourceConfig cfg) : cfg_(std::move(cfg)) {
   frame_period_ns_ = hz_to_period_ns(cfg_.fps > 0.0 ? cfg_.fps : 10.0);
 }
@@ -27,6 +64,17 @@ Status FrameDirSource::open() {
   opened_ = true;
   idx_ = 0;
   emitted_ = 0;
+
+  if (cfg_.prefetch_depth > 0) {
+    FramePrefetcherConfig pc;
+    pc.depth = static_cast<std::size_t>(cfg_.prefetch_depth);
+    pc.io_threads = cfg_.io_threads;
+    pc.loop = cfg_.loop;
+    prefetcher_ = std::make_unique<FramePrefetcher>(
+        pc, frame_paths_.size(),
+        [this](std::size_t index, Frame& out) { return load_frame(index, out); });
+    prefetcher_->start();
+  }
   return Status::ok_status();
 }
 
@@ -50,7 +98,8 @@ Status FrameDirSource::load_file_list() {
       return Status::io_error("FrameDirSource: failed listing directory: " + cfg_.path);
     }
     if (!it.is_regular_file(ec)) continue;
-    if (it.path().extension() != ".bin") continue;
+    const auto ext = it.path().extension();
+    if (ext != ".bin" && ext != ".qbin") continue;
     entries.push_back(std::make_pair(it.path().filename().string(), it.path().string()));
   }
 
@@ -63,75 +112,235 @@ Status FrameDirSource::load_file_list() {
   }
 
   if (frame_paths_.empty()) {
-    return Status::not_found("FrameDirSource: no .bin files found in " + cfg_.path);
+    return Status::not_found("FrameDirSource: no .bin/.qbin files found in " + cfg_.path);
   }
   return Status::ok_status();
 }
 
-Result<Frame> FrameDirSource::read_frame(const std::string& path, const std::string& frame_id) {
-  std::ifstream f(path, std::ios::binary);
-  if (!f.is_open()) {
-    return Result<Frame>::err(Status::io_error("FrameDirSource: failed to open " + path));
+Status FrameDirSource::open_frame(std::size_t index, OpenFrame& f) const {
+  const std::string& path = frame_paths_[index];
+  if (is_quantized_path(path) || cfg_.read_mode == FrameDirReadMode::kMmap) {
+    auto map_r = MappedFile::open(path, MappedFile::Access::kSequential);
+    if (!map_r.ok()) return map_r.status();
+    f.map = map_r.take_value();
+    return Status::ok_status();
   }
+  f.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (f.fd < 0) return Status::io_error("FrameDirSource: failed to open " + path);
+  (void)::posix_fadvise(f.fd, 0, 0, POSIX_FADV_WILLNEED);
+  return Status::ok_status();
+}
 
-  f.seekg(0, std::ios::end);
-  const std::streamoff nbytes = f.tellg();
-  f.seekg(0, std::ios::beg);
-
-  const std::streamoff stride = 4 * static_cast<std::streamoff>(sizeof(float));
-  if (nbytes <= 0 || (nbytes % stride) != 0) {
-    return Result<Frame>::err(Status::corrupt_data(
-        "FrameDirSource: frame file size not multiple of 4*float"));
+Status FrameDirSource::decode_frame(std::size_t index, OpenFrame& f, Frame& out) const {
+  if (f.fd >= 0) {
+    const Status st = read_frame(f.fd, frame_ids_[index], out);
+    ::close(f.fd);
+    f.fd = -1;
+    return st;
   }
+  std::shared_ptr<const MappedFile> map = std::move(f.map);
+  if (is_quantized_path(frame_paths_[index])) return decode_quantized_frame(*map, frame_ids_[index], out);
+  return map_frame(std::move(map), frame_ids_[index], out);
+}
 
-  const std::size_t npts = static_cast<std::size_t>(nbytes / stride);
+Status FrameDirSource::read_frame(int fd, const std::string& frame_id, Frame& out) {
+  struct stat st {};
+  const bool stat_ok = ::fstat(fd, &st) == 0;
+  const auto nbytes = stat_ok ? static_cast<std::size_t>(st.st_size) : 0;
 
-  std::vector<float> buf(4 * npts);
-  f.read(reinterpret_cast<char*>(buf.data()),
-         static_cast<std::streamsize>(buf.size() * sizeof(float)));
-  if (!f) return Result<Frame>::err(Status::io_error("FrameDirSource: short read"));
+  constexpr std::size_t stride = 4 * sizeof(float);
+  if (nbytes == 0 || (nbytes % stride) != 0) {
+    return Status::corrupt_data("FrameDirSource: frame file size not multiple of 4*float");
+  }
 
-  Frame out;
-  out.frame_id = frame_id;
+  const std::size_t npts = nbytes / stride;
+  out.frame_id.assign(frame_id);
+  out.points.clear();
   out.points.reserve(npts);
-  for (std::size_t i = 0; i < npts; ++i) {
-    const float x = buf[4 * i + 0];
-    const float y = buf[4 * i + 1];
-    const float z = buf[4 * i + 2];
-    const float intensity = buf[4 * i + 3];
-    out.points.push_back(PointXYZI{x, y, z, intensity});
+
+  // Read fixed-size chunks of records into a stack buffer and de-interleave each chunk
+  // straight into the frame's lanes: no per-frame scratch allocation.
+  constexpr std::size_t kChunkPoints = 1024;
+  float chunk[kChunkPoints * 4];
+  std::size_t done = 0;
+  while (done < npts) {
+    const std::size_t want = std::min(kChunkPoints, npts - done);
+    const std::size_t want_bytes = want * stride;
+    std::size_t got = 0;
+    while (got < want_bytes) {
+      const ssize_t r = ::read(fd, reinterpret_cast<char*>(chunk) + got, want_bytes - got);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) {
+        out.points.clear();
+        return Status::io_error("FrameDirSource: short read");
+      }
+      got += static_cast<std::size_t>(r);
+    }
+    out.points.append(ConstPointView{chunk + 0, chunk + 1, chunk + 2, chunk + 3, want, 4});
+    done += want;
   }
 
-  return Result<Frame>::ok(std::move(out));
+  return Status::ok_status();
+}
+
+Status FrameDirSource::map_frame(std::shared_ptr<const MappedFile> map, const std::string& frame_id,
+                                 Frame& out) {
+  constexpr std::size_t stride = 4 * sizeof(float);
+  if (map->size() == 0 || (map->size() % stride) != 0) {
+    return Status::corrupt_data("FrameDirSource: frame file size not multiple of 4*float");
+  }
+
+  // mmap returns page-aligned memory, so the float records are naturally aligned.
+  const auto* base = reinterpret_cast<const float*>(map->data());
+  const std::size_t npts = map->size() / stride;
+
+  out.frame_id.assign(frame_id);
+  out.points.borrow(ConstPointView{base + 0, base + 1, base + 2, base + 3, npts, 4}, std::move(map));
+  return Status::ok_status();
+}
+
+Status FrameDirSource::decode_quantized_frame(const MappedFile& map, const std::string& frame_id,
+                                              Frame& out) {
+  if (map.size() < sizeof(QuantizedFrameFileHeader)) {
+    return Status::corrupt_data("FrameDirSource: quantized frame too small: " + map.path());
+  }
+  QuantizedFrameFileHeader h{};
+  std::memcpy(&h, map.data(), sizeof(h));
+  const std::size_t n = h.num_points;
+  if (std::memcmp(h.magic, kQuantizedFrameMagic, sizeof(h.magic)) != 0 ||
+      map.size() != sizeof(h) + n * kQuantizedBytesPerPoint) {
+    return Status::corrupt_data("FrameDirSource: bad quantized frame: " + map.path());
+  }
+
+  const std::byte* lanes = map.data() + sizeof(h);
+  QuantizedPointsView q;
+  q.x = reinterpret_cast<const std::int16_t*>(lanes);
+  q.y = q.x + n;
+  q.z = q.y + n;
+  q.intensity = reinterpret_cast<const std::uint8_t*>(q.z + n);
+  q.size = n;
+  q.params = h.params;
+
+  out.frame_id.assign(frame_id);
+  dequantize_points(q, out.points);
+  return Status::ok_status();
+}
+
+// Safe to call from prefetch threads: only reads the (immutable while open) file list.
+Status FrameDirSource::load_frame(std::size_t index, Frame& out) {
+  OpenFrame f;
+  WM_RETURN_IF_ERROR(open_frame(index, f));
+  return decode_frame(index, f, out);
 }
 
 Result<Frame> FrameDirSource::next() {
+  Frame out;
+  Status st = next_into(out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Status FrameDirSource::next_into(Frame& out) {
   if (!opened_) {
-    return Result<Frame>::err(Status::invalid_argument("FrameDirSource::next: not opened"));
+    return Status::invalid_argument("FrameDirSource::next: not opened");
   }
   if (frame_paths_.empty()) {
-    return Result<Frame>::err(Status::out_of_range("eof"));
+    return Status::out_of_range("eof");
+  }
+
+  if (prefetcher_) {
+    WM_RETURN_IF_ERROR(prefetcher_->next_into(out));
+    out.t_ns = TimestampNs{emitted_ * frame_period_ns_};
+    out.seq = static_cast<std::uint64_t>(emitted_);
+    ++emitted_;
+    return Status::ok_status();
   }
 
   if (idx_ >= frame_paths_.size()) {
     if (!cfg_.loop) {
-      return Result<Frame>::err(Status::out_of_range("eof"));
+      return Status::out_of_range("eof");
     }
     idx_ = 0;
   }
 
-  auto frame_r = read_frame(frame_paths_[idx_], frame_ids_[idx_]);
-  if (!frame_r.ok()) return frame_r;
-
-  Frame frame = frame_r.take_value();
-  frame.t_ns = TimestampNs{emitted_ * frame_period_ns_};
+  WM_RETURN_IF_ERROR(load_frame(idx_, out));
+  out.t_ns = TimestampNs{emitted_ * frame_period_ns_};
+  out.seq = static_cast<std::uint64_t>(emitted_);
 
   ++idx_;
   ++emitted_;
-  return Result<Frame>::ok(std::move(frame));
+  return Status::ok_status();
+}
+
+Result<std::size_t> FrameDirSource::next_batch(std::span<Frame> out) {
+  using R = Result<std::size_t>;
+  if (!opened_) {
+    return R::err(Status::invalid_argument("FrameDirSource::next: not opened"));
+  }
+  if (frame_paths_.empty()) {
+    return R::err(Status::out_of_range("eof"));
+  }
+
+  if (prefetcher_) {
+    auto n_r = prefetcher_->next_batch(out);
+    if (!n_r.ok()) return n_r;
+    for (std::size_t k = 0; k < n_r.value(); ++k) {
+      out[k].t_ns = TimestampNs{emitted_ * frame_period_ns_};
+      out[k].seq = static_cast<std::uint64_t>(emitted_);
+      ++emitted_;
+    }
+    return n_r;
+  }
+
+  // Open (and so hint) every file of the batch first, following the wrap when looping,
+  // then decode from the same mappings and descriptors. An open failure ends the batch
+  // there; the frame is retried, and its error reported, by the next call.
+  std::size_t idx = idx_;
+  Status open_st;
+  batch_.clear();
+  for (std::size_t k = 0; k < out.size(); ++k, ++idx) {
+    if (idx >= frame_paths_.size()) {
+      if (!cfg_.loop) break;
+      idx = 0;
+    }
+    batch_.emplace_back();
+    open_st = open_frame(idx, batch_.back());
+    if (!open_st.ok()) {
+      batch_.pop_back();
+      break;
+    }
+  }
+  if (batch_.empty()) {
+    if (!open_st.ok()) return R::err(open_st);
+    return R::err(Status::out_of_range("eof"));
+  }
+
+  std::size_t n = 0;
+  Status st;
+  for (; n < batch_.size(); ++n) {
+    if (idx_ >= frame_paths_.size()) idx_ = 0;
+    st = decode_frame(idx_, batch_[n], out[n]);
+    if (!st.ok()) break;
+    out[n].t_ns = TimestampNs{emitted_ * frame_period_ns_};
+    out[n].seq = static_cast<std::uint64_t>(emitted_);
+    ++idx_;
+    ++emitted_;
+  }
+  for (std::size_t k = n; k < batch_.size(); ++k) {
+    if (batch_[k].fd >= 0) ::close(batch_[k].fd);
+  }
+  batch_.clear();
+  if (n == 0) return R::err(st);
+  return R::ok(n);
+}
+
+FramePrefetchStats FrameDirSource::prefetch_stats() const {
+  return prefetcher_ ? prefetcher_->stats() : FramePrefetchStats{};
 }
 
 void FrameDirSource::close() {
+  // Stop I/O threads before the file list they read from goes away.
+  prefetcher_.reset();
   opened_ = false;
   frame_paths_.clear();
   frame_ids_.clear();
@@ -0,0 +1,431 @@
+// File: src/adapters/replay/packed_dataset.cpp
+#include "wm/adapters/replay/packed_dataset.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+namespace wm {
+namespace {
+
+std::uint64_t fnv1a64(const void* data, std::size_t n) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+  std::uint64_t h = 1469598103934665603ull;
+  for (std::size_t i = 0; i < n; ++i) {
+    h ^= static_cast<std::uint64_t>(p[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::uint64_t align_up(std::uint64_t v) {
+  return (v + kPackedAlignment - 1) / kPackedAlignment * kPackedAlignment;
+}
+
+std::uint64_t lane_bytes(std::uint64_t num_points) { return align_up(num_points * sizeof(float)); }
+
+std::uint64_t payload_bytes(PackedEncoding enc, std::uint64_t n) {
+  if (enc == PackedEncoding::kQuant16) {
+    return align_up(sizeof(QuantizationParams)) + 3 * align_up(n * sizeof(std::int16_t)) +
+           align_up(n * sizeof(std::uint8_t));
+  }
+  return 4 * lane_bytes(n);
+}
+
+template <std::size_t N>
+void copy_padded(char (&dst)[N], const std::string& src) {
+  std::memset(dst, 0, N);
+  std::memcpy(dst, src.data(), std::min(src.size(), N - 1));
+}
+
+template <std::size_t N>
+std::size_t padded_length(const char (&src)[N]) {
+  return static_cast<std::size_t>(std::find(src, src + N, '\0') - src);
+}
+
+}  // namespace
+
+// -----------------------------
+// PackedDatasetWriter
+// -----------------------------
+
+PackedDatasetWriter::~PackedDatasetWriter() {
+  // A writer destroyed before finish() holds a file without index or footer; drop it rather than
+  // finalizing a truncated dataset that would still pass verify().
+  if (f_.is_open()) {
+    f_.close();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+  }
+}
+
+Status PackedDatasetWriter::open(const std::string& path, const std::string& node_id,
+                                 PackedEncoding encoding) {
+  if (f_.is_open()) return Status::invalid_argument("PackedDatasetWriter: already open");
+
+  f_.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!f_.is_open()) return Status::io_error("PackedDatasetWriter: failed opening " + path);
+
+  path_ = path;
+  node_id_ = node_id;
+  encoding_ = encoding;
+  offset_ = 0;
+  index_.clear();
+
+  PackedFileHeader h{};
+  std::memcpy(h.magic, kPackedFileMagic, sizeof(h.magic));
+  h.version = kPackedVersion;
+  h.header_bytes = sizeof(PackedFileHeader);
+  copy_padded(h.node_id, node_id_);
+  return write_bytes(&h, sizeof(h));
+}
+
+Status PackedDatasetWriter::write_bytes(const void* data, std::size_t n) {
+  f_.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+  if (!f_.good()) return Status::io_error("PackedDatasetWriter: failed writing " + path_);
+  offset_ += n;
+  return Status::ok_status();
+}
+
+Status PackedDatasetWriter::pad_to_alignment() {
+  static constexpr char kZeros[kPackedAlignment] = {};
+  const std::uint64_t pad = align_up(offset_) - offset_;
+  return pad > 0 ? write_bytes(kZeros, static_cast<std::size_t>(pad)) : Status::ok_status();
+}
+
+Status PackedDatasetWriter::append(const Frame& frame, std::uint64_t seq) {
+  if (!f_.is_open()) return Status::invalid_argument("PackedDatasetWriter: not open");
+  if (!index_.empty() && frame.t_ns.ns < index_.back().t_ns) {
+    return Status::invalid_argument("PackedDatasetWriter: timestamps must be non-decreasing");
+  }
+
+  WM_RETURN_IF_ERROR(pad_to_alignment());
+
+  const ConstPointView pts = frame.points.view();
+  const std::uint64_t n = pts.size;
+
+  PackedFrameHeader h{};
+  h.magic = kPackedFrameMagic;
+  h.encoding = static_cast<std::uint32_t>(encoding_);
+  h.num_points = n;
+  h.t_ns = frame.t_ns.ns;
+  h.seq = seq;
+  copy_padded(h.node_id, node_id_);
+  copy_padded(h.frame_id, frame.frame_id);
+  h.payload_bytes = payload_bytes(encoding_, n);
+
+  index_.push_back(PackedIndexEntry{offset_, h.t_ns, seq, n});
+  WM_RETURN_IF_ERROR(write_bytes(&h, sizeof(h)));
+
+  return encoding_ == PackedEncoding::kQuant16 ? write_quantized_lanes(pts) : write_float_lanes(pts);
+}
+
+Status PackedDatasetWriter::write_float_lanes(ConstPointView pts) {
+  // Borrowed (strided) views are written lane by lane through a small staging buffer.
+  const std::uint64_t n = pts.size;
+  const float* lanes[4] = {pts.x, pts.y, pts.z, pts.intensity};
+  for (const float* lane : lanes) {
+    if (pts.contiguous()) {
+      WM_RETURN_IF_ERROR(write_bytes(lane, n * sizeof(float)));
+    } else {
+      float staging[1024];
+      for (std::uint64_t i = 0; i < n;) {
+        const std::uint64_t m = std::min<std::uint64_t>(1024, n - i);
+        for (std::uint64_t k = 0; k < m; ++k) staging[k] = lane[(i + k) * pts.stride];
+        WM_RETURN_IF_ERROR(write_bytes(staging, m * sizeof(float)));
+        i += m;
+      }
+    }
+    WM_RETURN_IF_ERROR(pad_to_alignment());
+  }
+  return Status::ok_status();
+}
+
+Status PackedDatasetWriter::write_quantized_lanes(ConstPointView pts) {
+  const std::size_t n = pts.size;
+  qx_.resize(n);
+  qy_.resize(n);
+  qz_.resize(n);
+  qi_.resize(n);
+
+  const QuantizationParams params = choose_quantization(pts);
+  quantize_points(pts, params, qx_.data(), qy_.data(), qz_.data(), qi_.data());
+
+  WM_RETURN_IF_ERROR(write_bytes(&params, sizeof(params)));
+  WM_RETURN_IF_ERROR(pad_to_alignment());
+  for (const auto* lane : {&qx_, &qy_, &qz_}) {
+    WM_RETURN_IF_ERROR(write_bytes(lane->data(), n * sizeof(std::int16_t)));
+    WM_RETURN_IF_ERROR(pad_to_alignment());
+  }
+  WM_RETURN_IF_ERROR(write_bytes(qi_.data(), n));
+  return pad_to_alignment();
+}
+
+Status PackedDatasetWriter::finish() {
+  if (!f_.is_open()) return Status::invalid_argument("PackedDatasetWriter: not open");
+
+  WM_RETURN_IF_ERROR(pad_to_alignment());
+
+  PackedFooter footer{};
+  std::memcpy(footer.magic, kPackedFooterMagic, sizeof(footer.magic));
+  footer.index_offset = offset_;
+  footer.num_frames = index_.size();
+  footer.t_first_ns = index_.empty() ? 0 : index_.front().t_ns;
+  footer.t_last_ns = index_.empty() ? 0 : index_.back().t_ns;
+  footer.index_checksum = fnv1a64(index_.data(), index_.size() * sizeof(PackedIndexEntry));
+
+  WM_RETURN_IF_ERROR(write_bytes(index_.data(), index_.size() * sizeof(PackedIndexEntry)));
+  WM_RETURN_IF_ERROR(write_bytes(&footer, sizeof(footer)));
+
+  f_.flush();
+  const bool ok = f_.good();
+  f_.close();
+  if (!ok) return Status::io_error("PackedDatasetWriter: failed flushing " + path_);
+  return Status::ok_status();
+}
+
+// -----------------------------
+// PackedDatasetReader
+// -----------------------------
+
+Status PackedDatasetReader::open(const std::string& path) {
+  close();
+
+  auto map_r = MappedFile::open(path, MappedFile::Access::kRandom);
+  if (!map_r.ok()) return map_r.status();
+  auto map = map_r.take_value();
+
+  if (map->size() < sizeof(PackedFileHeader) + sizeof(PackedFooter)) {
+    return Status::corrupt_data("PackedDatasetReader: file too small: " + path);
+  }
+
+  PackedFileHeader header{};
+  std::memcpy(&header, map->data(), sizeof(header));
+  if (std::memcmp(header.magic, kPackedFileMagic, sizeof(header.magic)) != 0) {
+    return Status::corrupt_data("PackedDatasetReader: bad file magic: " + path);
+  }
+  if (header.version != kPackedVersion) {
+    return Status::unsupported("PackedDatasetReader: unsupported version " +
+                               std::to_string(header.version) + " in " + path);
+  }
+
+  PackedFooter footer{};
+  std::memcpy(&footer, map->data() + map->size() - sizeof(PackedFooter), sizeof(footer));
+  if (std::memcmp(footer.magic, kPackedFooterMagic, sizeof(footer.magic)) != 0) {
+    return Status::corrupt_data("PackedDatasetReader: bad footer (truncated file?): " + path);
+  }
+
+  // The index must fill [index_offset, footer) exactly. Compared by subtraction: offsets
+  // and counts come from the file and their sums could wrap.
+  const std::uint64_t index_end = map->size() - sizeof(PackedFooter);
+  if (footer.index_offset % alignof(PackedIndexEntry) != 0 || footer.index_offset < sizeof(PackedFileHeader) ||
+      footer.index_offset > index_end || (index_end - footer.index_offset) % sizeof(PackedIndexEntry) != 0 ||
+      footer.num_frames != (index_end - footer.index_offset) / sizeof(PackedIndexEntry)) {
+    return Status::corrupt_data("PackedDatasetReader: index out of bounds: " + path);
+  }
+
+  map_ = std::move(map);
+  footer_ = footer;
+  index_ = reinterpret_cast<const PackedIndexEntry*>(map_->data() + footer.index_offset);
+  num_frames_ = static_cast<std::size_t>(footer.num_frames);
+  node_id_.assign(header.node_id, padded_length(header.node_id));
+  return Status::ok_status();
+}
+
+void PackedDatasetReader::close() {
+  map_.reset();
+  footer_ = PackedFooter{};
+  index_ = nullptr;
+  num_frames_ = 0;
+  node_id_.clear();
+}
+
+std::size_t PackedDatasetReader::lower_bound_time(std::int64_t t_ns) const noexcept {
+  const PackedIndexEntry* end = index_ + num_frames_;
+  const PackedIndexEntry* it = std::lower_bound(
+      index_, end, t_ns, [](const PackedIndexEntry& e, std::int64_t t) { return e.t_ns < t; });
+  return static_cast<std::size_t>(it - index_);
+}
+
+Result<const PackedFrameHeader*> PackedDatasetReader::frame_header(std::size_t i) const {
+  using R = Result<const PackedFrameHeader*>;
+  if (!is_open()) return R::err(Status::invalid_argument("PackedDatasetReader: not open"));
+  if (i >= num_frames_) return R::err(Status::out_of_range("eof"));
+
+  const PackedIndexEntry& e = index_[i];
+  if (e.offset % kPackedAlignment != 0 || e.offset > footer_.index_offset ||
+      footer_.index_offset - e.offset < sizeof(PackedFrameHeader)) {
+    return R::err(Status::corrupt_data("PackedDatasetReader: frame offset out of bounds"));
+  }
+  // Bytes between the frame header and the index.
+  const std::uint64_t room = footer_.index_offset - e.offset - sizeof(PackedFrameHeader);
+
+  const auto* h = reinterpret_cast<const PackedFrameHeader*>(map_->data() + e.offset);
+  if (h->magic != kPackedFrameMagic || h->num_points != e.num_points) {
+    return R::err(Status::corrupt_data("PackedDatasetReader: bad frame header at index " +
+                                       std::to_string(i)));
+  }
+  if (h->encoding != static_cast<std::uint32_t>(PackedEncoding::kFloat32Soa) &&
+      h->encoding != static_cast<std::uint32_t>(PackedEncoding::kQuant16)) {
+    return R::err(Status::unsupported("PackedDatasetReader: unknown encoding " +
+                                      std::to_string(h->encoding)));
+  }
+  const auto enc = static_cast<PackedEncoding>(h->encoding);
+  // Every encoding takes at least kQuantizedBytesPerPoint per point, so a count that passes
+  // the first test cannot overflow payload_bytes.
+  if (h->num_points > room / kQuantizedBytesPerPoint || h->payload_bytes != payload_bytes(enc, h->num_points) ||
+      h->payload_bytes > room) {
+    return R::err(Status::corrupt_data("PackedDatasetReader: frame payload out of bounds"));
+  }
+  return R::ok(h);
+}
+
+Result<PackedEncoding> PackedDatasetReader::encoding(std::size_t i) const {
+  auto h = frame_header(i);
+  if (!h.ok()) return Result<PackedEncoding>::err(h.status());
+  return Result<PackedEncoding>::ok(static_cast<PackedEncoding>((*h)->encoding));
+}
+
+Status PackedDatasetReader::quantized_view(std::size_t i, QuantizedPointsView& out) const {
+  auto h_r = frame_header(i);
+  if (!h_r.ok()) return h_r.status();
+  const PackedFrameHeader* h = *h_r;
+  if (h->encoding != static_cast<std::uint32_t>(PackedEncoding::kQuant16)) {
+    return Status::invalid_argument("PackedDatasetReader: frame is not quantized");
+  }
+
+  const std::uint64_t n = h->num_points;
+  const std::uint64_t lane16 = align_up(n * sizeof(std::int16_t));
+  const std::byte* payload = reinterpret_cast<const std::byte*>(h) + sizeof(PackedFrameHeader);
+  std::memcpy(&out.params, payload, sizeof(QuantizationParams));
+  const std::byte* lanes = payload + align_up(sizeof(QuantizationParams));
+  out.x = reinterpret_cast<const std::int16_t*>(lanes);
+  out.y = reinterpret_cast<const std::int16_t*>(lanes + lane16);
+  out.z = reinterpret_cast<const std::int16_t*>(lanes + 2 * lane16);
+  out.intensity = reinterpret_cast<const std::uint8_t*>(lanes + 3 * lane16);
+  out.size = static_cast<std::size_t>(n);
+  return Status::ok_status();
+}
+
+Status PackedDatasetReader::read_into(std::size_t i, Frame& out, bool copy_points) const {
+  auto h_r = frame_header(i);
+  if (!h_r.ok()) return h_r.status();
+  const PackedFrameHeader* h = *h_r;
+
+  out.t_ns = TimestampNs{h->t_ns};
+  out.seq = h->seq;
+  out.frame_id.assign(h->frame_id, padded_length(h->frame_id));
+
+  if (h->encoding == static_cast<std::uint32_t>(PackedEncoding::kQuant16)) {
+    QuantizedPointsView q;
+    WM_RETURN_IF_ERROR(quantized_view(i, q));
+    dequantize_points(q, out.points);
+    return Status::ok_status();
+  }
+
+  const std::uint64_t n = h->num_points;
+  const std::uint64_t lane = lane_bytes(n);
+  const std::byte* payload = reinterpret_cast<const std::byte*>(h) + sizeof(PackedFrameHeader);
+  const auto* x = reinterpret_cast<const float*>(payload);
+  const auto* y = reinterpret_cast<const float*>(payload + lane);
+  const auto* z = reinterpret_cast<const float*>(payload + 2 * lane);
+  const auto* in = reinterpret_cast<const float*>(payload + 3 * lane);
+  const ConstPointView v{x, y, z, in, static_cast<std::size_t>(n), 1};
+
+  if (copy_points) {
+    out.points.clear();
+    out.points.append(v);
+  } else {
+    out.points.borrow(v, map_);
+  }
+  return Status::ok_status();
+}
+
+void PackedDatasetReader::prefetch_records(std::size_t first, std::size_t last) const noexcept {
+  last = std::min(last, num_frames_);
+  if (map_ == nullptr || first >= last) return;
+  // Records are stored in index order, so the range ends where the next record (or the
+  // index itself) begins.
+  const std::uint64_t begin = index_[first].offset;
+  const std::uint64_t end = last < num_frames_ ? index_[last].offset : footer_.index_offset;
+  if (end > begin) map_->advise_willneed(begin, end - begin);
+}
+
+Status PackedDatasetReader::verify() const {
+  if (!is_open()) return Status::invalid_argument("PackedDatasetReader: not open");
+
+  const std::uint64_t sum = fnv1a64(index_, num_frames_ * sizeof(PackedIndexEntry));
+  if (sum != footer_.index_checksum) {
+    return Status::corrupt_data("PackedDatasetReader: index checksum mismatch");
+  }
+
+  Frame scratch;
+  for (std::size_t i = 0; i < num_frames_; ++i) {
+    if (i > 0 && index_[i].t_ns < index_[i - 1].t_ns) {
+      return Status::corrupt_data("PackedDatasetReader: index not sorted by time");
+    }
+    WM_RETURN_IF_ERROR(read_into(i, scratch));
+  }
+  return Status::ok_status();
+}
+
+// -----------------------------
+// PackedDatasetSource
+// -----------------------------
+
+PackedDatasetSource::PackedDatasetSource(PackedDatasetSourceConfig cfg) : cfg_(std::move(cfg)) {}
+
+Status PackedDatasetSource::open() {
+  if (cfg_.path.empty()) return Status::invalid_argument("PackedDatasetSource: path is empty");
+  close();
+  WM_RETURN_IF_ERROR(reader_.open(cfg_.path));
+  if (reader_.num_frames() == 0) {
+    reader_.close();
+    return Status::not_found("PackedDatasetSource: dataset has no frames: " + cfg_.path);
+  }
+  idx_ = 0;
+  return Status::ok_status();
+}
+
+Result<Frame> PackedDatasetSource::next() {
+  Frame out;
+  Status st = next_into(out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Status PackedDatasetSource::next_into(Frame& out) {
+  if (!reader_.is_open()) {
+    return Status::invalid_argument("PackedDatasetSource::next: not opened");
+  }
+  if (idx_ >= reader_.num_frames()) {
+    if (!cfg_.loop) return Status::out_of_range("eof");
+    idx_ = 0;
+  }
+  WM_RETURN_IF_ERROR(reader_.read_into(idx_, out, cfg_.copy_points));
+  ++idx_;
+  return Status::ok_status();
+}
+
+Status PackedDatasetSource::seek(std::size_t index) {
+  if (!reader_.is_open()) return Status::invalid_argument("PackedDatasetSource::seek: not opened");
+  if (index > reader_.num_frames()) return Status::out_of_range("PackedDatasetSource::seek: past end");
+  idx_ = index;
+  return Status::ok_status();
+}
+
+Status PackedDatasetSource::seek_time(TimestampNs t) {
+  if (!reader_.is_open()) {
+    return Status::invalid_argument("PackedDatasetSource::seek_time: not opened");
+  }
+  idx_ = reader_.lower_bound_time(t.ns);
+  return Status::ok_status();
+}
+
+void PackedDatasetSource::close() {
+  reader_.close();
+  idx_ = 0;
+}
+
+}  // namespace wm
@@ -1,4 +1,118 @@
-// src/adapters/replay/replay_reader.cpp
+// File: src/adapters/replay/replay_reader.cpp
+#include "wm/adapters/replay/replay_reader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <utility>
+
 namespace wm {
-void replay_reader_placeholder() {}
-}  // namespace wm
\ No newline at end of file
+namespace {
+
+std::string resolve_dataset_file(const std::string& path) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  if (fs::is_directory(path, ec)) return (fs::path(path) / kReplayDatasetFileName).string();
+  return path;
+}
+
+}  // namespace
+
+ReplayReader::ReplayReader(ReplayReaderConfig cfg) : cfg_(std::move(cfg)) {}
+
+Status ReplayReader::open() {
+  if (cfg_.dataset_path.empty()) return Status::invalid_argument("ReplayReader: dataset_path is empty");
+  if (cfg_.time_scale < 0.0) return Status::invalid_argument("ReplayReader: time_scale must be >= 0");
+  close();
+
+  WM_RETURN_IF_ERROR(reader_.open(resolve_dataset_file(cfg_.dataset_path)));
+  if (reader_.num_frames() == 0) {
+    reader_.close();
+    return Status::not_found("ReplayReader: dataset has no frames: " + cfg_.dataset_path);
+  }
+
+  // Trim by index: two binary searches over the mapped footer index, no frame reads.
+  const std::int64_t t0 = reader_.t_first_ns();
+  begin_ = cfg_.start_offset_ns > 0 ? reader_.lower_bound_time(t0 + cfg_.start_offset_ns) : 0;
+  end_ = cfg_.end_offset_ns > 0 ? reader_.lower_bound_time(t0 + cfg_.end_offset_ns)
+                                : reader_.num_frames();
+  if (begin_ >= end_) {
+    reader_.close();
+    return Status::out_of_range("ReplayReader: trim window selects no frames");
+  }
+
+  const std::int64_t t_begin = reader_.entry(begin_).t_ns;
+  const std::int64_t t_last = reader_.entry(end_ - 1).t_ns;
+  const std::size_t n = end_ - begin_;
+  const std::int64_t mean_period = n > 1 ? (t_last - t_begin) / static_cast<std::int64_t>(n - 1)
+                                         : 100000000;
+
+  t_window_start_ns_ = t_begin;
+  loop_span_ns_ = (t_last - t_begin) + mean_period;
+  loop_offset_ns_ = 0;
+  idx_ = begin_;
+  emitted_ = 0;
+  return Status::ok_status();
+}
+
+Result<Frame> ReplayReader::next() {
+  Frame out;
+  Status st = next_into(out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Status ReplayReader::next_into(Frame& out) {
+  if (!reader_.is_open()) return Status::invalid_argument("ReplayReader::next: not opened");
+
+  if (idx_ >= end_) {
+    if (!cfg_.loop) return Status::out_of_range("eof");
+    idx_ = begin_;
+    loop_offset_ns_ += loop_span_ns_;
+  }
+
+  WM_RETURN_IF_ERROR(reader_.read_into(idx_, out, cfg_.copy_points));
+  const std::int64_t t_rel = out.t_ns.ns - t_window_start_ns_ + loop_offset_ns_;
+
+  if (cfg_.time_scale > 0.0) {
+    if (emitted_ == 0) wall_anchor_ = std::chrono::steady_clock::now();
+    const auto due = wall_anchor_ + std::chrono::nanoseconds(static_cast<std::int64_t>(
+                                        static_cast<double>(t_rel) / cfg_.time_scale));
+    std::this_thread::sleep_until(due);
+  }
+
+  out.t_ns = TimestampNs{t_rel};
+  out.seq = emitted_;
+  ++idx_;
+  ++emitted_;
+  return Status::ok_status();
+}
+
+Result<std::size_t> ReplayReader::next_batch(std::span<Frame> out) {
+  if (!reader_.is_open()) {
+    return Result<std::size_t>::err(Status::invalid_argument("ReplayReader::next: not opened"));
+  }
+
+  // Records up to the window end (or the wrap point when looping) are contiguous on disk.
+  const std::size_t first = idx_ < end_ ? idx_ : begin_;
+  reader_.prefetch_records(first, std::min(end_, first + out.size()));
+
+  std::size_t n = 0;
+  for (; n < out.size(); ++n) {
+    const Status st = next_into(out[n]);
+    if (!st.ok()) {
+      if (n == 0) return Result<std::size_t>::err(st);
+      break;
+    }
+  }
+  return Result<std::size_t>::ok(n);
+}
+
+void ReplayReader::close() {
+  reader_.close();
+  begin_ = end_ = idx_ = 0;
+  emitted_ = 0;
+  loop_offset_ns_ = 0;
+}
+
+}  // namespace wm
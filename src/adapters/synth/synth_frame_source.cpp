@@ -2,6 +2,7 @@
 #include "wm/adapters/synth/synth_frame_source.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <random>
 #include <string>
@@ -16,6 +17,17 @@ std::int64_t hz_to_period_ns(double hz) {
   return static_cast<std::int64_t>(std::llround(ns));
 }
 
+// Obstacle surface: 8x8 grid, six samples per cell (see append_obstacle_points).
+constexpr std::size_t kObstaclePoints = 8 * 8 * 6;
+
+// "synth_<tick>" written into the existing string storage (no allocation once warmed up).
+void assign_frame_id(std::string& out, std::int64_t tick) {
+  char digits[24];
+  const auto r = std::to_chars(digits, digits + sizeof(digits), tick);
+  out.assign("synth_");
+  out.append(digits, r.ptr);
+}
+
 }  // namespace
 
 SynthFrameSource::SynthFrameSource(SynthSourceConfig cfg) : cfg_(std::move(cfg)) {
@@ -33,15 +45,38 @@ Status SynthFrameSource::open() {
 }
 
 Result<Frame> SynthFrameSource::next() {
+  Frame out;
+  Status st = next_into(out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Status SynthFrameSource::next_into(Frame& out) {
+  if (!opened_) {
+    return Status::invalid_argument("SynthFrameSource::next: not opened");
+  }
+  fill_frame(out);
+  return Status::ok_status();
+}
+
+Result<std::size_t> SynthFrameSource::next_batch(std::span<Frame> out) {
   if (!opened_) {
-    return Result<Frame>::err(Status::invalid_argument("SynthFrameSource::next: not opened"));
+    return Result<std::size_t>::err(Status::invalid_argument("SynthFrameSource::next: not opened"));
   }
+  for (Frame& f : out) fill_frame(f);
+  return Result<std::size_t>::ok(out.size());
+}
 
-  Frame out;
+void SynthFrameSource::fill_frame(Frame& out) {
   const std::int64_t t_ns = tick_ * tick_period_ns_;
   out.t_ns = TimestampNs{t_ns};
-  out.frame_id = "synth_" + std::to_string(tick_);
-  out.points = static_points_;
+  out.seq = static_cast<std::uint64_t>(tick_);
+  assign_frame_id(out.frame_id, tick_);
+
+  // Copy the static scene into the reused lanes (memcpy per lane, capacity kept across ticks).
+  out.points.clear();
+  out.points.reserve(static_points_.size() + (cfg_.enable_obstacle ? kObstaclePoints : 0));
+  out.points.append(static_points_.view());
 
   const double t_s = static_cast<double>(t_ns) * 1e-9;
   if (cfg_.enable_obstacle && t_s >= cfg_.obstacle_start_s) {
@@ -49,7 +84,6 @@ Result<Frame> SynthFrameSource::next() {
   }
 
   ++tick_;
-  return Result<Frame>::ok(std::move(out));
 }
 
 void SynthFrameSource::close() {
@@ -70,7 +104,7 @@ void SynthFrameSource::build_static_scene() {
   }
 }
 
-void SynthFrameSource::append_obstacle_points(std::vector<PointXYZI>& points, double t_s) const {
+void SynthFrameSource::append_obstacle_points(PointBuffer& points, double t_s) const {
   constexpr int kGrid = 8;
   constexpr float kHalfSize = 0.5f;
   float cx = 2.0f;
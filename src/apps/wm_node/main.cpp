@@ -1,15 +1,28 @@
 // File: src/apps/wm_node/main.cpp
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "wm/adapters/frame_dir/frame_dir_source.hpp"
+#include "wm/adapters/replay/replay_reader.hpp"
 #include "wm/adapters/synth/synth_frame_source.hpp"
 #include "wm/core/events/jsonl_event_sink.hpp"
+#include "wm/core/geom/point_transform.hpp"
+#include "wm/core/io/frame_pool.hpp"
 #include "wm/core/io/frame_source.hpp"
+#include "wm/core/io/merge_frame_source.hpp"
+#include "wm/core/mapping/integration_scheduler.hpp"
+#include "wm/core/mapping/map_snapshot.hpp"
+#include "wm/core/mapping/multires_map.hpp"
+#include "wm/core/mapping/spatial_query.hpp"
 #include "wm/core/model/node_runner.hpp"
+#include "wm/core/preprocess/input_preprocessor.hpp"
 #include "wm/core/util/config_loader.hpp"
 
 namespace {
@@ -42,30 +55,143 @@ void print_usage() {
             << "  --config <path>\n";
 }
 
+std::unique_ptr<wm::FrameSource> make_synth_source(const wm::Config& cfg, std::uint32_t seed) {
+  wm::SynthSourceConfig sc;
+  sc.tick_hz = cfg.input.tick_hz;
+  sc.seed = seed;
+  sc.num_points = cfg.input.synth.num_points;
+  sc.enable_obstacle = cfg.input.synth.enable_obstacle;
+  sc.obstacle_start_s = cfg.input.synth.obstacle_start_s;
+  sc.moving_obstacle = cfg.input.synth.moving_obstacle;
+  sc.obstacle_speed_mps = cfg.input.synth.obstacle_speed_mps;
+  return std::make_unique<wm::SynthFrameSource>(sc);
+}
+
+std::unique_ptr<wm::FrameSource> make_frame_dir_source(const wm::Config& cfg, const std::string& path,
+                                                       bool loop, double fps) {
+  wm::FrameDirSourceConfig dc;
+  dc.path = path;
+  dc.loop = loop;
+  dc.fps = fps > 0.0 ? fps : cfg.input.tick_hz;
+  dc.read_mode = cfg.input.frame_dir.read_mode == "mmap" ? wm::FrameDirReadMode::kMmap
+                                                         : wm::FrameDirReadMode::kCopy;
+  dc.prefetch_depth = cfg.input.frame_dir.prefetch_depth;
+  dc.io_threads = cfg.input.frame_dir.io_threads;
+  return std::make_unique<wm::FrameDirSource>(dc);
+}
+
+std::unique_ptr<wm::FrameSource> make_replay_source(const wm::Config& cfg, const std::string& path) {
+  wm::ReplayReaderConfig rc;
+  rc.dataset_path = path;
+  rc.time_scale = cfg.replay.time_scale;
+  rc.start_offset_ns = cfg.replay.start_offset_ns;
+  rc.end_offset_ns = cfg.replay.end_offset_ns;
+  rc.loop = cfg.replay.loop;
+  return std::make_unique<wm::ReplayReader>(rc);
+}
+
 std::unique_ptr<wm::FrameSource> make_source_from_config(const wm::Config& cfg) {
   if (cfg.input.type == "synth") {
-    wm::SynthSourceConfig sc;
-    sc.tick_hz = cfg.input.tick_hz;
-    sc.seed = cfg.input.synth.seed;
-    sc.num_points = cfg.input.synth.num_points;
-    sc.enable_obstacle = cfg.input.synth.enable_obstacle;
-    sc.obstacle_start_s = cfg.input.synth.obstacle_start_s;
-    sc.moving_obstacle = cfg.input.synth.moving_obstacle;
-    sc.obstacle_speed_mps = cfg.input.synth.obstacle_speed_mps;
-    return std::make_unique<wm::SynthFrameSource>(sc);
+    return make_synth_source(cfg, cfg.input.synth.seed);
   }
 
   if (cfg.input.type == "frame_dir") {
-    wm::FrameDirSourceConfig dc;
-    dc.path = cfg.input.frame_dir.path;
-    dc.loop = cfg.input.frame_dir.loop;
-    dc.fps = cfg.input.frame_dir.fps > 0.0 ? cfg.input.frame_dir.fps : cfg.input.tick_hz;
-    return std::make_unique<wm::FrameDirSource>(dc);
+    return make_frame_dir_source(cfg, cfg.input.frame_dir.path, cfg.input.frame_dir.loop,
+                                 cfg.input.frame_dir.fps);
+  }
+
+  if (cfg.input.type == "replay") {
+    return make_replay_source(cfg, cfg.replay.dataset_path);
+  }
+
+  if (cfg.input.type == "merge") {
+    std::vector<wm::MergeSensor> sensors;
+    for (const wm::InputSensorConfig& s : cfg.input.sensors) {
+      wm::MergeSensor m;
+      m.sensor_id = s.sensor_id;
+      m.T_node_lidar = s.T_node_lidar;
+      if (s.type == "synth") m.source = make_synth_source(cfg, s.seed);
+      else if (s.type == "frame_dir") m.source = make_frame_dir_source(cfg, s.path, s.loop, s.fps);
+      else m.source = make_replay_source(cfg, s.path);
+      sensors.push_back(std::move(m));
+    }
+    return std::make_unique<wm::MergeFrameSource>(std::move(sensors));
   }
 
   return nullptr;
 }
 
+std::string format_prefetch_stats(const wm::FramePrefetchStats& s) {
+  return "queue_depth=" + std::to_string(s.queue_depth) +
+         " max_queue_depth=" + std::to_string(s.max_queue_depth) +
+         " frames_loaded=" + std::to_string(s.frames_loaded) +
+         " load_ms=" + std::to_string(s.load_ns / 1000000) +
+         " io_wait_ms=" + std::to_string(s.io_wait_ns / 1000000) +
+         " io_waits=" + std::to_string(s.io_waits);
+}
+
+// `block_allocs_per_s`: blocks allocated per second since the previous report.
+std::string format_map_stats(const wm::MultiResMap& map, const wm::VoxelBlockMapStats& m, double block_allocs_per_s,
+                             const wm::IntegrationSchedulerStats& s, const wm::RayIntegratorStats& r) {
+  return "blocks=" + std::to_string(m.blocks) + " regions=" + std::to_string(m.regions) +
+         " occupied_voxels=" + std::to_string(map.count_occupied()) +
+         " known_voxels=" + std::to_string(map.count_known()) +
+         " memory_bytes=" + std::to_string(m.memory_bytes) + " live_bytes=" + std::to_string(m.live_bytes) +
+         " pool_bytes=" + std::to_string(m.pool_bytes) + " pool_chunks=" + std::to_string(m.pool_chunks) +
+         " huge_page_chunks=" + std::to_string(m.huge_page_chunks) +
+         " pool_occupancy_pct=" + std::to_string(std::lround(100.0 * m.pool_occupancy())) +
+         " fragmentation_pct=" + std::to_string(std::lround(100.0 * m.fragmentation())) +
+         " free_regions=" + std::to_string(m.free_regions) +
+         " blocks_allocated=" + std::to_string(m.blocks_allocated) +
+         " blocks_released=" + std::to_string(m.blocks_released) +
+         " block_allocs_per_s=" + std::to_string(std::llround(block_allocs_per_s)) +
+         " regions_reused=" + std::to_string(m.regions_reused) +
+         " evicted_regions=" + std::to_string(m.evicted_regions) +
+         " evicted_blocks=" + std::to_string(m.evicted_blocks) +
+         " spilled_regions=" + std::to_string(m.spilled_regions) +
+         " restored_regions=" + std::to_string(m.restored_regions) +
+         " spill_written_bytes=" + std::to_string(m.spill_bytes_written) +
+         " spill_read_bytes=" + std::to_string(m.spill_bytes_read) +
+         " spill_file_bytes=" + std::to_string(m.spill_file_bytes) +
+         " spill_errors=" + std::to_string(m.spill_errors) +
+         " spill_compaction_errors=" + std::to_string(m.spill_compaction_errors) + " frames=" + std::to_string(s.frames) +
+         " batches=" + std::to_string(s.batches) + " max_batch_frames=" + std::to_string(s.max_batch_frames) +
+         " blocks_touched=" + std::to_string(r.blocks_touched) +
+         " integrate_ms=" + std::to_string(s.integrate_ns / 1000000);
+}
+
+// Snapshot of map level i: the configured path for level 0, `path`.l<i> for coarser levels.
+std::string level_snapshot_path(const std::string& path, int level) {
+  return level == 0 ? path : path + ".l" + std::to_string(level);
+}
+
+// Restores every level of the map from baseline.snapshot_path, or none of them. Returns the
+// map_snapshot event message.
+std::string restore_map_snapshot(const wm::Config& cfg, wm::MultiResMap& map, bool& restored) {
+  const wm::MapSnapshotKey key = wm::MapSnapshotKey::from_config(cfg);
+  std::vector<wm::VoxelBlockMap> levels;
+  for (int i = 0; i < map.num_levels(); ++i) {
+    const std::string path = level_snapshot_path(cfg.baseline.snapshot_path, i);
+    wm::Result<wm::VoxelBlockMap> r = wm::load_map_snapshot(path, key, map.level(i).params());
+    if (!r.ok()) return "restored=0 path=" + path + " reason=" + r.status().message();
+    levels.push_back(r.take_value());
+  }
+  for (int i = 0; i < map.num_levels(); ++i) map.level(i) = std::move(levels[static_cast<std::size_t>(i)]);
+  restored = true;
+  return "restored=1 path=" + cfg.baseline.snapshot_path + " levels=" + std::to_string(map.num_levels()) +
+         " blocks=" + std::to_string(map.stats().blocks);
+}
+
+wm::Status save_map_snapshots(const wm::Config& cfg, const wm::MultiResMap& map) {
+  const wm::MapSnapshotKey key = wm::MapSnapshotKey::from_config(cfg);
+  for (int i = 0; i < map.num_levels(); ++i) {
+    const std::string path = level_snapshot_path(cfg.baseline.snapshot_path, i);
+    const wm::Status st = wm::save_map_snapshot(map.level(i), key, path);
+    if (!st.ok()) return st;
+  }
+  return wm::Status::ok_status();
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -97,6 +223,10 @@ int main(int argc, char** argv) {
     return 2;
   }
 
+  // Read-ahead statistics are reported alongside heartbeats when the source has them.
+  const auto* frame_dir_source = dynamic_cast<const wm::FrameDirSource*>(source.get());
+  const bool report_prefetch = frame_dir_source != nullptr && cfg.input.frame_dir.prefetch_depth > 0;
+
   const wm::Status st_open = source->open();
   if (!st_open.ok()) {
     std::cerr << st_open.message() << "\n";
@@ -123,6 +253,15 @@ int main(int argc, char** argv) {
   const auto tick_period = std::chrono::duration_cast<std::chrono::nanoseconds>(
       std::chrono::duration<double>(1.0 / cfg.input.tick_hz));
 
+  // Replay paces itself from recorded timestamps (or runs flat out with time_scale 0),
+  // so the tick_hz sleep only applies to the other sources. A merge of replay sensors
+  // inherits their pacing; otherwise tick_hz is the merged frame rate across sensors.
+  const bool self_paced =
+      cfg.input.type == "replay" ||
+      (cfg.input.type == "merge" &&
+       std::all_of(cfg.input.sensors.begin(), cfg.input.sensors.end(),
+                   [](const wm::InputSensorConfig& s) { return s.type == "replay"; }));
+
   const auto t_start = clock::now();
   auto next_tick = t_start + tick_period;
   auto last_hb = t_start - std::chrono::seconds(cfg.input.heartbeat_every_s > 0
@@ -132,6 +271,74 @@ int main(int argc, char** argv) {
   std::int64_t tick_count = 0;
   bool had_error = false;
 
+  // Input gating and budget-driven decimation. Preprocessed frames hold node-frame points.
+  wm::InputPreprocessor preprocessor(cfg);
+  const auto T_node_lidar_of = [&cfg](const wm::Frame& f) -> const wm::TransformSE3& {
+    if (cfg.input.type == "merge" && f.sensor_index < cfg.input.sensors.size()) {
+      return cfg.input.sensors[f.sensor_index].T_node_lidar;
+    }
+    return cfg.calibration.T_node_lidar;
+  };
+
+  // World model: occupancy map (range-banded levels when lod_levels > 1), updated in
+  // batches at mapping.integrate_hz of frame time. A baseline snapshot written by an
+  // earlier run under the same config and calibration replaces relearning it.
+  wm::MultiResMap map(cfg.mapping);
+  bool baseline_frozen = false;
+  if (!cfg.baseline.snapshot_path.empty()) {
+    (void)runner.emit_event(sink, "map_snapshot", restore_map_snapshot(cfg, map, baseline_frozen));
+  }
+  wm::IntegrationScheduler scheduler(map, wm::RayIntegratorConfig::from_config(cfg.mapping),
+                                     wm::IntegrationSchedulerConfig::from_config(cfg.mapping));
+  // Query threads read the map through the snapshot published after each batch
+  // (mapping.publish_snapshots), stamped with the frame time at which it was integrated.
+  wm::MultiResOccupancyPublisher occupancy;
+  std::int64_t snapshot_capture_ns = 0;
+  const auto integrated = [&](bool batch_done, wm::TimestampNs t) {
+    if (!batch_done || !cfg.mapping.publish_snapshots) return;
+    const auto t0 = clock::now();
+    occupancy.publish(wm::MultiResOccupancySnapshot::capture(map, static_cast<std::uint64_t>(t.ns)));
+    snapshot_capture_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+  };
+  wm::TimestampNs last_frame_t{};
+  // map_stats events; the block allocation rate covers the time since the previous one.
+  std::uint64_t last_blocks_allocated = map.stats().blocks_allocated;
+  bool spill_error_reported = false;
+  auto last_map_stats = clock::now();
+  const auto emit_map_stats = [&] {
+    const wm::VoxelBlockMapStats m = map.stats();
+    const auto t = clock::now();
+    const double dt = std::chrono::duration<double>(t - last_map_stats).count();
+    const double rate = dt > 0.0 ? static_cast<double>(m.blocks_allocated - last_blocks_allocated) / dt : 0.0;
+    last_blocks_allocated = m.blocks_allocated;
+    last_map_stats = t;
+    if (m.spill_errors > 0 && !spill_error_reported) {
+      // Reported once; spill_errors in map_stats keeps counting the dropped regions.
+      for (int i = 0; i < map.num_levels() && !spill_error_reported; ++i) {
+        const wm::Status& st = map.level(i).spill_status();
+        if (st.ok()) continue;
+        (void)runner.emit_event(sink, "map_spill_error", "level=" + std::to_string(i) + " " + st.message());
+        spill_error_reported = true;
+      }
+    }
+    std::string msg = format_map_stats(map, m, rate, scheduler.stats(), scheduler.integrator_stats());
+    if (const auto snap = occupancy.latest()) {
+      msg += " snapshot_blocks=" + std::to_string(snap->num_blocks()) +
+             " snapshot_bytes=" + std::to_string(snap->memory_bytes()) +
+             " snapshot_capture_ms=" + std::to_string(snapshot_capture_ns / 1000000);
+    }
+    return runner.emit_event(sink, "map_stats", msg);
+  };
+  // Baseline timing follows frame time from the first frame: warmup frames are not
+  // integrated, and the map is frozen (snapshotted) after warmup + capture.
+  bool have_first_frame = false;
+  wm::TimestampNs t_first_frame{};
+
+  // Frames are recycled across ticks: point lanes and frame_id keep their capacity.
+  wm::FramePool frame_pool(/*max_idle=*/2);
+  // Reused batch storage for self-paced replay (input.batch_size > 1).
+  std::vector<wm::Frame> batch(self_paced ? static_cast<std::size_t>(cfg.input.batch_size) : 0);
+
   while (true) {
     const auto now = clock::now();
 
@@ -160,28 +367,98 @@ int main(int argc, char** argv) {
         had_error = true;
         break;
       }
+      if (report_prefetch) {
+        (void)runner.emit_event(sink, "input_stats",
+                                format_prefetch_stats(frame_dir_source->prefetch_stats()));
+      }
+      (void)emit_map_stats();
+    }
+
+    // Offline replay pulls up to batch_size frames per iteration; paced sources pull one.
+    std::size_t want = 1;
+    if (self_paced) {
+      want = static_cast<std::size_t>(cfg.input.batch_size);
+      if (cfg.input.max_ticks > 0) {
+        want = std::min<std::size_t>(want, static_cast<std::size_t>(cfg.input.max_ticks - tick_count));
+      }
+    }
+
+    wm::FramePool::Lease lease;
+    std::span<wm::Frame> frames;
+    if (want == 1) {
+      lease = frame_pool.acquire();
+      frames = std::span<wm::Frame>(lease.get(), 1);
+    } else {
+      frames = std::span<wm::Frame>(batch.data(), want);
+    }
+
+    const wm::Result<std::size_t> got_r = source->next_batch(frames);
+    if (!got_r.ok()) {
+      if (got_r.status().code() == wm::Status::Code::kOutOfRange) {
+        (void)runner.emit_event(sink, "input_eof", "input source reached end");
+        (void)sink.flush();
+      } else {
+        std::cerr << got_r.status().message() << "\n";
+        had_error = true;
+      }
+      break;
     }
 
-    auto frame_r = source->next();
-    if (frame_r.ok()) {
-      wm::Frame frame = frame_r.take_value();
-      const wm::Status st = runner.emit_event(
-          sink, "frame_stats",
-          "frame_id=" + frame.frame_id + " num_points=" + std::to_string(frame.points.size()));
+    // Frames within a batch are processed strictly in source order.
+    const std::size_t got = got_r.value();
+    for (std::size_t k = 0; k < got && !had_error; ++k) {
+      wm::Frame& frame = frames[k];
+      const wm::PreprocessStats ps = preprocessor.process(frame, T_node_lidar_of(frame));
+      const auto t_process = clock::now();
+
+      const wm::RangeGateStats& gs = ps.gate;
+      std::string msg = "frame_id=" + frame.frame_id + " num_points=" + std::to_string(ps.points_in) +
+                        " kept=" + std::to_string(gs.kept) +
+                        " rej_min_range=" + std::to_string(gs.rejected_min_range) +
+                        " rej_max_range=" + std::to_string(gs.rejected_max_range) +
+                        " rej_roi=" + std::to_string(gs.rejected_roi) +
+                        " out=" + std::to_string(ps.points_out) + " level=" + std::to_string(ps.level);
+      if (!frame.sensor_id.empty()) msg += " sensor=" + frame.sensor_id;
+      wm::Status st = runner.emit_event(sink, "frame_stats", msg);
+
+      if (!have_first_frame) {
+        have_first_frame = true;
+        t_first_frame = frame.t_ns;
+      }
+      const std::int64_t since_first_ns = frame.t_ns.ns - t_first_frame.ns;
+      if (since_first_ns >= cfg.baseline.warmup_duration_ns) {
+        integrated(scheduler.push(frame.t_ns, wm::translation(T_node_lidar_of(frame)), frame.points.view()),
+                   frame.t_ns);
+        last_frame_t = frame.t_ns;
+      }
+      if (st.ok() && !baseline_frozen &&
+          since_first_ns >= cfg.baseline.warmup_duration_ns + cfg.baseline.capture_duration_ns) {
+        baseline_frozen = true;
+        integrated(scheduler.flush(), last_frame_t);
+        std::string frozen = "blocks=" + std::to_string(map.stats().blocks);
+        if (!cfg.baseline.snapshot_path.empty()) {
+          const wm::Status st_snap = save_map_snapshots(cfg, map);
+          frozen += st_snap.ok() ? " snapshot=" + cfg.baseline.snapshot_path : " snapshot_error=" + st_snap.message();
+        }
+        st = runner.emit_event(sink, "baseline_frozen", frozen);
+      }
+
+      wm::FrameCost cost;
+      cost.t_ns = frame.t_ns;
+      cost.points_in = ps.points_in;
+      cost.points_out = ps.points_out;
+      cost.preprocess_ns = ps.preprocess_ns;
+      cost.process_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t_process).count();
+      if (st.ok() && preprocessor.governor().observe(cost)) {
+        st = runner.emit_event(sink, "budget_adjusted", preprocessor.governor().last_change());
+      }
       if (!st.ok()) {
         std::cerr << st.message() << "\n";
         had_error = true;
-        break;
       }
-    } else if (frame_r.status().code() == wm::Status::Code::kOutOfRange) {
-      (void)runner.emit_event(sink, "input_eof", "input source reached end");
-      (void)sink.flush();
-      break;
-    } else {
-      std::cerr << frame_r.status().message() << "\n";
-      had_error = true;
-      break;
     }
+    if (had_error) break;
+    lease.reset();
 
     const wm::Status st_flush = sink.flush();
     if (!st_flush.ok()) {
@@ -190,7 +467,8 @@ int main(int argc, char** argv) {
       break;
     }
 
-    ++tick_count;
+    tick_count += static_cast<std::int64_t>(got);
+    if (self_paced) continue;
 
     const auto after = clock::now();
     if (after < next_tick) {
@@ -201,6 +479,10 @@ int main(int argc, char** argv) {
     }
   }
 
+  integrated(scheduler.flush(), last_frame_t);
+  (void)emit_map_stats();
+  (void)sink.flush();
+
   if (had_error) return 2;
   std::cout << "OK\n";
   return 0;
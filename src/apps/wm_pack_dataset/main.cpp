@@ -0,0 +1,175 @@
+// File: src/apps/wm_pack_dataset/main.cpp
+// Converts a frame_dir dataset (one .bin per frame) into a single packed .wmpack file,
+// and optionally into a directory of quantized .qbin frame files.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "wm/adapters/frame_dir/frame_dir_source.hpp"
+#include "wm/adapters/replay/packed_dataset.hpp"
+
+namespace {
+
+struct Args {
+  std::string frame_dir;
+  std::string out_path;
+  std::string node_id{"node_001"};
+  std::string encoding{"f32"};
+  std::string qbin_dir;
+  double fps{10.0};
+  bool help{false};
+};
+
+Args parse_args(int argc, char** argv) {
+  Args a;
+  for (int i = 1; i < argc; ++i) {
+    const std::string s = argv[i];
+    if (s == "--help" || s == "-h") {
+      a.help = true;
+      return a;
+    }
+    if (s == "--frame-dir" && i + 1 < argc) {
+      a.frame_dir = argv[++i];
+      continue;
+    }
+    if (s == "--out" && i + 1 < argc) {
+      a.out_path = argv[++i];
+      continue;
+    }
+    if (s == "--node-id" && i + 1 < argc) {
+      a.node_id = argv[++i];
+      continue;
+    }
+    if (s == "--encoding" && i + 1 < argc) {
+      a.encoding = argv[++i];
+      continue;
+    }
+    if (s == "--qbin-dir" && i + 1 < argc) {
+      a.qbin_dir = argv[++i];
+      continue;
+    }
+    if (s == "--fps" && i + 1 < argc) {
+      const char* v = argv[++i];
+      char* end = nullptr;
+      a.fps = std::strtod(v, &end);
+      // Not a whole finite number: rejected with the usage like fps <= 0.
+      if (end == v || *end != '\0' || !std::isfinite(a.fps)) a.fps = 0.0;
+      continue;
+    }
+    a.help = true;
+    return a;
+  }
+  return a;
+}
+
+void print_usage() {
+  std::cout << "wm_pack_dataset\n"
+            << "  --frame-dir <dir>   input directory of .bin frames (lexicographic order)\n"
+            << "  --out <path>        output .wmpack file\n"
+            << "  [--node-id <id>]    node id stored in the dataset (default node_001)\n"
+            << "  [--fps <hz>]        frame rate used to synthesise timestamps (default 10)\n"
+            << "  [--encoding <e>]    f32 (16 B/point, default) | q16 (7 B/point)\n"
+            << "  [--qbin-dir <dir>]  also write each frame as a quantized .qbin file here\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Args args = parse_args(argc, argv);
+  if (args.help || args.frame_dir.empty() || args.out_path.empty() || args.fps <= 0.0 ||
+      (args.encoding != "f32" && args.encoding != "q16")) {
+    print_usage();
+    return args.help ? 0 : 2;
+  }
+
+  const auto t0 = std::chrono::steady_clock::now();
+
+  wm::FrameDirSourceConfig dc;
+  dc.path = args.frame_dir;
+  dc.fps = args.fps;
+  dc.read_mode = wm::FrameDirReadMode::kMmap;
+  wm::FrameDirSource source(dc);
+
+  wm::Status st = source.open();
+  if (!st.ok()) {
+    std::cerr << st.message() << "\n";
+    return 1;
+  }
+
+  wm::PackedDatasetWriter writer;
+  const wm::PackedEncoding encoding =
+      args.encoding == "q16" ? wm::PackedEncoding::kQuant16 : wm::PackedEncoding::kFloat32Soa;
+  // Pack into a temp file and only rename it into place once it has been finished and verified,
+  // so a failed run never leaves a truncated dataset at the output path.
+  const std::string tmp_path = args.out_path + ".tmp";
+  st = writer.open(tmp_path, args.node_id, encoding);
+  if (!st.ok()) {
+    std::cerr << st.message() << "\n";
+    return 1;
+  }
+
+  if (!args.qbin_dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(args.qbin_dir, ec);
+    if (ec) {
+      std::cerr << "failed creating " << args.qbin_dir << ": " << ec.message() << "\n";
+      return 1;
+    }
+  }
+
+  wm::Frame frame;
+  std::uint64_t total_points = 0;
+  while (true) {
+    st = source.next_into(frame);
+    if (st.code() == wm::Status::Code::kOutOfRange) break;
+    if (st.ok()) st = writer.append(frame, frame.seq);
+    if (st.ok() && !args.qbin_dir.empty()) {
+      std::filesystem::path stem = std::filesystem::path(frame.frame_id).stem();
+      st = wm::write_quantized_frame_file(
+          (std::filesystem::path(args.qbin_dir) / stem).string() + ".qbin", frame.points.view());
+    }
+    if (!st.ok()) {
+      std::cerr << st.message() << "\n";
+      return 1;
+    }
+    total_points += frame.points.size();
+  }
+
+  st = writer.finish();
+  if (!st.ok()) {
+    std::cerr << st.message() << "\n";
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);
+    return 1;
+  }
+
+  // Re-open and run the full integrity check on what we just wrote.
+  wm::PackedDatasetReader reader;
+  st = reader.open(tmp_path);
+  if (st.ok()) st = reader.verify();
+  const std::size_t num_frames = reader.num_frames();
+  reader.close();
+  if (!st.ok()) {
+    std::cerr << "verification failed: " << st.message() << "\n";
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);
+    return 1;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, args.out_path, ec);
+  if (ec) {
+    std::cerr << "failed renaming " << tmp_path << ": " << ec.message() << "\n";
+    std::filesystem::remove(tmp_path, ec);
+    return 1;
+  }
+
+  const double dt_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  std::cout << "Packed " << num_frames << " frames (" << total_points << " points) into "
+            << args.out_path << " in " << dt_s << " s\n";
+  return 0;
+}
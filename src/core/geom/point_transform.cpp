@@ -0,0 +1,145 @@
+// File: src/core/geom/point_transform.cpp
+#include "wm/core/geom/point_transform.hpp"
+
+#include <cstring>
+
+#if WM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace wm {
+namespace {
+
+// Source and destination lanes for one batch. dst may alias src (in place): every kernel
+// loads a full vector of x/y/z before storing any of it.
+struct Lanes {
+  const float* x;
+  const float* y;
+  const float* z;
+  float* ox;
+  float* oy;
+  float* oz;
+  std::size_t n;
+};
+
+void transform_scalar(const TransformSE3& T, const Lanes& l, std::size_t begin) noexcept {
+  const auto& m = T.m;
+  for (std::size_t i = begin; i < l.n; ++i) {
+    const float x = l.x[i];
+    const float y = l.y[i];
+    const float z = l.z[i];
+    l.ox[i] = ((m[0] * x + m[1] * y) + m[2] * z) + m[3];
+    l.oy[i] = ((m[4] * x + m[5] * y) + m[6] * z) + m[7];
+    l.oz[i] = ((m[8] * x + m[9] * y) + m[10] * z) + m[11];
+  }
+}
+
+#if WM_SIMD_X86
+std::size_t transform_sse2(const TransformSE3& T, const Lanes& l) noexcept {
+  const auto& m = T.m;
+  __m128 r[12];
+  for (int k = 0; k < 12; ++k) r[k] = _mm_set1_ps(m[k]);
+
+  std::size_t i = 0;
+  for (; i + 4 <= l.n; i += 4) {
+    const __m128 x = _mm_loadu_ps(l.x + i);
+    const __m128 y = _mm_loadu_ps(l.y + i);
+    const __m128 z = _mm_loadu_ps(l.z + i);
+    const __m128 tx = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_mul_ps(r[2], z)), r[3]);
+    const __m128 ty = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[4], x), _mm_mul_ps(r[5], y)), _mm_mul_ps(r[6], z)), r[7]);
+    const __m128 tz = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[8], x), _mm_mul_ps(r[9], y)), _mm_mul_ps(r[10], z)), r[11]);
+    _mm_storeu_ps(l.ox + i, tx);
+    _mm_storeu_ps(l.oy + i, ty);
+    _mm_storeu_ps(l.oz + i, tz);
+  }
+  return i;
+}
+
+WM_TARGET_AVX2 inline __m256 affine_row_avx2(__m256 a, __m256 b, __m256 c, __m256 d, __m256 x,
+                                             __m256 y, __m256 z) noexcept {
+  return _mm256_add_ps(
+      _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(b, y)), _mm256_mul_ps(c, z)), d);
+}
+
+WM_TARGET_AVX2
+std::size_t transform_avx2(const TransformSE3& T, const Lanes& l) noexcept {
+  const auto& m = T.m;
+  __m256 r[12];
+  for (int k = 0; k < 12; ++k) r[k] = _mm256_set1_ps(m[k]);
+
+  // Unaligned loads/stores: views may start anywhere, and on aligned PointBuffer lanes they
+  // cost the same as the aligned forms.
+  std::size_t i = 0;
+  for (; i + 8 <= l.n; i += 8) {
+    const __m256 x = _mm256_loadu_ps(l.x + i);
+    const __m256 y = _mm256_loadu_ps(l.y + i);
+    const __m256 z = _mm256_loadu_ps(l.z + i);
+    _mm256_storeu_ps(l.ox + i, affine_row_avx2(r[0], r[1], r[2], r[3], x, y, z));
+    _mm256_storeu_ps(l.oy + i, affine_row_avx2(r[4], r[5], r[6], r[7], x, y, z));
+    _mm256_storeu_ps(l.oz + i, affine_row_avx2(r[8], r[9], r[10], r[11], x, y, z));
+  }
+  return i;
+}
+#endif
+
+void transform_lanes(const TransformSE3& T, const Lanes& l, SimdLevel level) noexcept {
+  std::size_t done = 0;
+#if WM_SIMD_X86
+  switch (clamp_simd_level(level)) {
+    case SimdLevel::kAvx2: done = transform_avx2(T, l); break;
+    case SimdLevel::kSse2: done = transform_sse2(T, l); break;
+    case SimdLevel::kScalar: break;
+  }
+#else
+  (void)level;
+#endif
+  transform_scalar(T, l, done);
+}
+
+}  // namespace
+
+TransformSE3 compose(const TransformSE3& a, const TransformSE3& b) noexcept {
+  TransformSE3 out;
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      float s = 0.0f;
+      for (int k = 0; k < 4; ++k) s += a.m[r * 4 + k] * b.m[k * 4 + c];
+      out.m[r * 4 + c] = s;
+    }
+  }
+  return out;
+}
+
+void transform_points(const TransformSE3& T, ConstPointView in, PointBuffer& out, SimdLevel level) {
+  // Clearing `out` would release the storage (or the borrowed frame) `in` reads from.
+  if (views_whole_buffer(in, out)) {
+    transform_points(T, out, level);
+    return;
+  }
+
+  if (!in.contiguous()) {
+    out.clear();
+    out.append(in);
+    transform_points(T, out.mutable_view(), level);
+    return;
+  }
+
+  out.clear();
+  out.resize(in.size);
+  const PointView v = out.mutable_view();
+  transform_lanes(T, Lanes{in.x, in.y, in.z, v.x, v.y, v.z, in.size}, level);
+  if (in.size > 0) std::memcpy(v.intensity, in.intensity, in.size * sizeof(float));
+}
+
+void transform_points(const TransformSE3& T, PointBuffer& pts, SimdLevel level) {
+  transform_points(T, pts.mutable_view(), level);
+}
+
+void transform_points(const TransformSE3& T, PointView pts, SimdLevel level) noexcept {
+  transform_lanes(T, Lanes{pts.x, pts.y, pts.z, pts.x, pts.y, pts.z, pts.size}, level);
+}
+
+}  // namespace wm
@@ -0,0 +1,54 @@
+// File: src/core/io/frame_pool.cpp
+#include "wm/core/io/frame_pool.hpp"
+
+#include <utility>
+
+namespace wm {
+
+FramePool::FramePool(std::size_t max_idle, std::size_t reserve_points)
+    : max_idle_(max_idle), reserve_points_(reserve_points) {
+  idle_.reserve(max_idle_);
+}
+
+FramePool::Lease FramePool::acquire() {
+  std::unique_ptr<Frame> frame;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    ++stats_.acquires;
+    if (!idle_.empty()) {
+      frame = std::move(idle_.back());
+      idle_.pop_back();
+      ++stats_.reuses;
+    } else {
+      ++stats_.frames_allocated;
+    }
+    stats_.idle = idle_.size();
+  }
+
+  if (!frame) {
+    frame = std::make_unique<Frame>();
+    if (reserve_points_ > 0) frame->points.reserve(reserve_points_);
+  }
+  return Lease(this, std::move(frame));
+}
+
+void FramePool::give_back(std::unique_ptr<Frame> frame) {
+  // Drop borrowed storage (e.g. a file mapping) now rather than when the frame is reused.
+  frame->points.clear();
+  frame->frame_id.clear();
+  frame->t_ns = TimestampNs{0};
+  frame->seq = 0;
+  frame->sensor_index = 0;
+  frame->sensor_id.clear();
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (idle_.size() < max_idle_) idle_.push_back(std::move(frame));
+  stats_.idle = idle_.size();
+}
+
+FramePoolStats FramePool::stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return stats_;
+}
+
+}  // namespace wm
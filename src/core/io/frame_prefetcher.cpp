@@ -0,0 +1,151 @@
+// File: src/core/io/frame_prefetcher.cpp
+#include "wm/core/io/frame_prefetcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace wm {
+namespace {
+
+std::int64_t elapsed_ns(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+}  // namespace
+
+FramePrefetcher::FramePrefetcher(FramePrefetcherConfig cfg, std::size_t num_items, LoadFn load)
+    : cfg_(cfg), num_items_(num_items), load_(std::move(load)) {
+  cfg_.depth = std::max<std::size_t>(cfg_.depth, 1);
+  cfg_.io_threads = std::max(cfg_.io_threads, 1);
+}
+
+void FramePrefetcher::start() {
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    slots_.clear();
+    slots_.resize(cfg_.depth);
+    next_to_load_ = 0;
+    next_to_consume_ = 0;
+    stopping_ = false;
+    stats_ = FramePrefetchStats{};
+  }
+  workers_.reserve(static_cast<std::size_t>(cfg_.io_threads));
+  for (int i = 0; i < cfg_.io_threads; ++i) {
+    workers_.emplace_back([this] { worker_loop(); });
+  }
+}
+
+void FramePrefetcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  cv_space_.notify_all();
+  cv_ready_.notify_all();
+  for (auto& t : workers_) {
+    if (t.joinable()) t.join();
+  }
+  workers_.clear();
+}
+
+void FramePrefetcher::worker_loop() {
+  while (true) {
+    std::uint64_t seq = 0;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_space_.wait(lock, [&] {
+        if (stopping_) return true;
+        if (!cfg_.loop && next_to_load_ >= num_items_) return false;
+        return next_to_load_ < next_to_consume_ + cfg_.depth;
+      });
+      if (stopping_) return;
+      seq = next_to_load_++;
+    }
+
+    // The claimed slot is not ready, so nobody else touches it until we publish it below.
+    Slot& slot = slots_[seq % cfg_.depth];
+    const auto t0 = std::chrono::steady_clock::now();
+    Status st = load_(static_cast<std::size_t>(seq % num_items_), slot.frame);
+    const std::int64_t dt = elapsed_ns(t0);
+
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      slot.status = std::move(st);
+      slot.ready = true;
+      ++stats_.frames_loaded;
+      stats_.load_ns += dt;
+      ++stats_.queue_depth;
+      stats_.max_queue_depth = std::max(stats_.max_queue_depth, stats_.queue_depth);
+    }
+    cv_ready_.notify_all();
+  }
+}
+
+Status FramePrefetcher::next_into(Frame& out, std::size_t* index_out) {
+  std::unique_lock<std::mutex> lock(mu_);
+  if (num_items_ == 0 || (!cfg_.loop && next_to_consume_ >= num_items_)) {
+    return Status::out_of_range("eof");
+  }
+
+  const std::uint64_t seq = next_to_consume_;
+  Slot& slot = slots_[seq % cfg_.depth];
+  if (!slot.ready) {
+    const auto t0 = std::chrono::steady_clock::now();
+    cv_ready_.wait(lock, [&] { return stopping_ || slot.ready; });
+    stats_.io_wait_ns += elapsed_ns(t0);
+    ++stats_.io_waits;
+    if (!slot.ready) return Status::internal("FramePrefetcher: stopped");
+  }
+
+  Status st = std::move(slot.status);
+  if (st.ok()) std::swap(out, slot.frame);
+  slot.ready = false;
+  --stats_.queue_depth;
+  ++next_to_consume_;
+  if (index_out != nullptr) *index_out = static_cast<std::size_t>(seq % num_items_);
+
+  lock.unlock();
+  cv_space_.notify_one();
+  return st;
+}
+
+Result<Frame> FramePrefetcher::next(std::size_t* index_out) {
+  Frame out;
+  Status st = next_into(out, index_out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Result<std::size_t> FramePrefetcher::next_batch(std::span<Frame> out) {
+  using R = Result<std::size_t>;
+  if (out.empty()) return R::ok(0);
+  Status st = next_into(out[0]);
+  if (!st.ok()) return R::err(std::move(st));
+
+  std::size_t n = 1;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (; n < out.size(); ++n) {
+      if (!cfg_.loop && next_to_consume_ >= num_items_) break;
+      Slot& slot = slots_[next_to_consume_ % cfg_.depth];
+      // Errors stay queued so the next call reports them in order.
+      if (!slot.ready || !slot.status.ok()) break;
+      std::swap(out[n], slot.frame);
+      slot.ready = false;
+      --stats_.queue_depth;
+      ++next_to_consume_;
+    }
+  }
+  if (n > 1) cv_space_.notify_all();
+  return R::ok(n);
+}
+
+FramePrefetchStats FramePrefetcher::stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return stats_;
+}
+
+}  // namespace wm
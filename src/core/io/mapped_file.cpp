@@ -0,0 +1,83 @@
+// File: src/core/io/mapped_file.cpp
+#include "wm/core/io/mapped_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wm {
+
+Result<std::shared_ptr<const MappedFile>> MappedFile::open(const std::string& path, Access access) {
+  auto r = map(path, access, /*writable=*/false);
+  if (!r.ok()) return Result<std::shared_ptr<const MappedFile>>::err(r.status());
+  return Result<std::shared_ptr<const MappedFile>>::ok(r.take_value());
+}
+
+Result<std::shared_ptr<MappedFile>> MappedFile::open_copy_on_write(const std::string& path, Access access) {
+  return map(path, access, /*writable=*/true);
+}
+
+Result<std::shared_ptr<MappedFile>> MappedFile::map(const std::string& path, Access access, bool writable) {
+  using R = Result<std::shared_ptr<MappedFile>>;
+
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) return R::err(Status::not_found("MappedFile: not found: " + path));
+    return R::err(Status::io_error("MappedFile: failed to open " + path + ": " + std::strerror(errno)));
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const int e = errno;
+    ::close(fd);
+    return R::err(Status::io_error("MappedFile: fstat failed for " + path + ": " + std::strerror(e)));
+  }
+
+  std::shared_ptr<MappedFile> mf(new MappedFile());
+  mf->path_ = path;
+  mf->size_ = static_cast<std::size_t>(st.st_size);
+
+  if (mf->size_ > 0) {
+    void* p = ::mmap(nullptr, mf->size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      const int e = errno;
+      ::close(fd);
+      return R::err(Status::io_error("MappedFile: mmap failed for " + path + ": " + std::strerror(e)));
+    }
+    // Advisory only; failure is harmless.
+    if (access == Access::kSequential) {
+      (void)::madvise(p, mf->size_, MADV_SEQUENTIAL);
+      (void)::madvise(p, mf->size_, MADV_WILLNEED);
+    } else {
+      (void)::madvise(p, mf->size_, MADV_RANDOM);
+    }
+    mf->data_ = static_cast<const std::byte*>(p);
+    mf->writable_ = writable;
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  return R::ok(std::move(mf));
+}
+
+void MappedFile::advise_willneed(std::size_t offset, std::size_t len) const noexcept {
+  if (data_ == nullptr || offset >= size_) return;
+  len = std::min(len, size_ - offset);
+  // madvise wants a page-aligned start; the mapping itself is page aligned.
+  static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const std::size_t start = offset - offset % page;
+  (void)::madvise(const_cast<std::byte*>(data_) + start, len + (offset - start), MADV_WILLNEED);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<std::byte*>(data_), size_);
+  }
+}
+
+}  // namespace wm
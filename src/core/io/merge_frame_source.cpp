@@ -0,0 +1,176 @@
+// File: src/core/io/merge_frame_source.cpp
+#include "wm/core/io/merge_frame_source.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace wm {
+namespace {
+
+// std::push_heap/pop_heap build a max-heap, so "less" means "later".
+struct LaterFirst {
+  template <typename T>
+  bool operator()(const T& a, const T& b) const noexcept {
+    if (a.t_ns != b.t_ns) return a.t_ns > b.t_ns;
+    return a.lane > b.lane;
+  }
+};
+
+}  // namespace
+
+MergeFrameSource::MergeFrameSource(std::vector<MergeSensor> sensors, MergeFrameSourceConfig cfg)
+    : cfg_(cfg) {
+  cfg_.queue_depth = std::max<std::size_t>(cfg_.queue_depth, 1);
+  lanes_.reserve(sensors.size());
+  for (auto& s : sensors) {
+    auto lane = std::make_unique<Lane>();
+    lane->sensor = std::move(s);
+    lanes_.push_back(std::move(lane));
+  }
+}
+
+Status MergeFrameSource::open() {
+  close();
+  if (lanes_.empty()) return Status::invalid_argument("MergeFrameSource: no sensors");
+  for (const auto& lane : lanes_) {
+    if (!lane->sensor.source) {
+      return Status::invalid_argument("MergeFrameSource: sensor has no source: " + lane->sensor.sensor_id);
+    }
+  }
+
+  for (std::size_t i = 0; i < lanes_.size(); ++i) {
+    const Status st = lanes_[i]->sensor.source->open();
+    if (!st.ok()) {
+      for (std::size_t j = 0; j < i; ++j) lanes_[j]->sensor.source->close();
+      return Status(st.code(), "MergeFrameSource: sensor " + lanes_[i]->sensor.sensor_id + ": " + st.message());
+    }
+  }
+
+  stopping_ = false;
+  heap_.clear();
+  heap_.reserve(lanes_.size());
+  emitted_ = 0;
+  for (auto& lane : lanes_) {
+    lane->ready.clear();
+    lane->end_status = Status::ok_status();
+    lane->finished = false;
+    lane->in_heap = false;
+    lane->exhausted = false;
+    Lane* l = lane.get();
+    lane->worker = std::thread([this, l] { worker_loop(*l); });
+  }
+  opened_ = true;
+  return Status::ok_status();
+}
+
+void MergeFrameSource::worker_loop(Lane& lane) {
+  while (true) {
+    Frame frame;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_space_.wait(lock, [&] { return stopping_ || lane.ready.size() < cfg_.queue_depth; });
+      if (stopping_) return;
+      if (!lane.spare.empty()) {
+        frame = std::move(lane.spare.back());
+        lane.spare.pop_back();
+      }
+    }
+
+    // Child sources are only ever touched by their own worker once open.
+    Status st = lane.sensor.source->next_into(frame);
+
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (st.ok()) {
+        lane.ready.push_back(std::move(frame));
+      } else {
+        lane.end_status = std::move(st);
+        lane.finished = true;
+      }
+    }
+    cv_ready_.notify_all();
+    if (lane.finished) return;  // only this thread sets it
+  }
+}
+
+Result<Frame> MergeFrameSource::next() {
+  Frame out;
+  Status st = next_into(out);
+  if (!st.ok()) return Result<Frame>::err(std::move(st));
+  return Result<Frame>::ok(std::move(out));
+}
+
+Status MergeFrameSource::next_into(Frame& out) {
+  if (!opened_) return Status::invalid_argument("MergeFrameSource::next: not opened");
+
+  std::unique_lock<std::mutex> lock(mu_);
+
+  // Every live child must have a head frame before the earliest one can be chosen.
+  for (std::uint32_t i = 0; i < lanes_.size(); ++i) {
+    Lane& lane = *lanes_[i];
+    if (lane.in_heap || lane.exhausted) continue;
+    cv_ready_.wait(lock, [&] { return stopping_ || !lane.ready.empty() || lane.finished; });
+    if (!lane.ready.empty()) {
+      std::swap(lane.head, lane.ready.front());
+      lane.spare.push_back(std::move(lane.ready.front()));
+      lane.ready.pop_front();
+      lane.in_heap = true;
+      heap_.push_back(HeapItem{lane.head.t_ns.ns, i});
+      std::push_heap(heap_.begin(), heap_.end(), LaterFirst{});
+    } else if (lane.finished) {
+      lane.exhausted = true;
+      if (lane.end_status.code() != Status::Code::kOutOfRange) {
+        return Status(lane.end_status.code(),
+                      "MergeFrameSource: sensor " + lane.sensor.sensor_id + ": " + lane.end_status.message());
+      }
+    } else {
+      return Status::internal("MergeFrameSource: stopped");
+    }
+  }
+  cv_space_.notify_all();
+
+  if (heap_.empty()) return Status::out_of_range("eof");
+
+  std::pop_heap(heap_.begin(), heap_.end(), LaterFirst{});
+  const std::uint32_t idx = heap_.back().lane;
+  heap_.pop_back();
+
+  Lane& lane = *lanes_[idx];
+  std::swap(out, lane.head);
+  lane.in_heap = false;
+  lock.unlock();
+
+  out.sensor_index = idx;
+  out.sensor_id.assign(lane.sensor.sensor_id);
+  out.seq = emitted_++;
+  return Status::ok_status();
+}
+
+void MergeFrameSource::stop_workers() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  cv_space_.notify_all();
+  cv_ready_.notify_all();
+  for (auto& lane : lanes_) {
+    if (lane->worker.joinable()) lane->worker.join();
+  }
+}
+
+void MergeFrameSource::close() {
+  // Workers call into the children, so they must stop before the children close.
+  stop_workers();
+  if (opened_) {
+    for (auto& lane : lanes_) lane->sensor.source->close();
+  }
+  for (auto& lane : lanes_) {
+    lane->ready.clear();
+    lane->in_heap = false;
+    lane->exhausted = false;
+  }
+  heap_.clear();
+  opened_ = false;
+}
+
+}  // namespace wm
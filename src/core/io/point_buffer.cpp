@@ -0,0 +1,230 @@
+// File: src/core/io/point_buffer.cpp
+#include "wm/core/io/point_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace wm {
+namespace {
+
+std::size_t round_up_to_line(std::size_t n) {
+  return (n + kPointLaneFloatsPerLine - 1) / kPointLaneFloatsPerLine * kPointLaneFloatsPerLine;
+}
+
+// Amortised growth; first allocation is at least one cache line per lane.
+std::size_t grown_capacity(std::size_t have, std::size_t need) {
+  std::size_t cap = std::max<std::size_t>(have, kPointLaneFloatsPerLine);
+  while (cap < need) cap += cap / 2 + kPointLaneFloatsPerLine;
+  return round_up_to_line(cap);
+}
+
+void copy_strided(float* dst, const float* src, std::size_t n, std::size_t stride) {
+  if (stride == 1) {
+    std::memcpy(dst, src, n * sizeof(float));
+    return;
+  }
+  for (std::size_t i = 0; i < n; ++i) dst[i] = src[i * stride];
+}
+
+}  // namespace
+
+// -----------------------------
+// AlignedFloatLane
+// -----------------------------
+
+void AlignedFloatLane::Deleter::operator()(float* p) const noexcept {
+  ::operator delete[](p, std::align_val_t{kPointLaneAlignment});
+}
+
+void AlignedFloatLane::reserve(std::size_t n, std::size_t keep) {
+  if (n <= capacity_) return;
+  const std::size_t cap = round_up_to_line(n);
+  auto* raw = static_cast<float*>(
+      ::operator new[](cap * sizeof(float), std::align_val_t{kPointLaneAlignment}));
+  std::unique_ptr<float[], Deleter> next(raw);
+  if (keep > 0 && data_) std::memcpy(next.get(), data_.get(), std::min(keep, capacity_) * sizeof(float));
+  data_ = std::move(next);
+  capacity_ = cap;
+}
+
+void AlignedFloatLane::assign(const AlignedFloatLane& other, std::size_t n) {
+  reserve(n, 0);
+  if (n > 0) std::memcpy(data_.get(), other.data_.get(), n * sizeof(float));
+}
+
+// -----------------------------
+// PointBuffer
+// -----------------------------
+
+PointBuffer::PointBuffer(const PointBuffer& other) { *this = other; }
+
+PointBuffer& PointBuffer::operator=(const PointBuffer& other) {
+  if (this == &other) return *this;
+
+  size_ = other.size_;
+  borrowed_ = other.borrowed_;
+  keepalive_ = other.keepalive_;
+
+  if (!other.is_borrowed()) {
+    x_.assign(other.x_, size_);
+    y_.assign(other.y_, size_);
+    z_.assign(other.z_, size_);
+    i_.assign(other.i_, size_);
+  }
+
+  // Reuse lanes for fields that already exist under the same name.
+  std::vector<NamedLane> fields;
+  fields.reserve(other.fields_.size());
+  for (const auto& f : other.fields_) {
+    NamedLane lane;
+    lane.name = f.name;
+    for (auto& mine : fields_) {
+      if (mine.name == f.name) {
+        lane.data = std::move(mine.data);
+        break;
+      }
+    }
+    lane.data.assign(f.data, size_);
+    fields.push_back(std::move(lane));
+  }
+  fields_ = std::move(fields);
+  return *this;
+}
+
+PointBuffer::PointBuffer(PointBuffer&& other) noexcept { *this = std::move(other); }
+
+PointBuffer& PointBuffer::operator=(PointBuffer&& other) noexcept {
+  if (this == &other) return *this;
+  x_ = std::move(other.x_);
+  y_ = std::move(other.y_);
+  z_ = std::move(other.z_);
+  i_ = std::move(other.i_);
+  fields_ = std::move(other.fields_);
+  size_ = std::exchange(other.size_, 0);
+  borrowed_ = std::exchange(other.borrowed_, ConstPointView{});
+  keepalive_ = std::move(other.keepalive_);
+  other.fields_.clear();
+  return *this;
+}
+
+void PointBuffer::grow_to(std::size_t n) {
+  if (n <= x_.capacity()) return;
+  const std::size_t cap = grown_capacity(x_.capacity(), n);
+  x_.reserve(cap, size_);
+  y_.reserve(cap, size_);
+  z_.reserve(cap, size_);
+  i_.reserve(cap, size_);
+  for (auto& f : fields_) f.data.reserve(cap, size_);
+}
+
+void PointBuffer::reserve(std::size_t n) {
+  materialize();
+  grow_to(n);
+}
+
+void PointBuffer::resize(std::size_t n) {
+  materialize();
+  grow_to(n);
+  size_ = n;
+}
+
+void PointBuffer::clear() noexcept {
+  size_ = 0;
+  borrowed_ = ConstPointView{};
+  keepalive_.reset();
+}
+
+void PointBuffer::truncate(std::size_t n) noexcept {
+  if (n >= size_) return;
+  size_ = n;
+  if (is_borrowed()) borrowed_.size = n;
+}
+
+void PointBuffer::push_back(float x, float y, float z, float intensity) {
+  materialize();
+  grow_to(size_ + 1);
+  x_.data()[size_] = x;
+  y_.data()[size_] = y;
+  z_.data()[size_] = z;
+  i_.data()[size_] = intensity;
+  for (auto& f : fields_) f.data.data()[size_] = 0.0f;
+  ++size_;
+}
+
+void PointBuffer::append(ConstPointView src) {
+  if (src.empty()) return;
+  materialize();
+  grow_to(size_ + src.size);
+  copy_strided(x_.data() + size_, src.x, src.size, src.stride);
+  copy_strided(y_.data() + size_, src.y, src.size, src.stride);
+  copy_strided(z_.data() + size_, src.z, src.size, src.stride);
+  copy_strided(i_.data() + size_, src.intensity, src.size, src.stride);
+  for (auto& f : fields_) std::fill_n(f.data.data() + size_, src.size, 0.0f);
+  size_ += src.size;
+}
+
+ConstPointView PointBuffer::view() const noexcept {
+  if (is_borrowed()) return borrowed_;
+  return ConstPointView{x_.data(), y_.data(), z_.data(), i_.data(), size_, 1};
+}
+
+PointView PointBuffer::mutable_view() {
+  materialize();
+  return PointView{x_.data(), y_.data(), z_.data(), i_.data(), size_};
+}
+
+float* PointBuffer::add_field(const std::string& name) {
+  if (float* existing = field(name)) return existing;
+  materialize();
+  NamedLane lane;
+  lane.name = name;
+  lane.data.reserve(std::max(x_.capacity(), kPointLaneFloatsPerLine), 0);
+  std::fill_n(lane.data.data(), size_, 0.0f);
+  fields_.push_back(std::move(lane));
+  return fields_.back().data.data();
+}
+
+float* PointBuffer::field(const std::string& name) noexcept {
+  for (auto& f : fields_) {
+    if (f.name == name) return f.data.data();
+  }
+  return nullptr;
+}
+
+const float* PointBuffer::field(const std::string& name) const noexcept {
+  for (const auto& f : fields_) {
+    if (f.name == name) return f.data.data();
+  }
+  return nullptr;
+}
+
+void PointBuffer::borrow(ConstPointView v, std::shared_ptr<const void> keepalive) {
+  fields_.clear();
+  if (v.empty()) {
+    clear();
+    return;
+  }
+  borrowed_ = v;
+  keepalive_ = std::move(keepalive);
+  size_ = v.size;
+}
+
+void PointBuffer::materialize() {
+  if (!is_borrowed()) return;
+
+  const ConstPointView src = borrowed_;
+  const std::shared_ptr<const void> hold = std::move(keepalive_);
+  borrowed_ = ConstPointView{};
+  size_ = 0;
+
+  grow_to(src.size);
+  copy_strided(x_.data(), src.x, src.size, src.stride);
+  copy_strided(y_.data(), src.y, src.size, src.stride);
+  copy_strided(z_.data(), src.z, src.size, src.stride);
+  copy_strided(i_.data(), src.intensity, src.size, src.stride);
+  size_ = src.size;
+}
+
+}  // namespace wm
@@ -0,0 +1,138 @@
+// File: src/core/io/quantized_points.cpp
+#include "wm/core/io/quantized_points.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "wm/core/util/simd.hpp"
+
+#if WM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace wm {
+namespace {
+
+constexpr float kQMax = 32767.0f;
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+inline float dequantize_axis(std::int16_t q, float scale, float offset) noexcept {
+  return q == kQuantizedNaN ? kNaN : static_cast<float>(q) * scale + offset;
+}
+
+// Scalar reference kernel. Separate multiply and add (no fma) so it matches the AVX2 kernel
+// bit for bit.
+void dequantize_scalar(const QuantizedPointsView& in, std::size_t begin, float* x, float* y, float* z,
+                       float* intensity) noexcept {
+  const QuantizationParams& p = in.params;
+  for (std::size_t i = begin; i < in.size; ++i) {
+    x[i] = dequantize_axis(in.x[i], p.scale[0], p.offset[0]);
+    y[i] = dequantize_axis(in.y[i], p.scale[1], p.offset[1]);
+    z[i] = dequantize_axis(in.z[i], p.scale[2], p.offset[2]);
+    intensity[i] = static_cast<float>(in.intensity[i]) * p.intensity_scale;
+  }
+}
+
+#if WM_SIMD_X86
+// q * scale + offset for 8 int16 codes, NaN where the code is kQuantizedNaN.
+WM_TARGET_AVX2 inline __m256 dequantize_axis8(const std::int16_t* src, __m256 scale, __m256 offset) noexcept {
+  const __m256i q = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+  const __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(q), scale), offset);
+  const __m256i nan_codes = _mm256_cmpeq_epi32(q, _mm256_set1_epi32(kQuantizedNaN));
+  return _mm256_blendv_ps(v, _mm256_set1_ps(kNaN), _mm256_castsi256_ps(nan_codes));
+}
+
+WM_TARGET_AVX2
+std::size_t dequantize_avx2(const QuantizedPointsView& in, float* x, float* y, float* z,
+                            float* intensity) noexcept {
+  const QuantizationParams& p = in.params;
+  const __m256 sx = _mm256_set1_ps(p.scale[0]);
+  const __m256 sy = _mm256_set1_ps(p.scale[1]);
+  const __m256 sz = _mm256_set1_ps(p.scale[2]);
+  const __m256 ox = _mm256_set1_ps(p.offset[0]);
+  const __m256 oy = _mm256_set1_ps(p.offset[1]);
+  const __m256 oz = _mm256_set1_ps(p.offset[2]);
+  const __m256 si = _mm256_set1_ps(p.intensity_scale);
+
+  // Output lanes are 64-byte aligned (PointBuffer), so stores can be aligned.
+  std::size_t i = 0;
+  for (; i + 8 <= in.size; i += 8) {
+    _mm256_store_ps(x + i, dequantize_axis8(in.x + i, sx, ox));
+    _mm256_store_ps(y + i, dequantize_axis8(in.y + i, sy, oy));
+    _mm256_store_ps(z + i, dequantize_axis8(in.z + i, sz, oz));
+    const __m128i qi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in.intensity + i));
+    _mm256_store_ps(intensity + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(qi)), si));
+  }
+  return i;
+}
+#endif
+
+}  // namespace
+
+QuantizationParams choose_quantization(ConstPointView pts) noexcept {
+  QuantizationParams p;
+  if (pts.empty()) return p;
+
+  float lo[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                 std::numeric_limits<float>::max()};
+  float hi[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                 std::numeric_limits<float>::lowest()};
+  float max_i = 0.0f;
+  // Non-finite values are left out (they are stored as sentinels, see quantize_points).
+  const auto extend = [](float v, float& l, float& h) {
+    if (!std::isfinite(v)) return;
+    l = std::min(l, v);
+    h = std::max(h, v);
+  };
+  for (std::size_t i = 0; i < pts.size; ++i) {
+    const PointXYZI q = pts.at(i);
+    extend(q.x, lo[0], hi[0]);
+    extend(q.y, lo[1], hi[1]);
+    extend(q.z, lo[2], hi[2]);
+    if (std::isfinite(q.intensity)) max_i = std::max(max_i, q.intensity);
+  }
+
+  for (int a = 0; a < 3; ++a) {
+    if (lo[a] > hi[a]) lo[a] = hi[a] = 0.0f;  // no finite value on this axis
+    // Halve before combining so extents near FLT_MAX do not overflow to inf.
+    p.offset[a] = 0.5f * lo[a] + 0.5f * hi[a];
+    // Floor the step at 1e-6 m so degenerate (flat) axes still round-trip.
+    p.scale[a] = std::max((0.5f * hi[a] - 0.5f * lo[a]) / kQMax, 1e-6f);
+  }
+  p.intensity_scale = max_i > 0.0f ? max_i / 255.0f : 1.0f / 255.0f;
+  return p;
+}
+
+void quantize_points(ConstPointView pts, const QuantizationParams& p, std::int16_t* x,
+                     std::int16_t* y, std::int16_t* z, std::uint8_t* intensity) noexcept {
+  // Non-finite inputs (and a NaN from bad params) are mapped before the int casts, which
+  // would be undefined for them; the clamp handles finite values out of range.
+  const auto q16 = [](float v, float offset, float scale) {
+    const float q = std::nearbyint((v - offset) / scale);
+    if (!std::isfinite(v) || std::isnan(q)) return kQuantizedNaN;
+    return static_cast<std::int16_t>(std::clamp(q, -kQMax, kQMax));
+  };
+  for (std::size_t i = 0; i < pts.size; ++i) {
+    const PointXYZI v = pts.at(i);
+    x[i] = q16(v.x, p.offset[0], p.scale[0]);
+    y[i] = q16(v.y, p.offset[1], p.scale[1]);
+    z[i] = q16(v.z, p.offset[2], p.scale[2]);
+    const float qi = std::nearbyint(v.intensity / p.intensity_scale);
+    intensity[i] = !std::isfinite(v.intensity) || std::isnan(qi) ? std::uint8_t{0} : static_cast<std::uint8_t>(std::clamp(qi, 0.0f, 255.0f));
+  }
+}
+
+void dequantize_points(const QuantizedPointsView& in, PointBuffer& out) {
+  out.clear();
+  out.resize(in.size);
+  const PointView v = out.mutable_view();
+
+  std::size_t done = 0;
+#if WM_SIMD_X86
+  if (cpu_has_avx2()) done = dequantize_avx2(in, v.x, v.y, v.z, v.intensity);
+#endif
+  dequantize_scalar(in, done, v.x, v.y, v.z, v.intensity);
+}
+
+}  // namespace wm
@@ -0,0 +1,103 @@
+// File: src/core/mapping/block_pool.cpp
+#include "wm/core/mapping/block_pool.hpp"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
+namespace wm {
+
+BlockPool::OwnedChunk& BlockPool::OwnedChunk::operator=(OwnedChunk&& o) noexcept {
+  std::swap(base_, o.base_);
+  std::swap(bytes_, o.bytes_);
+  return *this;
+}
+
+BlockPool::OwnedChunk::~OwnedChunk() {
+  if (base_ != nullptr) (void)::munmap(base_, bytes_);
+}
+
+BlockPool::BlockPool(BlockPoolParams params) : params_(params) {
+  params_.block_bytes = std::max<std::size_t>(params_.block_bytes, 1);
+  params_.blocks_per_slab = std::max<std::size_t>(params_.blocks_per_slab, 1);
+  std::size_t blocks = std::max<std::size_t>(params_.blocks_per_chunk, 1);
+  if (params_.huge_pages) blocks = std::max(blocks, (kHugePageBytes + params_.block_bytes - 1) / params_.block_bytes);
+  const std::size_t slab = params_.blocks_per_slab;
+  params_.blocks_per_chunk = (blocks + slab - 1) / slab * slab;
+}
+
+void BlockPool::map_chunk() {
+  // Huge-page chunks span whole huge pages (the tail past the last block is never touched).
+  const std::size_t align = params_.huge_pages ? kHugePageBytes : 0;
+  const std::size_t bytes = align != 0 ? (chunk_bytes() + align - 1) / align * align : chunk_bytes();
+  // Over-map by one huge page and trim, so the chunk starts on a huge page boundary.
+  void* raw = ::mmap(nullptr, bytes + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) throw std::bad_alloc();
+  auto* base = static_cast<std::uint8_t*>(raw);
+  if (align != 0) {
+    const std::size_t head = (align - reinterpret_cast<std::uintptr_t>(raw) % align) % align;
+    if (head > 0) (void)::munmap(raw, head);
+    (void)::munmap(base + head + bytes, align - head);
+    base += head;
+#ifdef MADV_HUGEPAGE
+    if (::madvise(base, bytes, MADV_HUGEPAGE) == 0) ++huge_page_chunks_;
+#endif
+  }
+  owned_.emplace_back(base, bytes);
+  chunks_.push_back(base);
+}
+
+std::uint32_t BlockPool::take_slab() {
+  ++slabs_taken_;
+  if (!free_.empty()) {
+    const std::uint32_t s = free_.back();
+    free_.pop_back();
+    ++slabs_reused_;
+    return s;
+  }
+  const auto s = static_cast<std::uint32_t>(slabs_);
+  if (s * params_.blocks_per_slab % params_.blocks_per_chunk == 0) map_chunk();
+  ++slabs_;
+  return s;
+}
+
+void BlockPool::release_slab(std::uint32_t slab) {
+  free_.push_back(slab);
+  ++slabs_released_;
+}
+
+void BlockPool::release_all() {
+  slabs_released_ += slabs_ - free_.size();
+  free_.clear();
+  for (std::size_t s = slabs_; s-- > 0;) free_.push_back(static_cast<std::uint32_t>(s));
+}
+
+void BlockPool::adopt(const std::vector<std::uint8_t*>& chunks, std::size_t blocks_per_chunk, std::size_t slabs,
+                      std::shared_ptr<const void> backing) {
+  params_.blocks_per_chunk = blocks_per_chunk;
+  chunks_ = chunks;
+  owned_.clear();
+  mapped_ = std::move(backing);
+  mapped_chunks_ = chunks.size();
+  huge_page_chunks_ = 0;
+  slabs_ = slabs;
+  free_.clear();
+}
+
+BlockPoolStats BlockPool::stats() const noexcept {
+  BlockPoolStats s;
+  s.chunks = chunks_.size();
+  s.mapped_chunks = mapped_chunks_;
+  s.huge_page_chunks = huge_page_chunks_;
+  s.chunk_bytes = chunk_bytes();
+  s.slabs = slabs_;
+  s.free_slabs = free_.size();
+  s.slabs_taken = slabs_taken_;
+  s.slabs_reused = slabs_reused_;
+  s.slabs_released = slabs_released_;
+  return s;
+}
+
+}  // namespace wm
@@ -0,0 +1,196 @@
+// File: src/core/mapping/block_spill.cpp
+#include "wm/core/mapping/block_spill.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace wm {
+namespace {
+
+constexpr std::uint64_t kCompactMinDeadBytes = 64ull << 20;
+
+std::uint32_t load_cell(const std::uint8_t* p, std::size_t cell_bytes) noexcept {
+  std::uint32_t v = p[0];
+  if (cell_bytes == 2) v |= static_cast<std::uint32_t>(p[1]) << 8;
+  return v;
+}
+
+bool pwrite_all(int fd, const std::uint8_t* data, std::size_t size, std::uint64_t offset) noexcept {
+  while (size > 0) {
+    const ssize_t w = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    data += w;
+    size -= static_cast<std::size_t>(w);
+    offset += static_cast<std::uint64_t>(w);
+  }
+  return true;
+}
+
+bool pread_all(int fd, std::uint8_t* data, std::size_t size, std::uint64_t offset) noexcept {
+  while (size > 0) {
+    const ssize_t r = ::pread(fd, data, size, static_cast<off_t>(offset));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) return false;
+    data += r;
+    size -= static_cast<std::size_t>(r);
+    offset += static_cast<std::uint64_t>(r);
+  }
+  return true;
+}
+
+}  // namespace
+
+void append_cells_rle(std::vector<std::uint8_t>& out, const void* cells, std::size_t n, std::size_t cell_bytes) {
+  const auto* c = static_cast<const std::uint8_t*>(cells);
+  for (std::size_t i = 0; i < n;) {
+    const std::uint32_t v = load_cell(c + i * cell_bytes, cell_bytes);
+    std::size_t run = 1;
+    while (i + run < n && run < 0xffff && load_cell(c + (i + run) * cell_bytes, cell_bytes) == v) ++run;
+    out.push_back(static_cast<std::uint8_t>(run));
+    out.push_back(static_cast<std::uint8_t>(run >> 8));
+    out.insert(out.end(), c + i * cell_bytes, c + (i + 1) * cell_bytes);
+    i += run;
+  }
+}
+
+std::size_t read_cells_rle(const std::uint8_t* in, std::size_t size, void* cells, std::size_t n,
+                           std::size_t cell_bytes) noexcept {
+  auto* c = static_cast<std::uint8_t*>(cells);
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < n;) {
+    if (pos + 2 + cell_bytes > size) return 0;
+    const std::size_t run = in[pos] | (static_cast<std::size_t>(in[pos + 1]) << 8);
+    if (run == 0 || i + run > n) return 0;
+    for (std::size_t k = 0; k < run; ++k) std::memcpy(c + (i + k) * cell_bytes, in + pos + 2, cell_bytes);
+    pos += 2 + cell_bytes;
+    i += run;
+  }
+  return pos;
+}
+
+BlockSpillFile::~BlockSpillFile() { close(); }
+
+Status BlockSpillFile::open(const std::string& path) {
+  close();
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) return Status::io_error("BlockSpillFile: failed to open " + path + ": " + std::strerror(errno));
+  path_ = path;
+  stats_ = BlockSpillStats{};
+  return Status::ok_status();
+}
+
+void BlockSpillFile::close() noexcept {
+  if (fd_ < 0) return;
+  ::close(fd_);
+  ::unlink(path_.c_str());
+  fd_ = -1;
+  index_.clear();
+  stats_.records = 0;
+  stats_.file_bytes = 0;
+  stats_.live_bytes = 0;
+}
+
+Status BlockSpillFile::put(std::uint64_t key, const std::vector<std::uint8_t>& bytes) {
+  if (fd_ < 0) return Status::io_error("BlockSpillFile: not open");
+  const std::uint64_t offset = stats_.file_bytes;
+  if (!pwrite_all(fd_, bytes.data(), bytes.size(), offset)) {
+    return Status::io_error("BlockSpillFile: write failed on " + path_ + ": " + std::strerror(errno));
+  }
+  Record& r = index_[key];
+  stats_.live_bytes -= r.size;  // 0 for a new key
+  r = Record{offset, bytes.size()};
+  stats_.records = index_.size();
+  stats_.file_bytes += bytes.size();
+  stats_.bytes_written += bytes.size();
+  stats_.live_bytes += bytes.size();
+  const std::uint64_t dead = stats_.file_bytes - stats_.live_bytes;
+  if (dead > stats_.live_bytes && dead > kCompactMinDeadBytes) {
+    // The record is stored either way; a failed compaction only leaves dead space behind.
+    Status st = compact();
+    if (!st.ok()) {
+      ++stats_.compaction_errors;
+      compaction_status_ = std::move(st);
+    }
+  }
+  return Status::ok_status();
+}
+
+Status BlockSpillFile::read(std::uint64_t key, std::vector<std::uint8_t>& out) const {
+  const auto it = index_.find(key);
+  if (it == index_.end()) return Status::not_found("BlockSpillFile: no record");
+  out.resize(static_cast<std::size_t>(it->second.size));
+  if (!pread_all(fd_, out.data(), out.size(), it->second.offset)) {
+    return Status::io_error("BlockSpillFile: read failed on " + path_ + ": " + std::strerror(errno));
+  }
+  return Status::ok_status();
+}
+
+std::vector<std::uint64_t> BlockSpillFile::keys() const {
+  std::vector<std::uint64_t> out;
+  out.reserve(index_.size());
+  for (const auto& [key, r] : index_) out.push_back(key);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+Status BlockSpillFile::take(std::uint64_t key, std::vector<std::uint8_t>& out) {
+  Status st = read(key, out);
+  if (!st.ok()) return st;
+  const auto it = index_.find(key);
+  const Record r = it->second;
+  index_.erase(it);
+  stats_.records = index_.size();
+  stats_.live_bytes -= r.size;
+  stats_.bytes_read += r.size;
+  if (index_.empty()) {
+    // Nothing live: start the file over.
+    if (::ftruncate(fd_, 0) == 0) stats_.file_bytes = 0;
+  }
+  return Status::ok_status();
+}
+
+Status BlockSpillFile::clear() {
+  index_.clear();
+  stats_.records = 0;
+  stats_.live_bytes = 0;
+  if (fd_ >= 0 && ::ftruncate(fd_, 0) != 0) {
+    return Status::io_error("BlockSpillFile: truncate failed on " + path_ + ": " + std::strerror(errno));
+  }
+  stats_.file_bytes = 0;
+  return Status::ok_status();
+}
+
+// Slides live records to the front of the file, in file order, then truncates.
+Status BlockSpillFile::compact() {
+  std::vector<std::pair<std::uint64_t, Record*>> order;
+  order.reserve(index_.size());
+  for (auto& [key, r] : index_) order.emplace_back(r.offset, &r);
+  std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  std::vector<std::uint8_t> buf;
+  std::uint64_t end = 0;
+  for (auto& [offset, r] : order) {
+    if (r->offset != end) {
+      buf.resize(static_cast<std::size_t>(r->size));
+      if (!pread_all(fd_, buf.data(), buf.size(), r->offset) || !pwrite_all(fd_, buf.data(), buf.size(), end)) {
+        return Status::io_error("BlockSpillFile: compaction failed on " + path_ + ": " + std::strerror(errno));
+      }
+      r->offset = end;
+    }
+    end += r->size;
+  }
+  if (::ftruncate(fd_, static_cast<off_t>(end)) != 0) {
+    return Status::io_error("BlockSpillFile: truncate failed on " + path_ + ": " + std::strerror(errno));
+  }
+  stats_.file_bytes = end;
+  ++stats_.compactions;
+  return Status::ok_status();
+}
+
+}  // namespace wm
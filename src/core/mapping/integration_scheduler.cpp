@@ -0,0 +1,52 @@
+// File: src/core/mapping/integration_scheduler.cpp
+#include "wm/core/mapping/integration_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace wm {
+
+IntegrationSchedulerConfig IntegrationSchedulerConfig::from_config(const MappingConfig& m) {
+  IntegrationSchedulerConfig c;
+  c.integrate_hz = m.integrate_hz;
+  return c;
+}
+
+IntegrationScheduler::IntegrationScheduler(MultiResMap& map, RayIntegratorConfig rcfg, IntegrationSchedulerConfig cfg)
+    : integrator_(map, rcfg), cfg_(cfg) {
+  period_ns_ = cfg_.integrate_hz > 0.0 ? static_cast<std::int64_t>(1e9 / cfg_.integrate_hz) : 0;
+}
+
+bool IntegrationScheduler::push(TimestampNs t_ns, const Vec3f& origin, ConstPointView points) {
+  bool ran = false;
+  if (!queued_.empty() && (t_ns.ns - window_start_.ns >= period_ns_ || t_ns < window_start_)) ran = flush();
+  if (queued_.empty()) window_start_ = t_ns;
+  queued_.push_back(Queued{origin, points_.size(), points.size});
+  points_.append(points);
+  ++stats_.frames;
+  if (period_ns_ == 0 || points_.size() >= cfg_.max_batch_points) ran = flush() || ran;
+  return ran;
+}
+
+bool IntegrationScheduler::flush() {
+  if (queued_.empty()) return false;
+  const auto t0 = std::chrono::steady_clock::now();
+  stats_.points += static_cast<std::int64_t>(points_.size());
+  // Views into the batch buffer are taken only now: appending may have moved it.
+  const ConstPointView all = points_.view();
+  bundles_.clear();
+  for (const Queued& q : queued_) {
+    const ConstPointView v{all.x + q.begin, all.y + q.begin, all.z + q.begin, all.intensity + q.begin, q.count, 1};
+    bundles_.push_back(RayBundle{q.origin, v});
+  }
+  integrator_.integrate(bundles_);
+  stats_.integrate_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+  ++stats_.batches;
+  stats_.max_batch_frames = std::max(stats_.max_batch_frames, queued_.size());
+  queued_.clear();
+  points_.clear();
+  return true;
+}
+
+}  // namespace wm
@@ -0,0 +1,309 @@
+// File: src/core/mapping/log_odds.cpp
+#include "wm/core/mapping/log_odds.hpp"
+
+#include <bit>
+#include <cstring>
+
+#if WM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace wm {
+namespace {
+
+template <class Cell>
+void update_scalar(const LogOddsModel& m, Cell* c, std::uint8_t* hits, std::uint8_t* misses, std::size_t begin,
+                   std::size_t n, BlockUpdateCounts& counts) noexcept {
+  for (std::size_t i = begin; i < n; ++i) {
+    if ((hits[i] | misses[i]) == 0) continue;
+    const std::int32_t v = static_cast<std::int32_t>(c[i]) + hits[i] * m.hit + misses[i] * m.miss;
+    c[i] = static_cast<Cell>(std::clamp(v, m.min, m.max));
+    counts.hits += hits[i];
+    counts.misses += misses[i];
+    hits[i] = 0;
+    misses[i] = 0;
+  }
+}
+
+#if WM_SIMD_X86
+// The SIMD kernels interleave the counts into (hits, misses) int16 pairs, so one madd with
+// (hit, miss) gives each cell's int32 delta; sums are clamped in int32 and packed back.
+inline std::int32_t madd_weights(const LogOddsModel& m) noexcept {
+  return static_cast<std::int32_t>((static_cast<std::uint32_t>(m.miss) << 16) |
+                                   (static_cast<std::uint32_t>(m.hit) & 0xffffu));
+}
+
+// Sum of the 16 unsigned bytes of v.
+inline std::int64_t sum_bytes_sse2(__m128i v) noexcept {
+  const __m128i s = _mm_sad_epu8(v, _mm_setzero_si128());
+  return _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+}
+
+// SSE2 has no signed 32-bit min/max; select through compares instead.
+inline __m128i clamp_epi32_sse2(__m128i v, __m128i lo, __m128i hi) noexcept {
+  const __m128i above = _mm_cmpgt_epi32(v, hi);
+  v = _mm_or_si128(_mm_and_si128(above, hi), _mm_andnot_si128(above, v));
+  const __m128i below = _mm_cmpgt_epi32(lo, v);
+  return _mm_or_si128(_mm_and_si128(below, lo), _mm_andnot_si128(below, v));
+}
+
+// 8 cells (int16 lanes of c) updated by the counts in the low 8 bytes of h and mi.
+inline __m128i update8_sse2(__m128i c, __m128i h, __m128i mi, __m128i w, __m128i lo, __m128i hi) noexcept {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i pairs = _mm_unpacklo_epi8(h, mi);
+  const __m128i d0 = _mm_madd_epi16(_mm_unpacklo_epi8(pairs, zero), w);
+  const __m128i d1 = _mm_madd_epi16(_mm_unpackhi_epi8(pairs, zero), w);
+  const __m128i c0 = _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16);
+  const __m128i c1 = _mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16);
+  return _mm_packs_epi32(clamp_epi32_sse2(_mm_add_epi32(c0, d0), lo, hi),
+                         clamp_epi32_sse2(_mm_add_epi32(c1, d1), lo, hi));
+}
+
+std::size_t update_i8_sse2(const LogOddsModel& m, std::int8_t* c, std::uint8_t* hits, std::uint8_t* misses,
+                           std::size_t n, BlockUpdateCounts& counts) noexcept {
+  const __m128i w = _mm_set1_epi32(madd_weights(m));
+  const __m128i lo = _mm_set1_epi32(m.min);
+  const __m128i hi = _mm_set1_epi32(m.max);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(hits + i));
+    const __m128i mi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(misses + i));
+    auto* p = reinterpret_cast<__m128i*>(c + i);
+    const __m128i c8 = _mm_loadl_epi64(p);
+    const __m128i r = update8_sse2(_mm_srai_epi16(_mm_unpacklo_epi8(c8, c8), 8), h, mi, w, lo, hi);
+    _mm_storel_epi64(p, _mm_packs_epi16(r, r));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(hits + i), zero);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(misses + i), zero);
+    counts.hits += sum_bytes_sse2(h);
+    counts.misses += sum_bytes_sse2(mi);
+  }
+  return i;
+}
+
+std::size_t update_i16_sse2(const LogOddsModel& m, std::int16_t* c, std::uint8_t* hits, std::uint8_t* misses,
+                            std::size_t n, BlockUpdateCounts& counts) noexcept {
+  const __m128i w = _mm_set1_epi32(madd_weights(m));
+  const __m128i lo = _mm_set1_epi32(m.min);
+  const __m128i hi = _mm_set1_epi32(m.max);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(hits + i));
+    const __m128i mi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(misses + i));
+    auto* p = reinterpret_cast<__m128i*>(c + i);
+    _mm_storeu_si128(p, update8_sse2(_mm_loadu_si128(p), h, mi, w, lo, hi));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(hits + i), zero);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(misses + i), zero);
+    counts.hits += sum_bytes_sse2(h);
+    counts.misses += sum_bytes_sse2(mi);
+  }
+  return i;
+}
+
+// 16 cells (int16 lanes of c) updated by the counts in h and mi.
+WM_TARGET_AVX2 inline __m256i update16_avx2(__m256i c, __m128i h, __m128i mi, __m256i w, __m256i lo,
+                                            __m256i hi) noexcept {
+  const __m256i d0 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(h, mi)), w);
+  const __m256i d1 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_unpackhi_epi8(h, mi)), w);
+  const __m256i c0 = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(c));
+  const __m256i c1 = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(c, 1));
+  const __m256i v0 = _mm256_max_epi32(_mm256_min_epi32(_mm256_add_epi32(c0, d0), hi), lo);
+  const __m256i v1 = _mm256_max_epi32(_mm256_min_epi32(_mm256_add_epi32(c1, d1), hi), lo);
+  // packs works per 128-bit lane; the permute restores cell order.
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1), 0xD8);
+}
+
+WM_TARGET_AVX2 std::size_t update_i8_avx2(const LogOddsModel& m, std::int8_t* c, std::uint8_t* hits,
+                                          std::uint8_t* misses, std::size_t n, BlockUpdateCounts& counts) noexcept {
+  const __m256i w = _mm256_set1_epi32(madd_weights(m));
+  const __m256i lo = _mm256_set1_epi32(m.min);
+  const __m256i hi = _mm256_set1_epi32(m.max);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hits + i));
+    const __m128i mi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(misses + i));
+    auto* p = reinterpret_cast<__m128i*>(c + i);
+    const __m256i r = update16_avx2(_mm256_cvtepi8_epi16(_mm_loadu_si128(p)), h, mi, w, lo, hi);
+    _mm_storeu_si128(p, _mm_packs_epi16(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(hits + i), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(misses + i), zero);
+    counts.hits += sum_bytes_sse2(h);
+    counts.misses += sum_bytes_sse2(mi);
+  }
+  return i;
+}
+
+WM_TARGET_AVX2 std::size_t update_i16_avx2(const LogOddsModel& m, std::int16_t* c, std::uint8_t* hits,
+                                           std::uint8_t* misses, std::size_t n, BlockUpdateCounts& counts) noexcept {
+  const __m256i w = _mm256_set1_epi32(madd_weights(m));
+  const __m256i lo = _mm256_set1_epi32(m.min);
+  const __m256i hi = _mm256_set1_epi32(m.max);
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hits + i));
+    const __m128i mi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(misses + i));
+    auto* p = reinterpret_cast<__m256i*>(c + i);
+    _mm256_storeu_si256(p, update16_avx2(_mm256_loadu_si256(p), h, mi, w, lo, hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(hits + i), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(misses + i), zero);
+    counts.hits += sum_bytes_sse2(h);
+    counts.misses += sum_bytes_sse2(mi);
+  }
+  return i;
+}
+
+// classify_block kernels: per step, compare masks for `occupied` (v > occupied) and
+// `known` (that or v < free) packed to one bit per cell. Steps never straddle a word.
+inline void put_bits(std::uint64_t* words, std::size_t i, std::uint32_t bits) noexcept {
+  words[i / 64] |= static_cast<std::uint64_t>(bits) << (i % 64);
+}
+
+std::size_t classify_i8_sse2(const LogOddsModel& m, const std::int8_t* c, std::size_t n, std::uint64_t* occupied,
+                             std::uint64_t* known) noexcept {
+  const __m128i occ = _mm_set1_epi8(static_cast<char>(m.occupied));
+  const __m128i fr = _mm_set1_epi8(static_cast<char>(m.free));
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i));
+    const __m128i is_occ = _mm_cmpgt_epi8(v, occ);
+    const __m128i is_known = _mm_or_si128(is_occ, _mm_cmpgt_epi8(fr, v));
+    put_bits(occupied, i, static_cast<std::uint32_t>(_mm_movemask_epi8(is_occ)));
+    put_bits(known, i, static_cast<std::uint32_t>(_mm_movemask_epi8(is_known)));
+  }
+  return i;
+}
+
+std::size_t classify_i16_sse2(const LogOddsModel& m, const std::int16_t* c, std::size_t n, std::uint64_t* occupied,
+                              std::uint64_t* known) noexcept {
+  const __m128i occ = _mm_set1_epi16(static_cast<short>(m.occupied));
+  const __m128i fr = _mm_set1_epi16(static_cast<short>(m.free));
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i + 8));
+    const __m128i o0 = _mm_cmpgt_epi16(v0, occ);
+    const __m128i o1 = _mm_cmpgt_epi16(v1, occ);
+    const __m128i k0 = _mm_or_si128(o0, _mm_cmpgt_epi16(fr, v0));
+    const __m128i k1 = _mm_or_si128(o1, _mm_cmpgt_epi16(fr, v1));
+    // Saturating packs keep the all-ones / zero lanes, one byte per cell.
+    put_bits(occupied, i, static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(o0, o1))));
+    put_bits(known, i, static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(k0, k1))));
+  }
+  return i;
+}
+
+WM_TARGET_AVX2 std::size_t classify_i8_avx2(const LogOddsModel& m, const std::int8_t* c, std::size_t n,
+                                            std::uint64_t* occupied, std::uint64_t* known) noexcept {
+  const __m256i occ = _mm256_set1_epi8(static_cast<char>(m.occupied));
+  const __m256i fr = _mm256_set1_epi8(static_cast<char>(m.free));
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i));
+    const __m256i is_occ = _mm256_cmpgt_epi8(v, occ);
+    const __m256i is_known = _mm256_or_si256(is_occ, _mm256_cmpgt_epi8(fr, v));
+    put_bits(occupied, i, static_cast<std::uint32_t>(_mm256_movemask_epi8(is_occ)));
+    put_bits(known, i, static_cast<std::uint32_t>(_mm256_movemask_epi8(is_known)));
+  }
+  return i;
+}
+
+WM_TARGET_AVX2 std::size_t classify_i16_avx2(const LogOddsModel& m, const std::int16_t* c, std::size_t n,
+                                             std::uint64_t* occupied, std::uint64_t* known) noexcept {
+  const __m256i occ = _mm256_set1_epi16(static_cast<short>(m.occupied));
+  const __m256i fr = _mm256_set1_epi16(static_cast<short>(m.free));
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i));
+    const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i + 16));
+    const __m256i o0 = _mm256_cmpgt_epi16(v0, occ);
+    const __m256i o1 = _mm256_cmpgt_epi16(v1, occ);
+    const __m256i k0 = _mm256_or_si256(o0, _mm256_cmpgt_epi16(fr, v0));
+    const __m256i k1 = _mm256_or_si256(o1, _mm256_cmpgt_epi16(fr, v1));
+    // packs works per 128-bit lane; the permute restores cell order.
+    const __m256i po = _mm256_permute4x64_epi64(_mm256_packs_epi16(o0, o1), 0xD8);
+    const __m256i pk = _mm256_permute4x64_epi64(_mm256_packs_epi16(k0, k1), 0xD8);
+    put_bits(occupied, i, static_cast<std::uint32_t>(_mm256_movemask_epi8(po)));
+    put_bits(known, i, static_cast<std::uint32_t>(_mm256_movemask_epi8(pk)));
+  }
+  return i;
+}
+#endif
+
+template <class Cell>
+void classify_scalar(const LogOddsModel& m, const Cell* c, std::size_t begin, std::size_t n, std::uint64_t* occupied,
+                     std::uint64_t* known) noexcept {
+  for (std::size_t i = begin; i < n; ++i) {
+    const std::uint64_t bit = std::uint64_t{1} << (i % 64);
+    if (c[i] > m.occupied) occupied[i / 64] |= bit;
+    if (c[i] > m.occupied || c[i] < m.free) known[i / 64] |= bit;
+  }
+}
+
+}  // namespace
+
+LogOddsModel LogOddsModel::make(int bits, float hit, float miss, float min, float max, float occupied,
+                                float free) noexcept {
+  LogOddsModel m;
+  m.bits = bits == 8 ? 8 : 16;
+  const float limit = m.bits == 8 ? 127.0f : 32767.0f;
+  m.scale = limit / std::max({std::fabs(min), std::fabs(max), 1e-6f});
+  m.hit = m.encode(hit);
+  m.miss = m.encode(miss);
+  m.min = m.encode(min);
+  m.max = m.encode(max);
+  m.occupied = m.encode(occupied);
+  m.free = m.encode(free);
+  return m;
+}
+
+BlockUpdateCounts apply_block_updates(const LogOddsModel& model, void* cells, std::uint8_t* hits,
+                                      std::uint8_t* misses, std::size_t n, SimdLevel level) noexcept {
+  BlockUpdateCounts counts;
+  std::size_t done = 0;
+  level = clamp_simd_level(level);
+  if (model.bits == 8) {
+    auto* c = static_cast<std::int8_t*>(cells);
+#if WM_SIMD_X86
+    if (level == SimdLevel::kAvx2) done = update_i8_avx2(model, c, hits, misses, n, counts);
+    if (level == SimdLevel::kSse2) done = update_i8_sse2(model, c, hits, misses, n, counts);
+#endif
+    update_scalar(model, c, hits, misses, done, n, counts);
+  } else {
+    auto* c = static_cast<std::int16_t*>(cells);
+#if WM_SIMD_X86
+    if (level == SimdLevel::kAvx2) done = update_i16_avx2(model, c, hits, misses, n, counts);
+    if (level == SimdLevel::kSse2) done = update_i16_sse2(model, c, hits, misses, n, counts);
+#endif
+    update_scalar(model, c, hits, misses, done, n, counts);
+  }
+  return counts;
+}
+
+void classify_block(const LogOddsModel& model, const void* cells, std::size_t n, std::uint64_t* occupied,
+                    std::uint64_t* known, SimdLevel level) noexcept {
+  const std::size_t words = (n + 63) / 64;
+  std::fill(occupied, occupied + words, 0);
+  std::fill(known, known + words, 0);
+  std::size_t done = 0;
+  level = clamp_simd_level(level);
+  if (model.bits == 8) {
+    const auto* c = static_cast<const std::int8_t*>(cells);
+#if WM_SIMD_X86
+    if (level == SimdLevel::kAvx2) done = classify_i8_avx2(model, c, n, occupied, known);
+    if (level == SimdLevel::kSse2) done = classify_i8_sse2(model, c, n, occupied, known);
+#endif
+    classify_scalar(model, c, done, n, occupied, known);
+  } else {
+    const auto* c = static_cast<const std::int16_t*>(cells);
+#if WM_SIMD_X86
+    if (level == SimdLevel::kAvx2) done = classify_i16_avx2(model, c, n, occupied, known);
+    if (level == SimdLevel::kSse2) done = classify_i16_sse2(model, c, n, occupied, known);
+#endif
+    classify_scalar(model, c, done, n, occupied, known);
+  }
+}
+
+}  // namespace wm
@@ -0,0 +1,320 @@
+// File: src/core/mapping/map_snapshot.cpp
+#include "wm/core/mapping/map_snapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "wm/core/io/mapped_file.hpp"
+#include "wm/core/mapping/block_spill.hpp"
+#include "wm/core/mapping/log_odds.hpp"
+#include "wm/core/util/repro_hash.hpp"
+
+namespace wm {
+namespace {
+
+// FNV-1a 64 taking a word per step (the index arrays are u64 throughout), so checking
+// the masks on restore costs about as much as copying them.
+struct Fnv1a64 {
+  std::uint64_t h = 1469598103934665603ull;
+
+  void add(const std::uint64_t* words, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      h ^= words[i];
+      h *= 1099511628211ull;
+    }
+  }
+};
+
+std::uint64_t align_up(std::uint64_t v, std::uint64_t a) { return (v + a - 1) / a * a; }
+
+template <std::size_t N>
+void copy_padded(char (&dst)[N], const std::string& src) {
+  std::memset(dst, 0, N);
+  std::memcpy(dst, src.data(), std::min(src.size(), N));
+}
+
+template <std::size_t N>
+bool equals_padded(const char (&a)[N], const std::string& b) {
+  char tmp[N];
+  copy_padded(tmp, b);
+  return b.size() <= N && std::memcmp(a, tmp, N) == 0;
+}
+
+template <std::size_t N>
+std::string from_padded(const char (&src)[N]) {
+  return std::string(src, static_cast<std::size_t>(std::find(src, src + N, '\0') - src));
+}
+
+}  // namespace
+
+// Friend of VoxelBlockMap: the snapshot is its pool, so it works on the internals.
+struct MapSnapshotAccess {
+  static Status save(const VoxelBlockMap& map, const MapSnapshotKey& key, const std::string& path);
+  static Result<VoxelBlockMap> load(const std::string& path, const MapSnapshotKey& key,
+                                    const VoxelBlockMapParams& params);
+};
+
+MapSnapshotKey MapSnapshotKey::from_config(const Config& cfg) {
+  return MapSnapshotKey{compute_map_config_hash(cfg), compute_calibration_hash(cfg.calibration)};
+}
+
+Status save_map_snapshot(const VoxelBlockMap& map, const MapSnapshotKey& key, const std::string& path) {
+  return MapSnapshotAccess::save(map, key, path);
+}
+
+Result<VoxelBlockMap> load_map_snapshot(const std::string& path, const MapSnapshotKey& key,
+                                        const VoxelBlockMapParams& params) {
+  return MapSnapshotAccess::load(path, key, params);
+}
+
+Status MapSnapshotAccess::save(const VoxelBlockMap& map, const MapSnapshotKey& key, const std::string& path) {
+  using Map = VoxelBlockMap;
+  const std::size_t bpr = map.blocks_per_region_;
+  const std::size_t block_bytes = map.block_bytes_;
+  const std::size_t bpc = map.params_.blocks_per_chunk;
+
+  // Live regions in table order (shard by shard) become the first regions of the file.
+  std::vector<std::uint64_t> region_keys;
+  std::vector<Map::RegionIndex> regions;
+  for (const Map::Shard& sh : map.shards_) {
+    for (const Map::Slot& s : sh.slots) {
+      if (s.key == Map::kEmptyKey) continue;
+      region_keys.push_back(s.key);
+      regions.push_back(s.region);
+    }
+  }
+  const std::size_t region_mask_words = bpr * 2 * map.mask_words_;
+  std::vector<std::uint64_t> block_keys;
+  std::vector<std::uint64_t> block_masks;
+  block_keys.reserve(regions.size() * bpr);
+  block_masks.reserve(regions.size() * region_mask_words);
+  for (const Map::RegionIndex r : regions) {
+    const auto first = map.block_keys_.begin() + static_cast<std::ptrdiff_t>(std::size_t{r} * bpr);
+    block_keys.insert(block_keys.end(), first, first + static_cast<std::ptrdiff_t>(bpr));
+    const auto masks = map.block_masks_.begin() + static_cast<std::ptrdiff_t>(std::size_t{r} * region_mask_words);
+    block_masks.insert(block_masks.end(), masks, masks + static_cast<std::ptrdiff_t>(region_mask_words));
+  }
+  std::uint64_t num_blocks = map.num_blocks_;
+
+  // Regions the memory budget spilled follow the live ones, read back from the spill file
+  // (twice: keys and masks now, cells when the voxel section is written).
+  const std::size_t live = regions.size();
+  std::vector<std::uint64_t> spilled = map.spill_ ? map.spill_->keys() : std::vector<std::uint64_t>{};
+  std::vector<std::uint8_t> record;
+  std::vector<std::uint64_t> record_keys(bpr);
+  std::vector<std::uint8_t> record_cells(bpr * block_bytes);
+  const auto read_spilled = [&](std::uint64_t region_key) {
+    const Status st = map.spill_->read(region_key, record);
+    if (!st.ok()) return st;
+    std::fill(record_cells.begin(), record_cells.end(), 0);
+    if (!map.decode_spill_record(region_key, record, record_keys.data(), record_cells.data())) {
+      return Status::corrupt_data("save_map_snapshot: damaged spill record");
+    }
+    return Status::ok_status();
+  };
+  for (const std::uint64_t region_key : spilled) {
+    const Status st = read_spilled(region_key);
+    if (!st.ok()) return st;
+    region_keys.push_back(region_key);
+    block_keys.insert(block_keys.end(), record_keys.begin(), record_keys.end());
+    const std::size_t m = block_masks.size();
+    block_masks.resize(m + region_mask_words, 0);
+    for (std::size_t slot = 0; slot < bpr; ++slot) {
+      if (record_keys[slot] == Map::kEmptyKey) continue;
+      std::uint64_t* masks = block_masks.data() + m + slot * 2 * map.mask_words_;
+      classify_block(map.log_odds_, record_cells.data() + slot * block_bytes, map.voxels_per_block_, masks,
+                     masks + map.mask_words_);
+      ++num_blocks;
+    }
+  }
+
+  const std::uint64_t n = region_keys.size();
+  const std::uint64_t chunks = (n * bpr + bpc - 1) / bpc;
+
+  MapSnapshotHeader h{};
+  std::memcpy(h.magic, kMapSnapshotMagic, sizeof(h.magic));
+  h.version = kMapSnapshotVersion;
+  h.header_bytes = sizeof(MapSnapshotHeader);
+  copy_padded(h.config_hash, key.config_hash);
+  copy_padded(h.calibration_hash, key.calibration_hash);
+  h.voxel_size_m = map.params_.voxel_size_m;
+  h.block_size_vox = map.params_.block_size_vox;
+  h.region_size_blocks = map.params_.region_size_blocks;
+  h.flags = (map.params_.morton_voxels ? kMapSnapshotMortonVoxels : 0u) |
+            (map.log_odds_.bits == 8 ? kMapSnapshotInt8Cells : 0u);
+  h.num_regions = n;
+  h.num_blocks = num_blocks;
+  h.blocks_per_chunk = bpc;
+  h.region_keys_offset = align_up(sizeof(MapSnapshotHeader), 64);
+  h.block_keys_offset = align_up(h.region_keys_offset + n * sizeof(std::uint64_t), 64);
+  const std::uint64_t masks_offset = align_up(h.block_keys_offset + block_keys.size() * sizeof(std::uint64_t), 64);
+  h.voxels_offset = align_up(masks_offset + block_masks.size() * sizeof(std::uint64_t), kMapSnapshotVoxelAlignment);
+  h.voxels_bytes = chunks * bpc * block_bytes;
+  Fnv1a64 sum;
+  sum.add(region_keys.data(), region_keys.size());
+  sum.add(block_keys.data(), block_keys.size());
+  sum.add(block_masks.data(), block_masks.size());
+  h.index_checksum = sum.h;
+
+  const std::string tmp = path + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!f.is_open()) return Status::io_error("save_map_snapshot: failed opening " + tmp);
+
+  std::uint64_t offset = 0;
+  const std::vector<std::uint8_t> zeros(std::max(block_bytes, kMapSnapshotVoxelAlignment), 0);
+  const auto write = [&](const void* data, std::uint64_t bytes) {
+    f.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    offset += bytes;
+  };
+  const auto pad_to = [&](std::uint64_t target) {
+    while (offset < target) write(zeros.data(), std::min<std::uint64_t>(target - offset, zeros.size()));
+  };
+
+  write(&h, sizeof(h));
+  pad_to(h.region_keys_offset);
+  write(region_keys.data(), region_keys.size() * sizeof(std::uint64_t));
+  pad_to(h.block_keys_offset);
+  write(block_keys.data(), block_keys.size() * sizeof(std::uint64_t));
+  pad_to(masks_offset);
+  write(block_masks.data(), block_masks.size() * sizeof(std::uint64_t));
+  pad_to(h.voxels_offset);
+  // Unused slots are written as zeros so the file depends only on the map contents.
+  for (std::size_t i = 0; i < live * bpr; ++i) {
+    const std::size_t b = std::size_t{regions[i / bpr]} * bpr + i % bpr;
+    write(block_keys[i] != Map::kEmptyKey ? map.block_ptr(static_cast<BlockIndex>(b)) : zeros.data(),
+          block_bytes);
+  }
+  for (const std::uint64_t region_key : spilled) {
+    const Status st = read_spilled(region_key);
+    if (!st.ok()) {
+      f.close();
+      std::error_code ec;
+      std::filesystem::remove(tmp, ec);
+      return st;
+    }
+    write(record_cells.data(), record_cells.size());
+  }
+  pad_to(h.voxels_offset + h.voxels_bytes);
+
+  f.flush();
+  const bool ok = f.good();
+  f.close();
+  std::error_code ec;
+  if (!ok) {
+    std::filesystem::remove(tmp, ec);
+    return Status::io_error("save_map_snapshot: failed writing " + tmp);
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) return Status::io_error("save_map_snapshot: failed renaming " + tmp + ": " + ec.message());
+  return Status::ok_status();
+}
+
+Result<VoxelBlockMap> MapSnapshotAccess::load(const std::string& path, const MapSnapshotKey& key,
+                                              const VoxelBlockMapParams& params) {
+  using R = Result<VoxelBlockMap>;
+  using Map = VoxelBlockMap;
+
+  auto file_r = MappedFile::open_copy_on_write(path, MappedFile::Access::kRandom);
+  if (!file_r.ok()) return R::err(file_r.status());
+  std::shared_ptr<MappedFile> file = file_r.take_value();
+
+  MapSnapshotHeader h{};
+  if (file->size() < sizeof(h)) return R::err(Status::corrupt_data("map snapshot: file too small: " + path));
+  std::memcpy(&h, file->data(), sizeof(h));
+  if (std::memcmp(h.magic, kMapSnapshotMagic, sizeof(h.magic)) != 0 || h.header_bytes != sizeof(h)) {
+    return R::err(Status::corrupt_data("map snapshot: bad magic: " + path));
+  }
+  if (h.version != kMapSnapshotVersion) {
+    return R::err(Status::unsupported("map snapshot: unsupported version " + std::to_string(h.version)));
+  }
+
+  // Stale: written under another config / calibration.
+  if (!equals_padded(h.config_hash, key.config_hash)) {
+    return R::err(Status::invalid_argument("map snapshot: config hash " + from_padded(h.config_hash) +
+                                           " != running " + key.config_hash));
+  }
+  if (!equals_padded(h.calibration_hash, key.calibration_hash)) {
+    return R::err(Status::invalid_argument("map snapshot: calibration hash " + from_padded(h.calibration_hash) +
+                                           " != running " + key.calibration_hash));
+  }
+
+  Map map(params);
+  const VoxelBlockMapParams& p = map.params_;
+  const bool morton = (h.flags & kMapSnapshotMortonVoxels) != 0;
+  const int bits = (h.flags & kMapSnapshotInt8Cells) != 0 ? 8 : 16;
+  if (h.voxel_size_m != p.voxel_size_m || h.block_size_vox != p.block_size_vox ||
+      h.region_size_blocks != p.region_size_blocks || morton != p.morton_voxels || bits != p.log_odds_bits) {
+    return R::err(Status::invalid_argument("map snapshot: map geometry differs from the running config"));
+  }
+
+  const std::size_t bpr = map.blocks_per_region_;
+  const std::size_t block_bytes = map.block_bytes_;
+  const std::uint64_t n = h.num_regions;
+  const std::uint64_t bpc = h.blocks_per_chunk;
+  const std::uint64_t size = file->size();
+  const std::uint64_t region_mask_words = bpr * 2 * map.mask_words_;
+  // Offsets are checked against the file size first, so the sums below cannot wrap.
+  const bool in_file = h.region_keys_offset <= size && h.block_keys_offset <= size && h.voxels_offset <= size &&
+                       h.voxels_bytes <= size - h.voxels_offset && bpc > 0 && bpc <= size &&
+                       n < (std::uint64_t{1} << 31) && n * bpr <= size;
+  if (!in_file) return R::err(Status::corrupt_data("map snapshot: inconsistent layout: " + path));
+  const std::uint64_t masks_offset = align_up(h.block_keys_offset + n * bpr * 8, 64);
+  const bool sane = bpc % bpr == 0 && h.region_keys_offset >= h.header_bytes && h.region_keys_offset % 64 == 0 &&
+                    h.block_keys_offset % 64 == 0 && h.voxels_offset % 64 == 0 &&
+                    h.region_keys_offset + n * 8 <= h.block_keys_offset &&
+                    masks_offset + n * region_mask_words * 8 <= h.voxels_offset &&
+                    h.voxels_bytes == (n * bpr + bpc - 1) / bpc * bpc * block_bytes;
+  if (!sane) return R::err(Status::corrupt_data("map snapshot: inconsistent layout: " + path));
+
+  const auto* region_keys = reinterpret_cast<const std::uint64_t*>(file->data() + h.region_keys_offset);
+  const auto* block_keys = reinterpret_cast<const std::uint64_t*>(file->data() + h.block_keys_offset);
+  const auto* block_masks = reinterpret_cast<const std::uint64_t*>(file->data() + masks_offset);
+  Fnv1a64 sum;
+  sum.add(region_keys, n);
+  sum.add(block_keys, n * bpr);
+  sum.add(block_masks, n * region_mask_words);
+  if (sum.h != h.index_checksum) {
+    return R::err(Status::corrupt_data("map snapshot: index checksum mismatch: " + path));
+  }
+
+  // Adopt the voxel section as the pool: chunk c starts c * bpc blocks in.
+  map.params_.blocks_per_chunk = static_cast<std::size_t>(bpc);
+  auto* voxels = reinterpret_cast<std::uint8_t*>(file->mutable_data() + h.voxels_offset);
+  const std::size_t num_chunks = static_cast<std::size_t>(h.voxels_bytes / (bpc * block_bytes));
+  std::vector<std::uint8_t*> chunks;
+  for (std::size_t c = 0; c < num_chunks; ++c) chunks.push_back(voxels + c * bpc * block_bytes);
+
+  map.block_keys_.assign(block_keys, block_keys + n * bpr);
+  map.block_masks_.assign(block_masks, block_masks + n * region_mask_words);
+  map.region_summary_.assign(static_cast<std::size_t>(n) * 2 * map.summary_words_, 0);
+  map.region_blocks_.assign(static_cast<std::size_t>(n), 0);
+  map.region_seen_.assign(static_cast<std::size_t>(n), map.epoch_);
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t i = r * bpr; i < (r + 1) * bpr; ++i) {
+      if (block_keys[i] == Map::kEmptyKey) continue;
+      // A block must sit in the slot of its own region, or lookups would never find it.
+      const BlockKey k = unpack_block_key(block_keys[i]);
+      if (pack_block_key(k) != block_keys[i] || map.region_key(k) != region_keys[r] ||
+          map.slot_in_region(k) != i - r * bpr) {
+        return R::err(Status::corrupt_data("map snapshot: block key outside its region slot: " + path));
+      }
+      ++map.region_blocks_[r];
+      map.refresh_summary(static_cast<BlockIndex>(i));
+    }
+    if (map.region_blocks_[r] == 0 || map.find_region(region_keys[r]) != Map::kInvalidRegion) {
+      return R::err(Status::corrupt_data("map snapshot: empty or duplicate region: " + path));
+    }
+    Map::insert_slot(map.shards_[map.shard_index(region_keys[r])], region_keys[r], static_cast<Map::RegionIndex>(r));
+    map.num_blocks_ += map.region_blocks_[r];
+  }
+  if (map.num_blocks_ != h.num_blocks) return R::err(Status::corrupt_data("map snapshot: block count mismatch: " + path));
+
+  file->advise_willneed(static_cast<std::size_t>(h.voxels_offset), static_cast<std::size_t>(h.voxels_bytes));
+  map.pool_.adopt(chunks, static_cast<std::size_t>(bpc), static_cast<std::size_t>(n), std::move(file));
+  return R::ok(std::move(map));
+}
+
+}  // namespace wm
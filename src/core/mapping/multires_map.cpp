@@ -0,0 +1,160 @@
+// File: src/core/mapping/multires_map.cpp
+#include "wm/core/mapping/multires_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "wm/core/geom/point_transform.hpp"
+
+namespace wm {
+
+MultiResMapParams MultiResMapParams::from_config(const MappingConfig& m) {
+  MultiResMapParams p;
+  p.base = VoxelBlockMapParams::from_config(m);
+  p.levels = m.lod_levels;
+  p.near_m = m.lod_near_m;
+  return p;
+}
+
+MultiResMap::MultiResMap(MultiResMapParams params) : params_(params) {
+  params_.levels = std::max(params_.levels, 1);
+  levels_.reserve(static_cast<std::size_t>(params_.levels));
+  for (int i = 0; i < params_.levels; ++i) {
+    VoxelBlockMapParams p = params_.base;
+    p.voxel_size_m = std::ldexp(params_.base.voxel_size_m, i);
+    // The memory budget is split evenly; each level spills to its own file.
+    p.memory_budget_bytes = params_.base.memory_budget_bytes / static_cast<std::size_t>(params_.levels);
+    if (!p.spill_path.empty() && params_.levels > 1) p.spill_path += ".l" + std::to_string(i);
+    levels_.emplace_back(p);
+  }
+  split_.resize(levels_.size());
+}
+
+float MultiResMap::band_min_m(int i) const noexcept {
+  return i == 0 ? 0.0f : std::ldexp(params_.near_m, i - 1);
+}
+
+float MultiResMap::band_max_m(int i) const noexcept {
+  return i + 1 == num_levels() ? std::numeric_limits<float>::infinity() : std::ldexp(params_.near_m, i);
+}
+
+int MultiResMap::level_of(const Vec3f& p) const noexcept {
+  // Same squared-distance test as RayIntegrator's band check, so a return is a hit in
+  // exactly the level that answers queries at its position.
+  const float dx = p.x - params_.center.x;
+  const float dy = p.y - params_.center.y;
+  const float dz = p.z - params_.center.z;
+  const float r2 = dx * dx + dy * dy + dz * dz;
+  int i = 0;
+  while (i + 1 < num_levels()) {
+    const float hi = band_max_m(i);
+    if (r2 < hi * hi) break;
+    ++i;
+  }
+  return i;
+}
+
+std::size_t MultiResMap::integrate_hits(ConstPointView pts) {
+  if (levels_.size() == 1) return levels_[0].integrate_hits(pts);
+  for (PointBuffer& b : split_) b.clear();
+  for (std::size_t i = 0; i < pts.size; ++i) {
+    const PointXYZI p = pts.at(i);
+    split_[static_cast<std::size_t>(level_of(Vec3f{p.x, p.y, p.z}))].push_back(p);
+  }
+  std::size_t n = 0;
+  for (std::size_t l = 0; l < levels_.size(); ++l) n += levels_[l].integrate_hits(split_[l].view());
+  return n;
+}
+
+std::size_t MultiResMap::count_occupied() const noexcept {
+  std::size_t n = 0;
+  for (const VoxelBlockMap& m : levels_) n += m.count_occupied();
+  return n;
+}
+
+std::size_t MultiResMap::count_known() const noexcept {
+  std::size_t n = 0;
+  for (const VoxelBlockMap& m : levels_) n += m.count_known();
+  return n;
+}
+
+VoxelBlockMapStats MultiResMap::stats() const noexcept {
+  VoxelBlockMapStats s;
+  for (const VoxelBlockMap& m : levels_) {
+    const VoxelBlockMapStats l = m.stats();
+    s.blocks += l.blocks;
+    s.free_blocks += l.free_blocks;
+    s.regions += l.regions;
+    s.shards = l.shards;
+    s.hash_slots += l.hash_slots;
+    s.pool_chunks += l.pool_chunks;
+    s.mapped_chunks += l.mapped_chunks;
+    s.huge_page_chunks += l.huge_page_chunks;
+    s.pool_bytes += l.pool_bytes;
+    s.free_regions += l.free_regions;
+    s.stranded_blocks += l.stranded_blocks;
+    s.memory_bytes += l.memory_bytes;
+    s.live_bytes += l.live_bytes;
+    s.evicted_regions += l.evicted_regions;
+    s.evicted_blocks += l.evicted_blocks;
+    s.spilled_regions += l.spilled_regions;
+    s.restored_regions += l.restored_regions;
+    s.spill_errors += l.spill_errors;
+    s.spill_compaction_errors += l.spill_compaction_errors;
+    s.spill_bytes_written += l.spill_bytes_written;
+    s.spill_bytes_read += l.spill_bytes_read;
+    s.spill_file_bytes += l.spill_file_bytes;
+    s.blocks_allocated += l.blocks_allocated;
+    s.blocks_released += l.blocks_released;
+    s.regions_allocated += l.regions_allocated;
+    s.regions_reused += l.regions_reused;
+  }
+  return s;
+}
+
+MultiResIntegrator::MultiResIntegrator(MultiResMap& map, RayIntegratorConfig cfg) : pool_(cfg.threads) {
+  levels_.reserve(static_cast<std::size_t>(map.num_levels()));
+  for (int i = 0; i < map.num_levels(); ++i) {
+    RayIntegratorConfig c = cfg;
+    if (map.num_levels() > 1) {
+      c.band_center = map.params().center;
+      c.band_min_m = map.band_min_m(i);
+      c.band_max_m = map.band_max_m(i);
+    }
+    levels_.push_back(std::make_unique<RayIntegrator>(map.level(i), c, pool_));
+  }
+}
+
+void MultiResIntegrator::integrate(const Vec3f& origin, ConstPointView points) {
+  for (auto& level : levels_) level->integrate(origin, points);
+}
+
+void MultiResIntegrator::integrate(std::span<const RayBundle> bundles) {
+  for (auto& level : levels_) level->integrate(bundles);
+}
+
+void MultiResIntegrator::integrate_scan(const TransformSE3& T_map_lidar, ConstPointView lidar_points) {
+  transform_points(T_map_lidar, lidar_points, transformed_);
+  integrate(translation(T_map_lidar), transformed_.view());
+}
+
+RayIntegratorStats MultiResIntegrator::stats() const noexcept {
+  RayIntegratorStats s;
+  for (const auto& level : levels_) {
+    const RayIntegratorStats& l = level->stats();
+    s.rays = l.rays;
+    s.rays_skipped += l.rays_skipped;
+    s.hits += l.hits;
+    s.misses += l.misses;
+    s.voxel_steps += l.voxel_steps;
+    s.blocks_touched += l.blocks_touched;
+    s.traverse_ns += l.traverse_ns;
+    s.allocate_ns += l.allocate_ns;
+    s.apply_ns += l.apply_ns;
+  }
+  return s;
+}
+
+}  // namespace wm
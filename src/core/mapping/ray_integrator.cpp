@@ -0,0 +1,482 @@
+// File: src/core/mapping/ray_integrator.cpp
+#include "wm/core/mapping/ray_integrator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "wm/core/geom/point_transform.hpp"
+
+namespace wm {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::int64_t elapsed_ns(Clock::time_point t0, Clock::time_point t1) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+}
+
+// Clips the segment a + t*(b - a), t in [t0, t1], to the box (slab method).
+bool clip_segment(const Vec3f& a, const Vec3f& d, const AABB& box, float& t0, float& t1) noexcept {
+  const float o[3] = {a.x, a.y, a.z};
+  const float v[3] = {d.x, d.y, d.z};
+  const float lo[3] = {box.min.x, box.min.y, box.min.z};
+  const float hi[3] = {box.max.x, box.max.y, box.max.z};
+  for (int k = 0; k < 3; ++k) {
+    if (v[k] == 0.0f) {
+      if (o[k] < lo[k] || o[k] >= hi[k]) return false;
+      continue;
+    }
+    const float inv = 1.0f / v[k];
+    float ta = (lo[k] - o[k]) * inv;
+    float tb = (hi[k] - o[k]) * inv;
+    if (ta > tb) std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    if (t0 > t1) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+RayIntegratorConfig RayIntegratorConfig::from_config(const MappingConfig& m) {
+  RayIntegratorConfig c;
+  c.threads = m.integrate_threads;
+  c.min_range_m = m.min_range_m;
+  c.max_range_m = m.max_range_m;
+  c.rays_per_batch = static_cast<std::size_t>(m.integrate_pass_rays);
+  return c;
+}
+
+RayIntegrator::RayIntegrator(VoxelBlockMap& map, RayIntegratorConfig cfg)
+    : map_(map), cfg_(cfg), owned_pool_(std::make_unique<ThreadPool>(cfg.threads)), pool_(owned_pool_.get()) {
+  init();
+}
+
+RayIntegrator::RayIntegrator(VoxelBlockMap& map, RayIntegratorConfig cfg, ThreadPool& pool)
+    : map_(map), cfg_(cfg), pool_(&pool) {
+  init();
+}
+
+void RayIntegrator::init() {
+  cfg_.rays_per_batch = std::max<std::size_t>(cfg_.rays_per_batch, 1);
+  // A few ranges per thread keeps threads busy when ray lengths differ a lot.
+  scratch_.resize(static_cast<std::size_t>(pool_->size()) * 4);
+  for (auto& s : scratch_) {
+    s.buckets.resize(map_.num_shards());
+    s.new_blocks.resize(map_.num_shards());
+  }
+  partitions_.resize(map_.num_shards());
+}
+
+void RayIntegrator::integrate_scan(const TransformSE3& T_map_lidar, ConstPointView lidar_points) {
+  transform_points(T_map_lidar, lidar_points, transformed_);
+  integrate(translation(T_map_lidar), transformed_.view());
+}
+
+int RayIntegrator::band_pieces(const Vec3f& origin, const Vec3f& d, float t0, float t1,
+                               float (&pieces)[2][2]) const noexcept {
+  // |e + t*d|^2 < r^2 for t strictly between the roots, e = origin - band_center.
+  const Vec3f e{origin.x - cfg_.band_center.x, origin.y - cfg_.band_center.y, origin.z - cfg_.band_center.z};
+  const float dd = d.x * d.x + d.y * d.y + d.z * d.z;
+  const float ed = e.x * d.x + e.y * d.y + e.z * d.z;
+  const float ee = e.x * e.x + e.y * e.y + e.z * e.z;
+  // Sphere of radius r: false if the ray misses it, else the entry and exit t.
+  const auto sphere = [&](float r, float& lo, float& hi) {
+    const float disc = ed * ed - dd * (ee - r * r);
+    if (!(disc > 0.0f)) return false;
+    const float s = std::sqrt(disc);
+    lo = (-ed - s) / dd;
+    hi = (-ed + s) / dd;
+    return true;
+  };
+
+  if (std::isfinite(cfg_.band_max_m)) {
+    float lo = 0.0f;
+    float hi = 0.0f;
+    if (!sphere(cfg_.band_max_m, lo, hi)) return 0;
+    t0 = std::max(t0, lo);
+    t1 = std::min(t1, hi);
+    if (t0 >= t1) return 0;
+  }
+  float lo = 0.0f;
+  float hi = 0.0f;
+  if (cfg_.band_min_m <= 0.0f || !sphere(cfg_.band_min_m, lo, hi) || hi <= t0 || lo >= t1) {
+    pieces[0][0] = t0;
+    pieces[0][1] = t1;
+    return 1;
+  }
+  int n = 0;
+  if (lo > t0) {
+    pieces[n][0] = t0;
+    pieces[n][1] = lo;
+    ++n;
+  }
+  if (hi < t1) {
+    pieces[n][0] = hi;
+    pieces[n][1] = t1;
+    ++n;
+  }
+  return n;
+}
+
+void RayIntegrator::traverse_range(const Vec3f& origin, ConstPointView pts, std::size_t begin,
+                                   std::size_t end, Scratch& s) const {
+  const float inv_vs = 1.0f / map_.voxel_size();
+  const std::int32_t B = map_.block_size();
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+
+  // Rays are always clipped to the space block keys can address (a voxel outside it has no
+  // block), and to the ROI as well with clip_to_roi.
+  AABB clip = map_.key_extent();
+  if (cfg_.clip_to_roi) {
+    const AABB& roi = map_.params().roi;
+    clip.min = Vec3f{std::max(clip.min.x, roi.min.x), std::max(clip.min.y, roi.min.y),
+                     std::max(clip.min.z, roi.min.z)};
+    clip.max = Vec3f{std::min(clip.max.x, roi.max.x), std::min(clip.max.y, roi.max.y),
+                     std::min(clip.max.z, roi.max.z)};
+  }
+  // Clip box in voxel coordinates (inclusive), used to keep clipped endpoints inside it.
+  const std::int32_t vlo[3] = {map_.voxel_coord(clip.min.x), map_.voxel_coord(clip.min.y),
+                               map_.voxel_coord(clip.min.z)};
+  const std::int32_t vhi[3] = {static_cast<std::int32_t>(std::ceil(clip.max.x * inv_vs)) - 1,
+                               static_cast<std::int32_t>(std::ceil(clip.max.y * inv_vs)) - 1,
+                               static_cast<std::int32_t>(std::ceil(clip.max.z * inv_vs)) - 1};
+
+  // Current run: consecutive voxels of one ray inside one block (see Scratch::buckets).
+  std::vector<std::uint32_t>* run = nullptr;
+  std::size_t run_header = 0;
+  std::uint64_t last_new = ~std::uint64_t{0};
+  const auto open_run = [&](const std::int32_t bk[3]) {
+    const BlockKey k{bk[0], bk[1], bk[2]};
+    const std::uint64_t key = pack_block_key(k);
+    const std::size_t shard = map_.shard_of(k);
+    // Read-only probe: the map is not modified while rays are traversed. Existing blocks
+    // travel with their index so the apply phase does not probe the table again.
+    const BlockIndex block = map_.find(k);
+    if (block == kInvalidBlock && key != last_new) {
+      s.new_blocks[shard].push_back(key);
+      last_new = key;
+    }
+    run = &s.buckets[shard];
+    run_header = run->size();
+    run->push_back(static_cast<std::uint32_t>(key));
+    run->push_back(static_cast<std::uint32_t>(key >> 32));
+    run->push_back(block);
+    run->push_back(0);
+  };
+  const auto close_run = [&] {
+    (*run)[run_header + 3] = static_cast<std::uint32_t>(run->size() - run_header - kRunHeader);
+  };
+
+  // Steps the voxels of origin + t * d, t in [t0, t1]; the last one is a hit if `hit`.
+  const auto walk = [&](const Vec3f& d, float t0, float t1, bool hit) {
+    // Endpoints in voxel units.
+    const float a[3] = {(origin.x + t0 * d.x) * inv_vs, (origin.y + t0 * d.y) * inv_vs,
+                        (origin.z + t0 * d.z) * inv_vs};
+    const float b[3] = {(origin.x + t1 * d.x) * inv_vs, (origin.y + t1 * d.y) * inv_vs,
+                        (origin.z + t1 * d.z) * inv_vs};
+
+    std::int32_t v[3];   // global voxel
+    std::int32_t ve[3];  // end voxel
+    std::int32_t bk[3];  // block of v
+    std::int32_t l[3];   // v inside its block
+    std::int32_t step[3];
+    float t_max[3];
+    float t_delta[3];
+    std::int64_t n = 0;
+    for (int k = 0; k < 3; ++k) {
+      v[k] = std::clamp(saturate_voxel_coord(a[k]), vlo[k], vhi[k]);
+      ve[k] = std::clamp(saturate_voxel_coord(b[k]), vlo[k], vhi[k]);
+      const float dk = b[k] - a[k];
+      n += std::abs(static_cast<std::int64_t>(ve[k]) - v[k]);
+      if (dk > 0.0f) {
+        step[k] = 1;
+        t_delta[k] = 1.0f / dk;
+        t_max[k] = (static_cast<float>(v[k]) + 1.0f - a[k]) * t_delta[k];
+      } else if (dk < 0.0f) {
+        step[k] = -1;
+        t_delta[k] = -1.0f / dk;
+        t_max[k] = (a[k] - static_cast<float>(v[k])) * t_delta[k];
+      } else {
+        step[k] = 0;
+        t_delta[k] = kInf;
+        t_max[k] = kInf;
+      }
+    }
+    const BlockKey bk0 = map_.block_of_voxel(v[0], v[1], v[2]);
+    bk[0] = bk0.x;
+    bk[1] = bk0.y;
+    bk[2] = bk0.z;
+    for (int k = 0; k < 3; ++k) l[k] = v[k] - bk[k] * B;
+    const auto local_index = [&] {
+      return map_.voxel_index(static_cast<std::uint32_t>(l[0]), static_cast<std::uint32_t>(l[1]),
+                              static_cast<std::uint32_t>(l[2]));
+    };
+    std::uint32_t off = local_index();
+
+    // Exactly n face crossings lead from the start voxel to the end voxel. Block-local
+    // coordinates are stepped incrementally, so the loop has no divisions.
+    open_run(bk);
+    for (std::int64_t k = 0; k < n; ++k) {
+      run->push_back(off);
+      int axis = t_max[0] < t_max[1] ? 0 : 1;
+      if (t_max[2] < t_max[axis]) axis = 2;
+      // Guard against float ties steering along an axis that is already done.
+      if (v[axis] == ve[axis]) {
+        axis = v[0] != ve[0] ? 0 : (v[1] != ve[1] ? 1 : 2);
+      }
+      v[axis] += step[axis];
+      t_max[axis] += t_delta[axis];
+      l[axis] += step[axis];
+      if (l[axis] < 0 || l[axis] >= B) {
+        l[axis] = step[axis] > 0 ? 0 : B - 1;
+        bk[axis] += step[axis];
+        close_run();
+        open_run(bk);
+      }
+      off = local_index();
+    }
+    run->push_back(off | (hit ? kHitBit : 0u));
+    close_run();
+    s.voxel_steps += n + 1;
+  };
+
+  const bool banded = cfg_.band_min_m > 0.0f || std::isfinite(cfg_.band_max_m);
+
+  for (std::size_t i = begin; i < end; ++i) {
+    const PointXYZI p = pts.at(i);
+    const Vec3f d{p.x - origin.x, p.y - origin.y, p.z - origin.z};
+    const float len = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    if (!(len >= cfg_.min_range_m) || !std::isfinite(len)) {
+      ++s.skipped;
+      continue;
+    }
+
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+    bool hit = true;
+    if (len > cfg_.max_range_m) {
+      t1 = cfg_.max_range_m / len;
+      hit = false;
+    }
+    const float t1_before = t1;
+    if (!clip_segment(origin, d, clip, t0, t1)) {
+      ++s.skipped;
+      continue;
+    }
+    if (t1 < t1_before) hit = false;
+
+    if (!banded) {
+      walk(d, t0, t1, hit);
+      continue;
+    }
+    // Restrict to the range band. The return stays a hit only if it lies in the band, and
+    // then it ends the last piece.
+    float pieces[2][2];
+    const int num_pieces = band_pieces(origin, d, t0, t1, pieces);
+    if (num_pieces == 0) {
+      ++s.skipped;
+      continue;
+    }
+    if (hit) {
+      const float ex = p.x - cfg_.band_center.x;
+      const float ey = p.y - cfg_.band_center.y;
+      const float ez = p.z - cfg_.band_center.z;
+      const float r2 = ex * ex + ey * ey + ez * ez;
+      hit = r2 >= cfg_.band_min_m * cfg_.band_min_m && r2 < cfg_.band_max_m * cfg_.band_max_m;
+      if (hit) pieces[num_pieces - 1][1] = t1;
+    }
+    for (int k = 0; k < num_pieces; ++k) walk(d, pieces[k][0], pieces[k][1], hit && k == num_pieces - 1);
+  }
+}
+
+void RayIntegrator::apply_partition(std::size_t p) {
+  PartitionScratch& ps = partitions_[p];
+  const std::size_t vpb = map_.voxels_per_block();
+  ps.blocks.clear();
+  ps.hits = 0;
+  ps.misses = 0;
+
+  // fn(block, entries, count) for every run of this partition, in ray order.
+  const auto for_each_run = [&](auto&& fn) {
+    for (Scratch& s : scratch_) {
+      const std::vector<std::uint32_t>& bucket = s.buckets[p];
+      for (std::size_t r = 0; r < bucket.size();) {
+        BlockIndex block = bucket[r + 2];
+        if (block == kInvalidBlock) {
+          // Allocated after traversal.
+          const std::uint64_t key = bucket[r] | (static_cast<std::uint64_t>(bucket[r + 1]) << 32);
+          block = map_.find(unpack_block_key(key));
+        }
+        const std::uint32_t count = bucket[r + 3];
+        fn(block, bucket.data() + r + kRunHeader, count);
+        r += kRunHeader + count;
+      }
+    }
+  };
+
+  // Count buffers of a block: hit counts, then miss counts (vpb each). mark_slot_ is shared,
+  // but a block belongs to exactly one partition, so partitions never write the same entry.
+  BlockIndex last_block = kInvalidBlock;
+  std::uint32_t last_slot = 0;
+  std::uint8_t* marks = nullptr;
+  const auto marks_of = [&](BlockIndex block) {
+    if (block != last_block) {
+      std::uint32_t& slot = mark_slot_[block];
+      if (slot == kNoSlot) {
+        slot = static_cast<std::uint32_t>(ps.blocks.size());
+        ps.blocks.push_back(block);
+        ps.updates.push_back(0);
+        if (ps.marks.size() < ps.blocks.size() * 2 * vpb) ps.marks.resize(ps.blocks.size() * 2 * vpb, 0);
+      }
+      last_block = block;
+      last_slot = slot;
+      marks = ps.marks.data() + static_cast<std::size_t>(slot) * 2 * vpb;
+    }
+    return marks;
+  };
+
+  // Pass 1: count each voxel's hits and misses in this pass (saturating at 255).
+  ps.updates.clear();
+  for_each_run([&](BlockIndex block, const std::uint32_t* e, std::uint32_t count) {
+    std::uint8_t* hits = marks_of(block);
+    std::uint8_t* misses = hits + vpb;
+    std::uint32_t& updates = ps.updates[last_slot];
+    for (std::uint32_t i = 0; i < count; ++i) {
+      const std::uint32_t v = e[i] & ~kHitBit;
+      updates += (hits[v] | misses[v]) == 0 ? 1 : 0;
+      std::uint8_t& n = (e[i] & kHitBit) ? hits[v] : misses[v];
+      n += n != 0xff ? 1 : 0;
+    }
+  });
+
+  // Pass 2a: blocks with many updates are applied whole by the saturating SIMD kernel,
+  // which clears their counts (a 512-voxel block is 32 AVX2 steps).
+  const LogOddsModel& model = map_.log_odds_model();
+  const std::size_t dense_divisor = cfg_.simd == SimdLevel::kAvx2 ? 16 : (cfg_.simd == SimdLevel::kSse2 ? 4 : 0);
+  for (std::size_t slot = 0; slot < ps.blocks.size(); ++slot) {
+    if (dense_divisor == 0 || ps.updates[slot] * dense_divisor < vpb) continue;
+    const BlockIndex b = ps.blocks[slot];
+    std::uint8_t* hits = ps.marks.data() + slot * 2 * vpb;
+    const BlockUpdateCounts c = apply_block_updates(model, map_.voxels(b), hits, hits + vpb, vpb, cfg_.simd);
+    map_.refresh_masks(b);
+    ps.hits += c.hits;
+    ps.misses += c.misses;
+    ps.updates[slot] = 0;
+  }
+
+  // Pass 2b: the remaining (sparse) blocks apply each counted voxel once and clear its
+  // counts, walking the same runs so the cost is proportional to the updates. Their
+  // occupancy bits follow voxel by voxel.
+  const auto scatter = [&](auto* cells_of_type) {
+    using Cell = std::remove_pointer_t<decltype(cells_of_type)>;
+    last_block = kInvalidBlock;
+    for_each_run([&](BlockIndex block, const std::uint32_t* e, std::uint32_t count) {
+      std::uint8_t* hits = marks_of(block);
+      std::uint8_t* misses = hits + vpb;
+      if (ps.updates[last_slot] == 0) return;
+      Cell* vox = map_.cells<Cell>(block);
+      for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint32_t v = e[i] & ~kHitBit;
+        if ((hits[v] | misses[v]) == 0) continue;
+        const std::int32_t sum = vox[v] + hits[v] * model.hit + misses[v] * model.miss;
+        vox[v] = static_cast<Cell>(std::clamp(sum, model.min, model.max));
+        map_.note_cell(block, v, vox[v]);
+        ps.hits += hits[v];
+        ps.misses += misses[v];
+        hits[v] = 0;
+        misses[v] = 0;
+      }
+    });
+  };
+  if (model.bits == 8) {
+    scatter(static_cast<std::int8_t*>(nullptr));
+  } else {
+    scatter(static_cast<std::int16_t*>(nullptr));
+  }
+
+  for (const BlockIndex b : ps.blocks) {
+    mark_slot_[b] = kNoSlot;
+    map_.touch(b);  // observed this pass, for the map's memory budget
+    map_.refresh_summary(b);
+  }
+  for (Scratch& s : scratch_) s.buckets[p].clear();
+}
+
+void RayIntegrator::integrate(const Vec3f& origin, ConstPointView points) {
+  const RayBundle bundle{origin, points};
+  integrate(std::span<const RayBundle>(&bundle, 1));
+}
+
+void RayIntegrator::integrate(std::span<const RayBundle> bundles) {
+  // Rays are numbered across bundles; passes and task ranges ignore bundle boundaries.
+  bundle_start_.resize(bundles.size() + 1);
+  bundle_start_[0] = 0;
+  for (std::size_t i = 0; i < bundles.size(); ++i) bundle_start_[i + 1] = bundle_start_[i] + bundles[i].points.size;
+  const std::size_t total = bundle_start_.back();
+  stats_.rays += static_cast<std::int64_t>(total);
+  const std::size_t tasks = scratch_.size();
+
+  for (std::size_t base = 0; base < total; base += cfg_.rays_per_batch) {
+    const std::size_t count = std::min(cfg_.rays_per_batch, total - base);
+    const std::size_t per_task = (count + tasks - 1) / tasks;
+
+    // 1. Traverse.
+    const auto t0 = Clock::now();
+    pool_->parallel_for(tasks, [&](std::size_t t, int) {
+      const std::size_t b = base + std::min(count, t * per_task);
+      const std::size_t e = base + std::min(count, (t + 1) * per_task);
+      // Bundles overlapping [b, e), each from its own origin.
+      std::size_t i = static_cast<std::size_t>(
+          std::upper_bound(bundle_start_.begin(), bundle_start_.end(), b) - bundle_start_.begin() - 1);
+      for (std::size_t r = b; r < e; ++i) {
+        const std::size_t first = bundle_start_[i];
+        const std::size_t end = std::min(e, bundle_start_[i + 1]);
+        if (end > r) traverse_range(bundles[i].origin, bundles[i].points, r - first, end - first, scratch_[t]);
+        r = std::max(r, end);
+      }
+    });
+
+    // 2. Allocate new blocks, one map shard per task (in task order, so block indices do
+    //    not depend on scheduling).
+    const auto t1 = Clock::now();
+    map_.insert_sharded(*pool_, [&](std::size_t shard, auto&& add) {
+      for (Scratch& s : scratch_) {
+        for (const std::uint64_t key : s.new_blocks[shard]) add(key);
+        s.new_blocks[shard].clear();
+      }
+    });
+    if (mark_slot_.size() < map_.block_capacity()) mark_slot_.resize(map_.block_capacity(), kNoSlot);
+
+    // 3. Apply, one map shard per task.
+    const auto t2 = Clock::now();
+    pool_->parallel_for(partitions_.size(), [&](std::size_t p, int) { apply_partition(p); });
+    const auto t3 = Clock::now();
+
+    // 4. Evict stale regions if the map is over its memory budget (no block indices are
+    //    held across passes).
+    map_.enforce_memory_budget();
+    const auto t4 = Clock::now();
+    stats_.traverse_ns += elapsed_ns(t0, t1);
+    stats_.allocate_ns += elapsed_ns(t1, t2) + elapsed_ns(t3, t4);
+    stats_.apply_ns += elapsed_ns(t2, t3);
+
+    for (Scratch& s : scratch_) {
+      stats_.voxel_steps += s.voxel_steps;
+      stats_.rays_skipped += s.skipped;
+      s.voxel_steps = s.skipped = 0;
+    }
+    for (const PartitionScratch& ps : partitions_) {
+      stats_.hits += ps.hits;
+      stats_.misses += ps.misses;
+      stats_.blocks_touched += static_cast<std::int64_t>(ps.blocks.size());
+    }
+  }
+}
+
+}  // namespace wm
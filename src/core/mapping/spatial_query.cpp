@@ -0,0 +1,420 @@
+// File: src/core/mapping/spatial_query.cpp
+#include "wm/core/mapping/spatial_query.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace wm {
+
+namespace {
+
+constexpr std::int64_t kKeyBias = std::int64_t{1} << (kBlockKeyBits - 1);
+constexpr std::uint64_t kKeyMask = (std::uint64_t{1} << kBlockKeyBits) - 1;
+// Sorts after every block key and matches none.
+constexpr std::uint64_t kNoBlock = ~std::uint64_t{0};
+
+std::int64_t floor_div(std::int64_t v, std::int64_t b) noexcept {
+  const std::int64_t q = v / b;
+  return (v % b != 0 && v < 0) ? q - 1 : q;
+}
+
+// Voxel coordinates of p. False for NaN, infinite or huge coordinates, whose float to
+// int64 cast would be undefined (a finite coordinate passing this can still lie outside
+// the block key range; callers check that).
+bool voxel_of(const Vec3f& p, float inv_voxel_size, std::int64_t* v) noexcept {
+  const float f[3] = {std::floor(p.x * inv_voxel_size), std::floor(p.y * inv_voxel_size),
+                      std::floor(p.z * inv_voxel_size)};
+  for (int a = 0; a < 3; ++a) {
+    if (!(std::fabs(f[a]) < 0x1p62f)) return false;
+    v[a] = static_cast<std::int64_t>(f[a]);
+  }
+  return true;
+}
+
+// First index >= from with keys[index] >= key: exponential then binary search, so a
+// forward merge pays O(log distance) per step instead of O(log n).
+std::size_t gallop(const std::vector<std::uint64_t>& keys, std::size_t from, std::uint64_t key) noexcept {
+  std::size_t lo = from;
+  std::size_t step = 1;
+  std::size_t hi = from;
+  while (hi < keys.size() && keys[hi] < key) {
+    lo = hi + 1;
+    hi += step;
+    step *= 2;
+  }
+  hi = std::min(hi, keys.size());
+  return static_cast<std::size_t>(std::lower_bound(keys.begin() + static_cast<std::ptrdiff_t>(lo),
+                                                   keys.begin() + static_cast<std::ptrdiff_t>(hi), key) -
+                                  keys.begin());
+}
+
+VoxelState state_of(const std::uint64_t* occupied, const std::uint64_t* known, std::uint32_t offset) noexcept {
+  const std::uint64_t bit = std::uint64_t{1} << (offset % 64);
+  if ((occupied[offset / 64] & bit) != 0) return VoxelState::kOccupied;
+  return (known[offset / 64] & bit) != 0 ? VoxelState::kFree : VoxelState::kUnknown;
+}
+
+}  // namespace
+
+// -----------------------------
+// OccupancySnapshot
+// -----------------------------
+
+std::shared_ptr<const OccupancySnapshot> OccupancySnapshot::capture(const VoxelBlockMap& map, std::uint64_t sequence) {
+  std::shared_ptr<OccupancySnapshot> s(new OccupancySnapshot());
+  s->voxel_size_ = map.voxel_size();
+  s->inv_voxel_size_ = 1.0f / map.voxel_size();
+  s->block_size_ = map.block_size();
+  s->words_ = map.mask_words();
+  s->sequence_ = sequence;
+
+  // Geometry tables, from the map's voxel order.
+  const auto b = static_cast<std::uint32_t>(s->block_size_);
+  const std::size_t w = s->words_;
+  s->axis_index_.resize(3 * std::size_t{b});
+  for (std::uint32_t l = 0; l < b; ++l) {
+    s->axis_index_[l] = map.voxel_index(l, 0, 0);
+    s->axis_index_[b + l] = map.voxel_index(0, l, 0);
+    s->axis_index_[2 * b + l] = map.voxel_index(0, 0, l);
+  }
+  s->local_.resize(3 * map.voxels_per_block());
+  for (std::uint32_t lz = 0; lz < b; ++lz) {
+    for (std::uint32_t ly = 0; ly < b; ++ly) {
+      for (std::uint32_t lx = 0; lx < b; ++lx) {
+        const std::size_t o = map.voxel_index(lx, ly, lz);
+        s->local_[3 * o] = static_cast<std::uint16_t>(lx);
+        s->local_[3 * o + 1] = static_cast<std::uint16_t>(ly);
+        s->local_[3 * o + 2] = static_cast<std::uint16_t>(lz);
+      }
+    }
+  }
+  // ranges_[axis][lo][hi] = ranges_[axis][lo][hi - 1] | (offsets with coordinate hi).
+  std::vector<std::uint64_t> at(3 * std::size_t{b} * w, 0);  // [axis * B + l]: coordinate l
+  for (std::size_t o = 0; o < map.voxels_per_block(); ++o) {
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      at[(axis * b + s->local_[3 * o + axis]) * w + o / 64] |= std::uint64_t{1} << (o % 64);
+    }
+  }
+  s->ranges_.assign(3 * std::size_t{b} * b * w, 0);
+  for (int axis = 0; axis < 3; ++axis) {
+    for (std::uint32_t lo = 0; lo < b; ++lo) {
+      for (std::uint32_t hi = lo; hi < b; ++hi) {
+        std::uint64_t* m =
+            s->ranges_.data() + s->range_at(axis, static_cast<std::int32_t>(lo), static_cast<std::int32_t>(hi));
+        const std::uint64_t* add = at.data() + (static_cast<std::size_t>(axis) * b + hi) * w;
+        for (std::size_t j = 0; j < w; ++j) m[j] = (hi > lo ? m[j - w] : 0) | add[j];
+      }
+    }
+  }
+
+  // Blocks with a known voxel, in key order.
+  std::vector<std::pair<std::uint64_t, BlockIndex>> order;
+  order.reserve(map.num_blocks());
+  map.for_each_block([&](const BlockKey& k, BlockIndex i) {
+    const std::uint64_t* known = map.known_mask(i);
+    for (std::size_t j = 0; j < w; ++j) {
+      if (known[j] != 0) {
+        order.emplace_back(order_key(k.x, k.y, k.z), i);
+        return;
+      }
+    }
+  });
+  std::sort(order.begin(), order.end());
+  s->keys_.resize(order.size());
+  s->masks_.resize(order.size() * 2 * w);
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    s->keys_[i] = order[i].first;
+    // occupied_mask(b) is followed by known_mask(b).
+    std::memcpy(s->masks_.data() + i * 2 * w, map.occupied_mask(order[i].second), 2 * w * sizeof(std::uint64_t));
+  }
+  return s;
+}
+
+std::size_t OccupancySnapshot::memory_bytes() const noexcept {
+  return sizeof(*this) + keys_.capacity() * sizeof(std::uint64_t) + masks_.capacity() * sizeof(std::uint64_t) +
+         axis_index_.capacity() * sizeof(std::uint32_t) + local_.capacity() * sizeof(std::uint16_t) +
+         ranges_.capacity() * sizeof(std::uint64_t);
+}
+
+std::size_t OccupancySnapshot::find(std::uint64_t key) const noexcept {
+  const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  return it != keys_.end() && *it == key ? static_cast<std::size_t>(it - keys_.begin()) : keys_.size();
+}
+
+VoxelState OccupancySnapshot::state(const Vec3f& p) const noexcept {
+  std::int64_t v[3];
+  if (!voxel_of(p, inv_voxel_size_, v)) return VoxelState::kUnknown;
+  std::int64_t k[3];
+  for (int a = 0; a < 3; ++a) {
+    k[a] = floor_div(v[a], block_size_);
+    if (k[a] < kBlockKeyMin || k[a] > kBlockKeyMax) return VoxelState::kUnknown;
+  }
+  const std::size_t i = find(order_key(k[0], k[1], k[2]));
+  if (i == keys_.size()) return VoxelState::kUnknown;
+  const std::uint32_t o = offset(static_cast<std::int32_t>(v[0] - k[0] * block_size_),
+                                 static_cast<std::int32_t>(v[1] - k[1] * block_size_),
+                                 static_cast<std::int32_t>(v[2] - k[2] * block_size_));
+  return state_of(occupied(i), known(i), o);
+}
+
+// -----------------------------
+// SpatialQuery
+// -----------------------------
+
+void SpatialQuery::states(const OccupancySnapshot& snap, std::span<const Vec3f> points, std::span<VoxelState> out) {
+  const std::int64_t b = snap.block_size_;
+  const float inv = snap.inv_voxel_size_;
+  points_.resize(points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    std::int64_t v[3] = {0, 0, 0};
+    std::int64_t k[3] = {0, 0, 0};
+    bool in_range = voxel_of(points[i], inv, v);
+    for (int a = 0; a < 3 && in_range; ++a) {
+      k[a] = floor_div(v[a], b);
+      in_range = k[a] >= kBlockKeyMin && k[a] <= kBlockKeyMax;
+    }
+    PointItem& item = points_[i];
+    item.query = static_cast<std::uint32_t>(i);
+    item.key = in_range ? OccupancySnapshot::order_key(k[0], k[1], k[2]) : kNoBlock;
+    item.offset = in_range ? snap.offset(static_cast<std::int32_t>(v[0] - k[0] * b),
+                                         static_cast<std::int32_t>(v[1] - k[1] * b),
+                                         static_cast<std::int32_t>(v[2] - k[2] * b))
+                           : 0;
+  }
+  std::sort(points_.begin(), points_.end(), [](const PointItem& a, const PointItem& c) { return a.key < c.key; });
+
+  // One forward merge: each distinct block is located once.
+  const std::vector<std::uint64_t>& keys = snap.keys_;
+  std::size_t cur = 0;
+  std::uint64_t cur_key = kNoBlock;
+  bool found = false;
+  for (const PointItem& item : points_) {
+    if (item.key != cur_key) {
+      cur_key = item.key;
+      cur = gallop(keys, cur, item.key);
+      found = cur < keys.size() && keys[cur] == item.key;
+    }
+    out[item.query] = found ? state_of(snap.occupied(cur), snap.known(cur), item.offset) : VoxelState::kUnknown;
+  }
+}
+
+void SpatialQuery::boxes(const OccupancySnapshot& snap, std::span<const AABB> boxes, std::span<BoxQueryResult> out,
+                         std::vector<OccupiedVoxel>* occupied) {
+  const std::int32_t bs = snap.block_size_;
+  const float inv = snap.inv_voxel_size_;
+  // Voxels a block key can address, per axis.
+  const std::int64_t vmin = std::int64_t{kBlockKeyMin} * bs;
+  const std::int64_t vmax = (std::int64_t{kBlockKeyMax} + 1) * bs - 1;
+
+  ranges_.resize(boxes.size());
+  order_.clear();
+  for (std::size_t q = 0; q < boxes.size(); ++q) {
+    const AABB& box = boxes[q];
+    BoxRange& r = ranges_[q];
+    out[q] = BoxQueryResult{};
+    const float lo[3] = {box.min.x, box.min.y, box.min.z};
+    const float hi[3] = {box.max.x, box.max.y, box.max.z};
+    bool empty = false;
+    std::uint64_t voxels = 1;
+    for (int a = 0; a < 3; ++a) {
+      if (!std::isfinite(lo[a]) || !std::isfinite(hi[a])) {
+        empty = true;
+        break;
+      }
+      const std::int64_t v0 = std::clamp(static_cast<std::int64_t>(std::floor(lo[a] * inv)), vmin, vmax);
+      const std::int64_t v1 = std::clamp(static_cast<std::int64_t>(std::ceil(hi[a] * inv)) - 1, vmin, vmax);
+      if (v1 < v0) {
+        empty = true;
+        break;
+      }
+      r.v0[a] = static_cast<std::int32_t>(v0);
+      r.v1[a] = static_cast<std::int32_t>(v1);
+      r.b0[a] = static_cast<std::int32_t>(floor_div(v0, bs));
+      r.b1[a] = static_cast<std::int32_t>(floor_div(v1, bs));
+      // Up to 2^24 voxels per axis at 8-voxel blocks: the product can exceed 64 bits.
+      const auto n = static_cast<std::uint64_t>(v1 - v0 + 1);
+      voxels = voxels > std::numeric_limits<std::uint64_t>::max() / n ? std::numeric_limits<std::uint64_t>::max()
+                                                                       : voxels * n;
+    }
+    if (empty) continue;
+    out[q].voxels = voxels;
+    order_.push_back(BoxItem{OccupancySnapshot::order_key(r.b0[0], r.b0[1], r.b0[2]), static_cast<std::uint32_t>(q)});
+  }
+  std::sort(order_.begin(), order_.end(),
+            [](const BoxItem& a, const BoxItem& c) { return a.key != c.key ? a.key < c.key : a.query < c.query; });
+
+  // Boxes sorted by first block: the start cursor only moves forward. Each box then walks
+  // the snapshot's blocks between its first and last key, galloping over the parts of
+  // that key range outside its x and y range, so it costs its observed blocks and rows
+  // rather than every row it spans.
+  const std::vector<std::uint64_t>& keys = snap.keys_;
+  const std::size_t w = snap.words_;
+  const float v = snap.voxel_size_;
+  const float e = v * static_cast<float>(bs);
+  std::size_t start = 0;
+  for (const BoxItem& item : order_) {
+    start = gallop(keys, start, item.key);
+    const BoxRange& r = ranges_[item.query];
+    BoxQueryResult& res = out[item.query];
+    const std::uint64_t last = OccupancySnapshot::order_key(r.b1[0], r.b1[1], r.b1[2]);
+    std::size_t i = start;
+    while (i < keys.size() && keys[i] <= last) {
+      const std::int32_t k[3] = {static_cast<std::int32_t>(static_cast<std::int64_t>(keys[i] & kKeyMask) - kKeyBias),
+                                 static_cast<std::int32_t>(
+                                     static_cast<std::int64_t>((keys[i] >> kBlockKeyBits) & kKeyMask) - kKeyBias),
+                                 static_cast<std::int32_t>(
+                                     static_cast<std::int64_t>(keys[i] >> (2 * kBlockKeyBits)) - kKeyBias)};
+      // Keys order by z, then y, then x, and z is inside the box here. Outside its y or x
+      // range, skip to the next key where a row inside the box could start.
+      bool skip = true;
+      std::uint64_t next = 0;
+      if (k[1] < r.b0[1]) {
+        next = OccupancySnapshot::order_key(r.b0[0], r.b0[1], k[2]);
+      } else if (k[1] > r.b1[1] || (k[0] > r.b1[0] && k[1] == r.b1[1])) {
+        next = OccupancySnapshot::order_key(r.b0[0], r.b0[1], std::int64_t{k[2]} + 1);
+      } else if (k[0] < r.b0[0]) {
+        next = OccupancySnapshot::order_key(r.b0[0], k[1], k[2]);
+      } else if (k[0] > r.b1[0]) {
+        next = OccupancySnapshot::order_key(r.b0[0], std::int64_t{k[1]} + 1, k[2]);
+      } else {
+        skip = false;
+      }
+      if (skip) {
+        i = gallop(keys, i + 1, next);
+        continue;
+      }
+      // The box's voxel range inside this block.
+      std::int32_t l0[3];
+      std::int32_t l1[3];
+      bool whole = true;
+      for (int a = 0; a < 3; ++a) {
+        l0[a] = std::max(r.v0[a] - k[a] * bs, 0);
+        l1[a] = std::min(r.v1[a] - k[a] * bs, bs - 1);
+        whole = whole && l0[a] == 0 && l1[a] == bs - 1;
+      }
+      const std::uint64_t* occ = snap.occupied(i);
+      const std::uint64_t* kn = snap.known(i);
+      const std::uint64_t* mx = whole ? nullptr : snap.axis_range(0, l0[0], l1[0]);
+      const std::uint64_t* my = whole ? nullptr : snap.axis_range(1, l0[1], l1[1]);
+      const std::uint64_t* mz = whole ? nullptr : snap.axis_range(2, l0[2], l1[2]);
+      for (std::size_t j = 0; j < w; ++j) {
+        const std::uint64_t m = whole ? ~std::uint64_t{0} : mx[j] & my[j] & mz[j];
+        const std::uint64_t o = occ[j] & m;
+        res.occupied += static_cast<std::uint64_t>(std::popcount(o));
+        res.known += static_cast<std::uint64_t>(std::popcount(kn[j] & m));
+        if (occupied == nullptr) continue;
+        for (std::uint64_t bits = o; bits != 0; bits &= bits - 1) {
+          const std::size_t off = j * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+          const std::uint16_t* l = snap.local_.data() + 3 * off;
+          occupied->push_back(OccupiedVoxel{
+              Vec3f{static_cast<float>(k[0]) * e + (static_cast<float>(l[0]) + 0.5f) * v,
+                    static_cast<float>(k[1]) * e + (static_cast<float>(l[1]) + 0.5f) * v,
+                    static_cast<float>(k[2]) * e + (static_cast<float>(l[2]) + 0.5f) * v},
+              item.query});
+        }
+      }
+      ++i;
+    }
+  }
+}
+
+void SpatialQuery::states(const MultiResOccupancySnapshot& snap, std::span<const Vec3f> points,
+                          std::span<VoxelState> out) {
+  if (snap.num_levels() == 1) {
+    states(snap.level(0), points, out);
+    return;
+  }
+  for (int l = 0; l < snap.num_levels(); ++l) {
+    level_index_.clear();
+    level_points_.clear();
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      if (snap.level_of(points[i]) != l) continue;
+      level_index_.push_back(static_cast<std::uint32_t>(i));
+      level_points_.push_back(points[i]);
+    }
+    if (level_index_.empty()) continue;
+    level_states_.resize(level_points_.size());
+    states(snap.level(l), level_points_, level_states_);
+    for (std::size_t j = 0; j < level_index_.size(); ++j) out[level_index_[j]] = level_states_[j];
+  }
+}
+
+void SpatialQuery::boxes(const MultiResOccupancySnapshot& snap, std::span<const AABB> boxes,
+                         std::span<BoxQueryResult> out, std::vector<OccupiedVoxel>* occupied) {
+  if (snap.num_levels() == 1) {
+    this->boxes(snap.level(0), boxes, out, occupied);
+    return;
+  }
+  for (int l = 0; l < snap.num_levels(); ++l) {
+    level_index_.clear();
+    level_boxes_.clear();
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+      if (snap.level_of(boxes[i]) != l) continue;
+      level_index_.push_back(static_cast<std::uint32_t>(i));
+      level_boxes_.push_back(boxes[i]);
+    }
+    if (level_index_.empty()) continue;
+    level_results_.resize(level_boxes_.size());
+    const std::size_t first = occupied != nullptr ? occupied->size() : 0;
+    this->boxes(snap.level(l), level_boxes_, level_results_, occupied);
+    for (std::size_t j = 0; j < level_index_.size(); ++j) out[level_index_[j]] = level_results_[j];
+    if (occupied == nullptr) continue;
+    for (std::size_t j = first; j < occupied->size(); ++j) (*occupied)[j].query = level_index_[(*occupied)[j].query];
+  }
+}
+
+// -----------------------------
+// MultiResOccupancySnapshot
+// -----------------------------
+
+std::shared_ptr<const MultiResOccupancySnapshot> MultiResOccupancySnapshot::capture(const MultiResMap& map,
+                                                                                    std::uint64_t sequence) {
+  std::shared_ptr<MultiResOccupancySnapshot> s(new MultiResOccupancySnapshot());
+  s->center_ = map.params().center;
+  s->sequence_ = sequence;
+  for (int i = 0; i < map.num_levels(); ++i) {
+    s->band_max_.push_back(map.band_max_m(i));
+    s->levels_.push_back(OccupancySnapshot::capture(map.level(i), sequence));
+  }
+  return s;
+}
+
+std::size_t MultiResOccupancySnapshot::num_blocks() const noexcept {
+  std::size_t n = 0;
+  for (const auto& l : levels_) n += l->num_blocks();
+  return n;
+}
+
+std::size_t MultiResOccupancySnapshot::memory_bytes() const noexcept {
+  std::size_t n = sizeof(*this) + band_max_.capacity() * sizeof(float);
+  for (const auto& l : levels_) n += l->memory_bytes();
+  return n;
+}
+
+int MultiResOccupancySnapshot::level_of(const Vec3f& p) const noexcept {
+  // MultiResMap::level_of on the captured bands.
+  const float dx = p.x - center_.x;
+  const float dy = p.y - center_.y;
+  const float dz = p.z - center_.z;
+  const float r2 = dx * dx + dy * dy + dz * dz;
+  int i = 0;
+  while (i + 1 < num_levels()) {
+    const float hi = band_max_[static_cast<std::size_t>(i)];
+    if (r2 < hi * hi) break;
+    ++i;
+  }
+  return i;
+}
+
+int MultiResOccupancySnapshot::level_of(const AABB& box) const noexcept {
+  // Nearest point of the box to the center (not std::clamp: an inverted box is allowed).
+  const auto nearest = [](float c, float lo, float hi) { return std::max(lo, std::min(c, hi)); };
+  return level_of(Vec3f{nearest(center_.x, box.min.x, box.max.x), nearest(center_.y, box.min.y, box.max.y),
+                        nearest(center_.z, box.min.z, box.max.z)});
+}
+
+}  // namespace wm
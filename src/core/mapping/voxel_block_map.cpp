@@ -0,0 +1,595 @@
+// File: src/core/mapping/voxel_block_map.cpp
+#include "wm/core/mapping/voxel_block_map.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "wm/core/geom/morton.hpp"
+
+namespace wm {
+
+VoxelBlockMapParams VoxelBlockMapParams::from_config(const MappingConfig& m) {
+  VoxelBlockMapParams p;
+  p.voxel_size_m = m.voxel_size_m;
+  p.block_size_vox = m.block_size_vox;
+  p.region_size_blocks = m.region_size_blocks;
+  p.morton_voxels = m.morton_voxels;
+  p.shards = m.map_shards;
+  p.roi = AABB{m.roi.min, m.roi.max};
+  p.log_odds_bits = m.log_odds_bits;
+  p.log_odds_hit = m.log_odds_hit;
+  p.log_odds_miss = m.log_odds_miss;
+  p.log_odds_min = m.log_odds_min;
+  p.log_odds_max = m.log_odds_max;
+  p.log_odds_occupied = m.log_odds_occupied;
+  p.log_odds_free = m.log_odds_free;
+  p.memory_budget_bytes = static_cast<std::size_t>(m.map_memory_budget_mb) << 20;
+  p.core = AABB{m.map_core.min, m.map_core.max};
+  p.spill_path = m.map_spill_path;
+  p.huge_pages = m.map_huge_pages;
+  return p;
+}
+
+VoxelBlockMap::VoxelBlockMap(VoxelBlockMapParams params) : params_(params) {
+  params_.block_size_vox = std::max(params_.block_size_vox, 1);
+  inv_voxel_size_ = 1.0f / params_.voxel_size_m;
+  block_size_ = static_cast<std::uint32_t>(params_.block_size_vox);
+  voxels_per_block_ = std::size_t{block_size_} * block_size_ * block_size_;
+  log_odds_ = LogOddsModel::make(params_.log_odds_bits, params_.log_odds_hit, params_.log_odds_miss,
+                                 params_.log_odds_min, params_.log_odds_max, params_.log_odds_occupied,
+                                 params_.log_odds_free);
+  params_.log_odds_bits = log_odds_.bits;
+  block_bytes_ = voxels_per_block_ * log_odds_.cell_bytes();
+
+  // Morton indices are only dense for power-of-two blocks; others keep the linear order.
+  params_.morton_voxels = params_.morton_voxels && std::has_single_bit(block_size_);
+  axis_index_.resize(3 * std::size_t{block_size_});
+  for (std::uint32_t l = 0; l < block_size_; ++l) {
+    if (params_.morton_voxels) {
+      axis_index_[l] = static_cast<std::uint32_t>(morton_encode3(l, 0, 0));
+      axis_index_[block_size_ + l] = static_cast<std::uint32_t>(morton_encode3(0, l, 0));
+      axis_index_[2 * block_size_ + l] = static_cast<std::uint32_t>(morton_encode3(0, 0, l));
+    } else {
+      axis_index_[l] = l;
+      axis_index_[block_size_ + l] = l * block_size_;
+      axis_index_[2 * block_size_ + l] = l * block_size_ * block_size_;
+    }
+  }
+
+  params_.region_size_blocks =
+      static_cast<int>(std::bit_floor(static_cast<std::uint32_t>(std::clamp(params_.region_size_blocks, 1, 16))));
+  region_shift_ = std::countr_zero(static_cast<std::uint32_t>(params_.region_size_blocks));
+  blocks_per_region_ = std::size_t{1} << (3 * region_shift_);
+  mask_words_ = (voxels_per_block_ + 63) / 64;
+  summary_words_ = (blocks_per_region_ + 63) / 64;
+  // One slab per region; chunks hold whole regions.
+  pool_ = BlockPool(BlockPoolParams{block_bytes_, blocks_per_region_, params_.blocks_per_chunk, params_.huge_pages});
+  params_.blocks_per_chunk = pool_.params().blocks_per_chunk;
+
+  params_.shards = static_cast<int>(std::bit_floor(static_cast<std::uint32_t>(std::clamp(params_.shards, 1, 1024))));
+  shard_shift_ = 63 - std::countr_zero(static_cast<std::uint32_t>(params_.shards));
+  const std::size_t n =
+      std::bit_ceil(std::max<std::size_t>(params_.initial_slots / static_cast<std::size_t>(params_.shards), 16));
+  shards_.resize(static_cast<std::size_t>(params_.shards));
+  for (Shard& sh : shards_) {
+    sh.slots.assign(n, Slot{kEmptyKey, kInvalidRegion});
+    sh.mask = n - 1;
+  }
+
+  if (params_.memory_budget_bytes > 0) {
+    budget_regions_ = std::max<std::size_t>(params_.memory_budget_bytes / region_bytes(), 1);
+  }
+}
+
+std::uint32_t VoxelBlockMap::voxel_offset(std::int32_t vx, std::int32_t vy, std::int32_t vz) const noexcept {
+  const std::int32_t b = params_.block_size_vox;
+  const auto local = [b](std::int32_t v) {
+    const std::int32_t r = v % b;
+    return static_cast<std::uint32_t>(r < 0 ? r + b : r);
+  };
+  return voxel_index(local(vx), local(vy), local(vz));
+}
+
+std::size_t VoxelBlockMap::slot_in_region(const BlockKey& k) const noexcept {
+  const auto m = static_cast<std::uint32_t>(params_.region_size_blocks - 1);
+  return static_cast<std::size_t>(morton_encode3(static_cast<std::uint32_t>(k.x) & m,
+                                                 static_cast<std::uint32_t>(k.y) & m,
+                                                 static_cast<std::uint32_t>(k.z) & m));
+}
+
+Vec3f VoxelBlockMap::block_origin(const BlockKey& k) const noexcept {
+  const float e = block_extent_m();
+  return Vec3f{static_cast<float>(k.x) * e, static_cast<float>(k.y) * e, static_cast<float>(k.z) * e};
+}
+
+AABB VoxelBlockMap::key_extent() const noexcept {
+  const float lo = static_cast<float>(kBlockKeyMin) * block_extent_m();
+  const float hi = (static_cast<float>(kBlockKeyMax) + 1.0f) * block_extent_m();
+  return AABB{Vec3f{lo, lo, lo}, Vec3f{hi, hi, hi}};
+}
+
+Vec3f VoxelBlockMap::voxel_center(const BlockKey& k, std::uint32_t offset) const noexcept {
+  std::uint32_t lx = 0;
+  std::uint32_t ly = 0;
+  std::uint32_t lz = 0;
+  if (params_.morton_voxels) {
+    morton_decode3(offset, lx, ly, lz);
+  } else {
+    lx = offset % block_size_;
+    ly = offset / block_size_ % block_size_;
+    lz = offset / (block_size_ * block_size_);
+  }
+  const Vec3f o = block_origin(k);
+  const float v = params_.voxel_size_m;
+  return Vec3f{o.x + (static_cast<float>(lx) + 0.5f) * v, o.y + (static_cast<float>(ly) + 0.5f) * v,
+               o.z + (static_cast<float>(lz) + 0.5f) * v};
+}
+
+VoxelBlockMap::RegionIndex VoxelBlockMap::find_region(std::uint64_t packed_region) const noexcept {
+  const Shard& sh = shards_[shard_index(packed_region)];
+  for (std::size_t i = hash_key(packed_region) & sh.mask;; i = (i + 1) & sh.mask) {
+    const Slot& s = sh.slots[i];
+    if (s.key == packed_region) return s.region;
+    if (s.key == kEmptyKey) return kInvalidRegion;
+  }
+}
+
+BlockIndex VoxelBlockMap::find(const BlockKey& k) const noexcept {
+  if (!block_key_in_range(k)) return kInvalidBlock;
+  const RegionIndex r = find_region(region_key(k));
+  if (r == kInvalidRegion) return kInvalidBlock;
+  const std::size_t b = static_cast<std::size_t>(r) * blocks_per_region_ + slot_in_region(k);
+  return block_keys_[b] != kEmptyKey ? static_cast<BlockIndex>(b) : kInvalidBlock;
+}
+
+BlockIndex VoxelBlockMap::find_or_insert(const BlockKey& k) {
+  assert(block_key_in_range(k));
+  const std::uint64_t packed_region = region_key(k);
+  RegionIndex r = find_region(packed_region);
+  if (r == kInvalidRegion) r = allocate_region(packed_region);
+  region_seen_[r] = epoch_;
+
+  const std::size_t b = static_cast<std::size_t>(r) * blocks_per_region_ + slot_in_region(k);
+  if (claim_block(b, r, pack_block_key(k))) ++num_blocks_;
+  return static_cast<BlockIndex>(b);
+}
+
+bool VoxelBlockMap::claim_block(std::size_t b, RegionIndex r, std::uint64_t packed_block) {
+  if (block_keys_[b] != kEmptyKey) return false;
+  block_keys_[b] = packed_block;
+  std::memset(block_ptr(static_cast<BlockIndex>(b)), 0, block_bytes_);
+  clear_masks(b);
+  ++region_blocks_[r];
+  region_seen_[r] = epoch_;
+  return true;
+}
+
+bool VoxelBlockMap::erase(const BlockKey& k) {
+  if (!block_key_in_range(k)) return false;
+  const std::uint64_t packed_region = region_key(k);
+  const RegionIndex r = find_region(packed_region);
+  if (r == kInvalidRegion) return false;
+  const std::size_t b = static_cast<std::size_t>(r) * blocks_per_region_ + slot_in_region(k);
+  if (block_keys_[b] == kEmptyKey) return false;
+
+  block_keys_[b] = kEmptyKey;
+  clear_masks(b);
+  --num_blocks_;
+  ++blocks_released_;
+  if (--region_blocks_[r] == 0) erase_region(packed_region);
+  return true;
+}
+
+void VoxelBlockMap::clear_masks(std::size_t b) noexcept {
+  std::fill_n(block_masks_.begin() + static_cast<std::ptrdiff_t>(b * 2 * mask_words_), 2 * mask_words_, 0);
+  const std::size_t r = b / blocks_per_region_;
+  const std::size_t slot = b % blocks_per_region_;
+  const std::uint64_t bit = std::uint64_t{1} << (slot % 64);
+  for (int kind = 0; kind < 2; ++kind) {
+    region_summary_[(2 * r + static_cast<std::size_t>(kind)) * summary_words_ + slot / 64] &= ~bit;
+  }
+}
+
+void VoxelBlockMap::refresh_masks(BlockIndex b) noexcept {
+  std::uint64_t* m = block_masks_.data() + std::size_t{b} * 2 * mask_words_;
+  classify_block(log_odds_, block_ptr(b), voxels_per_block_, m, m + mask_words_);
+  refresh_summary(b);
+}
+
+void VoxelBlockMap::refresh_summary(BlockIndex b) noexcept {
+  const std::uint64_t* m = block_masks_.data() + std::size_t{b} * 2 * mask_words_;
+  const std::size_t r = b / blocks_per_region_;
+  const std::size_t slot = b % blocks_per_region_;
+  const std::uint64_t bit = std::uint64_t{1} << (slot % 64);
+  for (int kind = 0; kind < 2; ++kind) {
+    std::uint64_t any = 0;
+    for (std::size_t w = 0; w < mask_words_; ++w) any |= m[kind * mask_words_ + w];
+    std::uint64_t& s = region_summary_[(2 * r + static_cast<std::size_t>(kind)) * summary_words_ + slot / 64];
+    s = any != 0 ? s | bit : s & ~bit;
+  }
+}
+
+std::size_t VoxelBlockMap::count_bits(int kind) const noexcept {
+  std::size_t n = 0;
+  for_each_summary_block(kind, [&](const BlockKey&, BlockIndex b) {
+    const std::uint64_t* m = occupied_mask(b) + static_cast<std::size_t>(kind) * mask_words_;
+    for (std::size_t w = 0; w < mask_words_; ++w) n += static_cast<std::size_t>(std::popcount(m[w]));
+  });
+  return n;
+}
+
+void VoxelBlockMap::clear() {
+  for (Shard& sh : shards_) {
+    std::fill(sh.slots.begin(), sh.slots.end(), Slot{kEmptyKey, kInvalidRegion});
+    sh.regions = 0;
+  }
+  blocks_released_ += num_blocks_;
+  num_blocks_ = 0;
+  // Keep the pool: every region becomes free, lowest index reused first.
+  std::fill(block_keys_.begin(), block_keys_.end(), kEmptyKey);
+  std::fill(block_masks_.begin(), block_masks_.end(), 0);
+  std::fill(region_summary_.begin(), region_summary_.end(), 0);
+  std::fill(region_blocks_.begin(), region_blocks_.end(), 0u);
+  pool_.release_all();
+  if (spill_) {
+    Status st = spill_->clear();
+    if (!st.ok()) {
+      ++spill_errors_;
+      spill_status_ = std::move(st);
+    }
+  }
+}
+
+VoxelBlockMap::RegionIndex VoxelBlockMap::allocate_region(std::uint64_t packed_region) {
+  const RegionIndex r = take_pool_region();
+  insert_slot(shards_[shard_index(packed_region)], packed_region, r);
+  restore_region(packed_region, r);
+  return r;
+}
+
+VoxelBlockMap::RegionIndex VoxelBlockMap::take_pool_region() {
+  const RegionIndex r = pool_.take_slab();
+  if (r < region_blocks_.size()) {
+    region_seen_[r] = epoch_;
+    return r;
+  }
+  // A new slab: grow the per-region and per-block side tables with it.
+  const std::size_t first_block = std::size_t{r} * blocks_per_region_;
+  region_blocks_.push_back(0);
+  region_seen_.push_back(epoch_);
+  block_keys_.resize(first_block + blocks_per_region_, kEmptyKey);
+  block_masks_.resize(block_keys_.size() * 2 * mask_words_, 0);
+  region_summary_.resize(region_blocks_.size() * 2 * summary_words_, 0);
+  return r;
+}
+
+void VoxelBlockMap::insert_slot(Shard& sh, std::uint64_t packed_region, RegionIndex r) {
+  // Keep the load factor <= 1/2 so probe sequences stay short.
+  if (2 * (sh.regions + 1) > sh.slots.size()) grow_table(sh);
+  std::size_t i = hash_key(packed_region) & sh.mask;
+  while (sh.slots[i].key != kEmptyKey) i = (i + 1) & sh.mask;
+  sh.slots[i] = Slot{packed_region, r};
+  ++sh.regions;
+}
+
+void VoxelBlockMap::erase_region(std::uint64_t packed_region) {
+  Shard& sh = shards_[shard_index(packed_region)];
+  const std::size_t mask = sh.mask;
+  std::vector<Slot>& slots = sh.slots;
+  std::size_t i = hash_key(packed_region) & mask;
+  while (slots[i].key != packed_region) i = (i + 1) & mask;
+
+  pool_.release_slab(slots[i].region);
+  --sh.regions;
+
+  // Backward-shift deletion: pull later entries of the cluster into the hole when their
+  // home slot does not lie (cyclically) between the hole and their current position.
+  for (std::size_t j = (i + 1) & mask; slots[j].key != kEmptyKey; j = (j + 1) & mask) {
+    const std::size_t home = hash_key(slots[j].key) & mask;
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      slots[i] = slots[j];
+      i = j;
+    }
+  }
+  slots[i] = Slot{kEmptyKey, kInvalidRegion};
+}
+
+void VoxelBlockMap::grow_table(Shard& sh) {
+  std::vector<Slot> old(sh.slots.size() * 2, Slot{kEmptyKey, kInvalidRegion});
+  old.swap(sh.slots);
+  sh.mask = sh.slots.size() - 1;
+  for (const Slot& s : old) {
+    if (s.key == kEmptyKey) continue;
+    std::size_t i = hash_key(s.key) & sh.mask;
+    while (sh.slots[i].key != kEmptyKey) i = (i + 1) & sh.mask;
+    sh.slots[i] = s;
+  }
+}
+
+// insert_sharded phase 1 (one task per shard). Blocks of existing regions are claimed
+// directly: the region, its block_keys_ entries and voxels belong to this shard, and the
+// pool does not grow in this phase. New regions get a pending table entry.
+void VoxelBlockMap::insert_pending(std::size_t shard, std::uint64_t packed_block) {
+  Shard& sh = shards_[shard];
+  const BlockKey k = unpack_block_key(packed_block);
+  const std::uint64_t packed_region = region_key(k);
+  RegionIndex r = find_region(packed_region);
+  if (r == kInvalidRegion) {
+    r = kPendingRegion | static_cast<RegionIndex>(sh.pending.size());
+    sh.pending.push_back(packed_region);
+    insert_slot(sh, packed_region, r);
+  }
+  if (r & kPendingRegion) {
+    sh.pending_blocks.push_back(packed_block);
+  } else if (claim_block(std::size_t{r} * blocks_per_region_ + slot_in_region(k), r, packed_block)) {
+    ++sh.added;
+  }
+}
+
+// Phase 2 (serial): pool slabs for every pending region, in shard order. Spilled regions
+// are read back here, so their blocks already exist when phase 3 claims them.
+void VoxelBlockMap::assign_pending_regions() {
+  for (Shard& sh : shards_) {
+    sh.assigned.clear();
+    for (std::size_t j = 0; j < sh.pending.size(); ++j) {
+      sh.assigned.push_back(take_pool_region());
+      restore_region(sh.pending[j], sh.assigned.back());
+    }
+  }
+}
+
+// Phase 3 (one task per shard): resolve pending table entries and claim their blocks.
+void VoxelBlockMap::commit_pending(std::size_t shard) {
+  Shard& sh = shards_[shard];
+  if (sh.pending.empty()) return;
+  for (std::size_t j = 0; j < sh.pending.size(); ++j) {
+    std::size_t i = hash_key(sh.pending[j]) & sh.mask;
+    while (sh.slots[i].key != sh.pending[j]) i = (i + 1) & sh.mask;
+    sh.slots[i].region = sh.assigned[j];
+  }
+  for (const std::uint64_t packed : sh.pending_blocks) {
+    const BlockKey k = unpack_block_key(packed);
+    const RegionIndex r = find_region(region_key(k));
+    if (claim_block(std::size_t{r} * blocks_per_region_ + slot_in_region(k), r, packed)) ++sh.added;
+  }
+  sh.pending.clear();
+  sh.pending_blocks.clear();
+}
+
+std::int32_t VoxelBlockMap::cell_at(const Vec3f& p) const noexcept {
+  const std::int32_t vx = voxel_coord(p.x);
+  const std::int32_t vy = voxel_coord(p.y);
+  const std::int32_t vz = voxel_coord(p.z);
+  const BlockIndex b = find(block_of_voxel(vx, vy, vz));
+  if (b == kInvalidBlock) return 0;
+  return cell(b, voxel_offset(vx, vy, vz));
+}
+
+std::size_t VoxelBlockMap::integrate_hits(ConstPointView pts) {
+  const AABB& roi = params_.roi;
+  const std::int32_t hit = log_odds_.hit;
+  const std::int32_t hi = log_odds_.max;
+
+  // Consecutive returns of a scan are spatially coherent, so most points hit the same
+  // block as their predecessor: cache it and skip the hash probe.
+  BlockKey last_key{kBlockKeyMin, kBlockKeyMin, kBlockKeyMin};
+  BlockIndex last_index = kInvalidBlock;
+  std::uint8_t* last_block = nullptr;
+
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < pts.size; ++i) {
+    const PointXYZI p = pts.at(i);
+    if (!(p.x >= roi.min.x && p.x < roi.max.x && p.y >= roi.min.y && p.y < roi.max.y &&
+          p.z >= roi.min.z && p.z < roi.max.z)) {
+      continue;
+    }
+    const std::int32_t vx = voxel_coord(p.x);
+    const std::int32_t vy = voxel_coord(p.y);
+    const std::int32_t vz = voxel_coord(p.z);
+    const BlockKey k = block_of_voxel(vx, vy, vz);
+    if (!block_key_in_range(k)) continue;  // ROI reaching past the key range
+    if (last_block == nullptr || k != last_key) {
+      if (last_index != kInvalidBlock) refresh_summary(last_index);
+      last_index = find_or_insert(k);
+      last_block = block_ptr(last_index);
+      last_key = k;
+    }
+    const std::uint32_t off = voxel_offset(vx, vy, vz);
+    if (log_odds_.bits == 8) {
+      auto& v = reinterpret_cast<std::int8_t*>(last_block)[off];
+      v = static_cast<std::int8_t>(std::min(v + hit, hi));
+      note_cell(last_index, off, v);
+    } else {
+      auto& v = reinterpret_cast<std::int16_t*>(last_block)[off];
+      v = static_cast<std::int16_t>(std::min(v + hit, hi));
+      note_cell(last_index, off, v);
+    }
+    ++n;
+  }
+  if (last_index != kInvalidBlock) refresh_summary(last_index);
+  enforce_memory_budget();
+  return n;
+}
+
+bool VoxelBlockMap::region_in_core(std::uint64_t packed_region) const noexcept {
+  const BlockKey k = unpack_block_key(packed_region);
+  const float e = block_extent_m() * static_cast<float>(params_.region_size_blocks);
+  const AABB& c = params_.core;
+  const auto overlaps = [e](std::int32_t i, float lo, float hi) {
+    return static_cast<float>(i) * e < hi && static_cast<float>(i + 1) * e > lo;
+  };
+  return overlaps(k.x, c.min.x, c.max.x) && overlaps(k.y, c.min.y, c.max.y) && overlaps(k.z, c.min.z, c.max.z);
+}
+
+std::size_t VoxelBlockMap::enforce_memory_budget() {
+  ++epoch_;
+  if (budget_regions_ == 0 || num_regions() <= budget_regions_) return 0;
+
+  // Evict down to 90% of the budget, so the next few passes fit without evicting again.
+  const std::size_t target = budget_regions_ - budget_regions_ / 10;
+  struct Candidate {
+    std::uint32_t seen;
+    std::uint64_t key;
+    RegionIndex region;
+  };
+  std::vector<Candidate> candidates;
+  for (const Shard& sh : shards_) {
+    for (const Slot& s : sh.slots) {
+      if (s.key != kEmptyKey && !region_in_core(s.key)) candidates.push_back({region_seen_[s.region], s.key, s.region});
+    }
+  }
+  // The core alone may exceed the budget; it stays regardless.
+  const std::size_t n = std::min(num_regions() - target, candidates.size());
+  const auto older = [](const Candidate& a, const Candidate& b) {
+    return a.seen != b.seen ? a.seen < b.seen : a.key < b.key;
+  };
+  std::nth_element(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(n), candidates.end(), older);
+  std::sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(n), older);
+  if (!params_.spill_path.empty() && !spill_) {
+    // Opened at the first eviction; if that fails, retried at the next pass.
+    auto file = std::make_unique<BlockSpillFile>();
+    Status st = file->open(params_.spill_path);
+    if (st.ok()) {
+      spill_ = std::move(file);
+    } else {
+      spill_status_ = std::move(st);
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i) evict_region(candidates[i].key, candidates[i].region);
+  return n;
+}
+
+// Spill record of a region: per used block, u32 slot in region, u32 byte count, then the
+// block's cells run-length coded (append_cells_rle).
+void VoxelBlockMap::evict_region(std::uint64_t packed_region, RegionIndex r) {
+  const std::size_t base = std::size_t{r} * blocks_per_region_;
+  if (spill_) {
+    spill_buf_.clear();
+    for (std::size_t b = base; b < base + blocks_per_region_; ++b) {
+      if (block_keys_[b] == kEmptyKey) continue;
+      const std::size_t head = spill_buf_.size();
+      spill_buf_.resize(head + 8);
+      append_cells_rle(spill_buf_, block_ptr(static_cast<BlockIndex>(b)), voxels_per_block_, log_odds_.cell_bytes());
+      const auto slot = static_cast<std::uint32_t>(b - base);
+      const auto len = static_cast<std::uint32_t>(spill_buf_.size() - head - 8);
+      std::memcpy(spill_buf_.data() + head, &slot, 4);
+      std::memcpy(spill_buf_.data() + head + 4, &len, 4);
+    }
+    Status st = spill_->put(packed_region, spill_buf_);
+    if (st.ok()) {
+      ++spilled_regions_;
+    } else {
+      ++spill_errors_;
+      spill_status_ = std::move(st);
+    }
+  } else if (!params_.spill_path.empty()) {
+    ++spill_errors_;  // the spill file could not be opened: dropped
+  }
+  std::fill(block_keys_.begin() + static_cast<std::ptrdiff_t>(base),
+            block_keys_.begin() + static_cast<std::ptrdiff_t>(base + blocks_per_region_), kEmptyKey);
+  std::fill_n(block_masks_.begin() + static_cast<std::ptrdiff_t>(base * 2 * mask_words_),
+              blocks_per_region_ * 2 * mask_words_, 0);
+  std::fill_n(region_summary_.begin() + static_cast<std::ptrdiff_t>(std::size_t{r} * 2 * summary_words_),
+              2 * summary_words_, 0);
+  num_blocks_ -= region_blocks_[r];
+  blocks_released_ += region_blocks_[r];
+  evicted_blocks_ += region_blocks_[r];
+  region_blocks_[r] = 0;
+  ++evicted_regions_;
+  erase_region(packed_region);
+}
+
+void VoxelBlockMap::restore_region(std::uint64_t packed_region, RegionIndex r) {
+  if (!spill_ || !spill_->contains(packed_region)) return;
+  Status st = spill_->take(packed_region, spill_buf_);
+  if (!st.ok()) {
+    ++spill_errors_;
+    spill_status_ = std::move(st);
+    return;
+  }
+  spill_keys_.resize(blocks_per_region_);
+  spill_cells_.resize(blocks_per_region_ * block_bytes_);
+  // A short or malformed record restores what decoded; the rest of the region is unknown.
+  if (!decode_spill_record(packed_region, spill_buf_, spill_keys_.data(), spill_cells_.data())) ++spill_errors_;
+  const std::size_t base = std::size_t{r} * blocks_per_region_;
+  for (std::size_t slot = 0; slot < blocks_per_region_; ++slot) {
+    if (spill_keys_[slot] == kEmptyKey) continue;
+    const std::size_t b = base + slot;
+    if (claim_block(b, r, spill_keys_[slot])) ++num_blocks_;
+    std::memcpy(block_ptr(static_cast<BlockIndex>(b)), spill_cells_.data() + slot * block_bytes_, block_bytes_);
+    refresh_masks(static_cast<BlockIndex>(b));
+  }
+  ++restored_regions_;
+}
+
+bool VoxelBlockMap::decode_spill_record(std::uint64_t packed_region, const std::vector<std::uint8_t>& rec,
+                                        std::uint64_t* keys, std::uint8_t* cells) const noexcept {
+  std::fill(keys, keys + blocks_per_region_, kEmptyKey);
+  const BlockKey rk = unpack_block_key(packed_region);
+  const std::int32_t R = params_.region_size_blocks;
+  const std::size_t size = rec.size();
+  std::size_t pos = 0;
+  while (pos + 8 <= size) {
+    std::uint32_t slot = 0;
+    std::uint32_t len = 0;
+    std::memcpy(&slot, rec.data() + pos, 4);
+    std::memcpy(&len, rec.data() + pos + 4, 4);
+    pos += 8;
+    if (slot >= blocks_per_region_ || len > size - pos) return false;
+    if (read_cells_rle(rec.data() + pos, len, cells + std::size_t{slot} * block_bytes_, voxels_per_block_,
+                       log_odds_.cell_bytes()) != len) {
+      return false;
+    }
+    std::uint32_t lx = 0;
+    std::uint32_t ly = 0;
+    std::uint32_t lz = 0;
+    morton_decode3(slot, lx, ly, lz);
+    keys[slot] = pack_block_key(BlockKey{rk.x * R + static_cast<std::int32_t>(lx),
+                                         rk.y * R + static_cast<std::int32_t>(ly),
+                                         rk.z * R + static_cast<std::int32_t>(lz)});
+    pos += len;
+  }
+  return pos == size;
+}
+
+VoxelBlockMapStats VoxelBlockMap::stats() const noexcept {
+  VoxelBlockMapStats s;
+  s.blocks = num_blocks_;
+  s.free_blocks = block_keys_.size() - num_blocks_;
+  s.shards = shards_.size();
+  for (const Shard& sh : shards_) {
+    s.regions += sh.regions;
+    s.hash_slots += sh.slots.size();
+  }
+  const BlockPoolStats pool = pool_.stats();
+  s.pool_chunks = pool.chunks;
+  s.mapped_chunks = pool.mapped_chunks;
+  s.huge_page_chunks = pool.huge_page_chunks;
+  s.pool_bytes = pool_.memory_bytes();
+  s.free_regions = pool.free_slabs;
+  s.stranded_blocks = num_regions() * blocks_per_region_ - num_blocks_;
+  s.memory_bytes = s.pool_bytes + s.hash_slots * sizeof(Slot) + block_keys_.capacity() * sizeof(std::uint64_t) +
+                   region_blocks_.capacity() * sizeof(std::uint32_t) +
+                   region_seen_.capacity() * sizeof(std::uint32_t) +
+                   (block_masks_.capacity() + region_summary_.capacity()) * sizeof(std::uint64_t);
+  s.live_bytes = num_regions() * region_bytes();
+  s.evicted_regions = evicted_regions_;
+  s.evicted_blocks = evicted_blocks_;
+  s.spilled_regions = spilled_regions_;
+  s.restored_regions = restored_regions_;
+  s.spill_errors = spill_errors_;
+  if (spill_) {
+    s.spill_bytes_written = spill_->stats().bytes_written;
+    s.spill_bytes_read = spill_->stats().bytes_read;
+    s.spill_file_bytes = spill_->stats().file_bytes;
+    s.spill_compaction_errors = spill_->stats().compaction_errors;
+  }
+  s.blocks_allocated = num_blocks_ + blocks_released_;
+  s.blocks_released = blocks_released_;
+  s.regions_allocated = pool.slabs_taken;
+  s.regions_reused = pool.slabs_reused;
+  return s;
+}
+
+}  // namespace wm
@@ -0,0 +1,72 @@
+// File: src/core/preprocess/input_preprocessor.cpp
+#include "wm/core/preprocess/input_preprocessor.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace wm {
+namespace {
+
+// Keeps every stride-th point, in place (extra fields included).
+void keep_every(PointBuffer& pts, int stride) {
+  if (stride <= 1 || pts.empty()) return;
+  const PointView v = pts.mutable_view();
+  const auto s = static_cast<std::size_t>(stride);
+  std::size_t w = 0;
+  for (std::size_t i = 0; i < v.size; i += s, ++w) {
+    v.x[w] = v.x[i];
+    v.y[w] = v.y[i];
+    v.z[w] = v.z[i];
+    v.intensity[w] = v.intensity[i];
+  }
+  for (std::size_t k = 0; k < pts.num_fields(); ++k) {
+    float* f = pts.field_at(k);
+    for (std::size_t i = 0, j = 0; i < v.size; i += s, ++j) f[j] = f[i];
+  }
+  pts.truncate(w);
+}
+
+// ROI with its x/y extent scaled about the centre; z is left alone (floor to ceiling).
+AABB shrink_roi(const AABB& roi, float scale) {
+  if (scale >= 1.0f) return roi;
+  const float cx = 0.5f * (roi.min.x + roi.max.x);
+  const float cy = 0.5f * (roi.min.y + roi.max.y);
+  const float hx = 0.5f * (roi.max.x - roi.min.x) * scale;
+  const float hy = 0.5f * (roi.max.y - roi.min.y) * scale;
+  return AABB{Vec3f{cx - hx, cy - hy, roi.min.z}, Vec3f{cx + hx, cy + hy, roi.max.z}};
+}
+
+}  // namespace
+
+InputPreprocessor::InputPreprocessor(const Config& cfg)
+    : gate_params_(RangeGateParams::from_config(cfg.mapping)),
+      downsampler_(VoxelDownsampleParams::from_config(cfg.budgets)),
+      governor_(ThroughputGovernorParams::from_config(cfg.budgets)) {}
+
+PreprocessStats InputPreprocessor::process(Frame& frame, const TransformSE3& T_node_lidar) {
+  using clock = std::chrono::steady_clock;
+  const auto t0 = clock::now();
+
+  const DecimationLevel& d = governor_.level();
+  PreprocessStats s;
+  s.level = governor_.level_index();
+  s.points_in = frame.points.size();
+
+  keep_every(frame.points, d.stride);
+
+  RangeGateParams gp = gate_params_;
+  gp.roi = shrink_roi(gate_params_.roi, d.roi_scale);
+  s.gate = range_gate(gp, T_node_lidar, frame.points);
+
+  if (d.voxel_m > 0.0f) {
+    downsampler_.set_voxel_m(d.voxel_m);
+    (void)downsampler_.downsample(frame.points.view(), scratch_);
+    std::swap(frame.points, scratch_);
+  }
+
+  s.points_out = frame.points.size();
+  s.preprocess_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+  return s;
+}
+
+}  // namespace wm
@@ -0,0 +1,291 @@
+// File: src/core/preprocess/range_gate.cpp
+#include "wm/core/preprocess/range_gate.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if WM_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace wm {
+namespace {
+
+// Source and destination lanes. Destinations may alias sources (in place): the write
+// index never passes the read index, and every kernel loads a point before storing over it.
+struct Lanes {
+  const float* x;
+  const float* y;
+  const float* z;
+  const float* i;
+  float* ox;
+  float* oy;
+  float* oz;
+  float* oi;
+  std::span<float* const> extra;  // in-place only: compacted alongside
+  std::size_t n;
+};
+
+struct Bounds {
+  float min2;
+  float max2;
+  Vec3f lo;
+  Vec3f hi;
+};
+
+Bounds make_bounds(const RangeGateParams& p) noexcept {
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  Bounds b;
+  b.min2 = p.min_range_m * p.min_range_m;
+  b.max2 = p.max_range_m * p.max_range_m;
+  b.lo = p.use_roi ? p.roi.min : Vec3f{-kInf, -kInf, -kInf};
+  b.hi = p.use_roi ? p.roi.max : Vec3f{kInf, kInf, kInf};
+  return b;
+}
+
+// Rejection counts (kept is derived from the write index).
+struct Counts {
+  std::size_t min_range{0};
+  std::size_t max_range{0};
+  std::size_t roi{0};
+};
+
+std::size_t gate_scalar(const TransformSE3& T, const Bounds& b, const Lanes& l, std::size_t begin,
+                        std::size_t w, Counts& c) noexcept {
+  const auto& m = T.m;
+  for (std::size_t i = begin; i < l.n; ++i) {
+    const float x = l.x[i];
+    const float y = l.y[i];
+    const float z = l.z[i];
+    const float r2 = (x * x + y * y) + z * z;
+    const float tx = ((m[0] * x + m[1] * y) + m[2] * z) + m[3];
+    const float ty = ((m[4] * x + m[5] * y) + m[6] * z) + m[7];
+    const float tz = ((m[8] * x + m[9] * y) + m[10] * z) + m[11];
+    const bool near_ok = r2 >= b.min2;
+    const bool far_ok = r2 <= b.max2;
+    const bool roi_ok = (tx >= b.lo.x) & (tx < b.hi.x) & (ty >= b.lo.y) & (ty < b.hi.y) &
+                        (tz >= b.lo.z) & (tz < b.hi.z);
+    c.min_range += !near_ok;
+    c.max_range += near_ok & !far_ok;
+    c.roi += near_ok & far_ok & !roi_ok;
+
+    // Always store, then advance only over kept points.
+    const float in = l.i[i];
+    l.ox[w] = tx;
+    l.oy[w] = ty;
+    l.oz[w] = tz;
+    l.oi[w] = in;
+    for (float* f : l.extra) f[w] = f[i];
+    w += static_cast<std::size_t>(near_ok & far_ok & roi_ok);
+  }
+  return w;
+}
+
+#if WM_SIMD_X86
+// Compaction tables for a 4- or 8-bit keep mask: lane indices of the kept points packed to
+// the front, and the number kept.
+struct CompactTable {
+  alignas(32) std::array<std::array<std::int32_t, 8>, 256> perm{};
+  std::array<std::uint8_t, 256> count{};
+
+  constexpr CompactTable() {
+    for (int mask = 0; mask < 256; ++mask) {
+      int k = 0;
+      for (int lane = 0; lane < 8; ++lane) {
+        if (mask & (1 << lane)) perm[static_cast<std::size_t>(mask)][static_cast<std::size_t>(k++)] = lane;
+      }
+      count[static_cast<std::size_t>(mask)] = static_cast<std::uint8_t>(k);
+    }
+  }
+};
+constexpr CompactTable kCompact{};
+
+// SSE2 has no variable lane permute, so the masks are computed four points at a time and
+// the survivors are written with the scalar store-then-advance pattern.
+std::size_t gate_sse2(const TransformSE3& T, const Bounds& b, const Lanes& l, std::size_t& w,
+                      Counts& c) noexcept {
+  const auto& m = T.m;
+  __m128 r[12];
+  for (int k = 0; k < 12; ++k) r[k] = _mm_set1_ps(m[k]);
+  const __m128 min2 = _mm_set1_ps(b.min2);
+  const __m128 max2 = _mm_set1_ps(b.max2);
+  const __m128 lox = _mm_set1_ps(b.lo.x), loy = _mm_set1_ps(b.lo.y), loz = _mm_set1_ps(b.lo.z);
+  const __m128 hix = _mm_set1_ps(b.hi.x), hiy = _mm_set1_ps(b.hi.y), hiz = _mm_set1_ps(b.hi.z);
+
+  alignas(16) float tx[4], ty[4], tz[4], ti[4];
+  std::size_t i = 0;
+  for (; i + 4 <= l.n; i += 4) {
+    const __m128 x = _mm_loadu_ps(l.x + i);
+    const __m128 y = _mm_loadu_ps(l.y + i);
+    const __m128 z = _mm_loadu_ps(l.z + i);
+    const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    const __m128 vx = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_mul_ps(r[2], z)), r[3]);
+    const __m128 vy = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[4], x), _mm_mul_ps(r[5], y)), _mm_mul_ps(r[6], z)), r[7]);
+    const __m128 vz = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[8], x), _mm_mul_ps(r[9], y)), _mm_mul_ps(r[10], z)), r[11]);
+    const __m128 roi = _mm_and_ps(
+        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vx, lox), _mm_cmplt_ps(vx, hix)),
+                   _mm_and_ps(_mm_cmpge_ps(vy, loy), _mm_cmplt_ps(vy, hiy))),
+        _mm_and_ps(_mm_cmpge_ps(vz, loz), _mm_cmplt_ps(vz, hiz)));
+    const unsigned near_ok = static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(r2, min2)));
+    const unsigned far_ok = static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(r2, max2)));
+    const unsigned roi_ok = static_cast<unsigned>(_mm_movemask_ps(roi));
+    c.min_range += kCompact.count[~near_ok & 0xfu];
+    c.max_range += kCompact.count[near_ok & ~far_ok & 0xfu];
+    c.roi += kCompact.count[near_ok & far_ok & ~roi_ok & 0xfu];
+    const unsigned keep = near_ok & far_ok & roi_ok;
+
+    _mm_store_ps(tx, vx);
+    _mm_store_ps(ty, vy);
+    _mm_store_ps(tz, vz);
+    _mm_store_ps(ti, _mm_loadu_ps(l.i + i));
+    for (std::size_t k = 0; k < 4; ++k) {
+      l.ox[w] = tx[k];
+      l.oy[w] = ty[k];
+      l.oz[w] = tz[k];
+      l.oi[w] = ti[k];
+      for (float* f : l.extra) f[w] = f[i + k];
+      w += (keep >> k) & 1u;
+    }
+  }
+  return i;
+}
+
+WM_TARGET_AVX2 inline __m256 affine_row_avx2(__m256 a, __m256 b, __m256 c, __m256 d, __m256 x,
+                                             __m256 y, __m256 z) noexcept {
+  return _mm256_add_ps(
+      _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(b, y)), _mm256_mul_ps(c, z)), d);
+}
+
+// Eight points per step: each lane is permuted so the kept points come first and stored
+// whole at the write index; the tail past the kept count is overwritten by the next store.
+// Stores reach at most index i + 7 < n, so nothing past the input is written.
+WM_TARGET_AVX2
+std::size_t gate_avx2(const TransformSE3& T, const Bounds& b, const Lanes& l, std::size_t& w,
+                      Counts& c) noexcept {
+  const auto& m = T.m;
+  __m256 r[12];
+  for (int k = 0; k < 12; ++k) r[k] = _mm256_set1_ps(m[k]);
+  const __m256 min2 = _mm256_set1_ps(b.min2);
+  const __m256 max2 = _mm256_set1_ps(b.max2);
+  const __m256 lox = _mm256_set1_ps(b.lo.x), loy = _mm256_set1_ps(b.lo.y), loz = _mm256_set1_ps(b.lo.z);
+  const __m256 hix = _mm256_set1_ps(b.hi.x), hiy = _mm256_set1_ps(b.hi.y), hiz = _mm256_set1_ps(b.hi.z);
+
+  std::size_t i = 0;
+  for (; i + 8 <= l.n; i += 8) {
+    const __m256 x = _mm256_loadu_ps(l.x + i);
+    const __m256 y = _mm256_loadu_ps(l.y + i);
+    const __m256 z = _mm256_loadu_ps(l.z + i);
+    const __m256 in = _mm256_loadu_ps(l.i + i);
+    const __m256 r2 =
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+    const __m256 vx = affine_row_avx2(r[0], r[1], r[2], r[3], x, y, z);
+    const __m256 vy = affine_row_avx2(r[4], r[5], r[6], r[7], x, y, z);
+    const __m256 vz = affine_row_avx2(r[8], r[9], r[10], r[11], x, y, z);
+    const __m256 roi = _mm256_and_ps(
+        _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(vx, lox, _CMP_GE_OQ), _mm256_cmp_ps(vx, hix, _CMP_LT_OQ)),
+                      _mm256_and_ps(_mm256_cmp_ps(vy, loy, _CMP_GE_OQ), _mm256_cmp_ps(vy, hiy, _CMP_LT_OQ))),
+        _mm256_and_ps(_mm256_cmp_ps(vz, loz, _CMP_GE_OQ), _mm256_cmp_ps(vz, hiz, _CMP_LT_OQ)));
+    const unsigned near_ok = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(r2, min2, _CMP_GE_OQ)));
+    const unsigned far_ok = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(r2, max2, _CMP_LE_OQ)));
+    const unsigned roi_ok = static_cast<unsigned>(_mm256_movemask_ps(roi));
+    c.min_range += kCompact.count[~near_ok & 0xffu];
+    c.max_range += kCompact.count[near_ok & ~far_ok & 0xffu];
+    c.roi += kCompact.count[near_ok & far_ok & ~roi_ok & 0xffu];
+    const unsigned keep = near_ok & far_ok & roi_ok;
+
+    const __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(kCompact.perm[keep].data()));
+    _mm256_storeu_ps(l.ox + w, _mm256_permutevar8x32_ps(vx, perm));
+    _mm256_storeu_ps(l.oy + w, _mm256_permutevar8x32_ps(vy, perm));
+    _mm256_storeu_ps(l.oz + w, _mm256_permutevar8x32_ps(vz, perm));
+    _mm256_storeu_ps(l.oi + w, _mm256_permutevar8x32_ps(in, perm));
+    for (float* f : l.extra) {
+      _mm256_storeu_ps(f + w, _mm256_permutevar8x32_ps(_mm256_loadu_ps(f + i), perm));
+    }
+    w += kCompact.count[keep];
+  }
+  return i;
+}
+#endif
+
+RangeGateStats gate_lanes(const RangeGateParams& params, const TransformSE3& T, const Lanes& l,
+                          SimdLevel level) noexcept {
+  const Bounds b = make_bounds(params);
+  Counts c;
+  std::size_t done = 0;
+  std::size_t w = 0;
+#if WM_SIMD_X86
+  switch (clamp_simd_level(level)) {
+    case SimdLevel::kAvx2: done = gate_avx2(T, b, l, w, c); break;
+    case SimdLevel::kSse2: done = gate_sse2(T, b, l, w, c); break;
+    case SimdLevel::kScalar: break;
+  }
+#else
+  (void)level;
+#endif
+  w = gate_scalar(T, b, l, done, w, c);
+
+  RangeGateStats s;
+  s.input = l.n;
+  s.kept = w;
+  s.rejected_min_range = c.min_range;
+  s.rejected_max_range = c.max_range;
+  s.rejected_roi = c.roi;
+  return s;
+}
+
+}  // namespace
+
+RangeGateParams RangeGateParams::from_config(const MappingConfig& m) {
+  RangeGateParams p;
+  p.min_range_m = m.min_range_m;
+  p.max_range_m = m.max_range_m;
+  p.roi = AABB{m.roi.min, m.roi.max};
+  return p;
+}
+
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar,
+                          PointBuffer& pts, SimdLevel level) {
+  const PointView v = pts.mutable_view();
+  std::vector<float*> extra(pts.num_fields());
+  for (std::size_t k = 0; k < extra.size(); ++k) extra[k] = pts.field_at(k);
+  const RangeGateStats s = gate_lanes(
+      params, T_roi_lidar, Lanes{v.x, v.y, v.z, v.intensity, v.x, v.y, v.z, v.intensity, extra, v.size},
+      level);
+  pts.truncate(s.kept);
+  return s;
+}
+
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar, PointView pts,
+                          SimdLevel level) noexcept {
+  return gate_lanes(params, T_roi_lidar,
+                    Lanes{pts.x, pts.y, pts.z, pts.intensity, pts.x, pts.y, pts.z, pts.intensity, {}, pts.size},
+                    level);
+}
+
+RangeGateStats range_gate(const RangeGateParams& params, const TransformSE3& T_roi_lidar,
+                          ConstPointView in, PointBuffer& out, SimdLevel level) {
+  // Clearing `out` would release the storage (or the borrowed frame) `in` reads from.
+  if (views_whole_buffer(in, out)) return range_gate(params, T_roi_lidar, out, level);
+
+  out.clear();
+  if (!in.contiguous()) {
+    out.append(in);
+    return range_gate(params, T_roi_lidar, out, level);
+  }
+
+  out.resize(in.size);
+  const PointView v = out.mutable_view();
+  const RangeGateStats s = gate_lanes(
+      params, T_roi_lidar, Lanes{in.x, in.y, in.z, in.intensity, v.x, v.y, v.z, v.intensity, {}, in.size},
+      level);
+  out.truncate(s.kept);
+  return s;
+}
+
+}  // namespace wm
@@ -0,0 +1,119 @@
+// File: src/core/preprocess/throughput_governor.cpp
+#include "wm/core/preprocess/throughput_governor.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace wm {
+namespace {
+
+// Frames needed before the governor reacts to an overrun (one slow frame is not a trend).
+constexpr std::size_t kMinFramesToStepUp = 3;
+
+// Keep ratio assumed for a level that has not run yet: stride and ROI area scale the
+// count directly; each voxel-size step is taken to halve it.
+double prior_keep_ratio(const DecimationLevel& d, float base_voxel_m) {
+  double r = 1.0 / d.stride * d.roi_scale * d.roi_scale;
+  if (d.voxel_m > 0.0f) r *= 0.5 * base_voxel_m / d.voxel_m;
+  return r;
+}
+
+}  // namespace
+
+ThroughputGovernorParams ThroughputGovernorParams::from_config(const BudgetsConfig& b) {
+  ThroughputGovernorParams p;
+  p.enabled = b.governor_enabled;
+  p.max_points_per_sec = b.max_points_per_sec;
+  p.target_fps = b.target_fps;
+  p.downsample_voxel_m = b.downsample_voxel_m;
+  p.window_frames = b.governor_window_frames;
+  p.headroom = b.governor_headroom;
+  return p;
+}
+
+ThroughputGovernor::ThroughputGovernor(ThroughputGovernorParams params) : params_(params) {
+  params_.window_frames = std::max(params_.window_frames, 2);
+  const float v = params_.downsample_voxel_m;
+  levels_ = {
+      DecimationLevel{1, 0.0f, 1.0f},      //
+      DecimationLevel{1, v, 1.0f},         //
+      DecimationLevel{1, 2.0f * v, 1.0f},  //
+      DecimationLevel{2, 2.0f * v, 1.0f},  //
+      DecimationLevel{2, 4.0f * v, 0.75f}, //
+      DecimationLevel{4, 4.0f * v, 0.5f},
+  };
+  keep_ratio_.reserve(levels_.size());
+  for (const DecimationLevel& d : levels_) keep_ratio_.push_back(prior_keep_ratio(d, v));
+}
+
+bool ThroughputGovernor::observe(const FrameCost& cost) {
+  if (!params_.enabled) return false;
+
+  window_.push_back(cost);
+  if (window_.size() > static_cast<std::size_t>(params_.window_frames)) window_.pop_front();
+
+  double points_in = 0.0;
+  double points_out = 0.0;
+  double cost_ns = 0.0;
+  for (const FrameCost& c : window_) {
+    points_in += static_cast<double>(c.points_in);
+    points_out += static_cast<double>(c.points_out);
+    cost_ns += static_cast<double>(c.preprocess_ns + c.process_ns);
+  }
+  if (points_in > 0.0) keep_ratio_[current_] = points_out / points_in;
+  if (window_.size() < 2) return false;
+
+  // Input rate from frame timestamps; fall back to the target when they do not advance.
+  const double frames = static_cast<double>(window_.size());
+  const double span_ns = static_cast<double>(window_.back().t_ns.ns - window_.front().t_ns.ns);
+  const double fps = span_ns > 0.0 ? (frames - 1.0) * 1e9 / span_ns : static_cast<double>(params_.target_fps);
+
+  const double points_budget = static_cast<double>(params_.max_points_per_sec);
+  const double time_budget_ns = 1e9 / params_.target_fps;
+  const double points_per_sec = points_out / frames * fps;
+  const double frame_ns = cost_ns / frames;
+
+  const bool over_points = points_per_sec > points_budget;
+  const bool over_time = frame_ns > time_budget_ns;
+  if ((over_points || over_time) && window_.size() >= kMinFramesToStepUp && current_ + 1 < levels_.size()) {
+    change_to(current_ + 1, over_points ? "points_per_sec" : "frame_time", points_per_sec, frame_ns, fps);
+    return true;
+  }
+
+  if (current_ > 0) {
+    // Processing cost is assumed to scale with the points that survive decimation.
+    const double lighter = keep_ratio_[current_ - 1];
+    const double here = std::max(keep_ratio_[current_], 1e-9);
+    const double predicted_points = points_in / frames * lighter * fps;
+    const double predicted_ns = frame_ns * lighter / here;
+    if (predicted_points <= params_.headroom * points_budget && predicted_ns <= params_.headroom * time_budget_ns) {
+      if (++headroom_frames_ >= params_.window_frames) {
+        change_to(current_ - 1, "headroom", points_per_sec, frame_ns, fps);
+        return true;
+      }
+    } else {
+      headroom_frames_ = 0;
+    }
+  }
+  return false;
+}
+
+void ThroughputGovernor::change_to(std::size_t next, const char* reason, double points_per_sec, double frame_ns,
+                                   double fps) {
+  const std::size_t from = current_;
+  current_ = next;
+  window_.clear();
+  headroom_frames_ = 0;
+
+  const DecimationLevel& d = levels_[current_];
+  char buf[256];
+  std::snprintf(buf, sizeof(buf),
+                "level=%zu from=%zu reason=%s stride=%d voxel_m=%.3f roi_scale=%.2f points_per_sec=%.0f "
+                "max_points_per_sec=%lld frame_ms=%.2f budget_ms=%.2f input_fps=%.1f",
+                current_, from, reason, d.stride, static_cast<double>(d.voxel_m), static_cast<double>(d.roi_scale),
+                points_per_sec, static_cast<long long>(params_.max_points_per_sec), frame_ns * 1e-6,
+                1e3 / params_.target_fps, fps);
+  last_change_ = buf;
+}
+
+}  // namespace wm
@@ -0,0 +1,294 @@
+// File: src/core/preprocess/voxel_downsample.cpp
+#include "wm/core/preprocess/voxel_downsample.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "wm/core/geom/morton.hpp"
+
+namespace wm {
+namespace {
+
+constexpr int kDigitBits = 8;
+constexpr std::size_t kDigits = std::size_t{1} << kDigitBits;
+constexpr std::int64_t kMaxExtent = (std::int64_t{1} << kMortonBitsPerAxis) - 1;
+constexpr float kCoordLimit = 1073741824.0f;  // 2^30 voxels: far outside any real frame
+constexpr std::uint32_t kEmptySlot = ~std::uint32_t{0};
+// Below this, splitting a frame across threads costs more than it saves.
+constexpr std::size_t kMinChunkPoints = 16384;
+
+// Voxel coordinate of v; false for non-finite or absurdly large values.
+bool voxel_of(float v, float inv, std::int64_t& out) noexcept {
+  const float f = std::floor(v * inv);
+  if (!(f >= -kCoordLimit && f <= kCoordLimit)) return false;
+  out = static_cast<std::int64_t>(f);
+  return true;
+}
+
+// Morton key of a point relative to the frame's minimum voxel. Points that cannot be keyed
+// get `drop`, which is larger than every valid key and so sorts last.
+struct KeyFn {
+  float inv;
+  std::int64_t lo[3];
+  std::uint64_t drop;
+
+  std::uint64_t operator()(float x, float y, float z) const noexcept {
+    std::int64_t v[3];
+    if (!voxel_of(x, inv, v[0]) || !voxel_of(y, inv, v[1]) || !voxel_of(z, inv, v[2])) return drop;
+    std::uint32_t d[3];
+    for (int k = 0; k < 3; ++k) {
+      const std::int64_t r = v[k] - lo[k];
+      if (r < 0 || r > kMaxExtent) return drop;
+      d[k] = static_cast<std::uint32_t>(r);
+    }
+    return morton_encode3(d[0], d[1], d[2]);
+  }
+};
+
+std::uint64_t hash_key(std::uint64_t k) noexcept { return k * 0x9e3779b97f4a7c15ull; }
+
+}  // namespace
+
+VoxelDownsampleParams VoxelDownsampleParams::from_config(const BudgetsConfig& b) {
+  VoxelDownsampleParams p;
+  p.voxel_m = b.downsample_voxel_m;
+  p.threads = b.downsample_threads;
+  return p;
+}
+
+VoxelDownsampler::VoxelDownsampler(VoxelDownsampleParams params) : params_(params), pool_(params.threads) {}
+
+VoxelDownsampler::Bounds VoxelDownsampler::frame_bounds(ConstPointView in, std::size_t chunks) {
+  const float inv = 1.0f / params_.voxel_m;
+  chunk_bounds_.resize(chunks);
+  pool_.parallel_for(chunks, [&](std::size_t c, int) {
+    Bounds b;
+    for (int k = 0; k < 3; ++k) {
+      b.lo[k] = std::numeric_limits<std::int64_t>::max();
+      b.hi[k] = std::numeric_limits<std::int64_t>::min();
+    }
+    const std::size_t end = in.size * (c + 1) / chunks;
+    for (std::size_t i = in.size * c / chunks; i < end; ++i) {
+      const std::size_t j = i * in.stride;
+      std::int64_t v[3];
+      if (!voxel_of(in.x[j], inv, v[0]) || !voxel_of(in.y[j], inv, v[1]) || !voxel_of(in.z[j], inv, v[2])) {
+        continue;
+      }
+      for (int k = 0; k < 3; ++k) {
+        b.lo[k] = std::min(b.lo[k], v[k]);
+        b.hi[k] = std::max(b.hi[k], v[k]);
+      }
+    }
+    chunk_bounds_[c] = b;
+  });
+
+  Bounds b = chunk_bounds_[0];
+  for (std::size_t c = 1; c < chunks; ++c) {
+    for (int k = 0; k < 3; ++k) {
+      b.lo[k] = std::min(b.lo[k], chunk_bounds_[c].lo[k]);
+      b.hi[k] = std::max(b.hi[k], chunk_bounds_[c].hi[k]);
+    }
+  }
+  return b;
+}
+
+VoxelDownsampleStats VoxelDownsampler::downsample(ConstPointView in, PointBuffer& out) {
+  out.clear();
+  VoxelDownsampleStats s;
+  s.input = in.size;
+  if (in.size == 0) return s;
+
+  s.hash_path = in.size <= params_.hash_max_points;
+  const std::size_t chunks =
+      s.hash_path ? 1 : std::clamp<std::size_t>(in.size / kMinChunkPoints, 1, static_cast<std::size_t>(pool_.size()));
+  const Bounds b = frame_bounds(in, chunks);
+  if (b.lo[0] > b.hi[0]) {  // no finite point
+    s.dropped = in.size;
+    return s;
+  }
+  if (s.hash_path) {
+    downsample_hash(in, b, out, s);
+  } else {
+    downsample_sorted(in, b, out, s);
+  }
+  s.output = out.size();
+  return s;
+}
+
+void VoxelDownsampler::downsample_sorted(ConstPointView in, const Bounds& b, PointBuffer& out,
+                                         VoxelDownsampleStats& s) {
+  const std::size_t n = in.size;
+  const std::size_t chunks = chunk_bounds_.size();
+  const auto chunk_begin = [&](std::size_t c, std::size_t total) { return total * c / chunks; };
+
+  // Bits per axis needed for the frame's extent; the drop key takes the next bit up.
+  std::int64_t extent = 0;
+  for (int k = 0; k < 3; ++k) extent = std::max(extent, std::min(b.hi[k] - b.lo[k], kMaxExtent));
+  const int axis_bits = std::bit_width(static_cast<std::uint64_t>(std::max<std::int64_t>(extent, 0)));
+  const int key_bits = 3 * axis_bits + 1;
+  const KeyFn key_of{1.0f / params_.voxel_m, {b.lo[0], b.lo[1], b.lo[2]}, std::uint64_t{1} << (3 * axis_bits)};
+
+  for (int k = 0; k < 2; ++k) {
+    keys_[k].resize(n);
+    index_[k].resize(n);
+  }
+  run_count_.assign(chunks, 0);
+
+  // 1. Keys (run_count_ holds per-chunk drop counts until step 3).
+  pool_.parallel_for(chunks, [&](std::size_t c, int) {
+    std::size_t dropped = 0;
+    const std::size_t end = chunk_begin(c + 1, n);
+    for (std::size_t i = chunk_begin(c, n); i < end; ++i) {
+      const std::size_t j = i * in.stride;
+      const std::uint64_t key = key_of(in.x[j], in.y[j], in.z[j]);
+      dropped += key == key_of.drop;
+      keys_[0][i] = key;
+      index_[0][i] = static_cast<std::uint32_t>(i);
+    }
+    run_count_[c] = dropped;
+  });
+  for (const std::size_t d : run_count_) s.dropped += d;
+
+  // 2. Stable LSD radix sort. Each chunk scatters its keys to offsets that follow every
+  // smaller digit and the same digit of earlier chunks, so the order never depends on
+  // how the work was split.
+  hist_.resize(chunks * kDigits);
+  int cur = 0;
+  for (int shift = 0; shift < key_bits; shift += kDigitBits) {
+    const std::uint64_t* src = keys_[cur].data();
+    pool_.parallel_for(chunks, [&](std::size_t c, int) {
+      std::size_t* h = hist_.data() + c * kDigits;
+      std::fill_n(h, kDigits, 0);
+      const std::size_t end = chunk_begin(c + 1, n);
+      for (std::size_t i = chunk_begin(c, n); i < end; ++i) ++h[(src[i] >> shift) & (kDigits - 1)];
+    });
+
+    std::size_t running = 0;
+    bool trivial = false;
+    for (std::size_t d = 0; d < kDigits && !trivial; ++d) {
+      std::size_t total = 0;
+      for (std::size_t c = 0; c < chunks; ++c) total += hist_[c * kDigits + d];
+      trivial = total == n;
+    }
+    if (trivial) continue;  // every key has this digit: the pass would not move anything
+    for (std::size_t d = 0; d < kDigits; ++d) {
+      for (std::size_t c = 0; c < chunks; ++c) {
+        const std::size_t count = hist_[c * kDigits + d];
+        hist_[c * kDigits + d] = running;
+        running += count;
+      }
+    }
+
+    const std::uint32_t* src_index = index_[cur].data();
+    std::uint64_t* dst = keys_[cur ^ 1].data();
+    std::uint32_t* dst_index = index_[cur ^ 1].data();
+    pool_.parallel_for(chunks, [&](std::size_t c, int) {
+      std::size_t* h = hist_.data() + c * kDigits;
+      const std::size_t end = chunk_begin(c + 1, n);
+      for (std::size_t i = chunk_begin(c, n); i < end; ++i) {
+        const std::size_t pos = h[(src[i] >> shift) & (kDigits - 1)]++;
+        dst[pos] = src[i];
+        dst_index[pos] = src_index[i];
+      }
+    });
+    cur ^= 1;
+  }
+
+  // 3. Reduce runs of equal keys. Chunk starts are moved forward to run starts so no
+  // voxel is split between chunks; dropped points sit at the end and are skipped.
+  const std::uint64_t* keys = keys_[cur].data();
+  const std::uint32_t* index = index_[cur].data();
+  const std::size_t valid = n - s.dropped;
+  run_begin_.resize(chunks + 1);
+  for (std::size_t c = 0; c <= chunks; ++c) {
+    std::size_t p = std::max(chunk_begin(c, valid), c > 0 ? run_begin_[c - 1] : 0);
+    while (p > 0 && p < valid && keys[p] == keys[p - 1]) ++p;
+    run_begin_[c] = p;
+  }
+
+  pool_.parallel_for(chunks, [&](std::size_t c, int) {
+    std::size_t runs = 0;
+    for (std::size_t p = run_begin_[c]; p < run_begin_[c + 1]; ++p) {
+      runs += p == run_begin_[c] || keys[p] != keys[p - 1];
+    }
+    run_count_[c] = runs;
+  });
+  std::size_t total = 0;
+  for (std::size_t& r : run_count_) {
+    const std::size_t count = r;
+    r = total;
+    total += count;
+  }
+
+  out.resize(total);
+  const PointView o = out.mutable_view();
+  pool_.parallel_for(chunks, [&](std::size_t c, int) {
+    std::size_t w = run_count_[c];
+    const std::size_t end = run_begin_[c + 1];
+    for (std::size_t p = run_begin_[c]; p < end;) {
+      double sx = 0.0, sy = 0.0, sz = 0.0, si = 0.0;
+      std::size_t q = p;
+      for (; q < end && keys[q] == keys[p]; ++q) {
+        const std::size_t j = static_cast<std::size_t>(index[q]) * in.stride;
+        sx += in.x[j];
+        sy += in.y[j];
+        sz += in.z[j];
+        si += in.intensity[j];
+      }
+      const double inv_count = 1.0 / static_cast<double>(q - p);
+      o.x[w] = static_cast<float>(sx * inv_count);
+      o.y[w] = static_cast<float>(sy * inv_count);
+      o.z[w] = static_cast<float>(sz * inv_count);
+      o.intensity[w] = static_cast<float>(si * inv_count);
+      ++w;
+      p = q;
+    }
+  });
+}
+
+void VoxelDownsampler::downsample_hash(ConstPointView in, const Bounds& b, PointBuffer& out,
+                                       VoxelDownsampleStats& s) {
+  const KeyFn key_of{1.0f / params_.voxel_m, {b.lo[0], b.lo[1], b.lo[2]}, ~std::uint64_t{0}};
+
+  const std::size_t slots = std::bit_ceil(std::max<std::size_t>(2 * in.size, 16));
+  const std::size_t mask = slots - 1;
+  const int shift = 64 - std::bit_width(mask);
+  table_.assign(slots, Slot{0, kEmptySlot});
+  accum_.clear();
+
+  for (std::size_t i = 0; i < in.size; ++i) {
+    const std::size_t j = i * in.stride;
+    const std::uint64_t key = key_of(in.x[j], in.y[j], in.z[j]);
+    if (key == key_of.drop) {
+      ++s.dropped;
+      continue;
+    }
+    std::size_t slot = static_cast<std::size_t>(hash_key(key) >> shift);
+    while (table_[slot].accum != kEmptySlot && table_[slot].key != key) slot = (slot + 1) & mask;
+    if (table_[slot].accum == kEmptySlot) {
+      table_[slot] = Slot{key, static_cast<std::uint32_t>(accum_.size())};
+      accum_.push_back(Accum{0.0, 0.0, 0.0, 0.0, 0});
+    }
+    Accum& a = accum_[table_[slot].accum];
+    a.x += in.x[j];
+    a.y += in.y[j];
+    a.z += in.z[j];
+    a.i += in.intensity[j];
+    ++a.count;
+  }
+
+  out.resize(accum_.size());
+  const PointView o = out.mutable_view();
+  for (std::size_t w = 0; w < accum_.size(); ++w) {
+    const Accum& a = accum_[w];
+    const double inv_count = 1.0 / static_cast<double>(a.count);
+    o.x[w] = static_cast<float>(a.x * inv_count);
+    o.y[w] = static_cast<float>(a.y * inv_count);
+    o.z[w] = static_cast<float>(a.z * inv_count);
+    o.intensity[w] = static_cast<float>(a.i * inv_count);
+  }
+}
+
+}  // namespace wm
@@ -8,6 +8,8 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include "wm/core/geom/point_transform.hpp"
+
 namespace wm {
 namespace fs = std::filesystem;
 
@@ -165,6 +167,7 @@ Result<Config> load_config(const std::string& path_str) {
     const auto b = y["baseline"];
     if (b["capture_duration_s"]) cfg.baseline.capture_duration_ns = seconds_to_ns(b["capture_duration_s"].as<double>());
     if (b["warmup_duration_s"])  cfg.baseline.warmup_duration_ns  = seconds_to_ns(b["warmup_duration_s"].as<double>());
+    if (b["snapshot_path"])      cfg.baseline.snapshot_path       = b["snapshot_path"].as<std::string>();
   }
 
   // --- mapping
@@ -176,6 +179,22 @@ Result<Config> load_config(const std::string& path_str) {
     maybe_set(m, "max_range_m", cfg.mapping.max_range_m);
     maybe_set(m, "use_intensity", cfg.mapping.use_intensity);
     maybe_set(m, "integrate_hz", cfg.mapping.integrate_hz);
+    maybe_set(m, "integrate_threads", cfg.mapping.integrate_threads);
+    maybe_set(m, "integrate_pass_rays", cfg.mapping.integrate_pass_rays);
+    maybe_set(m, "publish_snapshots", cfg.mapping.publish_snapshots);
+    maybe_set(m, "region_size_blocks", cfg.mapping.region_size_blocks);
+    maybe_set(m, "morton_voxels", cfg.mapping.morton_voxels);
+    maybe_set(m, "map_shards", cfg.mapping.map_shards);
+    maybe_set(m, "map_huge_pages", cfg.mapping.map_huge_pages);
+    maybe_set(m, "lod_levels", cfg.mapping.lod_levels);
+    maybe_set(m, "lod_near_m", cfg.mapping.lod_near_m);
+    maybe_set(m, "log_odds_bits", cfg.mapping.log_odds_bits);
+    maybe_set(m, "log_odds_hit", cfg.mapping.log_odds_hit);
+    maybe_set(m, "log_odds_miss", cfg.mapping.log_odds_miss);
+    maybe_set(m, "log_odds_min", cfg.mapping.log_odds_min);
+    maybe_set(m, "log_odds_max", cfg.mapping.log_odds_max);
+    maybe_set(m, "log_odds_occupied", cfg.mapping.log_odds_occupied);
+    maybe_set(m, "log_odds_free", cfg.mapping.log_odds_free);
 
     if (is_map(m["roi"])) {
       const auto r = m["roi"];
@@ -192,6 +211,24 @@ Result<Config> load_config(const std::string& path_str) {
         maybe_set(mx, "z", cfg.mapping.roi.max.z);
       }
     }
+
+    maybe_set(m, "map_memory_budget_mb", cfg.mapping.map_memory_budget_mb);
+    if (is_map(m["map_core"])) {
+      const auto r = m["map_core"];
+      if (is_map(r["min"])) {
+        const auto mn = r["min"];
+        maybe_set(mn, "x", cfg.mapping.map_core.min.x);
+        maybe_set(mn, "y", cfg.mapping.map_core.min.y);
+        maybe_set(mn, "z", cfg.mapping.map_core.min.z);
+      }
+      if (is_map(r["max"])) {
+        const auto mx = r["max"];
+        maybe_set(mx, "x", cfg.mapping.map_core.max.x);
+        maybe_set(mx, "y", cfg.mapping.map_core.max.y);
+        maybe_set(mx, "z", cfg.mapping.map_core.max.z);
+      }
+    }
+    if (m["map_spill_path"]) cfg.mapping.map_spill_path = m["map_spill_path"].as<std::string>();
   }
 
   // --- budgets
@@ -200,6 +237,10 @@ Result<Config> load_config(const std::string& path_str) {
     maybe_set(b, "max_points_per_sec", cfg.budgets.max_points_per_sec);
     maybe_set(b, "target_fps", cfg.budgets.target_fps);
     maybe_set(b, "downsample_voxel_m", cfg.budgets.downsample_voxel_m);
+    maybe_set(b, "downsample_threads", cfg.budgets.downsample_threads);
+    maybe_set(b, "governor_enabled", cfg.budgets.governor_enabled);
+    maybe_set(b, "governor_window_frames", cfg.budgets.governor_window_frames);
+    maybe_set(b, "governor_headroom", cfg.budgets.governor_headroom);
   }
 
   // --- change detection
@@ -231,6 +272,31 @@ Result<Config> load_config(const std::string& path_str) {
     maybe_set(i, "heartbeat_every_s", cfg.input.heartbeat_every_s);
     maybe_set(i, "max_ticks", cfg.input.max_ticks);
     maybe_set(i, "max_run_s", cfg.input.max_run_s);
+    maybe_set(i, "batch_size", cfg.input.batch_size);
+
+    if (i["sensors"]) {
+      if (!i["sensors"].IsSequence()) {
+        return Result<Config>::err(Status::invalid_argument("input.sensors must be a sequence"));
+      }
+      cfg.input.sensors.clear();
+      for (const auto& sn : i["sensors"]) {
+        InputSensorConfig s;
+        maybe_set(sn, "sensor_id", s.sensor_id);
+        maybe_set(sn, "type", s.type);
+        s.type = to_lower(s.type);
+        maybe_set(sn, "path", s.path);
+        maybe_set(sn, "loop", s.loop);
+        maybe_set(sn, "fps", s.fps);
+        maybe_set(sn, "seed", s.seed);
+        s.T_node_lidar = cfg.calibration.T_node_lidar;
+        if (sn["T_node_lidar"]) {
+          auto t = parse_transform4x4(sn["T_node_lidar"]);
+          if (!t.ok()) return Result<Config>::err(t.status());
+          s.T_node_lidar = t.take_value();
+        }
+        cfg.input.sensors.push_back(std::move(s));
+      }
+    }
 
     if (is_map(i["synth"])) {
       const auto s = i["synth"];
@@ -247,6 +313,10 @@ Result<Config> load_config(const std::string& path_str) {
       maybe_set(d, "path", cfg.input.frame_dir.path);
       maybe_set(d, "loop", cfg.input.frame_dir.loop);
       maybe_set(d, "fps", cfg.input.frame_dir.fps);
+      maybe_set(d, "read_mode", cfg.input.frame_dir.read_mode);
+      cfg.input.frame_dir.read_mode = to_lower(cfg.input.frame_dir.read_mode);
+      maybe_set(d, "prefetch_depth", cfg.input.frame_dir.prefetch_depth);
+      maybe_set(d, "io_threads", cfg.input.frame_dir.io_threads);
     }
   }
 
@@ -257,6 +327,12 @@ Result<Config> load_config(const std::string& path_str) {
     maybe_set(o, "heartbeat_period_s", cfg.output.heartbeat_period_s);
   }
 
+  // Derived extrinsics: fuse lidar -> node -> site once so per-point code applies one matrix.
+  cfg.calibration.T_site_lidar = compose(cfg.calibration.T_site_node, cfg.calibration.T_node_lidar);
+  for (InputSensorConfig& s : cfg.input.sensors) {
+    s.T_site_lidar = compose(cfg.calibration.T_site_node, s.T_node_lidar);
+  }
+
   // Final validation (fail early).
   const Status s = validate_config(cfg);
   if (!s.ok()) return Result<Config>::err(s);
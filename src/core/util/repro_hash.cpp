@@ -114,20 +114,44 @@ std::string compute_config_hash(const Config& cfg) {
   // Baseline.
   h.add_i64(cfg.baseline.capture_duration_ns);
   h.add_i64(cfg.baseline.warmup_duration_ns);
+  h.add_string(cfg.baseline.snapshot_path);
 
   // Mapping.
   h.add_float(cfg.mapping.voxel_size_m);
   h.add_i32(cfg.mapping.block_size_vox);
+  h.add_i32(cfg.mapping.region_size_blocks);
+  h.add_bool(cfg.mapping.morton_voxels);
+  h.add_i32(cfg.mapping.map_shards);
+  h.add_bool(cfg.mapping.map_huge_pages);
+  h.add_i32(cfg.mapping.lod_levels);
+  h.add_float(cfg.mapping.lod_near_m);
+  h.add_i32(cfg.mapping.log_odds_bits);
+  h.add_float(cfg.mapping.log_odds_hit);
+  h.add_float(cfg.mapping.log_odds_miss);
+  h.add_float(cfg.mapping.log_odds_min);
+  h.add_float(cfg.mapping.log_odds_max);
+  h.add_float(cfg.mapping.log_odds_occupied);
+  h.add_float(cfg.mapping.log_odds_free);
   add_aabb(h, AABB{cfg.mapping.roi.min, cfg.mapping.roi.max});
+  h.add_i32(cfg.mapping.map_memory_budget_mb);
+  add_aabb(h, AABB{cfg.mapping.map_core.min, cfg.mapping.map_core.max});
+  h.add_string(cfg.mapping.map_spill_path);
   h.add_float(cfg.mapping.min_range_m);
   h.add_float(cfg.mapping.max_range_m);
   h.add_bool(cfg.mapping.use_intensity);
   h.add_i32(cfg.mapping.integrate_hz);
+  h.add_i32(cfg.mapping.integrate_threads);
+  h.add_i32(cfg.mapping.integrate_pass_rays);
+  h.add_bool(cfg.mapping.publish_snapshots);
 
   // Budgets.
   h.add_i64(cfg.budgets.max_points_per_sec);
   h.add_i32(cfg.budgets.target_fps);
   h.add_float(cfg.budgets.downsample_voxel_m);
+  h.add_i32(cfg.budgets.downsample_threads);
+  h.add_bool(cfg.budgets.governor_enabled);
+  h.add_i32(cfg.budgets.governor_window_frames);
+  h.add_float(cfg.budgets.governor_headroom);
 
   // Change detection.
   h.add_i64(cfg.change.persistence_ns);
@@ -149,6 +173,7 @@ std::string compute_config_hash(const Config& cfg) {
   h.add_i32(cfg.input.heartbeat_every_s);
   h.add_i64(cfg.input.max_ticks);
   h.add_double(cfg.input.max_run_s);
+  h.add_i32(cfg.input.batch_size);
 
   h.add_u32(cfg.input.synth.seed);
   h.add_i32(cfg.input.synth.num_points);
@@ -160,6 +185,20 @@ std::string compute_config_hash(const Config& cfg) {
   h.add_string(cfg.input.frame_dir.path);
   h.add_bool(cfg.input.frame_dir.loop);
   h.add_double(cfg.input.frame_dir.fps);
+  h.add_string(cfg.input.frame_dir.read_mode);
+  h.add_i32(cfg.input.frame_dir.prefetch_depth);
+  h.add_i32(cfg.input.frame_dir.io_threads);
+
+  h.add_u64(cfg.input.sensors.size());
+  for (const InputSensorConfig& s : cfg.input.sensors) {
+    h.add_string(s.sensor_id);
+    h.add_string(s.type);
+    h.add_string(s.path);
+    h.add_bool(s.loop);
+    h.add_double(s.fps);
+    h.add_u32(s.seed);
+    add_transform(h, s.T_node_lidar);
+  }
 
   // Output.
   h.add_string(cfg.output.out_dir);
@@ -168,4 +207,51 @@ std::string compute_config_hash(const Config& cfg) {
   return to_hex(h.h);
 }
 
+std::string compute_map_config_hash(const Config& cfg) {
+  Fnv1a64 h;
+
+  h.add_string(cfg.node_id);
+  h.add_string(cfg.frames.lidar_frame);
+  h.add_string(cfg.frames.node_frame);
+  h.add_string(cfg.frames.site_frame);
+
+  // What the baseline learns from.
+  h.add_i64(cfg.baseline.capture_duration_ns);
+  h.add_i64(cfg.baseline.warmup_duration_ns);
+
+  // Geometry and update rules. Shards, huge pages and threads change the layout or speed,
+  // never the contents. Eviction does (regions without a spill file revert to unknown),
+  // but only whether there is a spill file, not where.
+  h.add_float(cfg.mapping.voxel_size_m);
+  h.add_i32(cfg.mapping.block_size_vox);
+  h.add_i32(cfg.mapping.region_size_blocks);
+  h.add_bool(cfg.mapping.morton_voxels);
+  h.add_i32(cfg.mapping.lod_levels);
+  h.add_float(cfg.mapping.lod_near_m);
+  h.add_i32(cfg.mapping.log_odds_bits);
+  h.add_float(cfg.mapping.log_odds_hit);
+  h.add_float(cfg.mapping.log_odds_miss);
+  h.add_float(cfg.mapping.log_odds_min);
+  h.add_float(cfg.mapping.log_odds_max);
+  h.add_float(cfg.mapping.log_odds_occupied);
+  h.add_float(cfg.mapping.log_odds_free);
+  add_aabb(h, AABB{cfg.mapping.roi.min, cfg.mapping.roi.max});
+  h.add_i32(cfg.mapping.map_memory_budget_mb);
+  add_aabb(h, AABB{cfg.mapping.map_core.min, cfg.mapping.map_core.max});
+  h.add_bool(!cfg.mapping.map_spill_path.empty());
+  h.add_float(cfg.mapping.min_range_m);
+  h.add_float(cfg.mapping.max_range_m);
+  h.add_i32(cfg.mapping.integrate_hz);
+  h.add_i32(cfg.mapping.integrate_pass_rays);
+
+  // Per-sensor extrinsics place every sensor's points in the map.
+  h.add_u64(cfg.input.sensors.size());
+  for (const InputSensorConfig& s : cfg.input.sensors) {
+    h.add_string(s.sensor_id);
+    add_transform(h, s.T_node_lidar);
+  }
+
+  return to_hex(h.h);
+}
+
 }  // namespace wm
@@ -0,0 +1,50 @@
+// File: src/core/util/simd.cpp
+#include "wm/core/util/simd.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace wm {
+namespace {
+
+bool detect_avx2() noexcept {
+  const char* off = std::getenv("WM_DISABLE_AVX2");
+  if (off != nullptr && std::strcmp(off, "0") != 0 && off[0] != '\0') return false;
+#if WM_SIMD_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+bool cpu_has_avx2() noexcept {
+  static const bool has = detect_avx2();
+  return has;
+}
+
+SimdLevel best_simd_level() noexcept {
+#if WM_SIMD_X86
+  return cpu_has_avx2() ? SimdLevel::kAvx2 : SimdLevel::kSse2;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+SimdLevel clamp_simd_level(SimdLevel requested) noexcept {
+  const SimdLevel best = best_simd_level();
+  return static_cast<int>(requested) < static_cast<int>(best) ? requested : best;
+}
+
+const char* simd_level_name(SimdLevel level) noexcept {
+  switch (level) {
+    case SimdLevel::kScalar: return "scalar";
+    case SimdLevel::kSse2: return "sse2";
+    case SimdLevel::kAvx2: return "avx2";
+  }
+  return "unknown";
+}
+
+}  // namespace wm